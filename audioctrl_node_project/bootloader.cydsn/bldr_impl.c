@@ -6,23 +6,308 @@
 #include "canopen_bootloader.h"
 #include <project.h>
 #include "timer.h"
+#include "sdo_block.h"
+#include "lzss.h"
+#include "mcast.h"
 
 
 #define BOOTLOADER_MAX_CMD_LEN Bootloader_SIZEOF_COMMAND_BUFFER
 
+/* Bootloader packet: SOP, command, length, data, checksum, EOP */
+#define BOOTLOADER_SOP          0x01
+#define BOOTLOADER_EOP          0x17
+#define BOOTLOADER_PKT_OVERHEAD 7
 
-static uint8_t bootloader_cmd_buff[BOOTLOADER_MAX_CMD_LEN];
-static uint8_t bootloader_resp_buff[BOOTLOADER_MAX_CMD_LEN];
-static int     bootloader_cmd_len = 0;
-static uint8_t bootloader_resp_len = 0;
+/* The packet checksum must be the one the Bootloader component is set to */
+#if defined(Bootloader_PACKET_CHECKSUM_CRC)
+  #define BOOTLOADER_CHECKSUM_CRC Bootloader_PACKET_CHECKSUM_CRC
+#else
+  #define BOOTLOADER_CHECKSUM_CRC 0
+#endif
+
+/* Row CRC, a command of our own the Bootloader component never sees.  Data:
+   array ID, first row (LE16), number of rows.  The response carries the
+   CRC-32 (IEEE 802.3, LE) of each row as it is in flash, so the host
+   programs only the rows of a new image that differ. */
+#define BOOTLOADER_CMD_ROW_CRC  0x50
+#define BOOTLOADER_ROW_CRC_MAX  ((BOOTLOADER_MAX_CMD_LEN - BOOTLOADER_PKT_OVERHEAD) / 4)
+#define BOOTLOADER_ARRAY_ROWS   (CY_FLASH_NUMBER_ROWS / CY_FLASH_NUMBER_ARRAYS)
+
+/* Command slots, used in turn.  A slot is taken from the first byte of a
+   command until CyBtldrCommRead() has copied it out; the Bootloader works on
+   its own copy, so the next command arrives in the other slot while a row is
+   erased and programmed. */
+#define BOOTLOADER_SLOTS        2
+
+#define SLOT_FREE               0
+#define SLOT_FILL               1   /* receiving */
+#define SLOT_HELD               2   /* complete, waits for the next command or the end of the transfer */
+#define SLOT_READY              3   /* waits for CyBtldrCommRead() */
+
+/* A block download carries plain packets or an LZSS stream of them, told
+   apart by its first byte.  A compressed stream goes through the input of
+   lzss.c and is decoded into the slots from the main loop. */
+#define STREAM_IDLE             0
+#define STREAM_PLAIN            1
+#define STREAM_LZ               2
+#define STREAM_LZ_END           3   /* all received, the input is still being decoded */
+
+typedef struct
+{
+  uint8_t          buff[BOOTLOADER_MAX_CMD_LEN];
+  uint16_t         len;
+  uint16_t         size;      /* packet size, 0 until the header is in */
+  uint16_t         tag;       /* multicast unit, MCAST_NO_UNIT if none */
+  volatile uint8_t state;
+} BootloaderSlot;
+
+static BootloaderSlot bootloader_slot[BOOTLOADER_SLOTS];
+static uint8_t  bootloader_fill = 0;
+static uint8_t  bootloader_read = 0;
+static uint8_t  bootloader_resp_buff[BOOTLOADER_MAX_CMD_LEN];
+static uint16_t bootloader_resp_len = 0;
+static uint8_t  bootloader_resp_error = 0;   /* failed response, kept until read */
+static volatile uint8_t bootloader_stream = STREAM_IDLE;
+static int16_t  bootloader_lz_byte = LZSS_EMPTY;  /* decoded, not taken by a slot yet */
+static uint16_t bootloader_tag = MCAST_NO_UNIT;      /* tag of the next command */
+static uint16_t bootloader_cmd_tag = MCAST_NO_UNIT;  /* tag of the command the Bootloader runs */
 
 
 void ClearResponse()
 {
+  if (bootloader_resp_error)
+    return;
+  
   bootloader_resp_buff[0] = 0xFF;
   bootloader_resp_len = 1;
 }
 
+/* Drops every command not yet read, after a failed one; a multicast unit
+   dropped is not acknowledged */
+static void FlushSlots(void)
+{
+  uint8 intr;
+  uint8_t i;
+  
+  intr = CyEnterCriticalSection();
+  for (i = 0; i < BOOTLOADER_SLOTS; i++)
+  {
+    if ((bootloader_slot[i].state == SLOT_READY) && (bootloader_slot[i].tag != MCAST_NO_UNIT))
+      MCAST_Result(bootloader_slot[i].tag, 0);
+    bootloader_slot[i].state = SLOT_FREE;
+  }
+  bootloader_fill = 0;
+  bootloader_read = 0;
+  bootloader_stream = STREAM_IDLE;
+  bootloader_lz_byte = LZSS_EMPTY;
+  LZSS_Reset();
+  CyExitCriticalSection(intr);
+}
+
+/* Appends one byte of a block download to the command in the fill slot */
+static uint8_t SlotPut(uint8_t b)
+{
+  BootloaderSlot *slot = &bootloader_slot[bootloader_fill];
+  
+  // A byte after a complete command releases it and starts the next one
+  if (slot->state == SLOT_HELD)
+  {
+    slot->state = SLOT_READY;
+    bootloader_fill ^= 1;
+    slot = &bootloader_slot[bootloader_fill];
+  }
+  if (slot->state == SLOT_FREE)
+  {
+    if (b != BOOTLOADER_SOP)
+      return PROGRAM_BLOCK_ERROR;
+    slot->len = 0;
+    slot->size = 0;
+    slot->tag = bootloader_tag;
+    slot->state = SLOT_FILL;
+  }
+  else if (slot->state != SLOT_FILL)
+    return PROGRAM_BLOCK_BUSY;
+  
+  slot->buff[slot->len++] = b;
+  if (slot->len == 4)
+  {
+    slot->size = (uint16_t)(slot->buff[2] | (slot->buff[3] << 8)) + BOOTLOADER_PKT_OVERHEAD;
+    if (slot->size > BOOTLOADER_MAX_CMD_LEN)
+      return PROGRAM_BLOCK_ERROR;
+  }
+  if (slot->len == slot->size)
+    slot->state = SLOT_HELD;
+  return PROGRAM_BLOCK_OK;
+}
+
+
+static uint16_t PacketChecksum(const uint8_t *buff, uint16_t len)
+{
+#if (BOOTLOADER_CHECKSUM_CRC != 0)
+  uint16_t crc = 0xFFFF;
+  uint8_t  b;
+  uint8_t  i;
+  
+  while (len--)
+  {
+    b = *buff++;
+    for (i = 0; i < 8; i++)
+    {
+      crc = ((crc ^ b) & 1) ? ((crc >> 1) ^ 0x8408) : (crc >> 1);
+      b >>= 1;
+    }
+  }
+  crc = ~crc;
+  return (uint16_t)((crc << 8) | (crc >> 8));
+#else
+  uint16_t sum = 0;
+  
+  while (len--)
+    sum += *buff++;
+  return (uint16_t)(1 + ~sum);
+#endif
+}
+
+/* Wraps data_len bytes of response data at buff + 4 into a packet */
+static uint16_t PacketFinish(uint8_t *buff, uint8_t status, uint16_t data_len)
+{
+  uint16_t sum;
+  
+  buff[0] = BOOTLOADER_SOP;
+  buff[1] = status;
+  buff[2] = (uint8_t)data_len;
+  buff[3] = (uint8_t)(data_len >> 8);
+  sum = PacketChecksum(buff, data_len + 4);
+  buff[data_len + 4] = (uint8_t)sum;
+  buff[data_len + 5] = (uint8_t)(sum >> 8);
+  buff[data_len + 6] = BOOTLOADER_EOP;
+  return data_len + BOOTLOADER_PKT_OVERHEAD;
+}
+
+static const uint32_t crc32_nibble[16] =
+{
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t RowCrc(const uint8_t *row)
+{
+  uint32_t crc = 0xFFFFFFFF;
+  uint16_t i;
+  
+  for (i = 0; i < CY_FLASH_SIZEOF_ROW; i++)
+  {
+    crc = (crc >> 4) ^ crc32_nibble[(crc ^ row[i]) & 0x0F];
+    crc = (crc >> 4) ^ crc32_nibble[(crc ^ (row[i] >> 4)) & 0x0F];
+  }
+  return ~crc;
+}
+
+/* Answers a Row CRC command; the response is built in the slot of the
+   command and goes out the way the Bootloader sends its own */
+static void RowCrcCommand(BootloaderSlot *slot)
+{
+  uint8_t  *buff = slot->buff;
+  uint16_t data_len = (uint16_t)(buff[2] | (buff[3] << 8));
+  uint8_t  status = CYRET_SUCCESS;
+  uint8_t  array = buff[4];
+  uint16_t row = (uint16_t)(buff[5] | (buff[6] << 8));
+  uint8_t  rows = buff[7];
+  uint32_t crc;
+  uint16_t count;
+  uint8_t  i;
+  
+  if ((data_len != 4) || (slot->len != data_len + BOOTLOADER_PKT_OVERHEAD))
+    status = Bootloader_ERR_LENGTH;
+  else if ((uint16_t)(buff[8] | (buff[9] << 8)) != PacketChecksum(buff, data_len + 4))
+    status = Bootloader_ERR_CHECKSUM;
+  else if (array >= CY_FLASH_NUMBER_ARRAYS)
+    status = Bootloader_ERR_ARRAY;
+  else if ((rows == 0) || (rows > BOOTLOADER_ROW_CRC_MAX) || (row + rows > BOOTLOADER_ARRAY_ROWS))
+    status = Bootloader_ERR_ROW;
+  
+  data_len = 0;
+  if (status == CYRET_SUCCESS)
+  {
+    for (i = 0; i < rows; i++)
+    {
+      crc = RowCrc((const uint8_t *)CY_FLASH_BASE +
+                   ((uint32_t)array * BOOTLOADER_ARRAY_ROWS + row + i) * CY_FLASH_SIZEOF_ROW);
+      buff[4 + data_len++] = (uint8_t)crc;
+      buff[4 + data_len++] = (uint8_t)(crc >> 8);
+      buff[4 + data_len++] = (uint8_t)(crc >> 16);
+      buff[4 + data_len++] = (uint8_t)(crc >> 24);
+    }
+  }
+  (void)CyBtldrCommWrite(buff, PacketFinish(buff, status, data_len), &count, 0);
+}
+
+/* Ends a block download: releases the last command, or drops an unfinished
+   one */
+static uint8_t SlotsEnd(uint8_t commit)
+{
+  BootloaderSlot *slot = &bootloader_slot[bootloader_fill];
+  
+  if (commit && (slot->state == SLOT_HELD))
+  {
+    slot->state = SLOT_READY;
+    bootloader_fill ^= 1;
+    return PROGRAM_BLOCK_OK;
+  }
+  
+  if ((slot->state == SLOT_FILL) || (slot->state == SLOT_HELD))
+    slot->state = SLOT_FREE;
+  return commit ? PROGRAM_BLOCK_ERROR : PROGRAM_BLOCK_OK;
+}
+
+/* Decodes a compressed stream into the slots, as far as they take it.  One
+   byte at a time with the interrupts off, an abort from the CAN interrupt
+   may flush the stream at any point. */
+static void LzDecode(void)
+{
+  uint8_t result = PROGRAM_BLOCK_OK;
+  uint8 intr;
+  
+  while (result == PROGRAM_BLOCK_OK)
+  {
+    intr = CyEnterCriticalSection();
+    if (bootloader_stream < STREAM_LZ)
+      result = PROGRAM_BLOCK_BUSY;
+    else
+    {
+      if (bootloader_lz_byte == LZSS_EMPTY)
+        bootloader_lz_byte = LZSS_Get();
+      
+      if (bootloader_lz_byte >= 0)
+      {
+        result = SlotPut((uint8_t)bootloader_lz_byte);
+        if (result == PROGRAM_BLOCK_OK)
+          bootloader_lz_byte = LZSS_EMPTY;
+      }
+      else if (bootloader_lz_byte == LZSS_ERROR)
+        result = PROGRAM_BLOCK_ERROR;
+      else
+      {
+        /* Input used up; at the end of the stream the last command goes
+           out, a command cut short is dropped */
+        if (bootloader_stream == STREAM_LZ_END)
+        {
+          (void)SlotsEnd(1);
+          bootloader_stream = STREAM_IDLE;
+        }
+        result = PROGRAM_BLOCK_BUSY;
+      }
+    }
+    CyExitCriticalSection(intr);
+  }
+  
+  if (result == PROGRAM_BLOCK_ERROR)
+  {
+    SDOB_Cancel();
+    FlushSlots();
+  }
+}
+
 
 /**********************************************************************************************************************
  * PSoC Bootloader Communication Callbacks
@@ -43,6 +328,8 @@ void CyBtldrCommStart(void)
 {
   TAR_InitHardware();
   TAR_AppInit();
+  SDOB_Start(USR_GetNodeId());
+  MCAST_Start(USR_GetNodeId());
   ClearResponse();
 }
 
@@ -91,9 +378,34 @@ void CyBtldrCommReset(void)
     Side Effects: None */
 cystatus CyBtldrCommWrite(uint8 *data, uint16 size, uint16 *count, uint8 timeOut)
 {
-  memcpy(bootloader_resp_buff, data, size);
   *count = size;
+  
+  /* The result of a multicast unit goes to its bitmap only; a failed unit
+     is sent again, it does not end anything */
+  if (bootloader_cmd_tag != MCAST_NO_UNIT)
+  {
+    MCAST_Result(bootloader_cmd_tag, (size > 1) && (data[1] == CYRET_SUCCESS));
+    bootloader_cmd_tag = MCAST_NO_UNIT;
+    return CYRET_SUCCESS;
+  }
+  
+  /* The host has not read the failure yet */
+  if (bootloader_resp_error)
+    return CYRET_SUCCESS;
+  
+  if (size > BOOTLOADER_MAX_CMD_LEN)
+    size = BOOTLOADER_MAX_CMD_LEN;
+  memcpy(bootloader_resp_buff, data, size);
   bootloader_resp_len = size;
+  
+  /* A failed command ends the stream it came in, the commands behind it
+     are dropped */
+  if ((size > 1) && (data[1] != CYRET_SUCCESS))
+  {
+    bootloader_resp_error = 1;
+    SDOB_Cancel();
+    FlushSlots();
+  }
   return CYRET_SUCCESS;
 }
 
@@ -117,19 +429,63 @@ cystatus CyBtldrCommWrite(uint8 *data, uint16 size, uint16 *count, uint8 timeOut
 cystatus CyBtldrCommRead(uint8 *data, uint16 size, uint16 *count, uint8 timeOut)
 {
   COP_t_Timer start_time = SysTick_GetTicks();
-  while((bootloader_cmd_len == 0) && (timeOut == 0xFF || SysTick_GetTicks() < start_time + (timeOut*10)))
-    TAR_AppRun();
+  BootloaderSlot *slot;
+  uint16_t len;
+  uint8 local;
+  uint8 intr;
   
-  if (bootloader_cmd_len > 0)
+  do
   {
-    memcpy(data, bootloader_cmd_buff, bootloader_cmd_len);
-    *count = bootloader_cmd_len;
-    bootloader_cmd_len = 0;
-    ClearResponse();
-    return CYRET_SUCCESS;
-  }
+    slot = &bootloader_slot[bootloader_read];
+    LzDecode();
+    while((slot->state != SLOT_READY) && (timeOut == 0xFF || SysTick_GetTicks() < start_time + (timeOut*10)))
+    {
+      TAR_AppRun();
+      SDOB_Service();
+      MCAST_Service();
+      LzDecode();
+    }
+    
+    if (slot->state != SLOT_READY)
+    {
+      SDOB_Service();
+      MCAST_Service();
+      return CYRET_TIMEOUT;
+    }
+    
+    bootloader_cmd_tag = slot->tag;
+    
+    /* Commands of our own are answered here, the Bootloader gets the rest */
+    local = (slot->len >= BOOTLOADER_PKT_OVERHEAD) && (slot->buff[1] == BOOTLOADER_CMD_ROW_CRC);
+    if (local)
+    {
+      ClearResponse();
+      RowCrcCommand(slot);
+    }
+    else
+    {
+      len = (slot->len < size) ? slot->len : size;
+      memcpy(data, slot->buff, len);
+      *count = len;
+    }
+    intr = CyEnterCriticalSection();
+    if (slot->state == SLOT_READY)
+    {
+      slot->state = SLOT_FREE;
+      bootloader_read ^= 1;
+    }
+    CyExitCriticalSection(intr);
+    
+    /* With the slot free, the next command is decoded and a block
+       acknowledge goes out before a row write holds the CPU, so the host
+       streams on meanwhile */
+    LzDecode();
+    SDOB_Service();
+    MCAST_Service();
+  } while (local);
   
-  return CYRET_TIMEOUT;
+  ClearResponse();
+  return CYRET_SUCCESS;
 }
 
 /*********************************************************************************************************************/
@@ -173,6 +529,10 @@ UINT8 Program_ObjReceive(UINT32  *pdw_len,
   {
     case SDO_k_DOWNLOAD:
     {
+      BootloaderSlot *slot = &bootloader_slot[bootloader_fill];
+      UINT8 result = SDO_k_ABORT_OK;
+      uint8 intr;
+      
       /* check if data size requested */
       if (pb_len == NULL)
       {
@@ -181,16 +541,39 @@ UINT8 Program_ObjReceive(UINT32  *pdw_len,
         return SDO_k_ABORT_OK;
       }
       
-      // Copy segment into command buffer and move the SDO position forward
-      memcpy((void*)(bootloader_cmd_buff+*pdw_pos), (void*)pb_data, *pb_len);
-      *pdw_pos += *pb_len;
-      bootloader_cmd_len = 0;
+      intr = CyEnterCriticalSection();
       
-      /* last data received */
-      if( *pdw_pos == *pdw_len )  
-        bootloader_cmd_len = *pdw_len;
+      /* The first segment takes the fill slot, if CyBtldrCommRead() has
+         freed it */
+      if ((*pdw_pos == 0) && (slot->state == SLOT_FREE))
+      {
+        slot->len = 0;
+        slot->tag = MCAST_NO_UNIT;
+        slot->state = SLOT_FILL;
+      }
       
-      break;
+      if ((slot->state != SLOT_FILL) || (*pdw_len > BOOTLOADER_MAX_CMD_LEN) ||
+          (*pdw_pos + *pb_len > *pdw_len))
+      {
+        result = SDO_k_ABORT_GEN_ERROR;
+      }
+      else
+      {
+        // Copy segment into command buffer and move the SDO position forward
+        memcpy((void*)(slot->buff+*pdw_pos), (void*)pb_data, *pb_len);
+        *pdw_pos += *pb_len;
+        slot->len = *pdw_pos;
+        
+        /* last data received */
+        if( *pdw_pos == *pdw_len )
+        {
+          slot->state = SLOT_READY;
+          bootloader_fill ^= 1;
+        }
+      }
+      
+      CyExitCriticalSection(intr);
+      return result;
     }
     case SDO_k_UPLOAD:
     {
@@ -212,16 +595,200 @@ UINT8 Program_ObjReceive(UINT32  *pdw_len,
       memcpy((void*)pb_data, (void*)(bootloader_resp_buff+*pdw_pos), *pb_len);
       *pdw_pos += *pb_len;
       
+      /* the host has the response */
+      if (*pdw_pos == *pdw_len)
+        bootloader_resp_error = 0;
+      
       break;
     }
     case SDO_k_ABORT:
     {
+      /* drop a command left unfinished */
+      if (bootloader_slot[bootloader_fill].state == SLOT_FILL)
+        bootloader_slot[bootloader_fill].state = SLOT_FREE;
       return SDO_k_ABORT_NO;
     }
   }
   return SDO_k_ABORT_OK;
 }
 
+/*************************************************************************
+**
+** Function    : Program_BlockSpace
+**
+** Description : Callback of the SDO block server, sizing the next block.
+**               Counts the rest of the command being received and a
+**               free slot; a stream of short commands may need more
+**               slots than that, Program_BlockWrite() then refuses.
+**               A compressed stream counts the room of the decoder
+**               input.
+**                
+** Parameters  : -
+**                
+** Returnvalue : bytes the command slots can take
+**
+*************************************************************************/
+uint16 Program_BlockSpace(void)
+{
+  BootloaderSlot *slot = &bootloader_slot[bootloader_fill];
+  uint16_t space = 0;
+  
+  /* A compressed stream is sized by the decoder input; the next stream
+     waits until the last one is decoded */
+  if (bootloader_stream == STREAM_LZ)
+    return LZSS_Space();
+  if (bootloader_stream == STREAM_LZ_END)
+    return 0;
+  
+  if (slot->state == SLOT_FREE)
+    space = BOOTLOADER_MAX_CMD_LEN;
+  else if (slot->state == SLOT_FILL)
+    space = (slot->size ? slot->size : BOOTLOADER_MAX_CMD_LEN) - slot->len;
+  
+  if ((slot->state != SLOT_READY) && (bootloader_slot[bootloader_fill ^ 1].state == SLOT_FREE))
+    space += BOOTLOADER_MAX_CMD_LEN;
+  
+  return space;
+}
+
+/*************************************************************************
+**
+** Function    : Program_BlockWrite
+**
+** Description : Callback of the SDO block server with the next bytes of
+**               a block download.  All or nothing: if a command would
+**               need a slot that is not free, no byte is taken.  The
+**               first bytes tell a compressed stream, which goes to the
+**               decoder input instead.
+**                
+** Parameters  : pb_data     (IN)      - bytes of the download
+**               b_len       (IN)      - number of bytes, up to 7
+**                
+** Returnvalue : PROGRAM_BLOCK_OK, PROGRAM_BLOCK_BUSY or
+**               PROGRAM_BLOCK_ERROR
+**
+*************************************************************************/
+uint8 Program_BlockWrite(const uint8 *pb_data, uint8 b_len)
+{
+  uint16_t len[BOOTLOADER_SLOTS];
+  uint16_t size[BOOTLOADER_SLOTS];
+  uint8_t  state[BOOTLOADER_SLOTS];
+  uint8_t  fill = bootloader_fill;
+  uint8_t  result = PROGRAM_BLOCK_OK;
+  uint8_t  i;
+  
+  if (bootloader_stream == STREAM_IDLE)
+  {
+    bootloader_stream = (pb_data[0] == LZSS_MAGIC) ? STREAM_LZ : STREAM_PLAIN;
+    if (bootloader_stream == STREAM_LZ)
+    {
+      bootloader_lz_byte = LZSS_EMPTY;
+      LZSS_Reset();
+    }
+  }
+  if (bootloader_stream == STREAM_LZ)
+    return LZSS_Put(pb_data, b_len) ? PROGRAM_BLOCK_OK : PROGRAM_BLOCK_BUSY;
+  if (bootloader_stream == STREAM_LZ_END)
+    return PROGRAM_BLOCK_BUSY;
+  
+  for (i = 0; i < BOOTLOADER_SLOTS; i++)
+  {
+    len[i] = bootloader_slot[i].len;
+    size[i] = bootloader_slot[i].size;
+    state[i] = bootloader_slot[i].state;
+  }
+  
+  for (i = 0; (i < b_len) && (result == PROGRAM_BLOCK_OK); i++)
+    result = SlotPut(pb_data[i]);
+  
+  if (result != PROGRAM_BLOCK_OK)
+  {
+    for (i = 0; i < BOOTLOADER_SLOTS; i++)
+    {
+      bootloader_slot[i].len = len[i];
+      bootloader_slot[i].size = size[i];
+      bootloader_slot[i].state = state[i];
+    }
+    bootloader_fill = fill;
+  }
+  return result;
+}
+
+/*************************************************************************
+**
+** Function    : Program_BlockEnd
+**
+** Description : Callback of the SDO block server at the end of a block
+**               download.  Once the CRC has matched the last command is
+**               handed to the bootloader; otherwise the command left in
+**               the fill slot is dropped.  A compressed stream is
+**               decoded to its end first, by CyBtldrCommRead().
+**                
+** Parameters  : b_commit    (IN)      - the transfer is complete and good
+**                
+** Returnvalue : PROGRAM_BLOCK_OK, PROGRAM_BLOCK_ERROR if the data ends
+**               inside a command
+**
+*************************************************************************/
+uint8 Program_BlockEnd(uint8 b_commit)
+{
+  bootloader_tag = MCAST_NO_UNIT;
+  
+  if (bootloader_stream == STREAM_LZ)
+  {
+    if (b_commit)
+    {
+      bootloader_stream = STREAM_LZ_END;
+      return PROGRAM_BLOCK_OK;
+    }
+    bootloader_lz_byte = LZSS_EMPTY;
+    LZSS_Reset();
+  }
+  if (bootloader_stream == STREAM_LZ_END)
+    return b_commit ? PROGRAM_BLOCK_ERROR : PROGRAM_BLOCK_OK;
+  
+  bootloader_stream = STREAM_IDLE;
+  return SlotsEnd(b_commit);
+}
+
+/*************************************************************************
+**
+** Function    : Program_BlockTag
+**
+** Description : Callback of the multicast download before the first
+**               byte of a unit.  The command is tagged with the unit, so
+**               its result is acknowledged to mcast.c and not kept as
+**               the response to the host.
+**                
+** Parameters  : w_unit      (IN)      - the unit
+**                
+** Returnvalue : -
+**
+*************************************************************************/
+void Program_BlockTag(uint16 w_unit)
+{
+  bootloader_tag = w_unit;
+}
+
+/*************************************************************************
+**
+** Function    : Program_BlockResponse
+**
+** Description : Callback of the SDO block server on a block upload of
+**               the response to the last command.
+**                
+** Parameters  : ppb_data    (OUT)     - the response
+**                
+** Returnvalue : length of the response
+**
+*************************************************************************/
+uint16 Program_BlockResponse(const uint8 **ppb_data)
+{
+  bootloader_resp_error = 0;
+  *ppb_data = bootloader_resp_buff;
+  return bootloader_resp_len;
+}
+
 /*********************************************************************************************************************/
 
 
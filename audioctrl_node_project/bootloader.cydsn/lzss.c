@@ -0,0 +1,219 @@
+/*******************************************************************************
+* FILE: lzss.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     LZSS stream decoder, see lzss.h.  The input buffer has one writer, the
+* CAN interrupt, and one reader, the main loop; each side moves only its own
+* index.  An item is taken from the input only once all of its bytes are in,
+* so LZSS_Get() can return LZSS_EMPTY at any point and go on from there.
+*******************************************************************************/
+#include "lzss.h"
+
+#define LZSS_WINDOW_SIZE        (1u << LZSS_WINDOW_BITS)
+#define LZSS_WINDOW_MASK        (LZSS_WINDOW_SIZE - 1u)
+#define LZSS_INPUT_MASK         (LZSS_INPUT_SIZE - 1u)
+#define LZSS_HEADER_SIZE        (2u)
+
+#if ((LZSS_WINDOW_BITS < 8u) || (LZSS_WINDOW_BITS > 12u))
+    #error "LZSS_WINDOW_BITS must be in 8..12"
+#endif
+#if ((LZSS_INPUT_SIZE & LZSS_INPUT_MASK) != 0u)
+    #error "LZSS_INPUT_SIZE must be a power of two"
+#endif
+
+static uint8 lzss_window[LZSS_WINDOW_SIZE];
+static uint16 lzss_out;                 /* bytes decoded, mod 2^16 */
+
+static uint8 lzss_in[LZSS_INPUT_SIZE];
+static volatile uint16 lzss_head;       /* moved by LZSS_Put() */
+static volatile uint16 lzss_tail;       /* moved by LZSS_Get() */
+
+static uint8 lzss_header;               /* header bytes still to come */
+static uint8 lzss_len_bits;             /* length bits of a match in this stream */
+static uint8 lzss_error;
+static uint8 lzss_flags;
+static uint8 lzss_count;                /* items left of the flag byte */
+static uint16 lzss_dist;
+static uint16 lzss_copy;                /* bytes left of the match */
+
+static uint8 LZSS_Next(void)
+{
+    uint8 b = lzss_in[lzss_tail & LZSS_INPUT_MASK];
+
+    lzss_tail++;
+    return (b);
+}
+
+/*******************************************************************************
+* Function Name: LZSS_Reset
+********************************************************************************
+*
+* Summary:
+*  Drops the input and starts a new stream, header first.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void LZSS_Reset(void)
+{
+    lzss_head = 0u;
+    lzss_tail = 0u;
+    lzss_out = 0u;
+    lzss_header = LZSS_HEADER_SIZE;
+    lzss_error = 0u;
+    lzss_count = 0u;
+    lzss_copy = 0u;
+}
+
+/*******************************************************************************
+* Function Name: LZSS_Space
+********************************************************************************
+*
+* Summary:
+*  Free room of the input buffer.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Bytes LZSS_Put() takes
+*
+*******************************************************************************/
+uint16 LZSS_Space(void)
+{
+    return ((uint16)(LZSS_INPUT_SIZE - (uint16)(lzss_head - lzss_tail)));
+}
+
+/*******************************************************************************
+* Function Name: LZSS_Put
+********************************************************************************
+*
+* Summary:
+*  Adds compressed bytes to the input, all of them or none.
+*
+* Parameters:
+*  data: compressed bytes
+*  len: number of bytes
+*
+* Return:
+*  1 if they were taken, 0 if the input has no room for them
+*
+*******************************************************************************/
+uint8 LZSS_Put(const uint8* data, uint8 len)
+{
+    uint16 head = lzss_head;
+
+    if (len > LZSS_Space())
+    {
+        return (0u);
+    }
+    while (len-- > 0u)
+    {
+        lzss_in[head & LZSS_INPUT_MASK] = *data++;
+        head++;
+    }
+    lzss_head = head;
+    return (1u);
+}
+
+/*******************************************************************************
+* Function Name: LZSS_Get
+********************************************************************************
+*
+* Summary:
+*  Decodes the next byte of the stream.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The byte, LZSS_EMPTY if the input runs out before it, LZSS_ERROR if the
+*  header is not one of a stream this decoder takes
+*
+*******************************************************************************/
+int16 LZSS_Get(void)
+{
+    uint16 avail = (uint16)(lzss_head - lzss_tail);
+    uint8 b;
+    uint8 hi;
+
+    while ((lzss_header > 0u) && !lzss_error)
+    {
+        if (avail == 0u)
+        {
+            return (LZSS_EMPTY);
+        }
+        avail--;
+        b = LZSS_Next();
+        if (lzss_header == LZSS_HEADER_SIZE)
+        {
+            lzss_error = (b != LZSS_MAGIC);
+        }
+        else
+        {
+            lzss_error = (b < 8u) || (b > LZSS_WINDOW_BITS);
+            lzss_len_bits = (uint8)(16u - b);
+        }
+        lzss_header--;
+    }
+    if (lzss_error)
+    {
+        return (LZSS_ERROR);
+    }
+
+    if (lzss_copy == 0u)
+    {
+        if (lzss_count == 0u)
+        {
+            if (avail == 0u)
+            {
+                return (LZSS_EMPTY);
+            }
+            avail--;
+            lzss_flags = LZSS_Next();
+            lzss_count = 8u;
+        }
+        if ((lzss_flags & 1u) == 0u)
+        {
+            if (avail == 0u)
+            {
+                return (LZSS_EMPTY);
+            }
+            lzss_flags >>= 1;
+            lzss_count--;
+            b = LZSS_Next();
+            lzss_window[lzss_out & LZSS_WINDOW_MASK] = b;
+            lzss_out++;
+            return ((int16)b);
+        }
+        if (avail < 2u)
+        {
+            return (LZSS_EMPTY);
+        }
+        lzss_flags >>= 1;
+        lzss_count--;
+        lzss_dist = LZSS_Next();
+        hi = LZSS_Next();
+        lzss_dist = (uint16)((lzss_dist | ((uint16)(hi >> lzss_len_bits) << 8)) + 1u);
+        lzss_copy = (uint16)((hi & ((1u << lzss_len_bits) - 1u)) + LZSS_MIN_MATCH);
+    }
+    b = lzss_window[(uint16)(lzss_out - lzss_dist) & LZSS_WINDOW_MASK];
+    lzss_window[lzss_out & LZSS_WINDOW_MASK] = b;
+    lzss_out++;
+    lzss_copy--;
+    return ((int16)b);
+}
+
+/* [] END OF FILE */
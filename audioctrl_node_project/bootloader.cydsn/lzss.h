@@ -0,0 +1,61 @@
+#ifndef _LZSS_H_
+#define _LZSS_H_
+/*******************************************************************************
+* FILE: lzss.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Streaming LZSS decoder for compressed bootloader images, packed by
+*   tools/lz_pack.py.  A compressed stream is the sequence of bootloader
+*   packets a plain block download would carry, behind a two byte header:
+*   LZSS_MAGIC and the window bits W of the packer.  Every flag byte, least
+*   significant bit first, tells for the eight items after it whether the
+*   item is a literal byte (0) or a match (1) of two bytes:
+*
+*       byte 0      distance - 1, bits 0..7
+*       byte 1      distance - 1, bits 8..W-1 in the top W-8 bits,
+*                   length - LZSS_MIN_MATCH in the 16-W bits below
+*
+*   A match copies from the last 2^W output bytes, across packets.  The
+*   first byte of a plain stream is the packet SOP, so the magic tells the
+*   two apart.
+*
+*   RAM is bounded by the window and the input buffer.  LZSS_Put() takes the
+*   bytes of a download segment from the CAN interrupt, LZSS_Get() hands out
+*   one decoded byte at a time in the main loop, so the decoder can stop on
+*   any byte the command slots cannot take yet.
+*******************************************************************************/
+#include <project.h>
+
+#define LZSS_MAGIC              (0x4Cu)
+#define LZSS_MIN_MATCH          (3u)
+
+/* Largest window of a stream the decoder takes, 8..12 */
+#ifndef LZSS_WINDOW_BITS
+    #define LZSS_WINDOW_BITS    (9u)
+#endif
+/* Compressed bytes received but not decoded, a power of two */
+#ifndef LZSS_INPUT_SIZE
+    #define LZSS_INPUT_SIZE     (256u)
+#endif
+
+/* LZSS_Get() */
+#define LZSS_EMPTY              (-1)    /* needs more input */
+#define LZSS_ERROR              (-2)    /* not a stream this decoder takes */
+
+/* Function prototypes */
+void LZSS_Reset(void);
+uint16 LZSS_Space(void);
+uint8 LZSS_Put(const uint8* data, uint8 len);
+int16 LZSS_Get(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,314 @@
+/*******************************************************************************
+* FILE: mcast.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Multicast download, see mcast.h.  Like sdo_block.c it takes its frames
+* out of the receive mailboxes in the CAN interrupt and sends from the main
+* loop.  A unit goes to the command slots through the block download hooks
+* of bldr_impl.c as it arrives, and is released to the bootloader only once
+* its CRC has matched; a unit dropped halfway leaves nothing behind.
+*******************************************************************************/
+#include <string.h>
+
+#include "mcast.h"
+#include "sdo_block.h"
+
+#define MCAST_COB_TX            (0x580u)
+#define MCAST_SEG_SIZE          (7u)
+#define MCAST_SEQ_MAX           (0x7Fu)
+#define MCAST_STATUS_UNITS      (32u)
+
+#define MCAST_START             (0x81u)
+#define MCAST_UNIT              (0x82u)
+#define MCAST_POLL              (0x83u)
+#define MCAST_STATUS            (0xE4u)   /* scs 7, reserved in SDO */
+
+static uint16 mcast_cob_tx;
+static volatile uint8 mcast_active;
+static uint8 mcast_session;
+static uint16 mcast_units;
+static uint8 mcast_acked[(MCAST_MAX_UNITS + 7u) / 8u];
+static uint8 mcast_queued;              /* units in the slots, no result yet */
+
+static uint16 mcast_unit;               /* unit being received */
+static uint16 mcast_len;
+static uint16 mcast_count;
+static uint16 mcast_crc;
+static uint16 mcast_crc_acc;
+static uint8 mcast_seq;
+
+static volatile uint16 mcast_poll;      /* unit of the pending STATUS */
+static volatile uint8 mcast_poll_session;
+static cyisraddress mcast_can_vector;
+static MCAST_Stats mcast_stats;
+
+static uint8 MCAST_Acked(uint16 unit)
+{
+    return ((mcast_acked[unit >> 3] >> (unit & 7u)) & 1u);
+}
+
+/*** Drops the unit being received, and the command it started ***/
+static void MCAST_Drop(void)
+{
+    if (mcast_unit != MCAST_NO_UNIT)
+    {
+        (void)Program_BlockEnd(0u);
+        mcast_unit = MCAST_NO_UNIT;
+        mcast_stats.dropped++;
+    }
+}
+
+static void MCAST_Unit(const uint8* frame)
+{
+    uint16 unit = (uint16)frame[1] | ((uint16)frame[2] << 8);
+
+    MCAST_Drop();
+    if (!mcast_active || (unit >= mcast_units) || MCAST_Acked(unit))
+    {
+        return;
+    }
+    mcast_len = (uint16)frame[3] | ((uint16)frame[4] << 8);
+    mcast_crc = (uint16)frame[5] | ((uint16)frame[6] << 8);
+    if ((mcast_len == 0u) || (mcast_len > (MCAST_SEQ_MAX * MCAST_SEG_SIZE)))
+    {
+        return;
+    }
+    mcast_unit = unit;
+    mcast_count = 0u;
+    mcast_crc_acc = 0u;
+    mcast_seq = 0u;
+    Program_BlockTag(unit);
+}
+
+static void MCAST_Segment(const uint8* frame)
+{
+    uint8 len;
+
+    if (mcast_unit == MCAST_NO_UNIT)
+    {
+        return;
+    }
+    len = ((mcast_len - mcast_count) < MCAST_SEG_SIZE) ? (uint8)(mcast_len - mcast_count) : MCAST_SEG_SIZE;
+    if ((frame[0] != (uint8)(mcast_seq + 1u)) || (Program_BlockWrite(&frame[1], len) != PROGRAM_BLOCK_OK))
+    {
+        MCAST_Drop();
+        return;
+    }
+    mcast_seq++;
+    mcast_count += len;
+    mcast_crc_acc = SDOB_Crc(mcast_crc_acc, &frame[1], len);
+    if (mcast_count == mcast_len)
+    {
+        if ((mcast_crc_acc != mcast_crc) || (Program_BlockEnd(1u) != PROGRAM_BLOCK_OK))
+        {
+            MCAST_Drop();
+            return;
+        }
+        mcast_unit = MCAST_NO_UNIT;
+        mcast_queued++;
+        mcast_stats.units++;
+    }
+}
+
+static void MCAST_Receive(const uint8* frame)
+{
+    uint16 arg = (uint16)frame[1] | ((uint16)frame[2] << 8);
+
+    switch (frame[0])
+    {
+        case MCAST_START:
+            MCAST_Drop();
+            memset(mcast_acked, 0, sizeof(mcast_acked));
+            mcast_units = arg;
+            mcast_session = frame[3];
+            /* Too many units to track: stay out, so the polls report
+             * nothing acked and the host sends the node everything alone */
+            mcast_active = (arg <= MCAST_MAX_UNITS) ? 1u : 0u;
+            break;
+        case MCAST_UNIT:
+            MCAST_Unit(frame);
+            break;
+        case MCAST_POLL:
+            mcast_poll_session = frame[3];
+            mcast_poll = arg;
+            break;
+        default:
+            if ((frame[0] != 0u) && (frame[0] <= MCAST_SEQ_MAX))
+            {
+                MCAST_Segment(frame);
+            }
+            break;
+    }
+}
+
+/*******************************************************************************
+ * Takes the multicast frames out of the receive mailboxes, then runs the
+ * interrupt of the SDO block server and the stack.
+ *******************************************************************************/
+static CY_ISR(MCAST_CanIsr)
+{
+    uint8 frame[8];
+    uint8 i;
+
+    for (i = 0u; i < CAN_NUMBER_OF_RX_MAILBOXES; i++)
+    {
+        if (((CAN_RX[i].rxcmd & CAN_RX_ACK_MSG) != 0u) && !CAN_GET_RX_IDE(i) && !CAN_GET_RX_RTR(i) &&
+            (CAN_GET_RX_ID(i) == MCAST_COB_RX) && (CAN_GET_DLC(i) == 8u))
+        {
+            frame[0] = CAN_RX_DATA_BYTE1(i);
+            frame[1] = CAN_RX_DATA_BYTE2(i);
+            frame[2] = CAN_RX_DATA_BYTE3(i);
+            frame[3] = CAN_RX_DATA_BYTE4(i);
+            frame[4] = CAN_RX_DATA_BYTE5(i);
+            frame[5] = CAN_RX_DATA_BYTE6(i);
+            frame[6] = CAN_RX_DATA_BYTE7(i);
+            frame[7] = CAN_RX_DATA_BYTE8(i);
+            MCAST_Receive(frame);
+            CAN_RX_ACK_MESSAGE(i);
+        }
+    }
+    mcast_can_vector();
+}
+
+/*******************************************************************************
+* Function Name: MCAST_Start
+********************************************************************************
+*
+* Summary:
+*  Sets the COB-ID of the STATUS answer and hooks the CAN interrupt.  Call it
+*  after the CANopen stack has started.
+*
+* Parameters:
+*  node_id: node-ID of the bootloader
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void MCAST_Start(uint8 node_id)
+{
+    mcast_cob_tx = (uint16)(MCAST_COB_TX + node_id);
+    mcast_active = 0u;
+    mcast_unit = MCAST_NO_UNIT;
+    mcast_poll = MCAST_NO_UNIT;
+    if (CyIntGetVector(CAN_ISR_NUMBER) != MCAST_CanIsr)
+    {
+        mcast_can_vector = CyIntSetVector(CAN_ISR_NUMBER, MCAST_CanIsr);
+    }
+}
+
+/*******************************************************************************
+* Function Name: MCAST_Service
+********************************************************************************
+*
+* Summary:
+*  Answers a POLL.  Call it from the loop waiting for commands.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void MCAST_Service(void)
+{
+    CAN_DATA_BYTES_MSG status;
+    CAN_TX_MSG msg;
+    uint16 unit = mcast_poll;
+    uint32 bits = 0u;
+    uint8 i;
+
+    if (unit == MCAST_NO_UNIT)
+    {
+        return;
+    }
+    /* Not in the session polled: nothing is acked */
+    if (mcast_active && (mcast_poll_session == mcast_session))
+    {
+        while ((unit < mcast_units) && MCAST_Acked(unit))
+        {
+            unit++;
+        }
+        if (unit >= mcast_units)
+        {
+            unit = MCAST_NO_UNIT;
+        }
+        for (i = 0u; (i < MCAST_STATUS_UNITS) && (unit != MCAST_NO_UNIT) && ((unit + i) < mcast_units); i++)
+        {
+            bits |= (uint32)MCAST_Acked((uint16)(unit + i)) << i;
+        }
+    }
+    status.byte[0] = MCAST_STATUS;
+    status.byte[1] = (uint8)unit;
+    status.byte[2] = (uint8)(unit >> 8);
+    status.byte[3] = (uint8)bits;
+    status.byte[4] = (uint8)(bits >> 8);
+    status.byte[5] = (uint8)(bits >> 16);
+    status.byte[6] = (uint8)(bits >> 24);
+    status.byte[7] = mcast_queued;
+
+    msg.id = mcast_cob_tx;
+    msg.rtr = 0u;
+    msg.ide = CAN_STANDARD_MESSAGE;
+    msg.dlc = 8u;
+    msg.irq = 0u;
+    msg.msg = &status;
+    if (CAN_SendMsg(&msg) == CAN_SUCCESS)
+    {
+        mcast_poll = MCAST_NO_UNIT;
+        mcast_stats.polls++;
+    }
+}
+
+/*******************************************************************************
+* Function Name: MCAST_Result
+********************************************************************************
+*
+* Summary:
+*  Acknowledges a unit once the bootloader has carried out its command.
+*  Called by bldr_impl.c, also for a queued unit it flushes.
+*
+* Parameters:
+*  unit: unit of the command
+*  ok: the command succeeded
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void MCAST_Result(uint16 unit, uint8 ok)
+{
+    uint8 intr;
+
+    intr = CyEnterCriticalSection();
+    if (mcast_queued > 0u)
+    {
+        mcast_queued--;
+    }
+    if (ok && (unit < mcast_units))
+    {
+        mcast_acked[unit >> 3] |= (uint8)(1u << (unit & 7u));
+        mcast_stats.acked++;
+    }
+    else
+    {
+        mcast_stats.failed++;
+    }
+    CyExitCriticalSection(intr);
+}
+
+void MCAST_GetStats(MCAST_Stats* stats)
+{
+    *stats = mcast_stats;
+}
+
+/* [] END OF FILE */
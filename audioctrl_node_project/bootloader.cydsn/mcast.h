@@ -0,0 +1,82 @@
+#ifndef _MCAST_H_
+#define _MCAST_H_
+/*******************************************************************************
+* FILE: mcast.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Multicast image download.  The host sends the bootloader packets of an
+*   image once, on MCAST_COB_RX, and every node in the bootloader programs
+*   them at the same time.  Each packet travels as a unit: a UNIT frame with
+*   its number, length and CRC-16/CCITT, then its bytes in numbered
+*   segments of 7.  There is no flow control; a node that misses a segment,
+*   has no free command slot or gets a bad CRC drops the unit.
+*
+*   A unit is acknowledged once the bootloader has carried out its command
+*   without error.  A POLL frame asks every node for its acknowledge bitmap;
+*   the nodes answer on their own SDO response COB-ID, so the bus sorts the
+*   answers by node-ID.  The top three bits of the STATUS command byte
+*   are 7, a command specifier SDO leaves reserved, so an SDO client on
+*   that COB-ID cannot take it for an abort or any other response.  The
+*   host sends the units a node lacks to that node alone, with an SDO
+*   block download, and polls again.
+*
+*       host, MCAST_COB_RX
+*       0x81 START  units (LE16), session      new session, nothing acked
+*       0x82 UNIT   unit, length, CRC (LE16)   the segments of the unit follow
+*       0x01..0x7F  7 bytes                    segment, numbered from 1
+*       0x83 POLL   first unit (LE16), session
+*
+*       node, 0x580 + node-ID
+*       0xE4 STATUS first unit not acked at or after the polled one (LE16,
+*                   0xFFFF if none), acked bits of the 32 units from it
+*                   (LE32, bit 0 first), units with a command still queued
+*
+*   A node that has missed the START of the session polled, or whose START
+*   announced more than MCAST_MAX_UNITS units, answers with the polled unit
+*   and no bit set, so the host sends it all units.  Units
+*   already acknowledged are skipped, so a unit may be sent to all nodes
+*   again.  Multicast units and an SDO block download share the
+*   command slots and must not run at the same time.  The RX mailboxes must
+*   accept MCAST_COB_RX.
+*******************************************************************************/
+#include <project.h>
+
+/* 0x680..0x6DF is left free by the CANopen predefined connection set */
+#ifndef MCAST_COB_RX
+    #define MCAST_COB_RX        (0x680u)
+#endif
+#ifndef MCAST_MAX_UNITS
+    #define MCAST_MAX_UNITS     (1024u)
+#endif
+
+#define MCAST_NO_UNIT           (0xFFFFu)
+
+typedef struct
+{
+    uint32 units;           /* units received whole, CRC good */
+    uint32 dropped;         /* segment missed, no slot or CRC error */
+    uint32 acked;           /* commands carried out */
+    uint32 failed;          /* commands that failed or were flushed */
+    uint32 polls;
+} MCAST_Stats;
+
+/* Function prototypes */
+void MCAST_Start(uint8 node_id);
+void MCAST_Service(void);
+void MCAST_Result(uint16 unit, uint8 ok);
+void MCAST_GetStats(MCAST_Stats* stats);
+
+/* Provided by the bootloader: the unit of the command started next */
+void Program_BlockTag(uint16 unit);
+
+#endif
+
+/* [] END OF FILE */
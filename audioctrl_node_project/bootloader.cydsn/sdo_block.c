@@ -0,0 +1,609 @@
+/*******************************************************************************
+* FILE: sdo_block.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     SDO block transfer server, see sdo_block.h.  The receive side runs in
+* the CAN interrupt and only records the frames; the main loop sends.  Upload
+* segments are queued one at a time, after every transmit mailbox has gone
+* idle, so the mailbox priority of the CAN block cannot reorder them.
+*
+*     A download keeps its last in-order segment back: only the end frame
+* tells how many of its bytes are data.  The segment before it is passed to
+* the bootloader when the next one arrives, and the CRC runs over the bytes
+* as they are passed on.
+*******************************************************************************/
+#include <string.h>
+
+#include "sdo_block.h"
+#include "timer.h"
+
+#define SDOB_COB_RX             (0x600u)
+#define SDOB_COB_TX             (0x580u)
+#define SDOB_SEG_SIZE           (7u)
+#define SDOB_BLKSIZE_MAX        (127u)
+
+/* Command specifiers, top three bits of the first byte */
+#define SDOB_CS_UPLOAD          (5u)    /* client block upload, server block download */
+#define SDOB_CS_DOWNLOAD        (6u)    /* client block download, server block upload */
+#define SDOB_CS_ABORT           (4u)
+
+#define SDOB_CRC_SUPPORT        (0x04u)
+#define SDOB_SIZE_INDICATED     (0x02u)
+#define SDOB_LAST_SEGMENT       (0x80u)
+
+/* Abort codes */
+#define SDOB_ABORT_TIMEOUT      (0x05040000u)
+#define SDOB_ABORT_COMMAND      (0x05040001u)
+#define SDOB_ABORT_BLKSIZE      (0x05040002u)
+#define SDOB_ABORT_SEQNO        (0x05040003u)
+#define SDOB_ABORT_CRC          (0x05040004u)
+#define SDOB_ABORT_MEMORY       (0x05040005u)
+#define SDOB_ABORT_LENGTH       (0x06070010u)
+#define SDOB_ABORT_TOO_LONG     (0x06070012u)
+#define SDOB_ABORT_STORE        (0x08000020u)
+#define SDOB_ABORT_STATE        (0x08000022u)
+
+typedef enum
+{
+    SDOB_IDLE,
+    SDOB_DL_BLOCK,          /* receiving segments */
+    SDOB_DL_END,            /* last segment acknowledged, end with CRC due */
+    SDOB_UL_INIT,           /* size sent, waiting for the start */
+    SDOB_UL_BLOCK,          /* sending segments */
+    SDOB_UL_ACK,            /* block sent, waiting for its acknowledge */
+    SDOB_UL_END             /* end with CRC sent */
+} SDOB_State;
+
+static volatile SDOB_State sdob_state;
+static uint16 sdob_cob_rx;
+static uint16 sdob_cob_tx;
+static uint32 sdob_ticks;               /* last frame of the transfer */
+
+static const uint8* sdob_data;
+static uint32 sdob_size;                /* indicated size, 0 if none */
+static uint32 sdob_total;               /* bytes passed to the bootloader */
+static uint16 sdob_crc_acc;             /* CRC of those bytes */
+static uint16 sdob_len;                 /* upload size */
+static uint16 sdob_pos;                 /* bytes of the acknowledged segments */
+static uint8 sdob_seq;                  /* segments in order in this block */
+static uint8 sdob_blksize;
+static uint8 sdob_crc;                  /* the host checks the CRC as well */
+static uint8 sdob_last;                 /* last segment received in order */
+static uint8 sdob_hold[SDOB_SEG_SIZE];  /* last segment, not passed on yet */
+static uint8 sdob_held;
+static uint8 sdob_ack_wait;             /* block acknowledge waits for space */
+static uint8 sdob_end_wait;             /* end frame waits for space */
+static uint8 sdob_end[8];
+
+static CAN_DATA_BYTES_MSG sdob_tx;
+static uint8 sdob_tx_pending;
+static cyisraddress sdob_can_vector;
+static SDOB_Stats sdob_stats;
+
+/* CRC-16/CCITT as CiA 301 specifies it: polynomial 0x1021, start 0 */
+static const uint16 sdob_crc_nibble[16] =
+{
+    0x0000u, 0x1021u, 0x2042u, 0x3063u, 0x4084u, 0x50A5u, 0x60C6u, 0x70E7u,
+    0x8108u, 0x9129u, 0xA14Au, 0xB16Bu, 0xC18Cu, 0xD1ADu, 0xE1CEu, 0xF1EFu
+};
+
+uint16 SDOB_Crc(uint16 crc, const uint8* data, uint16 len)
+{
+    while (len-- > 0u)
+    {
+        crc = (uint16)((crc << 4) ^ sdob_crc_nibble[(crc >> 12) ^ (*data >> 4)]);
+        crc = (uint16)((crc << 4) ^ sdob_crc_nibble[(crc >> 12) ^ (*data & 0x0Fu)]);
+        data++;
+    }
+    return (crc);
+}
+
+/*** Starts the next response; bytes 1..3 carry the object ***/
+static void SDOB_Reply(uint8 command)
+{
+    memset(&sdob_tx, 0, sizeof(sdob_tx));
+    sdob_tx.byte[0] = command;
+    sdob_tx.byte[1] = (uint8)SDOB_INDEX;
+    sdob_tx.byte[2] = (uint8)(SDOB_INDEX >> 8);
+    sdob_tx.byte[3] = SDOB_SUBINDEX;
+    sdob_tx_pending = 1u;
+}
+
+static void SDOB_PutLong(uint8* dest, uint32 value)
+{
+    dest[0] = (uint8)value;
+    dest[1] = (uint8)(value >> 8);
+    dest[2] = (uint8)(value >> 16);
+    dest[3] = (uint8)(value >> 24);
+}
+
+/*** Ends the transfer; a download drops the command it left unfinished ***/
+static void SDOB_Reset(void)
+{
+    if ((sdob_state == SDOB_DL_BLOCK) || (sdob_state == SDOB_DL_END))
+    {
+        (void)Program_BlockEnd(0u);
+    }
+    sdob_state = SDOB_IDLE;
+    sdob_ack_wait = 0u;
+    sdob_end_wait = 0u;
+}
+
+static void SDOB_Abort(uint32 code)
+{
+    SDOB_Reply((uint8)(SDOB_CS_ABORT << 5));
+    SDOB_PutLong(&sdob_tx.byte[4], code);
+    SDOB_Reset();
+    sdob_stats.aborts++;
+}
+
+/*** Segments the bootloader can take after the held one, 0 if none ***/
+static uint8 SDOB_NextBlock(void)
+{
+    uint16 space = Program_BlockSpace();
+    uint16 segments;
+
+    if (sdob_held)
+    {
+        space = (space > SDOB_SEG_SIZE) ? (uint16)(space - SDOB_SEG_SIZE) : 0u;
+    }
+    segments = space / SDOB_SEG_SIZE;
+    return ((segments > SDOB_BLKSIZE) ? SDOB_BLKSIZE : (uint8)segments);
+}
+
+/*** Passes the held segment, or the data bytes of it, on to the bootloader ***/
+static uint8 SDOB_Forward(uint8 len)
+{
+    uint8 result = PROGRAM_BLOCK_OK;
+
+    if (sdob_held)
+    {
+        result = Program_BlockWrite(sdob_hold, len);
+        if (result == PROGRAM_BLOCK_OK)
+        {
+            sdob_crc_acc = SDOB_Crc(sdob_crc_acc, sdob_hold, len);
+            sdob_total += len;
+            sdob_held = 0u;
+        }
+    }
+    return (result);
+}
+
+/*******************************************************************************
+ * Block download
+ *******************************************************************************/
+static void SDOB_DownloadInit(const uint8* frame)
+{
+    sdob_held = 0u;
+    sdob_blksize = SDOB_NextBlock();
+    if (sdob_blksize == 0u)
+    {
+        SDOB_Abort(SDOB_ABORT_STATE);
+        return;
+    }
+    sdob_size = 0u;
+    if (frame[0] & SDOB_SIZE_INDICATED)
+    {
+        sdob_size = (uint32)frame[4] | ((uint32)frame[5] << 8) | ((uint32)frame[6] << 16) | ((uint32)frame[7] << 24);
+    }
+    sdob_crc = (frame[0] & SDOB_CRC_SUPPORT) ? 1u : 0u;
+    sdob_crc_acc = 0u;
+    sdob_total = 0u;
+    sdob_seq = 0u;
+    sdob_last = 0u;
+    sdob_ack_wait = 0u;
+    sdob_end_wait = 0u;
+    SDOB_Reply((uint8)((SDOB_CS_UPLOAD << 5) | SDOB_CRC_SUPPORT));
+    sdob_tx.byte[4] = sdob_blksize;
+    sdob_state = SDOB_DL_BLOCK;
+}
+
+/*******************************************************************************
+ * Acknowledges the block with the last in-order sequence number.  With both
+ * command slots taken it waits, and SDOB_Service() sends it once
+ * CyBtldrCommRead() has freed one; the host holds the next block until then.
+ *******************************************************************************/
+static void SDOB_BlockAck(void)
+{
+    uint8 blksize = SDOB_NextBlock();
+
+    sdob_ack_wait = (blksize == 0u) ? 1u : 0u;
+    if (sdob_ack_wait)
+    {
+        return;
+    }
+    SDOB_Reply((uint8)((SDOB_CS_UPLOAD << 5) | 2u));
+    sdob_tx.byte[1] = sdob_seq;
+    sdob_tx.byte[2] = blksize;
+    sdob_tx.byte[3] = 0u;
+    sdob_seq = 0u;
+    sdob_blksize = blksize;
+    if (sdob_last)
+    {
+        sdob_state = SDOB_DL_END;
+    }
+}
+
+/*******************************************************************************
+ * A segment is kept only if it follows the last one in order and the
+ * bootloader has taken the one before; the host repeats the rest of the
+ * block after the acknowledge.
+ *******************************************************************************/
+static void SDOB_Segment(const uint8* frame)
+{
+    uint8 seqno = frame[0] & (uint8)~SDOB_LAST_SEGMENT;
+    uint8 result;
+
+    if ((seqno == (uint8)(sdob_seq + 1u)) && !sdob_last && !sdob_ack_wait)
+    {
+        result = SDOB_Forward(SDOB_SEG_SIZE);
+        if (result == PROGRAM_BLOCK_ERROR)
+        {
+            SDOB_Abort(SDOB_ABORT_STORE);
+            return;
+        }
+        if (result == PROGRAM_BLOCK_OK)
+        {
+            memcpy(sdob_hold, &frame[1], SDOB_SEG_SIZE);
+            sdob_held = 1u;
+            sdob_seq = seqno;
+            sdob_last = (frame[0] & SDOB_LAST_SEGMENT) ? 1u : 0u;
+        }
+        else
+        {
+            sdob_stats.stalls++;
+        }
+    }
+    if (((seqno >= sdob_blksize) || (frame[0] & SDOB_LAST_SEGMENT)) && !sdob_ack_wait)
+    {
+        if (sdob_seq < seqno)
+        {
+            sdob_stats.retries++;
+        }
+        SDOB_BlockAck();
+    }
+}
+
+static void SDOB_DownloadEnd(const uint8* frame)
+{
+    uint8 unused = (frame[0] >> 2) & 0x07u;
+    uint8 result = SDOB_Forward((uint8)(SDOB_SEG_SIZE - unused));
+
+    sdob_end_wait = (result == PROGRAM_BLOCK_BUSY) ? 1u : 0u;
+    if (sdob_end_wait)
+    {
+        memcpy(sdob_end, frame, sizeof(sdob_end));
+    }
+    else if (result == PROGRAM_BLOCK_ERROR)
+    {
+        SDOB_Abort(SDOB_ABORT_STORE);
+    }
+    else if ((sdob_size != 0u) && (sdob_total != sdob_size))
+    {
+        SDOB_Abort(SDOB_ABORT_LENGTH);
+    }
+    else if (sdob_crc && (sdob_crc_acc != ((uint16)frame[1] | ((uint16)frame[2] << 8))))
+    {
+        sdob_stats.crc_errors++;
+        SDOB_Abort(SDOB_ABORT_CRC);
+    }
+    else if (Program_BlockEnd(1u) != PROGRAM_BLOCK_OK)
+    {
+        /* The data stops inside a command */
+        SDOB_Abort(SDOB_ABORT_LENGTH);
+    }
+    else
+    {
+        SDOB_Reply((uint8)((SDOB_CS_UPLOAD << 5) | 1u));
+        sdob_state = SDOB_IDLE;
+        sdob_stats.downloads++;
+    }
+}
+
+/*******************************************************************************
+ * Block upload
+ *******************************************************************************/
+static void SDOB_UploadInit(const uint8* frame)
+{
+    if ((frame[4] == 0u) || (frame[4] > SDOB_BLKSIZE_MAX))
+    {
+        SDOB_Abort(SDOB_ABORT_BLKSIZE);
+        return;
+    }
+    sdob_blksize = frame[4];
+    sdob_crc = (frame[0] & SDOB_CRC_SUPPORT) ? 1u : 0u;
+    sdob_len = Program_BlockResponse(&sdob_data);
+    SDOB_Reply((uint8)((SDOB_CS_DOWNLOAD << 5) | SDOB_CRC_SUPPORT | SDOB_SIZE_INDICATED));
+    SDOB_PutLong(&sdob_tx.byte[4], sdob_len);
+    sdob_state = SDOB_UL_INIT;
+}
+
+static void SDOB_UploadAck(const uint8* frame)
+{
+    uint16 segments = (sdob_len == 0u) ? 1u : (uint16)((sdob_len + SDOB_SEG_SIZE - 1u) / SDOB_SEG_SIZE);
+    uint16 acked;
+
+    if (frame[1] > sdob_seq)
+    {
+        SDOB_Abort(SDOB_ABORT_SEQNO);
+        return;
+    }
+    if ((frame[2] == 0u) || (frame[2] > SDOB_BLKSIZE_MAX))
+    {
+        SDOB_Abort(SDOB_ABORT_BLKSIZE);
+        return;
+    }
+    if (frame[1] < sdob_seq)
+    {
+        sdob_stats.retries++;
+    }
+    acked = (uint16)(sdob_pos / SDOB_SEG_SIZE + frame[1]);
+    if (acked >= segments)
+    {
+        SDOB_Reply((uint8)((SDOB_CS_DOWNLOAD << 5) | ((segments * SDOB_SEG_SIZE - sdob_len) << 2) | 1u));
+        if (sdob_crc)
+        {
+            uint16 crc = SDOB_Crc(0u, sdob_data, sdob_len);
+
+            sdob_tx.byte[1] = (uint8)crc;
+            sdob_tx.byte[2] = (uint8)(crc >> 8);
+        }
+        else
+        {
+            sdob_tx.byte[1] = 0u;
+            sdob_tx.byte[2] = 0u;
+        }
+        sdob_tx.byte[3] = 0u;
+        sdob_state = SDOB_UL_END;
+        return;
+    }
+    sdob_pos = (uint16)(acked * SDOB_SEG_SIZE);
+    sdob_seq = 0u;
+    sdob_blksize = frame[2];
+    sdob_state = SDOB_UL_BLOCK;
+}
+
+/*******************************************************************************
+ * Takes a frame of the server SDO.  Returns 1 if it belongs to a block
+ * transfer, 0 if the stack is to handle it.
+ *******************************************************************************/
+static uint8 SDOB_Receive(const uint8* frame)
+{
+    uint8 cs = frame[0] >> 5;
+    uint8 ours = (((uint16)frame[1] | ((uint16)frame[2] << 8)) == SDOB_INDEX) && (frame[3] == SDOB_SUBINDEX);
+
+    /* A segment with the last flag looks like an abort, seqno 0 does not exist */
+    if ((cs == SDOB_CS_ABORT) && ((sdob_state != SDOB_DL_BLOCK) || (frame[0] == (uint8)(SDOB_CS_ABORT << 5))))
+    {
+        if ((sdob_state == SDOB_IDLE) || !ours)
+        {
+            return (0u);
+        }
+        SDOB_Reset();
+        sdob_stats.aborts++;
+        return (1u);
+    }
+    sdob_ticks = SysTick_GetTicks();
+    if (sdob_state == SDOB_DL_BLOCK)
+    {
+        SDOB_Segment(frame);
+    }
+    else if ((cs == SDOB_CS_DOWNLOAD) && ((frame[0] & 1u) == 0u) && ours)
+    {
+        SDOB_DownloadInit(frame);
+    }
+    else if ((cs == SDOB_CS_DOWNLOAD) && (sdob_state == SDOB_DL_END) && (frame[0] & 1u) && !sdob_end_wait)
+    {
+        SDOB_DownloadEnd(frame);
+    }
+    else if ((cs == SDOB_CS_UPLOAD) && ((frame[0] & 3u) == 0u) && ours)
+    {
+        SDOB_UploadInit(frame);
+    }
+    else if ((cs == SDOB_CS_UPLOAD) && (sdob_state == SDOB_UL_INIT) && ((frame[0] & 3u) == 3u))
+    {
+        sdob_pos = 0u;
+        sdob_seq = 0u;
+        sdob_state = SDOB_UL_BLOCK;
+    }
+    else if ((cs == SDOB_CS_UPLOAD) && (sdob_state == SDOB_UL_ACK) && ((frame[0] & 3u) == 2u))
+    {
+        SDOB_UploadAck(frame);
+    }
+    else if ((cs == SDOB_CS_UPLOAD) && (sdob_state == SDOB_UL_END) && ((frame[0] & 3u) == 1u))
+    {
+        sdob_state = SDOB_IDLE;
+        sdob_stats.uploads++;
+    }
+    else if (sdob_state != SDOB_IDLE)
+    {
+        SDOB_Abort(SDOB_ABORT_COMMAND);
+    }
+    else
+    {
+        return (0u);
+    }
+    return (1u);
+}
+
+/*******************************************************************************
+ * Takes the frames of the server SDO that belong to a block transfer out of
+ * the receive mailboxes, then runs the interrupt of the stack.
+ *******************************************************************************/
+static CY_ISR(SDOB_CanIsr)
+{
+    uint8 frame[8];
+    uint8 i;
+
+    for (i = 0u; i < CAN_NUMBER_OF_RX_MAILBOXES; i++)
+    {
+        if (((CAN_RX[i].rxcmd & CAN_RX_ACK_MSG) != 0u) && !CAN_GET_RX_IDE(i) && !CAN_GET_RX_RTR(i) &&
+            (CAN_GET_RX_ID(i) == sdob_cob_rx) && (CAN_GET_DLC(i) == 8u))
+        {
+            frame[0] = CAN_RX_DATA_BYTE1(i);
+            frame[1] = CAN_RX_DATA_BYTE2(i);
+            frame[2] = CAN_RX_DATA_BYTE3(i);
+            frame[3] = CAN_RX_DATA_BYTE4(i);
+            frame[4] = CAN_RX_DATA_BYTE5(i);
+            frame[5] = CAN_RX_DATA_BYTE6(i);
+            frame[6] = CAN_RX_DATA_BYTE7(i);
+            frame[7] = CAN_RX_DATA_BYTE8(i);
+            if (SDOB_Receive(frame))
+            {
+                CAN_RX_ACK_MESSAGE(i);
+            }
+        }
+    }
+    sdob_can_vector();
+}
+
+/*** No transmit mailbox holds a frame that has not gone out yet ***/
+static uint8 SDOB_TxIdle(void)
+{
+    uint8 i;
+
+    for (i = 0u; i < CAN_NUMBER_OF_TX_MAILBOXES; i++)
+    {
+        if ((CAN_TX[i].txcmd & CAN_TX_REQUEST_PENDING) != 0u)
+        {
+            return (0u);
+        }
+    }
+    return (1u);
+}
+
+static uint8 SDOB_Send(CAN_DATA_BYTES_MSG* data)
+{
+    CAN_TX_MSG msg;
+
+    msg.id = sdob_cob_tx;
+    msg.rtr = 0u;
+    msg.ide = CAN_STANDARD_MESSAGE;
+    msg.dlc = 8u;
+    msg.irq = 0u;
+    msg.msg = data;
+    return (CAN_SendMsg(&msg) == CAN_SUCCESS);
+}
+
+/*******************************************************************************
+* Function Name: SDOB_Start
+********************************************************************************
+*
+* Summary:
+*  Sets the COB-IDs of the default server SDO and hooks the CAN interrupt.
+*  Call it after the CANopen stack has started.
+*
+* Parameters:
+*  node_id: node-ID of the bootloader
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void SDOB_Start(uint8 node_id)
+{
+    sdob_cob_rx = (uint16)(SDOB_COB_RX + node_id);
+    sdob_cob_tx = (uint16)(SDOB_COB_TX + node_id);
+    sdob_state = SDOB_IDLE;
+    sdob_tx_pending = 0u;
+    if (CyIntGetVector(CAN_ISR_NUMBER) != SDOB_CanIsr)
+    {
+        sdob_can_vector = CyIntSetVector(CAN_ISR_NUMBER, SDOB_CanIsr);
+    }
+}
+
+/*******************************************************************************
+* Function Name: SDOB_Service
+********************************************************************************
+*
+* Summary:
+*  Sends the pending response or the next upload segment and aborts a
+*  transfer the host has left.  Call it from the loop waiting for commands.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void SDOB_Service(void)
+{
+    CAN_DATA_BYTES_MSG seg;
+    uint16 at;
+    uint8 intr;
+
+    intr = CyEnterCriticalSection();
+    if ((sdob_state != SDOB_IDLE) && ((SysTick_GetTicks() - sdob_ticks) >= SDOB_TIMEOUT_MS))
+    {
+        SDOB_Abort(SDOB_ABORT_TIMEOUT);
+    }
+    if (sdob_end_wait)
+    {
+        SDOB_DownloadEnd(sdob_end);
+    }
+    else if (sdob_ack_wait)
+    {
+        SDOB_BlockAck();
+    }
+    if (sdob_tx_pending)
+    {
+        if (SDOB_Send(&sdob_tx))
+        {
+            sdob_tx_pending = 0u;
+        }
+    }
+    else if ((sdob_state == SDOB_UL_BLOCK) && SDOB_TxIdle())
+    {
+        at = (uint16)(sdob_pos + sdob_seq * SDOB_SEG_SIZE);
+        memset(&seg, 0, sizeof(seg));
+        seg.byte[0] = (uint8)(sdob_seq + 1u);
+        if ((at + SDOB_SEG_SIZE) >= sdob_len)
+        {
+            seg.byte[0] |= SDOB_LAST_SEGMENT;
+        }
+        if (at < sdob_len)
+        {
+            memcpy(&seg.byte[1], &sdob_data[at], ((sdob_len - at) < SDOB_SEG_SIZE) ? (sdob_len - at) : SDOB_SEG_SIZE);
+        }
+        if (SDOB_Send(&seg))
+        {
+            sdob_seq++;
+            if ((seg.byte[0] & SDOB_LAST_SEGMENT) || (sdob_seq >= sdob_blksize))
+            {
+                sdob_state = SDOB_UL_ACK;
+            }
+        }
+    }
+    CyExitCriticalSection(intr);
+}
+
+/*******************************************************************************
+ * Aborts a running download, for a command of it that failed.
+ *******************************************************************************/
+void SDOB_Cancel(void)
+{
+    uint8 intr;
+
+    intr = CyEnterCriticalSection();
+    if ((sdob_state == SDOB_DL_BLOCK) || (sdob_state == SDOB_DL_END))
+    {
+        SDOB_Abort(SDOB_ABORT_STORE);
+    }
+    CyExitCriticalSection(intr);
+}
+
+void SDOB_GetStats(SDOB_Stats* stats)
+{
+    *stats = sdob_stats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,92 @@
+#ifndef _SDO_BLOCK_H_
+#define _SDO_BLOCK_H_
+/*******************************************************************************
+* FILE: sdo_block.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   CiA 301 SDO block transfer for the program data object (0x1F50 sub 1).
+*   The CANopen bootloader stack only serves segmented SDO, where every
+*   7 bytes cost a request, a response and two turnarounds of the host.  In
+*   block mode the host streams up to SDOB_BLKSIZE segments back to back and
+*   the node confirms the whole block with one frame; the transfer ends with
+*   a CRC-16/CCITT over the data.
+*
+*   The stack owns the CAN interrupt, so SDOB_Start() moves its vector behind
+*   a wrapper once the stack has installed it.  The wrapper takes the block
+*   requests of the program data object, and every frame of the server SDO
+*   while a block transfer runs, out of the receive mailboxes before the
+*   stack sees them; anything else is left to the stack.  Responses and
+*   upload segments are sent by SDOB_Service() from the main loop, so the
+*   CAN_SendMsg() calls of the stack and of this module never nest.
+*
+*   A download carries one bootloader command or a stream of them.  The
+*   bytes go to Program_BlockWrite(), which cuts them into commands by their
+*   length field; a command is handed to the bootloader once the first byte
+*   of the next one has arrived, and the last one only after the CRC of the
+*   whole transfer has matched.  Each command is still covered by its own
+*   packet checksum.  While a row is written the next command streams into
+*   the other command slot, as far as the block size the node offered lets
+*   the host run ahead; a write holds the CPU, so the frames that arrive
+*   meanwhile wait in the receive mailboxes.  SDOB_BLKSIZE should therefore
+*   not exceed the mailboxes open to the server SDO.  A command that fails
+*   ends the stream with an abort, SDOB_Cancel(), and its response is kept
+*   for the host to read.  The stream may also come LZSS compressed, see
+*   lzss.h; the block size then follows the room of the decoder input.
+*
+*   Program_BlockSpace(), Program_BlockWrite() and Program_BlockEnd() feed
+*   the command slots, Program_BlockResponse() gives the response for a
+*   block upload.  They live in bldr_impl.c next to Program_ObjReceive().
+*******************************************************************************/
+#include <project.h>
+
+#define SDOB_INDEX              (0x1F50u)
+#define SDOB_SUBINDEX           (1u)
+
+/* Segments per block offered to the host, 1..127 */
+#ifndef SDOB_BLKSIZE
+    #define SDOB_BLKSIZE        (16u)
+#endif
+/* A transfer without a frame for this long is aborted */
+#ifndef SDOB_TIMEOUT_MS
+    #define SDOB_TIMEOUT_MS     (1000u)
+#endif
+
+typedef struct
+{
+    uint32 downloads;       /* transfers received and CRC checked */
+    uint32 uploads;         /* responses sent */
+    uint32 crc_errors;
+    uint32 retries;         /* blocks acknowledged short of a sequence gap */
+    uint32 stalls;          /* segments refused, both command slots taken */
+    uint32 aborts;          /* transfers aborted by either side */
+} SDOB_Stats;
+
+/* Function prototypes */
+void SDOB_Start(uint8 node_id);
+void SDOB_Service(void);
+void SDOB_Cancel(void);
+void SDOB_GetStats(SDOB_Stats* stats);
+uint16 SDOB_Crc(uint16 crc, const uint8* data, uint16 len);
+
+/* Program_BlockWrite(), Program_BlockEnd() */
+#define PROGRAM_BLOCK_OK        (0u)
+#define PROGRAM_BLOCK_BUSY      (1u)    /* no free command slot, nothing taken */
+#define PROGRAM_BLOCK_ERROR     (2u)    /* not a bootloader packet, or too long */
+
+/* Provided by the bootloader */
+uint16 Program_BlockSpace(void);
+uint8 Program_BlockWrite(const uint8* data, uint8 len);
+uint8 Program_BlockEnd(uint8 commit);
+uint16 Program_BlockResponse(const uint8** data);
+
+#endif
+
+/* [] END OF FILE */
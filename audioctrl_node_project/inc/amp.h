@@ -0,0 +1,82 @@
+#ifndef _AMP_H_
+#define _AMP_H_
+/*******************************************************************************
+* FILE: amp.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   RAM shadow of the amplifier register map.  AMP_Write() only updates the
+*   shadow and marks the register dirty when its value changes, or when it
+*   is not known yet.  AMP_Flush(), called from the main loop, sends each
+*   run of dirty registers as one auto-increment burst through i2cq.  It
+*   waits until the bursts of the previous flush are done, so a register
+*   written many times while the bus is busy goes out once, with its last
+*   value.  Short clean gaps inside a run are sent again instead of starting
+*   a new transaction.
+*
+*   AMP_Refresh() reads registers back into the shadow.  In verify mode each
+*   burst is read back after it is written, and registers that do not match
+*   are marked dirty again.
+*******************************************************************************/
+#include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+
+#define AMP_I2C_ADDR            (0x20u)
+#define AMP_REG_COUNT           (256u)
+
+/* Largest clean gap merged into a burst.  A new transaction costs start,
+ * address and register pointer, so gaps up to two bytes are cheaper to
+ * resend. */
+#ifndef AMP_GAP_MAX
+    #define AMP_GAP_MAX         (2u)
+#endif
+#ifndef AMP_VERIFY
+    #define AMP_VERIFY          (0u)
+#endif
+/* Wait after a failed burst.  After AMP_RETRIES failures in a row the
+ * amplifier counts as offline and is tried every AMP_OFFLINE_MS, with the
+ * dirty registers kept, until a burst goes through. */
+#ifndef AMP_RETRY_MS
+    #define AMP_RETRY_MS        (10u)
+#endif
+#ifndef AMP_RETRIES
+    #define AMP_RETRIES         (3u)
+#endif
+#ifndef AMP_OFFLINE_MS
+    #define AMP_OFFLINE_MS      (1000u)
+#endif
+
+typedef struct
+{
+    uint32 writes;          /* AMP_Write() calls */
+    uint32 unchanged;       /* of which left the register clean */
+    uint32 bursts;          /* write transactions queued */
+    uint32 bytes;           /* register bytes in those */
+    uint32 write_errors;    /* bursts that failed and were marked dirty again */
+    uint32 verify_errors;   /* registers that read back wrong */
+    uint8 offline;          /* AMP_RETRIES bursts in a row failed */
+} AMP_Stats;
+
+/* Function prototypes */
+void AMP_Start(void);
+void AMP_Write(uint8 reg, uint8 value);
+uint8 AMP_Read(uint8 reg);
+void AMP_Invalidate(uint8 reg);
+uint8 AMP_Dirty(void);
+void AMP_Flush(void);
+uint8 AMP_Refresh(uint8 first, uint16 count);
+void AMP_SetVerify(uint8 enable);
+void AMP_GetStats(AMP_Stats* stats);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,33 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+/*******************************************************************************
+* FILE: bench.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   On-target micro benchmarks, run with the BENCH serial command.  Cycle
+*   counts come from SysTick_GetCycles64() with the cost of the measurement
+*   itself taken off; results are printed as OK lines.
+*******************************************************************************/
+#include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+
+#ifndef BENCH_ENABLE
+    #define BENCH_ENABLE        0
+#endif
+
+/* Function prototypes */
+void BENCH_Command(uint8 argc, char* argv[]);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,61 @@
+#ifndef _EE24_H_
+#define _EE24_H_
+/*******************************************************************************
+* FILE: ee24.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   24AA256 EEPROM driver on top of i2cq.  A read is one sequential read
+*   transaction of any length.  A write is split at the 64 byte page
+*   boundaries, the device would otherwise wrap inside the page; after each
+*   page the device is polled with address-only probes until it
+*   acknowledges, which ends its write cycle, instead of waiting the worst
+*   case 5 ms.  The done callback runs once the whole write is in the array.
+*
+*   One operation runs at a time; the caller's buffer must stay valid until
+*   it is done.  EE24_Wait() turns an operation into a blocking call; it
+*   runs the timer wheel while it waits, so timer callbacks run inside it.
+*******************************************************************************/
+#include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+
+#define EE24_I2C_ADDR           (0x50u)
+#define EE24_SIZE               (32768u)
+#define EE24_PAGE_SIZE          (64u)
+
+/* Datasheet maximum of the internal write cycle */
+#define EE24_WRITE_CYCLE_US     (5000u)
+
+/* Longest write cycle waited for */
+#ifndef EE24_POLL_MS
+    #define EE24_POLL_MS        (10u)
+#endif
+
+/* Results */
+#define EE24_OK                 (0u)
+#define EE24_ERR_BUSY           (1u)    /* another operation is running */
+#define EE24_ERR_RANGE          (2u)
+#define EE24_ERR_I2C            (3u)    /* transfer failed after i2cq retries */
+#define EE24_ERR_TIMEOUT        (4u)    /* write cycle did not end */
+
+/* Completion, runs in main loop context */
+typedef void (*EE24_DoneFn)(void* context, uint8 result);
+
+/* Function prototypes */
+uint8 EE24_Read(uint16 address, uint8* buffer, uint16 size, EE24_DoneFn done, void* context);
+uint8 EE24_Write(uint16 address, const uint8* buffer, uint16 size, EE24_DoneFn done, void* context);
+uint8 EE24_Busy(void);
+uint8 EE24_Wait(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,40 @@
+#ifndef _FMT_H_
+#define _FMT_H_
+/*******************************************************************************
+* FILE: fmt.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Small reentrant printf engine for the Cortex-M0, which has no divide
+*   instruction.  Decimal digits come from a shift-and-add divide by 10 and
+*   hex digits from shifts, so no __aeabi_uidivmod call is made.  Output goes
+*   to a caller buffer or, in chunks, to a sink function.
+*
+*   Supported: %d %i %u %x %X %o %c %s %p %%, flags '-' '0' '+' ' ' '#', width
+*   and precision (also '*'), length modifiers h hh l ll (ll is formatted from
+*   the full 64 bit value).
+*******************************************************************************/
+#include <stdarg.h>
+#include <project.h>
+
+/* Receives formatted output, length is never 0 */
+typedef void (*FMT_SinkFn)(void* context, const char* data, uint16 length);
+
+/* Function prototypes */
+int FMT_VFormat(FMT_SinkFn sink, void* context, const char* format, va_list args);
+int FMT_Format(FMT_SinkFn sink, void* context, const char* format, ...);
+int FMT_VSnprintf(char* buffer, uint16 size, const char* format, va_list args);
+int FMT_Snprintf(char* buffer, uint16 size, const char* format, ...);
+uint32 FMT_DivU10(uint32 n);
+uint8 FMT_U32ToDec(uint32 value, char* out);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,110 @@
+#ifndef _I2CQ_H_
+#define _I2CQ_H_
+/*******************************************************************************
+* FILE: i2cq.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Queued I2C master transactions.  I2CQ_Write() and I2CQ_Read() copy the
+*   request into a ring and return at once; the bytes are moved by the SCBM
+*   interrupt in buffer mode and I2CQ_Service(), called from the main loop,
+*   starts the next phase or transaction when the block reports completion.
+*   The SCBM interrupt calls SysTick_Wake(), so a tickless SysTick_Idle()
+*   does not sleep through a completion.
+*
+*   A transaction is register addressed: reg_size (0..2) bytes of register
+*   address, most significant first, then the data.  A read sends the
+*   address without a stop and reads after a repeated start.  I2CQ_Write()
+*   and I2CQ_Read() copy up to I2CQ_DATA_MAX bytes through the queue entry;
+*   I2CQ_WriteBuf() and I2CQ_ReadBuf() use the caller's buffer for
+*   transfers of any length, and I2CQ_Probe() only checks for an ACK.
+*
+*   Except for probes, an address NAK or bus error is retried up to
+*   I2CQ_RETRIES times after I2CQ_RETRY_MS, so an EEPROM busy with its write
+*   cycle is simply waited for.  A transaction that does not finish within
+*   I2CQ_TIMEOUT_MS, plus a millisecond per 2^I2CQ_BYTES_PER_MS_SHIFT bytes,
+*   resets the block and counts as a timeout.  The done callback then runs
+*   from I2CQ_Service() with the result and, for reads, the data.
+*
+*   The blocking i2c_psoc calls use the same block and must not be mixed with
+*   queued work that is still in flight, see I2CQ_Flush().
+*******************************************************************************/
+#include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+
+/* Queue depth, a power of two */
+#ifndef I2CQ_DEPTH
+    #define I2CQ_DEPTH          (8u)
+#endif
+/* Largest data part of one transaction */
+#ifndef I2CQ_DATA_MAX
+    #define I2CQ_DATA_MAX       (16u)
+#endif
+#ifndef I2CQ_RETRIES
+    #define I2CQ_RETRIES        (3u)
+#endif
+#ifndef I2CQ_RETRY_MS
+    #define I2CQ_RETRY_MS       (2u)
+#endif
+#ifndef I2CQ_TIMEOUT_MS
+    #define I2CQ_TIMEOUT_MS     (10u)
+#endif
+/* Bus time allowed for long transfers, 8 bytes per ms holds down to 100 kHz */
+#ifndef I2CQ_BYTES_PER_MS_SHIFT
+    #define I2CQ_BYTES_PER_MS_SHIFT (3u)
+#endif
+
+/* Results, passed to the done callback and returned by the submit calls */
+#define I2CQ_OK                 (0u)
+#define I2CQ_ERR_NAK            (1u)    /* address or data not acknowledged */
+#define I2CQ_ERR_BUS            (2u)    /* arbitration lost, bus error, abort */
+#define I2CQ_ERR_TIMEOUT        (3u)
+#define I2CQ_ERR_FULL           (4u)    /* not queued */
+#define I2CQ_ERR_PARAM          (5u)    /* not queued */
+
+/* Completion of a transaction, runs in main loop context.  data points to
+ * the bytes read (NULL for writes) and is only valid during the call. */
+typedef void (*I2CQ_DoneFn)(void* context, uint8 result, const uint8* data, uint16 length);
+
+typedef struct
+{
+    uint32 submitted;
+    uint32 completed;       /* finished with I2CQ_OK */
+    uint32 failed;          /* finished with an error after the retries */
+    uint32 retries;
+    uint32 naks;
+    uint32 bus_errors;
+    uint32 timeouts;
+    uint32 full;            /* submits refused for lack of space */
+    uint32 probes;          /* I2CQ_Probe() transactions, not counted above */
+    uint8  depth_max;       /* queue high water mark */
+} I2CQ_Stats;
+
+/* Function prototypes */
+void I2CQ_Start(void);
+void I2CQ_Service(void);
+uint8 I2CQ_Write(uint8 address, uint16 reg, uint8 reg_size, const uint8* data, uint8 length,
+                 I2CQ_DoneFn done, void* context);
+uint8 I2CQ_Read(uint8 address, uint16 reg, uint8 reg_size, uint8 length,
+                I2CQ_DoneFn done, void* context);
+uint8 I2CQ_WriteBuf(uint8 address, const uint8* buffer, uint16 length, I2CQ_DoneFn done, void* context);
+uint8 I2CQ_ReadBuf(uint8 address, uint16 reg, uint8 reg_size, uint8* buffer, uint16 length,
+                   I2CQ_DoneFn done, void* context);
+uint8 I2CQ_Probe(uint8 address, I2CQ_DoneFn done, void* context);
+uint8 I2CQ_Pending(void);
+void I2CQ_Flush(void);
+void I2CQ_GetStats(I2CQ_Stats* stats);
+void I2CQ_ClearStats(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,93 @@
+#ifndef _MODLOG_H_
+#define _MODLOG_H_
+/*******************************************************************************
+* FILE: modlog.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Per module log levels.  MLOGn(module, level, format, ...) prints when
+*   level is at or below both MLOG_LEVEL_MAX, a compile time ceiling that
+*   removes more verbose calls from the image, and the module's runtime
+*   threshold.  The thresholds are packed one nibble per module (module 0 in
+*   bits 0..3) and exposed through object 0x2610 so a single node can be made
+*   verbose over CAN.  Output goes through TLOGn() when TLOG_DEFERRED is set
+*   and through SIO_Printf() otherwise.
+*******************************************************************************/
+#include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+#include "sio.h"
+#include "tlog.h"
+
+/* Levels, lower is more severe */
+#define MLOG_LVL_NONE       0u
+#define MLOG_LVL_ERROR      1u
+#define MLOG_LVL_WARN       2u
+#define MLOG_LVL_INFO       3u
+#define MLOG_LVL_DEBUG      4u
+#define MLOG_LVL_TRACE      5u
+
+/* Modules */
+#define MLOG_MOD_TIMER      0u
+#define MLOG_MOD_SIO        1u
+#define MLOG_MOD_SDO        2u
+#define MLOG_MOD_USR        3u
+#define MLOG_MOD_BOOT       4u
+#define MLOG_MOD_LAST       5u
+
+/* Compile time ceiling, calls above it generate no code.  Logging is off
+ * altogether when the slave framework is built without printf support. */
+#ifndef MLOG_LEVEL_MAX
+    #if defined(SLAVE_FRAMEWORK_USE_PRINTF) && (SLAVE_FRAMEWORK_USE_PRINTF == 0)
+        #define MLOG_LEVEL_MAX  MLOG_LVL_NONE
+    #else
+        #define MLOG_LEVEL_MAX  MLOG_LVL_DEBUG
+    #endif
+#endif
+
+/* Runtime threshold of every module after reset */
+#ifndef MLOG_LEVEL_DEFAULT
+    #define MLOG_LEVEL_DEFAULT  MLOG_LVL_WARN
+#endif
+
+extern uint8 mlog_level[MLOG_MOD_LAST];
+
+#define MLOG_ON(mod, lvl)   (((lvl) <= MLOG_LEVEL_MAX) && ((lvl) <= mlog_level[(mod)]))
+
+#if TLOG_DEFERRED
+    #define MLOG_OUT0(f)                TLOG0(f)
+    #define MLOG_OUT1(f, a)             TLOG1(f, a)
+    #define MLOG_OUT2(f, a, b)          TLOG2(f, a, b)
+    #define MLOG_OUT3(f, a, b, c)       TLOG3(f, a, b, c)
+    #define MLOG_OUT4(f, a, b, c, d)    TLOG4(f, a, b, c, d)
+#else
+    #define MLOG_OUT0(f)                (void)SIO_Printf(f)
+    #define MLOG_OUT1(f, a)             (void)SIO_Printf(f, a)
+    #define MLOG_OUT2(f, a, b)          (void)SIO_Printf(f, a, b)
+    #define MLOG_OUT3(f, a, b, c)       (void)SIO_Printf(f, a, b, c)
+    #define MLOG_OUT4(f, a, b, c, d)    (void)SIO_Printf(f, a, b, c, d)
+#endif
+
+#define MLOG0(mod, lvl, f)              do { if (MLOG_ON(mod, lvl)) { MLOG_OUT0(f); } } while (0)
+#define MLOG1(mod, lvl, f, a)           do { if (MLOG_ON(mod, lvl)) { MLOG_OUT1(f, a); } } while (0)
+#define MLOG2(mod, lvl, f, a, b)        do { if (MLOG_ON(mod, lvl)) { MLOG_OUT2(f, a, b); } } while (0)
+#define MLOG3(mod, lvl, f, a, b, c)     do { if (MLOG_ON(mod, lvl)) { MLOG_OUT3(f, a, b, c); } } while (0)
+#define MLOG4(mod, lvl, f, a, b, c, d)  do { if (MLOG_ON(mod, lvl)) { MLOG_OUT4(f, a, b, c, d); } } while (0)
+
+/* Function prototypes */
+void MLOG_SetLevel(uint8 module, uint8 level);
+uint8 MLOG_GetLevel(uint8 module);
+void MLOG_SetLevels(uint32 packed);
+uint32 MLOG_GetLevels(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -34,8 +34,8 @@ void NODE_LED_SetAllDim(uint32_t dim);
 uint8 NODE_GetAddress(void);
 uint8 NODE_GetOptions(void);
 void NODE_Start(void);
-void NODE_ReadEE(uint16 addr, uint8* buffer, size_t size);
-void NODE_WriteEE(uint16 addr, const uint8* buffer, size_t size);
+uint8 NODE_ReadEE(uint16 addr, uint8* buffer, size_t size);
+uint8 NODE_WriteEE(uint16 addr, const uint8* buffer, size_t size);
 
 void NODE_Test(void);
 #endif  // _CARDS_H_
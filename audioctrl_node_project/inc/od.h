@@ -0,0 +1,103 @@
+#ifndef _OD_H_
+#define _OD_H_
+/*******************************************************************************
+* FILE: od.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Application view of the object dictionary.  tools/od_gen.py turns
+*   config/slave_node.yaml into od_table[], one const entry per index and
+*   subindex, and od_slot[], the table position of each index from
+*   OD_INDEX_FIRST, the lowest manufacturer object (0x2600 here), so a lookup
+*   is two array reads.  The few communication profile objects the
+*   application handles are found in od_comm_slot[].
+*
+*   Each object has a set of handlers, registered from the YAML and
+*   replaceable with OD_Register():
+*     validate  before a write, may reject a value that is in range
+*     apply     after a write, acts on the new value
+*     refresh   before a read, supplies the current value
+*   A value without a refresh handler is kept in RAM; record subindex 0 is
+*   the constant in the entry.
+*******************************************************************************/
+#include <project.h>
+
+/* Results, also used by the handlers */
+#define OD_OK                   (0u)
+#define OD_NO_OBJECT            (1u)
+#define OD_RANGE                (2u)
+#define OD_READ_ONLY            (3u)
+
+/* CiA 301 data type codes */
+#define OD_TYPE_BOOLEAN         (0x01u)
+#define OD_TYPE_INT8            (0x02u)
+#define OD_TYPE_INT16           (0x03u)
+#define OD_TYPE_INT32           (0x04u)
+#define OD_TYPE_UINT8           (0x05u)
+#define OD_TYPE_UINT16          (0x06u)
+#define OD_TYPE_UINT32          (0x07u)
+
+#define OD_ACCESS_RO            (0x01u)
+#define OD_ACCESS_WO            (0x02u)
+#define OD_ACCESS_RW            (OD_ACCESS_RO | OD_ACCESS_WO)
+#define OD_ACCESS_CONST         (0x04u)     /* value is the one in the entry */
+
+typedef struct
+{
+    uint8 (*validate)(uint8 subindex, uint32 value);    /* NULL if none */
+    void  (*apply)(uint8 subindex, uint32 value);
+    uint8 (*refresh)(uint8 subindex, uint32* value);
+} OD_Handlers;
+
+typedef struct
+{
+    uint16 index;
+    uint8  subindex;
+    uint8  type;            /* OD_TYPE_xxx */
+    uint8  access;          /* OD_ACCESS_xxx */
+    uint8  size;            /* bytes */
+    uint8  object;          /* position in od_handlers[] */
+    uint32 low;             /* write range, signed for the INTn types */
+    uint32 high;
+    uint32 value;           /* value when there is no refresh or RAM copy */
+    void*  data;            /* RAM copy, NULL if none */
+} OD_Entry;
+
+typedef struct
+{
+    uint16 index;
+    uint8  slot;
+} OD_CommSlot;
+
+/* Object value kept by the parameter store, subindex 0 */
+typedef struct
+{
+    uint16 index;
+    uint8  size;
+} OD_Persist;
+
+extern const OD_Entry od_table[];
+extern const uint8 od_slot[];
+extern const OD_CommSlot od_comm_slot[];
+extern const OD_Persist od_persist[];
+extern const OD_Handlers* od_handlers[];
+
+/* Function prototypes */
+const OD_Entry* OD_Find(uint16 index, uint8 subindex);
+uint8 OD_Register(uint16 index, const OD_Handlers* handlers);
+uint8 OD_Read(uint16 index, uint8 subindex, uint32* value);
+uint8 OD_Validate(uint16 index, uint8 subindex, uint32 value);
+void OD_Apply(uint16 index, uint8 subindex, uint32 value);
+uint8 OD_Write(uint16 index, uint8 subindex, uint32 value);
+uint8 OD_Size(uint16 index, uint8 subindex);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,70 @@
+#ifndef _OD_TABLE_H_
+#define _OD_TABLE_H_
+/*******************************************************************************
+* FILE: od_table.h
+*
+* Generated by tools/od_gen.py from config/slave_node.yaml, do not edit.
+********************************************************************************
+*
+* DESCRIPTION:
+*   Object indices and the typed handlers of Audio Control Node.
+*******************************************************************************/
+#include "od.h"
+
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+
+/* Build switches of the conditional objects, as generated */
+#if (((PROF_ENABLE) ? 1 : 0) != 1)
+    #error "od_table.h was generated for PROF_ENABLE 1, run make od"
+#endif
+
+/* Object indices */
+#define OD_IDX_STORE_PARAMETERS             (0x1010u)
+#define OD_IDX_RESTORE_DEFAULT_PARAMETERS   (0x1011u)
+#define OD_IDX_SPEAKER_ENABLE               (0x2600u)
+#define OD_IDX_SPEAKER_VOLUME               (0x2601u)
+#define OD_IDX_LOG_LEVELS                   (0x2610u)
+#define OD_IDX_PROF_RESET                   (0x2620u)
+#define OD_IDX_PROF_USR_MAIN                (0x2621u)
+#define OD_IDX_PROF_LED_HANDLER             (0x2622u)
+#define OD_IDX_PROF_OBJCB                   (0x2623u)
+#define OD_IDX_PROF_CAN_ISR                 (0x2624u)
+
+#define OD_INDEX_FIRST                     (0x2600u)
+#define OD_INDEX_LAST                      (0x2624u)
+#define OD_OBJECT_COUNT                    (10u)
+#define OD_TABLE_SIZE                      (64u)
+#define OD_COMM_COUNT                      (2u)
+#define OD_NO_SLOT                         (0xFFu)
+#define OD_PDO_APPLY_COUNT                 (3u)
+
+/* Parameter store: objects, bytes of their values, layout signature */
+#define OD_PERSIST_COUNT                   (3u)
+#define OD_PERSIST_SIZE                    (6u)
+#define OD_PERSIST_LAYOUT                  (0x11u)
+
+/* Default handlers, implemented by the application.  validate and
+ * refresh return OD_xxx; validate only sees values in the object's
+ * range. */
+uint8 OD_Validate_store_parameters(uint8 subindex, uint32 value);
+void OD_Apply_store_parameters(uint8 subindex, uint32 value);
+uint8 OD_Refresh_store_parameters(uint8 subindex, uint32* value);
+uint8 OD_Validate_restore_default_parameters(uint8 subindex, uint32 value);
+void OD_Apply_restore_default_parameters(uint8 subindex, uint32 value);
+uint8 OD_Refresh_restore_default_parameters(uint8 subindex, uint32* value);
+void OD_Apply_speaker_enable(uint8 value);
+uint8 OD_Refresh_speaker_enable(uint8* value);
+void OD_Apply_speaker_volume(uint8 value);
+void OD_Apply_log_levels(uint32 value);
+uint8 OD_Refresh_log_levels(uint32* value);
+void OD_Apply_prof_reset(uint8 value);
+uint8 OD_Refresh_prof_usr_main(uint8 subindex, uint32* value);
+uint8 OD_Refresh_prof_led_handler(uint8 subindex, uint32* value);
+uint8 OD_Refresh_prof_objcb(uint8 subindex, uint32* value);
+uint8 OD_Refresh_prof_can_isr(uint8 subindex, uint32* value);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,81 @@
+#ifndef _PFAIL_H_
+#define _PFAIL_H_
+/*******************************************************************************
+* FILE: pfail.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Power-fail fast path.  The low voltage detect interrupt fires when VDDD
+*   falls below PFAIL_LVD_THRESHOLD; from there the supply holds the node for
+*   at least PFAIL_HOLDUP_US.  The handler takes the I2C block away from
+*   i2cq, asks pstore for a snapshot of the persistent values that changed
+*   since the last store and writes it into the spare page after the log in
+*   one page write, with the blocking manual mode calls.
+*
+*   The worst case, entry plus the bus time of the largest snapshot plus the
+*   EEPROM write cycle, is checked against the hold-up at compile time.  At
+*   run time the page write must start before a deadline that leaves it its
+*   bus time and the write cycle; an EEPROM still busy with a store of the
+*   main loop is ACK polled until then and the snapshot is dropped after.
+*   SysTick stands still in the interrupt, so the deadline is a number of
+*   polls paced by CyDelayUs(), and the durations in PFAIL_Stats are
+*   estimates from the polls and the bytes sent at PFAIL_I2C_HZ.
+*
+*   If the supply recovers the detector is armed again PFAIL_REARM_MS after
+*   the trip, a delay started by PFAIL_Service() from the main loop; i2cq
+*   recovers the transaction it lost through its timeout.
+*******************************************************************************/
+#include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+
+#ifndef PFAIL_LVD_THRESHOLD
+    #define PFAIL_LVD_THRESHOLD (CY_LVD_THRESHOLD_4_5_V)
+#endif
+/* NVIC line of the srss interrupt, which carries the LVD event */
+#ifndef PFAIL_IRQ_NUMBER
+    #define PFAIL_IRQ_NUMBER    (11u)
+#endif
+/* Supply hold-up from the LVD trip, measured on the board */
+#ifndef PFAIL_HOLDUP_US
+    #define PFAIL_HOLDUP_US     (10000u)
+#endif
+/* Interrupt entry, bus takeover and snapshot, before the first bus byte */
+#ifndef PFAIL_ENTRY_US
+    #define PFAIL_ENTRY_US      (200u)
+#endif
+/* Slowest I2C clock the budget allows for */
+#ifndef PFAIL_I2C_HZ
+    #define PFAIL_I2C_HZ        (400000u)
+#endif
+#ifndef PFAIL_REARM_MS
+    #define PFAIL_REARM_MS      (1000u)
+#endif
+
+typedef struct
+{
+    uint32 events;          /* LVD interrupts */
+    uint32 written;         /* snapshots written */
+    uint32 unchanged;       /* nothing to keep */
+    uint32 late;            /* EEPROM busy past the deadline */
+    uint32 errors;          /* NAK or bus error during the page write */
+    uint16 last_us;         /* trip to stop of the last page write, estimated */
+    uint16 max_us;
+} PFAIL_Stats;
+
+/* Function prototypes */
+void PFAIL_Start(void);
+void PFAIL_Service(void);
+void PFAIL_GetStats(PFAIL_Stats* stats);
+
+#endif
+
+/* [] END OF FILE */
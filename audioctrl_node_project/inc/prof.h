@@ -0,0 +1,71 @@
+#ifndef _PROF_H_
+#define _PROF_H_
+/*******************************************************************************
+* FILE: prof.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Cycle profiler for a fixed set of hot paths.  PROF_ENTER(site) and
+*   PROF_EXIT(site) bracket the code in one function; each exit adds the
+*   SysClk cycles spent, less the cost of the markers, to the site's call
+*   count, total, min, max and a histogram of powers of four starting at 64
+*   cycles.  The statistics are read over SDO from records 0x2621.. (one per
+*   site) and cleared by writing object 0x2620.
+*
+*   With PROF_ENABLE 0 the markers expand to nothing, and make od leaves
+*   the objects out of the dictionary.
+*******************************************************************************/
+#include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+#include "timer.h"
+
+#ifndef PROF_ENABLE
+    #define PROF_ENABLE         0
+#endif
+
+/* Sites, one record each (OD_IDX_PROF_xxx) */
+#define PROF_SITE_USR_MAIN      0u
+#define PROF_SITE_LED_HANDLER   1u
+#define PROF_SITE_OBJCB         2u
+#define PROF_SITE_CAN_ISR       3u
+#define PROF_SITE_LAST          4u
+
+#define PROF_HIST_BINS          8u
+
+/* Record subindices, all UNSIGNED32 */
+#define PROF_SUB_CALLS          1u
+#define PROF_SUB_TOTAL_LO       2u
+#define PROF_SUB_TOTAL_HI       3u
+#define PROF_SUB_MIN            4u
+#define PROF_SUB_MAX            5u
+#define PROF_SUB_HIST           6u          /* PROF_HIST_BINS entries */
+#define PROF_SUB_LAST           (PROF_SUB_HIST + PROF_HIST_BINS - 1u)
+
+#if (PROF_ENABLE)
+    #define PROF_ENTER(site)    uint32 prof_start_##site = SysTick_GetCycles()
+    #define PROF_EXIT(site)     PROF_Record((site), SysTick_GetCycles() - prof_start_##site)
+#else
+    #define PROF_ENTER(site)
+    #define PROF_EXIT(site)
+#endif
+
+/* Function prototypes */
+#if (PROF_ENABLE)
+void PROF_Start(void);
+void PROF_Record(uint8 site, uint32 cycles);
+void PROF_Reset(void);
+uint8 PROF_Read(uint8 site, uint8 subindex, uint32* value);
+#endif
+
+#endif
+
+/* [] END OF FILE */
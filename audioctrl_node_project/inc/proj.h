@@ -43,5 +43,82 @@
 #define SLAVE_FRAMEWORK_USE_BOOTLOADER   1
 /******************************************************************************/
 
+/******************************************************************************/
+/* timer                                                                      */
+/******************************************************************************/
+#define SYSTICK_USE_TICKLESS             1
+#define SYSTICK_TICKLESS_MAX_MS          100
+/******************************************************************************/
+
+/******************************************************************************/
+/* sio                                                                        */
+/******************************************************************************/
+#define SIO_TX_BUFFER_SIZE               256
+#define SIO_TX_POLICY                    SIO_TX_POLICY_DROP
+/******************************************************************************/
+
+/******************************************************************************/
+/* i2cq: queued I2C transactions, counters on the STAT serial command         */
+/******************************************************************************/
+#define I2CQ_DEPTH                       8
+#define I2CQ_RETRIES                     3
+#define I2CQ_TIMEOUT_MS                  10
+/******************************************************************************/
+
+/******************************************************************************/
+/* amp: register shadow, readback of every burst when AMP_VERIFY is set       */
+/******************************************************************************/
+#define AMP_VERIFY                       0
+/******************************************************************************/
+
+/******************************************************************************/
+/* pstore: 4 page parameter log at 0x7E00, snapshot page after it             */
+/******************************************************************************/
+#define PSTORE_BASE                      0x7E00
+#define PSTORE_SECTORS                   4
+/******************************************************************************/
+
+/******************************************************************************/
+/* pfail: power-fail snapshot, LVD trip and supply hold-up budget             */
+/******************************************************************************/
+#define PFAIL_LVD_THRESHOLD              CY_LVD_THRESHOLD_4_5_V
+#define PFAIL_HOLDUP_US                  10000
+/******************************************************************************/
+
+/******************************************************************************/
+/* tlog: release builds send PRINTF_ARGn as tokens, see tools/tlog_decode.py  */
+/******************************************************************************/
+#ifdef NDEBUG
+#define TLOG_DEFERRED                    1
+#else
+#define TLOG_DEFERRED                    0
+#endif
+/******************************************************************************/
+
+/******************************************************************************/
+/* modlog: compile time ceiling and reset default, runtime via object 0x2610  */
+/******************************************************************************/
+#if (SLAVE_FRAMEWORK_USE_PRINTF)
+#define MLOG_LEVEL_MAX                   MLOG_LVL_TRACE
+#endif
+#define MLOG_LEVEL_DEFAULT               MLOG_LVL_WARN
+/******************************************************************************/
+
+/******************************************************************************/
+/* prof: cycle profiler, objects 0x2620 (reset) and 0x2621.. (one per site)   */
+/******************************************************************************/
+#define PROF_ENABLE                      1
+/******************************************************************************/
+
+/******************************************************************************/
+/* bench: BENCH serial command in debug builds                                */
+/******************************************************************************/
+#ifdef NDEBUG
+#define BENCH_ENABLE                     0
+#else
+#define BENCH_ENABLE                     1
+#endif
+/******************************************************************************/
+
 
 #endif
@@ -0,0 +1,91 @@
+#ifndef _PSTORE_H_
+#define _PSTORE_H_
+/*******************************************************************************
+* FILE: pstore.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Persistent parameters in the EEPROM.  The objects marked persist in
+*   config/slave_node.yaml (od_persist[]) are kept as one record in a log of
+*   PSTORE_SLOTS fixed size records spread over PSTORE_SECTORS pages.  Every
+*   store appends the next record, so the pages take turns and wear evenly;
+*   a record carries a sequence number and a CRC, and the valid record with
+*   the highest sequence number is the current one.  A record never crosses
+*   a page, so a store is a single page write and a torn one only loses the
+*   record being written.
+*
+*   PSTORE_Start() reads the whole log in one sequential read; the newest
+*   record is then written to the objects through OD_Write(), which applies
+*   them, and kept in RAM.  PSTORE_Save() and PSTORE_Restore() implement the
+*   CiA 301 store (0x1010) and restore default (0x1011) commands: they only
+*   take the request, PSTORE_Service() writes it once the EEPROM is idle.
+*   A save equal to the cached record is not written.  A restore appends a
+*   record without values, so the defaults apply from the next reset.
+*
+*   The page after the log takes a power-fail snapshot: PSTORE_Snapshot()
+*   serializes the values that differ from the stored record, for pfail.c
+*   to write in one page write.  At boot a snapshot that is not older than
+*   the newest record is applied on top of it, stored as a new record and
+*   the page is blanked again for the next power fail.
+*******************************************************************************/
+#include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+#include "ee24.h"
+
+/* Log placement, pages of EE24_PAGE_SIZE bytes */
+#ifndef PSTORE_BASE
+    #define PSTORE_BASE         (0x7E00u)
+#endif
+#ifndef PSTORE_SECTORS
+    #define PSTORE_SECTORS      (4u)
+#endif
+
+#define PSTORE_RECORD_SIZE      (16u)
+#define PSTORE_PAYLOAD_MAX      (8u)
+#define PSTORE_LOG_SIZE         (PSTORE_SECTORS * EE24_PAGE_SIZE)
+
+/* Snapshot page and the largest snapshot: header, every value, CRC */
+#define PSTORE_SNAP_BASE        (PSTORE_BASE + PSTORE_LOG_SIZE)
+#define PSTORE_SNAP_SIZE        (7u + PSTORE_PAYLOAD_MAX + 2u)
+
+/* CiA 301 command signatures, "save" and "load" */
+#define PSTORE_SIGNATURE_SAVE   (0x65766173u)
+#define PSTORE_SIGNATURE_LOAD   (0x64616F6Cu)
+
+/* PSTORE_Status() */
+#define PSTORE_LOADING          (0u)
+#define PSTORE_EMPTY            (1u)    /* no record, or defaults restored */
+#define PSTORE_RESTORED         (2u)    /* the objects hold stored values */
+#define PSTORE_FAILED           (3u)    /* log not readable, stores refused */
+
+typedef struct
+{
+    uint32 seq;             /* sequence number of the current record */
+    uint32 stores;          /* records written */
+    uint32 unchanged;       /* saves that matched the cached record */
+    uint32 errors;          /* records that failed to write */
+    uint8  valid;           /* valid records found at boot */
+    uint8  merged;          /* power-fail snapshot applied at boot */
+} PSTORE_Stats;
+
+/* Function prototypes */
+void PSTORE_Start(void);
+void PSTORE_Service(void);
+void PSTORE_Save(void);
+void PSTORE_Restore(void);
+uint8 PSTORE_Status(void);
+uint8 PSTORE_Snapshot(uint8* snapshot);
+void PSTORE_GetStats(PSTORE_Stats* stats);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,58 @@
+#ifndef _SIO_CMD_H_
+#define _SIO_CMD_H_
+/*******************************************************************************
+* FILE: sio_cmd.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Command interpreter of the serial debug port.  A line is split into
+*   upper case words separated by spaces or commas; the first word selects an
+*   entry of sio_cmd_table[] and the handler gets the words like main().
+*   Replies are a single line starting with OK or ERR so scripts can keep
+*   several commands in flight.
+*
+*       ODR <index> <sub>           read an object, hex index/subindex
+*       ODW <index> <sub> <value>   write an object, value 0x.. or decimal
+*******************************************************************************/
+#include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+
+#define SIO_CMD_MAX_ARGS        (6u)
+
+typedef void (*SIO_CmdFn)(uint8 argc, char* argv[]);
+
+typedef struct
+{
+    const char* name;       /* upper case */
+    uint8 min_args;         /* not counting the command word */
+    SIO_CmdFn handler;
+    const char* help;
+} SIO_Command;
+
+/* Receive accounting, see SIO_GetRxStats() */
+typedef struct
+{
+    uint32 lines;           /* complete lines handed to the interpreter */
+    uint32 overruns;        /* lines lost because the previous one was busy */
+    uint32 too_long;        /* lines longer than the receive buffer */
+} SIO_RxStats;
+
+extern const SIO_Command sio_cmd_table[];
+extern const uint8 sio_cmd_count;
+
+/* Function prototypes */
+void SIO_Service(void);
+void SIO_GetRxStats(SIO_RxStats* stats);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,62 @@
+#ifndef _SIO_TX_H_
+#define _SIO_TX_H_
+/*******************************************************************************
+* FILE: sio_tx.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Transmit side of the serial input output subsystem.  Output is copied into
+*   a circular buffer and returns immediately; the SIOU TX interrupt refills
+*   the 8 byte hardware FIFO from it.  When the buffer cannot take a message,
+*   SIO_TX_POLICY decides whether the message is dropped (and counted) or the
+*   caller waits for room.
+*******************************************************************************/
+#include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+
+#define SIO_TX_POLICY_DROP      0u  /* discard messages that do not fit */
+#define SIO_TX_POLICY_BLOCK     1u  /* wait until the buffer has room */
+
+/* Default full buffer policy, can be changed with SIO_SetTxPolicy() */
+#ifndef SIO_TX_POLICY
+    #define SIO_TX_POLICY       SIO_TX_POLICY_DROP
+#endif
+
+/* Longest single SIO_Printf() line including prompt and end of line */
+#ifndef SIO_LINE_SIZE
+    #define SIO_LINE_SIZE       128
+#endif
+
+/* Transmit accounting, see SIO_GetTxStats() */
+typedef struct
+{
+    uint32 bytes;           /* bytes handed to the UART */
+    uint32 dropped_msgs;    /* messages discarded by the drop policy */
+    uint32 dropped_bytes;
+    uint32 blocked;         /* writes that had to wait for room */
+    uint16 high_water;      /* most bytes ever queued */
+} SIO_TxStats;
+
+/* Function prototypes */
+uint16 SIO_Write(const uint8* data, uint16 length);
+void SIO_PutChar(char8 ch);
+void SIO_PutString(const char8* string);
+void SIO_Flush(void);
+void SIO_TxService(void);
+uint16 SIO_TxPending(void);
+void SIO_SetTxPolicy(uint8 policy);
+void SIO_GetTxStats(SIO_TxStats* stats);
+void SIO_ClearTxStats(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -24,6 +24,25 @@
 *   dedicated timer/counter available for the job.
 *******************************************************************************/
 #include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+
+/* Tickless mode: SysTick is reprogrammed to interrupt at the next timer
+ * deadline instead of every millisecond, and SysTick_Idle() sleeps the CPU
+ * until then.  Interrupts that leave work for the main loop must call
+ * SysTick_Wake(), or work that arrives between the loop's poll and the
+ * sleep waits for the deadline.  SYSTICK_TICKLESS_MAX_MS bounds each sleep,
+ * which matters for code that polls SysTick_GetTicks() instead of using a
+ * timer.  Other CySysTick callbacks, such as the stack timebase, are run
+ * once per millisecond of each period, in a burst at its end.  The bound
+ * cannot exceed the 24-bit reload (699 ms at 24 MHz). */
+#ifndef SYSTICK_USE_TICKLESS
+    #define SYSTICK_USE_TICKLESS        0
+#endif
+#ifndef SYSTICK_TICKLESS_MAX_MS
+    #define SYSTICK_TICKLESS_MAX_MS     (699u)
+#endif
 
 #define TIMER_ID_500      0
 #define TIMER_ID_250      1
@@ -32,20 +51,61 @@
 #define TIMER_ID_SENSOR   4
 #define TIMER_ID_SECONDS  5    
 #define TIMER_ID_LAST     6 
-    
+
+/* Software timer callback, runs from SysTick_Refresh() in main loop context */
+typedef void (*SysTick_TimerFn)(void* context);
+
+/* What a periodic timer does when the main loop falls behind by more than
+ * one period */
+#define SYSTICK_TIMER_CATCHUP   0u  /* run every missed expiry, in order */
+#define SYSTICK_TIMER_COALESCE  1u  /* run once, count the rest as overruns */
+
+/* Software timer.  Storage is owned by the caller and must stay valid while
+ * the timer is armed; initialise it once with SysTick_TimerInit(). */
+typedef struct SysTick_Timer_s
+{
+    struct SysTick_Timer_s*  next;      /* wheel slot list */
+    struct SysTick_Timer_s** pprev;     /* NULL when not armed */
+    uint32 expires;                     /* absolute tick of next expiry */
+    uint32 period;                      /* reload in ticks, 0 for one-shot */
+    SysTick_TimerFn callback;           /* NULL for flag delivery only */
+    void*  context;
+    uint8  mode;                        /* SYSTICK_TIMER_xxx */
+    volatile uint8 pending;             /* expiries not yet consumed */
+    uint16 overruns;                    /* expiries coalesced or dropped */
+    uint16 late_last;                   /* ticks from expiry to its run */
+    uint16 late_max;
+} SysTick_Timer;
+
 /* Function prototypes */
 void SysTick_Callback(void);     
 uint16 SysTick_GetMicroseconds(void);
+uint64 SysTick_GetMicroseconds64(void);
+uint64 SysTick_GetCycles64(void);
+uint32 SysTick_GetCycles(void);
+uint32 SysTick_CyclesToMs(uint32 cycles, uint32* rest);
 uint32 SysTick_GetMinutes(void);
 uint32 SysTick_GetSeconds(void);
 uint32 SysTick_GetStatus(void);
 uint32 SysTick_GetTicks(void);
 uint32 SysTick_GetTimestamp(void);
 void SysTick_Refresh(void);
+void SysTick_Idle(void);
+void SysTick_Wake(void);
 void SysTick_Start(void);
 uint8 SysTick_TimerCheck(uint8 index);
 void SysTick_TimerSet(uint8 index, uint32 milliseconds);
 
+void SysTick_TimerInit(SysTick_Timer* timer, SysTick_TimerFn callback, void* context);
+void SysTick_TimerArm(SysTick_Timer* timer, uint32 delay, uint32 period);
+void SysTick_TimerCancel(SysTick_Timer* timer);
+uint8 SysTick_TimerPending(const SysTick_Timer* timer);
+uint8 SysTick_TimerExpired(SysTick_Timer* timer);
+void SysTick_TimerSetMode(SysTick_Timer* timer, uint8 mode);
+void SysTick_TimerClearStats(SysTick_Timer* timer);
+SysTick_Timer* SysTick_TimerGetLegacy(uint8 index);
+uint32 SysTick_GetBacklogMax(void);
+
 #endif
 
 /* [] END OF FILE */
@@ -0,0 +1,87 @@
+#ifndef _TLOG_H_
+#define _TLOG_H_
+/*******************************************************************************
+* FILE: tlog.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Tokenized logging.  TLOGn(format, ...) does no formatting on the target:
+*   the format string is placed in the .tlog_fmt section, which is not
+*   allocated and so never reaches flash, and only its offset in that section
+*   is sent together with the raw 32 bit arguments.
+*   tools/tlog_decode.py reads the strings back out of the .elf and turns the
+*   UART stream into text.
+*
+*   Frame on the wire, little endian:
+*       0xF0 | nargs        one byte, nargs 0..4, never valid ASCII
+*       id                  uint16, offset of the format string
+*       args                nargs x uint32
+*   Anything outside a frame is plain text from SIO_Printf() and friends.
+*
+*   With TLOG_DEFERRED set, PRINTF_ARG0..4 from slave_framework.h are routed
+*   here; include this header after slave_framework.h.
+*******************************************************************************/
+#include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+
+#ifndef TLOG_DEFERRED
+    #define TLOG_DEFERRED       0
+#endif
+
+#define TLOG_FRAME_MARK         (0xF0u)
+#define TLOG_MAX_ARGS           (4u)
+
+/* The section flags are spelt out so the assembler creates .tlog_fmt without
+ * SHF_ALLOC; the trailing '@' comments out the flags GCC appends.  The host
+ * simulation keeps the strings loaded and measures from the section start. */
+#if defined(__arm__)
+    #define TLOG_SECTION        __attribute__((section(".tlog_fmt,\"\",%progbits @"), used))
+    #define TLOG_ID(fmt)        ((uint16)(uint32)(fmt))
+#else
+    extern const char __start_tlog_fmt[];
+    #define TLOG_SECTION        __attribute__((section("tlog_fmt"), used))
+    #define TLOG_ID(fmt)        ((uint16)((fmt) - __start_tlog_fmt))
+#endif
+
+#define TLOG_EMIT(fmt, n, ...)                                                  \
+    do                                                                          \
+    {                                                                           \
+        static const char TLOG_SECTION tlog_fmt_[] = fmt;                       \
+        const uint32 tlog_args_[(n) + 1] = { 0u, ##__VA_ARGS__ };               \
+        TLOG_Write(TLOG_ID(tlog_fmt_), (n), &tlog_args_[1]);                    \
+    } while (0)
+
+#define TLOG0(fmt)                  TLOG_EMIT(fmt, 0)
+#define TLOG1(fmt, a)               TLOG_EMIT(fmt, 1, (uint32)(a))
+#define TLOG2(fmt, a, b)            TLOG_EMIT(fmt, 2, (uint32)(a), (uint32)(b))
+#define TLOG3(fmt, a, b, c)         TLOG_EMIT(fmt, 3, (uint32)(a), (uint32)(b), (uint32)(c))
+#define TLOG4(fmt, a, b, c, d)      TLOG_EMIT(fmt, 4, (uint32)(a), (uint32)(b), (uint32)(c), (uint32)(d))
+
+#if TLOG_DEFERRED
+    #undef  PRINTF_ARG0
+    #undef  PRINTF_ARG1
+    #undef  PRINTF_ARG2
+    #undef  PRINTF_ARG3
+    #undef  PRINTF_ARG4
+    #define PRINTF_ARG0(f)              TLOG0(f)
+    #define PRINTF_ARG1(f, a)           TLOG1(f, a)
+    #define PRINTF_ARG2(f, a, b)        TLOG2(f, a, b)
+    #define PRINTF_ARG3(f, a, b, c)     TLOG3(f, a, b, c)
+    #define PRINTF_ARG4(f, a, b, c, d)  TLOG4(f, a, b, c, d)
+#endif
+
+/* Function prototypes */
+void TLOG_Write(uint16 id, uint8 nargs, const uint32* args);
+
+#endif
+
+/* [] END OF FILE */
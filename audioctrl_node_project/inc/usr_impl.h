@@ -14,6 +14,7 @@
 *     This module implements the USR CAN slave routines
 *
 *******************************************************************************/
+#include "od.h"
 
 typedef enum {
     SUBINDEX_ENABLE     = 0x01,
@@ -41,6 +42,12 @@ typedef enum {
 #define MOD_PERIOD                  (1024u)
 #define MOD_FREQ                    (10u)
 
+/* Results of USR_ObjRead() / USR_ObjWrite(), see od.h */
+#define USR_OBJ_OK                  OD_OK
+#define USR_OBJ_NO_OBJECT           OD_NO_OBJECT
+#define USR_OBJ_RANGE               OD_RANGE
+#define USR_OBJ_READ_ONLY           OD_READ_ONLY
+
 #ifndef SLAVE_FRAMEWORK_USE_MAIN_CB
     #define SLAVE_FRAMEWORK_USE_MAIN_CB         0
 #endif
@@ -52,4 +59,7 @@ typedef enum {
 void USR_Tick(void);
 void USR_SPKR_Enable(void);
 void USR_SPKR_Disable(void);
+uint8 USR_SPKR_IsEnabled(void);
+uint8 USR_ObjRead(uint16 index, uint8 subindex, uint32* value);
+uint8 USR_ObjWrite(uint16 index, uint8 subindex, uint32 value);
 
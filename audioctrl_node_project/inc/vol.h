@@ -0,0 +1,60 @@
+#ifndef _VOL_H_
+#define _VOL_H_
+/*******************************************************************************
+* FILE: vol.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*   Speaker volume.  The 0..100 volume of object 0x2601 maps linearly onto
+*   an attenuation of 48..0 dB in 0.5 dB steps, 0 is mute.  A flash table
+*   turns the attenuation into a Q15 gain, scaled to the amplifier's gain
+*   register.  VOL_Set() only moves the target: a SysTick timer walks the
+*   attenuation towards it by VOL_RAMP_STEP every VOL_RAMP_MS, so a jump
+*   becomes a ramp without audible steps, and a new target during a ramp
+*   continues from where the ramp is.  Every step goes to the amp register
+*   shadow, whose flush sends only the latest value once the previous write
+*   is done, so the I2C traffic is what the link can carry.
+*******************************************************************************/
+#include <project.h>
+#ifdef USE_PROJECT_HEADER
+    #include "proj.h"
+#endif
+
+/* Amplifier gain register, VOL_GAIN_MAX is its 0 dB code and 0 mutes */
+#ifndef VOL_AMP_REG
+    #define VOL_AMP_REG         (0x01u)
+#endif
+#ifndef VOL_GAIN_MAX
+    #define VOL_GAIN_MAX        (0xFFu)
+#endif
+/* Ramp speed, VOL_RAMP_STEP half dB every VOL_RAMP_MS */
+#ifndef VOL_RAMP_MS
+    #define VOL_RAMP_MS         (1u)
+#endif
+#ifndef VOL_RAMP_STEP
+    #define VOL_RAMP_STEP       (1u)
+#endif
+
+#define VOL_MAX                 (100u)
+/* Boot volume, must match the default of object 0x2601 */
+#ifndef VOL_DEFAULT
+    #define VOL_DEFAULT         (VOL_MAX)
+#endif
+#define VOL_ATTEN_MUTE          (97u)   /* half dB steps, one past -48 dB */
+
+/* Function prototypes */
+void VOL_Start(void);
+void VOL_Set(uint8 volume);
+uint8 VOL_GetAtten(void);
+uint8 VOL_Ramping(void);
+
+#endif
+
+/* [] END OF FILE */
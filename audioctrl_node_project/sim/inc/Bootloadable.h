@@ -0,0 +1,26 @@
+#ifndef _SIM_BOOTLOADABLE_H_
+#define _SIM_BOOTLOADABLE_H_
+/*******************************************************************************
+* FILE: Bootloadable.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Host simulation stand-in for the Bootloadable component.  Loading the
+* bootloader ends the simulated process with SIM_EXIT_BOOTLOADER.
+*******************************************************************************/
+#include "cytypes.h"
+
+#define SIM_EXIT_BOOTLOADER     (3)
+
+void Bootloadable_Load(void);
+
+#endif
+
+/* [] END OF FILE */
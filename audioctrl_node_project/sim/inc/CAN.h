@@ -0,0 +1,91 @@
+#ifndef _SIM_CAN_H_
+#define _SIM_CAN_H_
+/*******************************************************************************
+* FILE: CAN.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Host simulation stand-in for the PSoC 4 CAN component.  Frames are held
+* in two queues in sim_can.c: the RX queue is drained into the 16 receive
+* mailboxes and raises CAN_ISR_NUMBER, CAN_SendMsg() appends to the TX queue.
+* When SIM_CAN_IF names a Linux SocketCAN interface (e.g. vcan0) both queues
+* are bridged to it so a real CANopen master can talk to the simulated node.
+*******************************************************************************/
+#include "cytypes.h"
+
+#define CAN_ISR_NUMBER              (8u)
+#define CAN_NUMBER_OF_RX_MAILBOXES  (16u)
+#define CAN_NUMBER_OF_TX_MAILBOXES  (8u)
+
+#define CAN_SUCCESS                 (0x00u)
+#define CAN_FAIL                    (0x01u)
+#define CAN_OUT_OF_RANGE            (0x02u)
+
+#define CAN_STANDARD_MESSAGE        (0x00u)
+#define CAN_EXTENDED_MESSAGE        (0x01u)
+#define CAN_STANDARD_MESSAGE_ID_MASK (0x7FFu)
+
+#define CAN_RX_MESSAGE              (0x8000u)   /* INT_SR: message received */
+#define CAN_RX_ACK_MSG              (0x0001u)   /* rxcmd: message available */
+#define CAN_RX_RTR_MSG              (0x0020u)
+#define CAN_RX_IDE_MSG              (0x0080u)
+
+typedef struct
+{
+    uint8 byte[8u];
+} CAN_DATA_BYTES_MSG;
+
+typedef struct
+{
+    uint32 id;
+    uint8  rtr;
+    uint8  ide;
+    uint8  dlc;
+    uint8  irq;
+    CAN_DATA_BYTES_MSG *msg;
+} CAN_TX_MSG;
+
+typedef struct
+{
+    reg32 rxcmd;
+    reg32 rxid;
+    reg32 rxdata[2u];
+} CAN_RX_STRUCT;
+
+extern CAN_RX_STRUCT CAN_RX[CAN_NUMBER_OF_RX_MAILBOXES];
+extern reg32 CAN_INT_SR_REG;
+
+#define CAN_GET_RX_ID(i)            (CAN_RX[i].rxid >> 21u)
+#define CAN_GET_RX_IDE(i)           ((CAN_RX[i].rxcmd & CAN_RX_IDE_MSG) != 0u)
+#define CAN_GET_RX_RTR(i)           ((CAN_RX[i].rxcmd & CAN_RX_RTR_MSG) != 0u)
+#define CAN_GET_DLC(i)              ((CAN_RX[i].rxcmd >> 16u) & 0x0Fu)
+#define CAN_RX_DATA_BYTE(i, n)      ((uint8)(CAN_RX[i].rxdata[(n) >> 2u] >> (24u - 8u * ((n) & 3u))))
+#define CAN_RX_DATA_BYTE1(i)        CAN_RX_DATA_BYTE(i, 0u)
+#define CAN_RX_DATA_BYTE2(i)        CAN_RX_DATA_BYTE(i, 1u)
+#define CAN_RX_DATA_BYTE3(i)        CAN_RX_DATA_BYTE(i, 2u)
+#define CAN_RX_DATA_BYTE4(i)        CAN_RX_DATA_BYTE(i, 3u)
+#define CAN_RX_DATA_BYTE5(i)        CAN_RX_DATA_BYTE(i, 4u)
+#define CAN_RX_DATA_BYTE6(i)        CAN_RX_DATA_BYTE(i, 5u)
+#define CAN_RX_DATA_BYTE7(i)        CAN_RX_DATA_BYTE(i, 6u)
+#define CAN_RX_DATA_BYTE8(i)        CAN_RX_DATA_BYTE(i, 7u)
+#define CAN_RX_ACK_MESSAGE(i)       (CAN_RX[i].rxcmd &= ~CAN_RX_ACK_MSG)
+
+uint8 CAN_Start(void);
+void  CAN_Stop(void);
+uint8 CAN_GlobalIntEnable(void);
+uint8 CAN_GlobalIntDisable(void);
+uint8 CAN_SendMsg(const CAN_TX_MSG *message);
+void  CAN_ReceiveMsg(uint8 rxMailbox);
+void  CAN_MsgRXIsr(void);
+CY_ISR_PROTO(CAN_ISR);
+
+#endif
+
+/* [] END OF FILE */
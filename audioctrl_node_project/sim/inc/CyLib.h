@@ -0,0 +1,148 @@
+#ifndef _SIM_CYLIB_H_
+#define _SIM_CYLIB_H_
+/*******************************************************************************
+* FILE: CyLib.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Host simulation stand-in for the PSoC 4 CyLib/CyFlash/cyPm system API.
+* Interrupts are modelled by the simulated NVIC in sim_cylib.c: vectors run
+* on the process main thread either from a periodic host signal (realtime
+* clock) or synchronously as simulated time advances (manual clock).
+*******************************************************************************/
+#include "cytypes.h"
+
+/* SysClk of the CY8C4247 as configured in the .cydwr */
+#define CYDEV_BCLK__SYSCLK__HZ      (24000000u)
+#define CYDEV_BCLK__SYSCLK__KHZ     (24000u)
+#define CYDEV_BCLK__SYSCLK__MHZ     (24u)
+
+/*******************************************************************************
+ * Interrupt controller
+ ******************************************************************************/
+#define CY_INT_IRQ_BASE             (16u)
+#define CY_INT_NUMBER_MAX           (31u)
+#define CY_INT_SYSTICK_IRQN         (15u)
+
+void  CyGlobalIntEnableFn(void);
+void  CyGlobalIntDisableFn(void);
+#define CyGlobalIntEnable           CyGlobalIntEnableFn()
+#define CyGlobalIntDisable          CyGlobalIntDisableFn()
+
+uint8 CyEnterCriticalSection(void);
+void  CyExitCriticalSection(uint8 savedIntrStatus);
+
+cyisraddress CyIntSetVector(uint8 number, cyisraddress address);
+cyisraddress CyIntGetVector(uint8 number);
+void  CyIntEnable(uint8 number);
+void  CyIntDisable(uint8 number);
+uint8 CyIntGetState(uint8 number);
+void  CyIntSetPending(uint8 number);
+void  CyIntClearPending(uint8 number);
+void  CyIntSetPriority(uint8 number, uint8 priority);
+
+/*******************************************************************************
+ * Delays
+ ******************************************************************************/
+void  CyDelay(uint32 milliseconds);
+void  CyDelayUs(uint16 microseconds);
+void  CyDelayCycles(uint32 cycles);
+
+/*******************************************************************************
+ * SysTick
+ ******************************************************************************/
+#define CY_SYS_SYST_NUM_OF_CALLBACKS    (5u)
+#define CY_SYS_SYST_CSR_ENABLE          ((uint32)(0x01u))
+#define CY_SYS_SYST_CSR_ENABLE_INT      ((uint32)(0x02u))
+#define CY_SYS_SYST_CSR_CLK_SRC_SYSCLK  ((uint32)(0x04u))
+#define CY_SYS_SYST_CSR_COUNTFLAG       ((uint32)(0x10000u))
+#define CY_SYS_SYST_RVR_CNT_MASK        ((uint32)(0x00FFFFFFu))
+#define CY_SYS_SYST_CVR_CNT_MASK        ((uint32)(0x00FFFFFFu))
+
+typedef void (*cySysTickCallback)(void);
+
+uint32 SIM_SysTickReadCvr(void);
+uint32 SIM_SysTickReadCsr(void);
+extern reg32 sim_systick_rvr;
+
+#define CY_SYS_SYST_CVR_REG             (SIM_SysTickReadCvr())
+#define CY_SYS_SYST_CSR_REG             (SIM_SysTickReadCsr())
+#define CY_SYS_SYST_RVR_REG             (sim_systick_rvr)
+
+/* SCB ICSR, only PENDSTSET is modelled */
+uintptr_t SIM_Cm0IcsrAddr(void);
+#define CYREG_CM0_ICSR                  (SIM_Cm0IcsrAddr())
+
+void   CySysTickStart(void);
+void   CySysTickInit(void);
+void   CySysTickEnable(void);
+void   CySysTickStop(void);
+void   CySysTickEnableInterrupt(void);
+void   CySysTickDisableInterrupt(void);
+void   CySysTickSetReload(uint32 value);
+uint32 CySysTickGetReload(void);
+uint32 CySysTickGetValue(void);
+void   CySysTickClear(void);
+uint32 CySysTickGetCountFlag(void);
+cySysTickCallback CySysTickSetCallback(uint32 number, cySysTickCallback function);
+cySysTickCallback CySysTickGetCallback(uint32 number);
+
+/*******************************************************************************
+ * Flash
+ ******************************************************************************/
+#define CY_FLASH_SIZE               (0x00020000u)
+#define CY_FLASH_SIZEOF_ROW         (128u)
+#define CY_FLASH_NUMBER_ROWS        (CY_FLASH_SIZE / CY_FLASH_SIZEOF_ROW)
+#define CY_FLASH_NUMBER_ARRAYS      (1u)
+
+extern uint8 sim_flash[CY_FLASH_SIZE];
+#define CYDEV_FLASH_BASE            ((uint32)0u)
+#define CY_FLASH_BASE_PTR           (sim_flash)
+
+#define CY_SYS_FLASH_SUCCESS        (0x00u)
+#define CY_SYS_FLASH_INVALID_ADDR   (0x04u)
+
+/* Worst case row erase + program time, CPU is stalled while it runs */
+#define SIM_FLASH_ROW_WRITE_US      (20000u)
+
+uint32 CySysFlashWriteRow(uint32 rowNum, const uint8 rowData[]);
+
+/*******************************************************************************
+ * Power management
+ ******************************************************************************/
+void CySysPmSleep(void);
+void CySysPmDeepSleep(void);
+
+/*******************************************************************************
+ * Low voltage detect, on the srss interrupt line.  SIM_SupplyFail() trips it.
+ ******************************************************************************/
+#define SIM_LVD_IRQN                (11u)
+#define CY_SYS_LVD_INT              ((uint32)(0x02u))
+
+#define CY_LVD_THRESHOLD_1_75_V     ((uint32)(0x00u))
+#define CY_LVD_THRESHOLD_2_9_V      ((uint32)(0x08u))
+#define CY_LVD_THRESHOLD_3_0_V      ((uint32)(0x09u))
+#define CY_LVD_THRESHOLD_3_2_V      ((uint32)(0x0Au))
+#define CY_LVD_THRESHOLD_4_0_V      ((uint32)(0x0Cu))
+#define CY_LVD_THRESHOLD_4_5_V      ((uint32)(0x0Fu))
+
+void   CySysLvdEnable(uint32 threshold);
+void   CySysLvdDisable(void);
+uint32 CySysLvdGetInterruptSource(void);
+void   CySysLvdClearInterrupt(void);
+
+/*******************************************************************************
+ * Software reset
+ ******************************************************************************/
+void CySoftwareReset(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,74 @@
+#ifndef _SIM_SCBM_H_
+#define _SIM_SCBM_H_
+/*******************************************************************************
+* FILE: SCBM.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Host simulation stand-in for the SCBM SCB component in I2C master mode.
+* Both the buffer (interrupt driven) and the manual master APIs are modelled.
+* Transfers take the bus time of the configured data rate; slaves are the
+* device models registered in sim_i2c.c (amplifier, 24AA256 EEPROM).
+*******************************************************************************/
+#include "cytypes.h"
+
+#define SCBM_ISR_NUMBER                 (9u)
+
+#define SCBM_I2C_WRITE_XFER_MODE        (0x00u)
+#define SCBM_I2C_READ_XFER_MODE         (0x01u)
+#define SCBM_I2C_ACK_DATA               (0x01u)
+#define SCBM_I2C_NAK_DATA               (0x02u)
+
+#define SCBM_I2C_MODE_COMPLETE_XFER     (0x00u)
+#define SCBM_I2C_MODE_REPEAT_START      (0x01u)
+#define SCBM_I2C_MODE_NO_STOP           (0x02u)
+
+#define SCBM_I2C_MSTAT_RD_CMPLT         (0x0001u)
+#define SCBM_I2C_MSTAT_WR_CMPLT         (0x0002u)
+#define SCBM_I2C_MSTAT_XFER_INP         (0x0004u)
+#define SCBM_I2C_MSTAT_XFER_HALT        (0x0008u)
+#define SCBM_I2C_MSTAT_ERR_SHORT_XFER   (0x0010u)
+#define SCBM_I2C_MSTAT_ERR_ADDR_NAK     (0x0020u)
+#define SCBM_I2C_MSTAT_ERR_ARB_LOST     (0x0040u)
+#define SCBM_I2C_MSTAT_ERR_XFER         (0x0080u)
+#define SCBM_I2C_MSTAT_ERR_BUS_ERROR    (0x0100u)
+#define SCBM_I2C_MSTAT_ERR_ABORT_XFER   (0x0200u)
+#define SCBM_I2C_MSTAT_ERR_MASK         (0x03F0u)
+
+#define SCBM_I2C_MSTR_NO_ERROR          (0x00u)
+#define SCBM_I2C_MSTR_BUS_BUSY          (0x01u)
+#define SCBM_I2C_MSTR_NOT_READY         (0x02u)
+#define SCBM_I2C_MSTR_ERR_LB_NAK        (0x03u)
+#define SCBM_I2C_MSTR_ERR_ARB_LOST      (0x04u)
+#define SCBM_I2C_MSTR_ERR_BUS_ERR       (0x05u)
+#define SCBM_I2C_MSTR_ERR_ABORT_START   (0x06u)
+
+void   SCBM_Start(void);
+void   SCBM_Stop(void);
+void   SCBM_SetCustomInterruptHandler(void (*func)(void));
+
+uint32 SCBM_I2CMasterWriteBuf(uint32 slaveAddress, uint8 * wrData, uint32 cnt, uint32 mode);
+uint32 SCBM_I2CMasterReadBuf(uint32 slaveAddress, uint8 * rdData, uint32 cnt, uint32 mode);
+uint32 SCBM_I2CMasterStatus(void);
+uint32 SCBM_I2CMasterClearStatus(void);
+uint32 SCBM_I2CMasterGetWriteBufSize(void);
+uint32 SCBM_I2CMasterGetReadBufSize(void);
+void   SCBM_I2CMasterClearWriteBuf(void);
+void   SCBM_I2CMasterClearReadBuf(void);
+
+uint32 SCBM_I2CMasterSendStart(uint32 slaveAddress, uint32 bitRnW);
+uint32 SCBM_I2CMasterSendRestart(uint32 slaveAddress, uint32 bitRnW);
+uint32 SCBM_I2CMasterSendStop(void);
+uint32 SCBM_I2CMasterWriteByte(uint32 theByte);
+uint32 SCBM_I2CMasterReadByte(uint32 ackNack);
+
+#endif
+
+/* [] END OF FILE */
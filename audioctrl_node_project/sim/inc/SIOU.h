@@ -0,0 +1,65 @@
+#ifndef _SIM_SIOU_H_
+#define _SIM_SIOU_H_
+/*******************************************************************************
+* FILE: SIOU.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Host simulation stand-in for the SIOU SCB component in UART mode.  The
+* model keeps the 8 entry hardware TX/RX FIFOs of the SCB and drains/fills
+* them at the configured baud rate, so blocking writes cost the same wall
+* time as on the board.  Transmitted bytes go to stdout (or SIM_UART_TX),
+* received bytes come from stdin (or SIM_UART_RX).
+*******************************************************************************/
+#include "cytypes.h"
+
+#define SIOU_FIFO_SIZE              (8u)
+#define SIOU_ISR_NUMBER             (10u)
+
+#define SIOU_INTR_TX_FIFO_LEVEL     (0x0001u)
+#define SIOU_INTR_TX_NOT_FULL       (0x0002u)
+#define SIOU_INTR_TX_EMPTY          (0x0010u)
+#define SIOU_INTR_TX_OVERFLOW       (0x0020u)
+#define SIOU_INTR_TX_UART_DONE      (0x0200u)
+
+#define SIOU_INTR_RX_FIFO_LEVEL     (0x0001u)
+#define SIOU_INTR_RX_NOT_EMPTY      (0x0004u)
+#define SIOU_INTR_RX_FULL           (0x0008u)
+#define SIOU_INTR_RX_OVERFLOW       (0x0020u)
+
+void   SIOU_Start(void);
+void   SIOU_Stop(void);
+
+void   SIOU_SpiUartWriteTxData(uint32 txData);
+void   SIOU_SpiUartPutArray(const uint8 wrBuf[], uint32 count);
+uint32 SIOU_SpiUartGetTxBufferSize(void);
+void   SIOU_SpiUartClearTxBuffer(void);
+uint32 SIOU_SpiUartReadRxData(void);
+uint32 SIOU_SpiUartGetRxBufferSize(void);
+void   SIOU_SpiUartClearRxBuffer(void);
+
+void   SIOU_UartPutString(const char8 string[]);
+void   SIOU_UartPutCRLF(uint32 txDataByte);
+uint32 SIOU_UartGetChar(void);
+#define SIOU_UartPutChar(ch)    SIOU_SpiUartWriteTxData((uint32)(ch))
+
+void   SIOU_SetTxInterruptMode(uint32 interruptMask);
+uint32 SIOU_GetTxInterruptMode(void);
+uint32 SIOU_GetTxInterruptSource(void);
+void   SIOU_ClearTxInterruptSource(uint32 interruptMask);
+void   SIOU_SetRxInterruptMode(uint32 interruptMask);
+uint32 SIOU_GetRxInterruptMode(void);
+uint32 SIOU_GetRxInterruptSource(void);
+void   SIOU_ClearRxInterruptSource(uint32 interruptMask);
+void   SIOU_SetCustomInterruptHandler(void (*func)(void));
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,77 @@
+#ifndef _SIM_CYTYPES_H_
+#define _SIM_CYTYPES_H_
+/*******************************************************************************
+* FILE: cytypes.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Host simulation stand-in for the PSoC Creator cytypes.h.  Only the types
+* and constants referenced by the node application and its fw_common/
+* fw_psoc_hal dependencies are provided.
+*******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#define CY_PSOC3    (0u)
+#define CY_PSOC4    (1u)
+#define CY_PSOC5    (0u)
+#define CY_IP_M0S8SCB   (1u)
+
+typedef unsigned char   uint8;
+typedef unsigned short  uint16;
+typedef unsigned int    uint32;
+typedef signed   char   int8;
+typedef signed   short  int16;
+typedef signed   int    int32;
+typedef          char   char8;
+typedef          float  float32;
+typedef          double float64;
+typedef          uint64_t uint64;
+typedef          int64_t  int64;
+
+typedef volatile uint8  reg8;
+typedef volatile uint16 reg16;
+typedef volatile uint32 reg32;
+
+typedef uint32 cystatus;
+
+#define CYRET_SUCCESS       (0x00u)
+#define CYRET_BAD_PARAM     (0x01u)
+#define CYRET_INVALID_STATE (0x02u)
+#define CYRET_MEMORY        (0x03u)
+#define CYRET_LOCKED        (0x04u)
+#define CYRET_EMPTY         (0x05u)
+#define CYRET_BAD_DATA      (0x06u)
+#define CYRET_STARTED       (0x07u)
+#define CYRET_FINISHED      (0x08u)
+#define CYRET_CANCELED      (0x09u)
+#define CYRET_TIMEOUT       (0x10u)
+#define CYRET_INVALID_OBJECT (0x20u)
+#define CYRET_UNKNOWN       ((cystatus)0xFFFFFFFFu)
+
+#define CY_GET_REG32(addr)          (*((const reg32 *)(addr)))
+#define CY_SET_REG32(addr, value)   (*((reg32 *)(addr)) = (uint32)(value))
+
+#define CY_INLINE   inline
+#define CY_NOINIT   __attribute__((section(".sim_noinit")))
+#define CY_ISR(FuncName)        void FuncName (void)
+#define CY_ISR_PROTO(FuncName)  void FuncName (void)
+typedef void (* cyisraddress)(void);
+
+#define LO8(x)      ((uint8) ((x) & 0xFFu))
+#define HI8(x)      ((uint8) ((uint16)(x) >> 8))
+#define LO16(x)     ((uint16) ((x) & 0xFFFFu))
+#define HI16(x)     ((uint16) ((uint32)(x) >> 16u))
+
+#endif
+
+/* [] END OF FILE */
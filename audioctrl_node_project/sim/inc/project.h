@@ -0,0 +1,29 @@
+#ifndef _SIM_PROJECT_H_
+#define _SIM_PROJECT_H_
+/*******************************************************************************
+* FILE: project.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Host simulation replacement for the PSoC Creator generated project.h.
+* Pulls in the stand-in component APIs for every instance placed on the
+* audioctrl_node_project TopDesign that the firmware calls.
+*******************************************************************************/
+#include "cytypes.h"
+#include "CyLib.h"
+#include "sim_pins.h"
+#include "SIOU.h"
+#include "SCBM.h"
+#include "CAN.h"
+#include "Bootloadable.h"
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,143 @@
+#ifndef _SIM_HAL_H_
+#define _SIM_HAL_H_
+/*******************************************************************************
+* FILE: sim_hal.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Harness side of the host simulation HAL.  The firmware only ever sees
+* the PSoC Creator style component APIs (project.h); benchmarks and test
+* drivers use the routines below to control simulated time, inject CAN and
+* UART traffic and inspect the peripheral models.
+*
+*     Two clock modes are supported, selected with SIM_CLOCK:
+*       realtime (default) - simulated time is host CLOCK_MONOTONIC and
+*                            interrupts are delivered from a host interval
+*                            timer signal, preempting the main loop.
+*       manual             - time only advances through SIM_Advance(),
+*                            CyDelay() and peripheral status polls, which
+*                            makes benchmark runs fully deterministic.
+*******************************************************************************/
+#include "project.h"
+
+/*******************************************************************************
+ * Clock and interrupt delivery
+ ******************************************************************************/
+#define SIM_NS_PER_US           (1000ull)
+#define SIM_NS_PER_MS           (1000000ull)
+#define SIM_NS_NEVER            (~0ull)
+
+/* Time charged to the manual clock for each polled peripheral status read */
+#ifndef SIM_POLL_NS
+    #define SIM_POLL_NS         (1000ull)
+#endif
+
+void   SIM_Init(void);
+bool   SIM_IsManualClock(void);
+uint64 SIM_ClockNs(void);
+void   SIM_Advance(uint64 ns);
+void   SIM_PollStep(void);
+void   SIM_Service(void);
+void   SIM_Lock(void);
+void   SIM_Unlock(void);
+void   SIM_IrqRaise(uint8 number);
+uint32 SIM_SysTickCyclesToNextReload(void);
+
+/*******************************************************************************
+ * Peripheral models. Each *_Service() brings its model up to date with the
+ * current simulated time and returns the time of its next internal event.
+ ******************************************************************************/
+uint64 SIM_SysTickService(uint64 now);
+uint64 SIM_UartService(uint64 now);
+uint64 SIM_I2cService(uint64 now);
+uint64 SIM_CanService(uint64 now);
+
+/*******************************************************************************
+ * GPIO
+ ******************************************************************************/
+void  SIM_SetNodeAddress(uint8 address);
+uint32 SIM_PinToggleCount(SIM_PIN pin);
+
+/*******************************************************************************
+ * Supply
+ ******************************************************************************/
+void   SIM_SupplyFail(void);
+
+/*******************************************************************************
+ * UART
+ ******************************************************************************/
+void   SIM_UartInject(const uint8* data, size_t length);
+uint32 SIM_UartTxCount(void);
+void   SIM_UartSetEcho(bool echo);
+
+/*******************************************************************************
+ * I2C bus and slave models
+ ******************************************************************************/
+typedef struct
+{
+    const char* name;
+    uint8  address;
+    void*  context;
+    /* Start of a write phase; returns false to NAK the address. */
+    bool  (*start)(void* context, bool read);
+    /* One byte written by the master; returns false to NAK it. */
+    bool  (*write)(void* context, uint8 data);
+    /* One byte requested by the master. */
+    uint8 (*read)(void* context);
+    /* Stop condition. */
+    void  (*stop)(void* context);
+} SIM_I2C_DEVICE;
+
+#define SIM_AMP_I2C_ADDR        (0x20u)
+#define SIM_AMP_NUM_REGS        (256u)
+#define SIM_EEPROM_I2C_ADDR     (0x50u)
+#define SIM_EEPROM_SIZE         (32768u)
+#define SIM_EEPROM_PAGE_SIZE    (64u)
+#define SIM_EEPROM_TWC_NS       (5u * SIM_NS_PER_MS)
+
+typedef struct
+{
+    uint32 transactions;
+    uint32 bytes;
+    uint32 naks;
+    uint64 busy_ns;
+} SIM_I2C_STATS;
+
+void   SIM_I2cAttach(SIM_I2C_DEVICE* device);
+void   SIM_I2cSetBitRate(uint32 hz);
+uint64 SIM_I2cByteNs(void);
+const SIM_I2C_STATS* SIM_I2cStats(void);
+uint8* SIM_AmpRegisters(void);
+uint32 SIM_AmpWriteCount(void);
+uint8* SIM_EepromData(void);
+uint32 SIM_EepromPageWrites(uint16 page);
+void   SIM_EepromSetNak(uint32 count);
+
+/*******************************************************************************
+ * CAN
+ ******************************************************************************/
+typedef struct
+{
+    uint32 id;
+    uint8  dlc;
+    uint8  rtr;
+    uint8  data[8u];
+} SIM_CAN_FRAME;
+
+bool   SIM_CanInject(const SIM_CAN_FRAME* frame);
+bool   SIM_CanPopTx(SIM_CAN_FRAME* frame);
+uint32 SIM_CanRxCount(void);
+uint32 SIM_CanTxCount(void);
+void   SIM_CanSetBitRate(uint32 bps);
+uint64 SIM_CanFrameNs(uint8 dlc);
+
+#endif
+
+/* [] END OF FILE */
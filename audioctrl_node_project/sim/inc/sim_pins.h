@@ -0,0 +1,68 @@
+#ifndef _SIM_PINS_H_
+#define _SIM_PINS_H_
+/*******************************************************************************
+* FILE: sim_pins.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Host simulation stand-in for the per-pin Pins component APIs generated
+* by PSoC Creator (LED_SYS.h, NODE_ADDR_0.h, ...).  Every pin is backed by a
+* single bit of state in sim_gpio.c that the harness can inspect or drive.
+*******************************************************************************/
+#include "cytypes.h"
+
+typedef enum {
+    SIM_PIN_LED_SYS,
+    SIM_PIN_LED_DBG,
+    SIM_PIN_LED_ERR,
+    SIM_PIN_LED_RUN,
+    SIM_PIN_NODE_ADDR_0,
+    SIM_PIN_NODE_ADDR_1,
+    SIM_PIN_NODE_ADDR_2,
+    SIM_PIN_NODE_ADDR_3,
+    SIM_PIN_NODE_ADDR_4,
+    SIM_PIN_NODE_ADDR_5,
+    SIM_PIN_NODE_ADDR_6,
+    SIM_PIN_STR_MON,
+    SIM_PIN_AMP_SHTDN,
+    SIM_PIN_PG_5V,
+    SIM_PIN_CAN_STANDBY,
+    SIM_PIN_CAN_FAULT,
+    SIM_PIN_LAST
+} SIM_PIN;
+
+uint8 SIM_PinRead(SIM_PIN pin);
+void SIM_PinWrite(SIM_PIN pin, uint8 value);
+
+#define SIM_PIN_API(name, id) \
+    static inline uint8 name##_Read(void) { return SIM_PinRead(id); } \
+    static inline uint8 name##_ReadDataReg(void) { return SIM_PinRead(id); } \
+    static inline void name##_Write(uint8 value) { SIM_PinWrite(id, value); }
+
+SIM_PIN_API(LED_SYS, SIM_PIN_LED_SYS)
+SIM_PIN_API(LED_DBG, SIM_PIN_LED_DBG)
+SIM_PIN_API(LED_ERR, SIM_PIN_LED_ERR)
+SIM_PIN_API(LED_RUN, SIM_PIN_LED_RUN)
+SIM_PIN_API(NODE_ADDR_0, SIM_PIN_NODE_ADDR_0)
+SIM_PIN_API(NODE_ADDR_1, SIM_PIN_NODE_ADDR_1)
+SIM_PIN_API(NODE_ADDR_2, SIM_PIN_NODE_ADDR_2)
+SIM_PIN_API(NODE_ADDR_3, SIM_PIN_NODE_ADDR_3)
+SIM_PIN_API(NODE_ADDR_4, SIM_PIN_NODE_ADDR_4)
+SIM_PIN_API(NODE_ADDR_5, SIM_PIN_NODE_ADDR_5)
+SIM_PIN_API(NODE_ADDR_6, SIM_PIN_NODE_ADDR_6)
+SIM_PIN_API(Str_Mon, SIM_PIN_STR_MON)
+SIM_PIN_API(Amp_Shtdn, SIM_PIN_AMP_SHTDN)
+SIM_PIN_API(PG_5V, SIM_PIN_PG_5V)
+SIM_PIN_API(CAN_STANDBY, SIM_PIN_CAN_STANDBY)
+SIM_PIN_API(CAN_FAULT, SIM_PIN_CAN_FAULT)
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,333 @@
+/*******************************************************************************
+* FILE: sim_can.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Host simulation model of the CAN component.  Received frames wait in
+* a queue until the bus has carried them (one frame time each) and a receive
+* mailbox is free, then raise CAN_ISR_NUMBER.  Transmitted frames are queued
+* for the harness and, when bridged, written to SocketCAN.
+*
+* Environment:
+*     SIM_CAN_BPS      bit rate used for frame timing         (default 500000)
+*     SIM_CAN_IF       SocketCAN interface to bridge, e.g. vcan0
+*******************************************************************************/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/can.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#endif
+
+#include "sim_hal.h"
+#include "cyapicallbacks.h"
+
+#define CAN_QUEUE_SIZE      (256u)
+
+typedef struct
+{
+    SIM_CAN_FRAME frame[CAN_QUEUE_SIZE];
+    uint32 head;
+    uint32 count;
+} CAN_QUEUE;
+
+CAN_RX_STRUCT CAN_RX[CAN_NUMBER_OF_RX_MAILBOXES];
+reg32 CAN_INT_SR_REG;
+
+static bool      can_started;
+static uint32    can_bps;
+static CAN_QUEUE can_rxq;
+static CAN_QUEUE can_txq;
+static uint64    can_rx_next_ns;
+static uint32    can_rx_total;
+static uint32    can_tx_total;
+static int       can_fd = -1;
+
+static bool CAN_QueuePush(CAN_QUEUE* q, const SIM_CAN_FRAME* frame)
+{
+    if (q->count == CAN_QUEUE_SIZE)
+    {
+        return (false);
+    }
+    q->frame[(q->head + q->count) % CAN_QUEUE_SIZE] = *frame;
+    q->count++;
+    return (true);
+}
+
+static bool CAN_QueuePop(CAN_QUEUE* q, SIM_CAN_FRAME* frame)
+{
+    if (q->count == 0u)
+    {
+        return (false);
+    }
+    *frame = q->frame[q->head];
+    q->head = (q->head + 1u) % CAN_QUEUE_SIZE;
+    q->count--;
+    return (true);
+}
+
+/*******************************************************************************
+ * Bit time of a standard data frame including worst case bit stuffing.
+ ******************************************************************************/
+uint64 SIM_CanFrameNs(uint8 dlc)
+{
+    uint32 bits = 47u + (8u * dlc) + ((34u + (8u * dlc) - 1u) / 4u);
+    return (((uint64)bits * 1000000000ull) / can_bps);
+}
+
+void SIM_CanSetBitRate(uint32 bps)
+{
+    can_bps = bps;
+}
+
+static void CAN_Init(void)
+{
+    const char* env;
+
+    if (can_bps != 0u)
+    {
+        return;
+    }
+    env = getenv("SIM_CAN_BPS");
+    can_bps = (env != NULL) ? (uint32)strtoul(env, NULL, 0) : 500000u;
+
+#ifdef __linux__
+    env = getenv("SIM_CAN_IF");
+    if ((env != NULL) && !SIM_IsManualClock())
+    {
+        struct sockaddr_can addr;
+        struct ifreq ifr;
+
+        can_fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK, CAN_RAW);
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, env, sizeof(ifr.ifr_name) - 1u);
+        memset(&addr, 0, sizeof(addr));
+        addr.can_family = AF_CAN;
+        if ((can_fd < 0) || (ioctl(can_fd, SIOCGIFINDEX, &ifr) < 0))
+        {
+            can_fd = -1;
+            return;
+        }
+        addr.can_ifindex = ifr.ifr_ifindex;
+        if (bind(can_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+        {
+            close(can_fd);
+            can_fd = -1;
+        }
+    }
+#endif
+}
+
+static void CAN_HostRx(void)
+{
+#ifdef __linux__
+    struct can_frame cf;
+
+    while ((can_fd >= 0) && (read(can_fd, &cf, sizeof(cf)) == (ssize_t)sizeof(cf)))
+    {
+        SIM_CAN_FRAME f;
+        f.id = cf.can_id & CAN_SFF_MASK;
+        f.rtr = ((cf.can_id & CAN_RTR_FLAG) != 0u) ? 1u : 0u;
+        f.dlc = (cf.can_dlc > 8u) ? 8u : cf.can_dlc;
+        memcpy(f.data, cf.data, 8u);
+        (void)SIM_CanInject(&f);
+    }
+#endif
+}
+
+static void CAN_HostTx(const SIM_CAN_FRAME* f)
+{
+#ifdef __linux__
+    if (can_fd >= 0)
+    {
+        struct can_frame cf;
+        memset(&cf, 0, sizeof(cf));
+        cf.can_id = f->id | (f->rtr ? CAN_RTR_FLAG : 0u);
+        cf.can_dlc = f->dlc;
+        memcpy(cf.data, f->data, 8u);
+        (void)write(can_fd, &cf, sizeof(cf));
+    }
+#else
+    (void)f;
+#endif
+}
+
+/*******************************************************************************
+ * Model
+ ******************************************************************************/
+uint64 SIM_CanService(uint64 now)
+{
+    uint32 i;
+    bool raised = false;
+
+    if (!can_started)
+    {
+        return (SIM_NS_NEVER);
+    }
+    CAN_HostRx();
+
+    for (i = 0u; (i < CAN_NUMBER_OF_RX_MAILBOXES) && (can_rxq.count != 0u); i++)
+    {
+        SIM_CAN_FRAME f;
+
+        if ((CAN_RX[i].rxcmd & CAN_RX_ACK_MSG) != 0u)
+        {
+            continue;
+        }
+        if (now < can_rx_next_ns)
+        {
+            break;
+        }
+        (void)CAN_QueuePop(&can_rxq, &f);
+        CAN_RX[i].rxid = f.id << 21u;
+        CAN_RX[i].rxdata[0] = ((uint32)f.data[0] << 24) | ((uint32)f.data[1] << 16) |
+                              ((uint32)f.data[2] << 8) | (uint32)f.data[3];
+        CAN_RX[i].rxdata[1] = ((uint32)f.data[4] << 24) | ((uint32)f.data[5] << 16) |
+                              ((uint32)f.data[6] << 8) | (uint32)f.data[7];
+        CAN_RX[i].rxcmd = CAN_RX_ACK_MSG | ((uint32)f.dlc << 16) | (f.rtr ? CAN_RX_RTR_MSG : 0u);
+        can_rx_next_ns = ((can_rx_next_ns > now) ? can_rx_next_ns : now) + SIM_CanFrameNs(f.dlc);
+        can_rx_total++;
+        raised = true;
+    }
+    if (raised)
+    {
+        CAN_INT_SR_REG |= CAN_RX_MESSAGE;
+        SIM_IrqRaise(CAN_ISR_NUMBER);
+    }
+    return ((can_rxq.count != 0u) ? ((can_rx_next_ns > now) ? can_rx_next_ns : now + SIM_POLL_NS) : SIM_NS_NEVER);
+}
+
+bool SIM_CanInject(const SIM_CAN_FRAME* frame)
+{
+    bool ok;
+    CAN_Init();
+    SIM_Lock();
+    ok = CAN_QueuePush(&can_rxq, frame);
+    SIM_Unlock();
+    return (ok);
+}
+
+bool SIM_CanPopTx(SIM_CAN_FRAME* frame)
+{
+    bool ok;
+    SIM_Lock();
+    ok = CAN_QueuePop(&can_txq, frame);
+    SIM_Unlock();
+    return (ok);
+}
+
+uint32 SIM_CanRxCount(void)
+{
+    return (can_rx_total);
+}
+
+uint32 SIM_CanTxCount(void)
+{
+    return (can_tx_total);
+}
+
+/*******************************************************************************
+ * Component API
+ ******************************************************************************/
+CY_ISR(CAN_ISR)
+{
+    CAN_INT_SR_REG &= ~CAN_RX_MESSAGE;
+    CAN_MsgRXIsr();
+}
+
+void CAN_MsgRXIsr(void)
+{
+    uint8 i;
+    for (i = 0u; i < CAN_NUMBER_OF_RX_MAILBOXES; i++)
+    {
+        if ((CAN_RX[i].rxcmd & CAN_RX_ACK_MSG) != 0u)
+        {
+            CAN_ReceiveMsg(i);
+        }
+    }
+}
+
+void CAN_ReceiveMsg(uint8 rxMailbox)
+{
+#ifdef CAN_RECEIVE_MSG_CALLBACK
+    CAN_ReceiveMsg_Callback();
+#endif
+    CAN_RX_ACK_MESSAGE(rxMailbox);
+}
+
+uint8 CAN_Start(void)
+{
+    CAN_Init();
+    if (CyIntGetVector(CAN_ISR_NUMBER) == NULL)
+    {
+        (void)CyIntSetVector(CAN_ISR_NUMBER, CAN_ISR);
+    }
+    CyIntEnable(CAN_ISR_NUMBER);
+    can_started = true;
+    return (CAN_SUCCESS);
+}
+
+void CAN_Stop(void)
+{
+    can_started = false;
+}
+
+uint8 CAN_GlobalIntEnable(void)
+{
+    CyIntEnable(CAN_ISR_NUMBER);
+    return (CAN_SUCCESS);
+}
+
+uint8 CAN_GlobalIntDisable(void)
+{
+    CyIntDisable(CAN_ISR_NUMBER);
+    return (CAN_SUCCESS);
+}
+
+uint8 CAN_SendMsg(const CAN_TX_MSG *message)
+{
+    SIM_CAN_FRAME f;
+    bool ok;
+
+    if ((message == NULL) || (message->dlc > 8u))
+    {
+        return (CAN_OUT_OF_RANGE);
+    }
+    memset(&f, 0, sizeof(f));
+    f.id = message->id;
+    f.rtr = message->rtr;
+    f.dlc = message->dlc;
+    if (message->msg != NULL)
+    {
+        memcpy(f.data, message->msg->byte, message->dlc);
+    }
+    SIM_Lock();
+    if (can_fd >= 0)
+    {
+        /* Bridged frames go straight to the host bus */
+        CAN_HostTx(&f);
+        ok = true;
+    }
+    else
+    {
+        ok = CAN_QueuePush(&can_txq, &f);
+    }
+    if (ok)
+    {
+        can_tx_total++;
+    }
+    SIM_Unlock();
+    return (ok ? CAN_SUCCESS : CAN_FAIL);
+}
+
+/* [] END OF FILE */
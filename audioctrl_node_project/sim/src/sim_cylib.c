@@ -0,0 +1,693 @@
+/*******************************************************************************
+* FILE: sim_cylib.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Core of the host simulation HAL: simulated clock, NVIC, SysTick, delays,
+* flash rows and power modes.  Interrupt vectors always run on the process
+* main thread.  In realtime mode a host interval timer signal brings the
+* peripheral models up to date and dispatches pending vectors, preempting the
+* firmware main loop just like a Cortex-M0 exception would.  Model state is
+* guarded by sim_busy: a signal arriving while the main thread is inside a
+* model defers its work to the end of that model call.
+*
+* Environment:
+*     SIM_CLOCK        realtime | manual                (default realtime)
+*     SIM_SERVICE_US   host timer period in realtime mode  (default 100)
+*     SIM_RUN_MS       end the process after this much simulated time
+*     SIM_STATS        print peripheral statistics on exit when set
+*     SIM_NODE_ADDR    value read back on the NODE_ADDR_n DIP switch pins
+*******************************************************************************/
+#define _GNU_SOURCE
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "sim_hal.h"
+
+#define SIM_NVIC_VECTORS        (32u)
+
+uint8 sim_flash[CY_FLASH_SIZE];
+reg32 sim_systick_rvr;
+
+static bool   sim_initialized;
+static bool   sim_manual;
+static uint64 sim_manual_ns;
+static uint64 sim_start_ns;
+static uint64 sim_run_ns = SIM_NS_NEVER;
+
+static volatile sig_atomic_t sim_busy;
+static volatile sig_atomic_t sim_deferred;
+static volatile sig_atomic_t sim_in_isr;
+static volatile uint32 sim_primask;
+static volatile uint32 sim_pending;
+static volatile uint32 sim_enabled = (1u << CY_INT_SYSTICK_IRQN);
+static cyisraddress sim_vectors[SIM_NVIC_VECTORS];
+
+static bool   systick_enabled;
+static bool   systick_int;
+static bool   systick_countflag;
+static uint32 systick_period;
+static uint64 systick_reload_cyc;   /* absolute SysClk cycle of the last reload */
+static cySysTickCallback systick_callbacks[CY_SYS_SYST_NUM_OF_CALLBACKS];
+
+static uint32 sim_isr_count[SIM_NVIC_VECTORS];
+
+static void SIM_Dispatch(void);
+
+/*******************************************************************************
+ * Clock
+ ******************************************************************************/
+static uint64 SIM_HostNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64)ts.tv_sec * 1000000000ull) + (uint64)ts.tv_nsec;
+}
+
+bool SIM_IsManualClock(void)
+{
+    return (sim_manual);
+}
+
+uint64 SIM_ClockNs(void)
+{
+    if (sim_manual)
+    {
+        return (sim_manual_ns);
+    }
+    return (SIM_HostNs() - sim_start_ns);
+}
+
+static uint64 SIM_CyclesToNs(uint64 cycles)
+{
+    return ((cycles * 1000ull) / CYDEV_BCLK__SYSCLK__MHZ);
+}
+
+static uint64 SIM_NsToCycles(uint64 ns)
+{
+    return ((ns * CYDEV_BCLK__SYSCLK__MHZ) / 1000ull);
+}
+
+/*******************************************************************************
+ * Brings every peripheral model up to simulated "now" and returns the time of
+ * the earliest pending model event.
+ ******************************************************************************/
+static uint64 SIM_ServiceModels(uint64 now)
+{
+    uint64 next = SIM_SysTickService(now);
+    uint64 t;
+
+    t = SIM_UartService(now);
+    next = (t < next) ? t : next;
+    t = SIM_I2cService(now);
+    next = (t < next) ? t : next;
+    t = SIM_CanService(now);
+    next = (t < next) ? t : next;
+
+    if (now >= sim_run_ns)
+    {
+        exit(0);
+    }
+    return (next);
+}
+
+void SIM_Service(void)
+{
+    if (sim_busy)
+    {
+        sim_deferred = 1;
+        return;
+    }
+    sim_busy++;
+    do
+    {
+        sim_deferred = 0;
+        (void)SIM_ServiceModels(SIM_ClockNs());
+    } while (sim_deferred);
+    sim_busy--;
+    SIM_Dispatch();
+}
+
+void SIM_Lock(void)
+{
+    sim_busy++;
+}
+
+void SIM_Unlock(void)
+{
+    sim_busy--;
+    if ((sim_busy == 0) && sim_deferred)
+    {
+        SIM_Service();
+    }
+}
+
+void SIM_Advance(uint64 ns)
+{
+    if (sim_manual)
+    {
+        uint64 target = sim_manual_ns + ns;
+        while (sim_manual_ns < target)
+        {
+            uint64 next;
+            sim_busy++;
+            next = SIM_ServiceModels(sim_manual_ns);
+            sim_busy--;
+            SIM_Dispatch();
+            sim_manual_ns = (next > sim_manual_ns && next < target) ? next : target;
+        }
+        SIM_Service();
+    }
+    else
+    {
+        struct timespec ts;
+        ts.tv_sec = (time_t)(ns / 1000000000ull);
+        ts.tv_nsec = (long)(ns % 1000000000ull);
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        {
+        }
+        SIM_Service();
+    }
+}
+
+void SIM_PollStep(void)
+{
+    if (sim_manual)
+    {
+        SIM_Advance(SIM_POLL_NS);
+    }
+    else
+    {
+        SIM_Service();
+    }
+}
+
+/*******************************************************************************
+ * NVIC
+ ******************************************************************************/
+static void SIM_Dispatch(void)
+{
+    uint32 n;
+
+    if (sim_in_isr || sim_primask)
+    {
+        return;
+    }
+    sim_in_isr = 1;
+    while ((sim_primask == 0u) && ((sim_pending & sim_enabled) != 0u))
+    {
+        for (n = 0u; n < SIM_NVIC_VECTORS; n++)
+        {
+            uint32 bit = (1u << n);
+            if ((sim_pending & sim_enabled & bit) != 0u)
+            {
+                __atomic_fetch_and(&sim_pending, ~bit, __ATOMIC_SEQ_CST);
+                sim_isr_count[n]++;
+                if (sim_vectors[n] != NULL)
+                {
+                    sim_vectors[n]();
+                }
+                break;
+            }
+        }
+    }
+    sim_in_isr = 0;
+}
+
+void SIM_IrqRaise(uint8 number)
+{
+    if (number < SIM_NVIC_VECTORS)
+    {
+        __atomic_fetch_or(&sim_pending, (1u << number), __ATOMIC_SEQ_CST);
+    }
+}
+
+void CyGlobalIntEnableFn(void)
+{
+    sim_primask = 0u;
+    SIM_Dispatch();
+}
+
+void CyGlobalIntDisableFn(void)
+{
+    sim_primask = 1u;
+}
+
+uint8 CyEnterCriticalSection(void)
+{
+    uint8 state = (uint8)sim_primask;
+    sim_primask = 1u;
+    return (state);
+}
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+    sim_primask = savedIntrStatus;
+    SIM_Dispatch();
+}
+
+cyisraddress CyIntSetVector(uint8 number, cyisraddress address)
+{
+    cyisraddress old = CyIntGetVector(number);
+    if (number < SIM_NVIC_VECTORS)
+    {
+        sim_vectors[number] = address;
+    }
+    return (old);
+}
+
+cyisraddress CyIntGetVector(uint8 number)
+{
+    return ((number < SIM_NVIC_VECTORS) ? sim_vectors[number] : NULL);
+}
+
+void CyIntEnable(uint8 number)
+{
+    if (number < SIM_NVIC_VECTORS)
+    {
+        sim_enabled |= (1u << number);
+        SIM_Dispatch();
+    }
+}
+
+void CyIntDisable(uint8 number)
+{
+    if (number < SIM_NVIC_VECTORS)
+    {
+        sim_enabled &= ~(1u << number);
+    }
+}
+
+uint8 CyIntGetState(uint8 number)
+{
+    return ((number < SIM_NVIC_VECTORS) ? (uint8)((sim_enabled >> number) & 1u) : 0u);
+}
+
+void CyIntSetPending(uint8 number)
+{
+    SIM_IrqRaise(number);
+    SIM_Dispatch();
+}
+
+void CyIntClearPending(uint8 number)
+{
+    if (number < SIM_NVIC_VECTORS)
+    {
+        __atomic_fetch_and(&sim_pending, ~(1u << number), __ATOMIC_SEQ_CST);
+    }
+}
+
+void CyIntSetPriority(uint8 number, uint8 priority)
+{
+    (void)number;
+    (void)priority;
+}
+
+/*******************************************************************************
+ * Delays
+ ******************************************************************************/
+void CyDelay(uint32 milliseconds)
+{
+    SIM_Advance((uint64)milliseconds * SIM_NS_PER_MS);
+}
+
+void CyDelayUs(uint16 microseconds)
+{
+    SIM_Advance((uint64)microseconds * SIM_NS_PER_US);
+}
+
+void CyDelayCycles(uint32 cycles)
+{
+    SIM_Advance(SIM_CyclesToNs(cycles));
+}
+
+/*******************************************************************************
+ * SysTick. The down counter is derived from the time of the last reload, so
+ * CVR reads are exact between service calls.
+ ******************************************************************************/
+static void SIM_SysTickIsr(void)
+{
+    uint32 i;
+    systick_countflag = false;
+    for (i = 0u; i < CY_SYS_SYST_NUM_OF_CALLBACKS; i++)
+    {
+        if (systick_callbacks[i] != NULL)
+        {
+            systick_callbacks[i]();
+        }
+    }
+}
+
+uint64 SIM_SysTickService(uint64 now)
+{
+    uint64 now_cyc = SIM_NsToCycles(now);
+
+    if (!systick_enabled)
+    {
+        return (SIM_NS_NEVER);
+    }
+
+    while (now_cyc >= systick_reload_cyc + systick_period + 1u)
+    {
+        systick_reload_cyc += (uint64)systick_period + 1u;
+        systick_countflag = true;
+        if (systick_int)
+        {
+            SIM_IrqRaise(CY_INT_SYSTICK_IRQN);
+        }
+        /* The counter picks up a new reload value when it wraps */
+        systick_period = sim_systick_rvr & CY_SYS_SYST_RVR_CNT_MASK;
+    }
+    /* First nanosecond at which the next wrap cycle has been reached */
+    return (SIM_CyclesToNs(systick_reload_cyc + systick_period + 1u) + 1u);
+}
+
+uint32 SIM_SysTickReadCvr(void)
+{
+    uint64 elapsed;
+
+    if (!systick_enabled)
+    {
+        return (0u);
+    }
+    if (sim_manual)
+    {
+        /* Reading the counter costs time like any other polled register */
+        sim_manual_ns += 42u;
+    }
+    SIM_Service();
+    elapsed = SIM_NsToCycles(SIM_ClockNs()) - systick_reload_cyc;
+    if (elapsed > systick_period)
+    {
+        elapsed = systick_period;
+    }
+    return (systick_period - (uint32)elapsed);
+}
+
+uint32 SIM_SysTickReadCsr(void)
+{
+    uint32 csr = 0u;
+    csr |= systick_enabled ? CY_SYS_SYST_CSR_ENABLE : 0u;
+    csr |= systick_int ? CY_SYS_SYST_CSR_ENABLE_INT : 0u;
+    csr |= CY_SYS_SYST_CSR_CLK_SRC_SYSCLK;
+    csr |= systick_countflag ? CY_SYS_SYST_CSR_COUNTFLAG : 0u;
+    systick_countflag = false;
+    return (csr);
+}
+
+uintptr_t SIM_Cm0IcsrAddr(void)
+{
+    static reg32 icsr;
+    SIM_Service();
+    icsr = ((sim_pending & (1u << CY_INT_SYSTICK_IRQN)) != 0u) ? 0x04000000u : 0u;
+    return ((uintptr_t)&icsr);
+}
+
+uint32 SIM_SysTickCyclesToNextReload(void)
+{
+    return (SIM_SysTickReadCvr());
+}
+
+void CySysTickInit(void)
+{
+    (void)CyIntSetVector(CY_INT_SYSTICK_IRQN, SIM_SysTickIsr);
+    CySysTickSetReload((CYDEV_BCLK__SYSCLK__HZ / 1000u) - 1u);
+    CySysTickClear();
+}
+
+void CySysTickStart(void)
+{
+    if (CyIntGetVector(CY_INT_SYSTICK_IRQN) != SIM_SysTickIsr)
+    {
+        CySysTickInit();
+    }
+    CySysTickEnable();
+}
+
+void CySysTickEnable(void)
+{
+    CySysTickEnableInterrupt();
+    if (!systick_enabled)
+    {
+        systick_reload_cyc = SIM_NsToCycles(SIM_ClockNs());
+        systick_period = sim_systick_rvr & CY_SYS_SYST_RVR_CNT_MASK;
+        systick_enabled = true;
+    }
+}
+
+void CySysTickStop(void)
+{
+    systick_enabled = false;
+}
+
+void CySysTickEnableInterrupt(void)
+{
+    systick_int = true;
+}
+
+void CySysTickDisableInterrupt(void)
+{
+    systick_int = false;
+}
+
+void CySysTickSetReload(uint32 value)
+{
+    sim_systick_rvr = value & CY_SYS_SYST_RVR_CNT_MASK;
+}
+
+uint32 CySysTickGetReload(void)
+{
+    return (sim_systick_rvr);
+}
+
+uint32 CySysTickGetValue(void)
+{
+    return (SIM_SysTickReadCvr());
+}
+
+void CySysTickClear(void)
+{
+    /* Writing CVR clears it; the next cycle reloads from RVR */
+    systick_reload_cyc = SIM_NsToCycles(SIM_ClockNs());
+    systick_period = sim_systick_rvr & CY_SYS_SYST_RVR_CNT_MASK;
+    systick_countflag = false;
+}
+
+uint32 CySysTickGetCountFlag(void)
+{
+    return ((SIM_SysTickReadCsr() & CY_SYS_SYST_CSR_COUNTFLAG) != 0u) ? 1u : 0u;
+}
+
+cySysTickCallback CySysTickSetCallback(uint32 number, cySysTickCallback function)
+{
+    cySysTickCallback old = CySysTickGetCallback(number);
+    if (number < CY_SYS_SYST_NUM_OF_CALLBACKS)
+    {
+        systick_callbacks[number] = function;
+    }
+    return (old);
+}
+
+cySysTickCallback CySysTickGetCallback(uint32 number)
+{
+    return ((number < CY_SYS_SYST_NUM_OF_CALLBACKS) ? systick_callbacks[number] : NULL);
+}
+
+/*******************************************************************************
+ * Flash
+ ******************************************************************************/
+uint32 CySysFlashWriteRow(uint32 rowNum, const uint8 rowData[])
+{
+    if (rowNum >= CY_FLASH_NUMBER_ROWS)
+    {
+        return (CY_SYS_FLASH_INVALID_ADDR);
+    }
+    memcpy(&sim_flash[rowNum * CY_FLASH_SIZEOF_ROW], rowData, CY_FLASH_SIZEOF_ROW);
+    SIM_Advance((uint64)SIM_FLASH_ROW_WRITE_US * SIM_NS_PER_US);
+    return (CY_SYS_FLASH_SUCCESS);
+}
+
+/*******************************************************************************
+ * Power modes. Sleep returns once an interrupt is pending or serviced.
+ ******************************************************************************/
+static uint32 SIM_IsrTotal(void)
+{
+    uint32 total = 0u;
+    uint32 i;
+    for (i = 0u; i < SIM_NVIC_VECTORS; i++)
+    {
+        total += sim_isr_count[i];
+    }
+    return (total);
+}
+
+void CySysPmSleep(void)
+{
+    uint32 seen = SIM_IsrTotal();
+
+    /* Like WFI, a pending enabled interrupt ends the sleep even while
+     * PRIMASK holds off its handler */
+    while ((SIM_IsrTotal() == seen) && ((sim_pending & sim_enabled) == 0u))
+    {
+        if (sim_manual)
+        {
+            uint64 next;
+            sim_busy++;
+            next = SIM_ServiceModels(sim_manual_ns);
+            sim_busy--;
+            SIM_Advance((next > sim_manual_ns && next != SIM_NS_NEVER) ? (next - sim_manual_ns) : SIM_POLL_NS);
+        }
+        else
+        {
+            sigset_t none;
+            sigemptyset(&none);
+            sigsuspend(&none);
+        }
+    }
+}
+
+void CySysPmDeepSleep(void)
+{
+    CySysPmSleep();
+}
+
+/*******************************************************************************
+ * Low voltage detect. The supply is fine until SIM_SupplyFail(), which trips
+ * an enabled detector once, like a falling supply crossing the threshold.
+ ******************************************************************************/
+static bool sim_lvd_enabled;
+static uint32 sim_lvd_intr;
+
+void CySysLvdEnable(uint32 threshold)
+{
+    (void)threshold;
+    sim_lvd_enabled = true;
+}
+
+void CySysLvdDisable(void)
+{
+    sim_lvd_enabled = false;
+}
+
+uint32 CySysLvdGetInterruptSource(void)
+{
+    return (sim_lvd_intr);
+}
+
+void CySysLvdClearInterrupt(void)
+{
+    sim_lvd_intr = 0u;
+}
+
+void SIM_SupplyFail(void)
+{
+    if (sim_lvd_enabled)
+    {
+        sim_lvd_intr = CY_SYS_LVD_INT;
+        SIM_IrqRaise(SIM_LVD_IRQN);
+    }
+}
+
+void CySoftwareReset(void)
+{
+    fprintf(stderr, "[sim] software reset\n");
+    exit(4);
+}
+
+void Bootloadable_Load(void)
+{
+    fprintf(stderr, "[sim] Bootloadable_Load: reset into bootloader\n");
+    exit(SIM_EXIT_BOOTLOADER);
+}
+
+/*******************************************************************************
+ * Start-up
+ ******************************************************************************/
+static void SIM_SignalHandler(int sig)
+{
+    int saved = errno;
+    (void)sig;
+    SIM_Service();
+    errno = saved;
+}
+
+static void SIM_PrintStats(void)
+{
+    const SIM_I2C_STATS* i2c = SIM_I2cStats();
+    fprintf(stderr,
+            "[sim] %.3f s simulated, %u systick irqs, can rx %u tx %u, "
+            "uart tx %u bytes, i2c %u xfers %u bytes %u naks (%.3f ms busy)\n",
+            (double)SIM_ClockNs() / 1e9,
+            sim_isr_count[CY_INT_SYSTICK_IRQN],
+            SIM_CanRxCount(), SIM_CanTxCount(), SIM_UartTxCount(),
+            i2c->transactions, i2c->bytes, i2c->naks,
+            (double)i2c->busy_ns / 1e6);
+}
+
+void SIM_Init(void)
+{
+    const char* env;
+
+    if (sim_initialized)
+    {
+        return;
+    }
+    sim_initialized = true;
+
+    env = getenv("SIM_CLOCK");
+    sim_manual = (env != NULL) && (strcmp(env, "manual") == 0);
+    sim_start_ns = SIM_HostNs();
+
+    env = getenv("SIM_RUN_MS");
+    if (env != NULL)
+    {
+        sim_run_ns = strtoull(env, NULL, 0) * SIM_NS_PER_MS;
+    }
+    if (getenv("SIM_STATS") != NULL)
+    {
+        atexit(SIM_PrintStats);
+    }
+    env = getenv("SIM_NODE_ADDR");
+    SIM_SetNodeAddress((env != NULL) ? (uint8)strtoul(env, NULL, 0) : 0x17u);
+
+    if (!sim_manual)
+    {
+        struct sigaction sa;
+        struct itimerval it;
+        long period_us = 100;
+
+        env = getenv("SIM_SERVICE_US");
+        if (env != NULL)
+        {
+            period_us = strtol(env, NULL, 0);
+        }
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = SIM_SignalHandler;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGALRM, &sa, NULL);
+
+        it.it_interval.tv_sec = 0;
+        it.it_interval.tv_usec = period_us;
+        it.it_value = it.it_interval;
+        setitimer(ITIMER_REAL, &it, NULL);
+    }
+}
+
+static void __attribute__((constructor)) SIM_Constructor(void)
+{
+    SIM_Init();
+}
+
+/* [] END OF FILE */
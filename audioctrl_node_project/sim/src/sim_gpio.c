@@ -0,0 +1,60 @@
+/*******************************************************************************
+* FILE: sim_gpio.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Host simulation model of the Pins components.  Outputs latch the last
+* written value and count edges so LED and amplifier control activity can be
+* measured; the NODE_ADDR_n inputs reflect the simulated DIP switch.
+*******************************************************************************/
+#include "sim_hal.h"
+
+static uint8  pin_state[SIM_PIN_LAST];
+static uint32 pin_toggles[SIM_PIN_LAST];
+
+uint8 SIM_PinRead(SIM_PIN pin)
+{
+    return ((pin < SIM_PIN_LAST) ? pin_state[pin] : 0u);
+}
+
+void SIM_PinWrite(SIM_PIN pin, uint8 value)
+{
+    if (pin < SIM_PIN_LAST)
+    {
+        value &= 0x01u;
+        if (pin_state[pin] != value)
+        {
+            pin_toggles[pin]++;
+        }
+        pin_state[pin] = value;
+    }
+}
+
+uint32 SIM_PinToggleCount(SIM_PIN pin)
+{
+    return ((pin < SIM_PIN_LAST) ? pin_toggles[pin] : 0u);
+}
+
+/*******************************************************************************
+ * The DIP switch is active low on the board: a closed switch reads 0.
+ ******************************************************************************/
+void SIM_SetNodeAddress(uint8 address)
+{
+    uint8 i;
+    for (i = 0u; i < 7u; i++)
+    {
+        pin_state[SIM_PIN_NODE_ADDR_0 + i] = ((address >> i) & 0x01u) ? 0u : 1u;
+    }
+    /* Supplies are good and the CAN transceiver reports no fault */
+    pin_state[SIM_PIN_PG_5V] = 1u;
+    pin_state[SIM_PIN_CAN_FAULT] = 1u;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,558 @@
+/*******************************************************************************
+* FILE: sim_i2c.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Host simulation model of the SCBM I2C master and the slaves on the
+* node's I2C bus:
+*       - the speaker amplifier at 0x20, a plain 256 byte register file with
+*         an auto-incrementing register pointer;
+*       - the 24AA256 EEPROM at 0x50: 32 KiB, 2 byte addressing, 64 byte page
+*         buffer that wraps inside the page and a 5 ms self-timed write cycle
+*         during which the device does not acknowledge its address.
+*
+*     Buffer mode transfers are executed against the slave at once but only
+* report completion after the bus time of the transfer (9 bit times a byte
+* plus start/stop) has elapsed, then raise SCBM_ISR_NUMBER.  Manual mode
+* calls block for the bus time of each byte.
+*
+* Environment:
+*     SIM_I2C_HZ       SCL rate                               (default 400000)
+*     SIM_EEPROM_FILE  backing file that keeps the EEPROM across runs
+*******************************************************************************/
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim_hal.h"
+
+#define I2C_MAX_DEVICES     (8u)
+
+static SIM_I2C_DEVICE* i2c_devices[I2C_MAX_DEVICES];
+static uint32 i2c_num_devices;
+static uint64 i2c_byte_ns;
+static SIM_I2C_STATS i2c_stats;
+
+static SIM_I2C_DEVICE* i2c_active;
+static uint32 i2c_status;
+static uint32 i2c_pending_status;
+static uint64 i2c_done_ns;
+static bool   i2c_xfer;
+static uint32 i2c_wr_count;
+static uint32 i2c_rd_count;
+static void (*i2c_custom_isr)(void);
+
+/*******************************************************************************
+ * Amplifier register file
+ ******************************************************************************/
+typedef struct
+{
+    uint8  regs[SIM_AMP_NUM_REGS];
+    uint8  pointer;
+    bool   have_pointer;
+    uint32 writes;
+} SIM_AMP;
+
+static SIM_AMP amp;
+
+static bool AMP_Start(void* context, bool read)
+{
+    SIM_AMP* a = context;
+    if (!read)
+    {
+        a->have_pointer = false;
+    }
+    return (true);
+}
+
+static bool AMP_Write(void* context, uint8 data)
+{
+    SIM_AMP* a = context;
+    if (!a->have_pointer)
+    {
+        a->pointer = data;
+        a->have_pointer = true;
+    }
+    else
+    {
+        a->regs[a->pointer++] = data;
+        a->writes++;
+    }
+    return (true);
+}
+
+static uint8 AMP_Read(void* context)
+{
+    SIM_AMP* a = context;
+    return (a->regs[a->pointer++]);
+}
+
+static void AMP_Stop(void* context)
+{
+    (void)context;
+}
+
+static SIM_I2C_DEVICE amp_device = {
+    "amp", SIM_AMP_I2C_ADDR, &amp, AMP_Start, AMP_Write, AMP_Read, AMP_Stop
+};
+
+uint8* SIM_AmpRegisters(void)
+{
+    return (amp.regs);
+}
+
+uint32 SIM_AmpWriteCount(void)
+{
+    return (amp.writes);
+}
+
+/*******************************************************************************
+ * 24AA256 EEPROM
+ ******************************************************************************/
+typedef struct
+{
+    uint8  mem[SIM_EEPROM_SIZE];
+    uint8  page[SIM_EEPROM_PAGE_SIZE];
+    uint8  page_valid[SIM_EEPROM_PAGE_SIZE];
+    uint16 address;
+    uint8  addr_bytes;
+    uint32 data_bytes;
+    uint64 busy_until;
+    uint32 force_nak;
+    uint32 page_writes[SIM_EEPROM_SIZE / SIM_EEPROM_PAGE_SIZE];
+    int    fd;
+} SIM_EEPROM;
+
+static SIM_EEPROM eeprom = { .fd = -1 };
+
+static bool EE_Start(void* context, bool read)
+{
+    SIM_EEPROM* e = context;
+
+    if (e->force_nak != 0u)
+    {
+        e->force_nak--;
+        return (false);
+    }
+    /* No acknowledge while the write cycle is in progress */
+    if (SIM_ClockNs() < e->busy_until)
+    {
+        return (false);
+    }
+    if (!read)
+    {
+        e->addr_bytes = 0u;
+        e->data_bytes = 0u;
+        memset(e->page_valid, 0, sizeof(e->page_valid));
+    }
+    return (true);
+}
+
+static bool EE_Write(void* context, uint8 data)
+{
+    SIM_EEPROM* e = context;
+
+    if (e->addr_bytes == 0u)
+    {
+        e->address = (uint16)((data & 0x7Fu) << 8);
+        e->addr_bytes++;
+    }
+    else if (e->addr_bytes == 1u)
+    {
+        e->address |= data;
+        e->addr_bytes++;
+    }
+    else
+    {
+        /* The internal address wraps inside the page buffer */
+        uint16 offset = (uint16)((e->address + e->data_bytes) % SIM_EEPROM_PAGE_SIZE);
+        e->page[offset] = data;
+        e->page_valid[offset] = 1u;
+        e->data_bytes++;
+    }
+    return (true);
+}
+
+static uint8 EE_Read(void* context)
+{
+    SIM_EEPROM* e = context;
+    uint8 data = e->mem[e->address];
+    e->address = (uint16)((e->address + 1u) % SIM_EEPROM_SIZE);
+    return (data);
+}
+
+static void EE_Stop(void* context)
+{
+    SIM_EEPROM* e = context;
+    uint16 base;
+    uint16 i;
+
+    if (e->data_bytes == 0u)
+    {
+        return;
+    }
+    base = (uint16)(e->address & ~(SIM_EEPROM_PAGE_SIZE - 1u));
+    for (i = 0u; i < SIM_EEPROM_PAGE_SIZE; i++)
+    {
+        if (e->page_valid[i])
+        {
+            e->mem[base + i] = e->page[i];
+        }
+    }
+    e->page_writes[base / SIM_EEPROM_PAGE_SIZE]++;
+    e->address = (uint16)(base + ((e->address + e->data_bytes) % SIM_EEPROM_PAGE_SIZE));
+    e->data_bytes = 0u;
+    e->busy_until = SIM_ClockNs() + SIM_EEPROM_TWC_NS;
+
+    if (e->fd >= 0)
+    {
+        (void)pwrite(e->fd, &e->mem[base], SIM_EEPROM_PAGE_SIZE, base);
+    }
+}
+
+static SIM_I2C_DEVICE eeprom_device = {
+    "24AA256", SIM_EEPROM_I2C_ADDR, &eeprom, EE_Start, EE_Write, EE_Read, EE_Stop
+};
+
+uint8* SIM_EepromData(void)
+{
+    return (eeprom.mem);
+}
+
+uint32 SIM_EepromPageWrites(uint16 page)
+{
+    return ((page < (SIM_EEPROM_SIZE / SIM_EEPROM_PAGE_SIZE)) ? eeprom.page_writes[page] : 0u);
+}
+
+void SIM_EepromSetNak(uint32 count)
+{
+    eeprom.force_nak = count;
+}
+
+/*******************************************************************************
+ * Bus
+ ******************************************************************************/
+void SIM_I2cAttach(SIM_I2C_DEVICE* device)
+{
+    if (i2c_num_devices < I2C_MAX_DEVICES)
+    {
+        i2c_devices[i2c_num_devices++] = device;
+    }
+}
+
+void SIM_I2cSetBitRate(uint32 hz)
+{
+    i2c_byte_ns = (9u * 1000000000ull) / hz;
+}
+
+uint64 SIM_I2cByteNs(void)
+{
+    return (i2c_byte_ns);
+}
+
+const SIM_I2C_STATS* SIM_I2cStats(void)
+{
+    return (&i2c_stats);
+}
+
+static SIM_I2C_DEVICE* I2C_Find(uint32 address)
+{
+    uint32 i;
+    for (i = 0u; i < i2c_num_devices; i++)
+    {
+        if (i2c_devices[i]->address == address)
+        {
+            return (i2c_devices[i]);
+        }
+    }
+    return (NULL);
+}
+
+static void I2C_Init(void)
+{
+    const char* env;
+
+    if (i2c_byte_ns != 0u)
+    {
+        return;
+    }
+    env = getenv("SIM_I2C_HZ");
+    SIM_I2cSetBitRate((env != NULL) ? (uint32)strtoul(env, NULL, 0) : 400000u);
+    memset(eeprom.mem, 0xFF, sizeof(eeprom.mem));
+    env = getenv("SIM_EEPROM_FILE");
+    if (env != NULL)
+    {
+        eeprom.fd = open(env, O_RDWR | O_CREAT, 0644);
+        if (eeprom.fd >= 0)
+        {
+            if (pread(eeprom.fd, eeprom.mem, SIM_EEPROM_SIZE, 0) != (ssize_t)SIM_EEPROM_SIZE)
+            {
+                (void)pwrite(eeprom.fd, eeprom.mem, SIM_EEPROM_SIZE, 0);
+            }
+        }
+    }
+    SIM_I2cAttach(&amp_device);
+    SIM_I2cAttach(&eeprom_device);
+}
+
+/*******************************************************************************
+ * Runs the address phase. Returns the slave or NULL on a NAK.
+ ******************************************************************************/
+static SIM_I2C_DEVICE* I2C_Address(uint32 address, bool read)
+{
+    SIM_I2C_DEVICE* dev = I2C_Find(address);
+
+    i2c_stats.transactions++;
+    i2c_stats.bytes++;
+    if ((dev == NULL) || !dev->start(dev->context, read))
+    {
+        i2c_stats.naks++;
+        return (NULL);
+    }
+    return (dev);
+}
+
+static void I2C_Stop(void)
+{
+    if (i2c_active != NULL)
+    {
+        i2c_active->stop(i2c_active->context);
+        i2c_active = NULL;
+    }
+}
+
+uint64 SIM_I2cService(uint64 now)
+{
+    if (!i2c_xfer)
+    {
+        return (SIM_NS_NEVER);
+    }
+    if (now < i2c_done_ns)
+    {
+        return (i2c_done_ns);
+    }
+    i2c_xfer = false;
+    i2c_status = (i2c_status & ~SCBM_I2C_MSTAT_XFER_INP) | i2c_pending_status;
+    SIM_IrqRaise(SCBM_ISR_NUMBER);
+    return (SIM_NS_NEVER);
+}
+
+static CY_ISR(SCBM_I2C_ISR)
+{
+    if (i2c_custom_isr != NULL)
+    {
+        i2c_custom_isr();
+    }
+}
+
+/*******************************************************************************
+ * Component API, buffer mode
+ ******************************************************************************/
+void SCBM_Start(void)
+{
+    I2C_Init();
+    (void)CyIntSetVector(SCBM_ISR_NUMBER, SCBM_I2C_ISR);
+    CyIntEnable(SCBM_ISR_NUMBER);
+}
+
+/* Disabling the block abandons a buffer transfer without completing it */
+void SCBM_Stop(void)
+{
+    SIM_Lock();
+    i2c_xfer = false;
+    I2C_Stop();
+    SIM_Unlock();
+}
+
+void SCBM_SetCustomInterruptHandler(void (*func)(void))
+{
+    i2c_custom_isr = func;
+}
+
+static uint32 I2C_BufferXfer(uint32 slaveAddress, uint8* data, uint32 cnt, uint32 mode, bool read)
+{
+    uint32 done = 0u;
+    uint32 status;
+
+    I2C_Init();
+    if (i2c_xfer || ((i2c_active != NULL) && ((mode & SCBM_I2C_MODE_REPEAT_START) == 0u)))
+    {
+        return (SCBM_I2C_MSTR_BUS_BUSY);
+    }
+
+    SIM_Lock();
+    i2c_active = I2C_Address(slaveAddress, read);
+    if (i2c_active == NULL)
+    {
+        status = SCBM_I2C_MSTAT_ERR_XFER | SCBM_I2C_MSTAT_ERR_ADDR_NAK;
+    }
+    else
+    {
+        status = read ? SCBM_I2C_MSTAT_RD_CMPLT : SCBM_I2C_MSTAT_WR_CMPLT;
+        for (done = 0u; done < cnt; done++)
+        {
+            if (read)
+            {
+                data[done] = i2c_active->read(i2c_active->context);
+            }
+            else if (!i2c_active->write(i2c_active->context, data[done]))
+            {
+                status |= SCBM_I2C_MSTAT_ERR_XFER | SCBM_I2C_MSTAT_ERR_SHORT_XFER;
+                done++;
+                break;
+            }
+        }
+        i2c_stats.bytes += done;
+    }
+
+    if (((mode & SCBM_I2C_MODE_NO_STOP) == 0u) || ((status & SCBM_I2C_MSTAT_ERR_XFER) != 0u))
+    {
+        I2C_Stop();
+    }
+    else
+    {
+        status |= SCBM_I2C_MSTAT_XFER_HALT;
+    }
+
+    if (read)
+    {
+        i2c_rd_count = done;
+    }
+    else
+    {
+        i2c_wr_count = done;
+    }
+    i2c_pending_status = status;
+    i2c_status = SCBM_I2C_MSTAT_XFER_INP;
+    i2c_done_ns = SIM_ClockNs() + ((uint64)(done + 2u) * i2c_byte_ns);
+    i2c_stats.busy_ns += (uint64)(done + 2u) * i2c_byte_ns;
+    i2c_xfer = true;
+    SIM_Unlock();
+    return (SCBM_I2C_MSTR_NO_ERROR);
+}
+
+uint32 SCBM_I2CMasterWriteBuf(uint32 slaveAddress, uint8 * wrData, uint32 cnt, uint32 mode)
+{
+    return (I2C_BufferXfer(slaveAddress, wrData, cnt, mode, false));
+}
+
+uint32 SCBM_I2CMasterReadBuf(uint32 slaveAddress, uint8 * rdData, uint32 cnt, uint32 mode)
+{
+    return (I2C_BufferXfer(slaveAddress, rdData, cnt, mode, true));
+}
+
+uint32 SCBM_I2CMasterStatus(void)
+{
+    SIM_PollStep();
+    return (i2c_status);
+}
+
+uint32 SCBM_I2CMasterClearStatus(void)
+{
+    uint32 status = i2c_status;
+    i2c_status &= SCBM_I2C_MSTAT_XFER_INP;
+    return (status);
+}
+
+uint32 SCBM_I2CMasterGetWriteBufSize(void)
+{
+    return (i2c_wr_count);
+}
+
+uint32 SCBM_I2CMasterGetReadBufSize(void)
+{
+    return (i2c_rd_count);
+}
+
+void SCBM_I2CMasterClearWriteBuf(void)
+{
+    i2c_wr_count = 0u;
+}
+
+void SCBM_I2CMasterClearReadBuf(void)
+{
+    i2c_rd_count = 0u;
+}
+
+/*******************************************************************************
+ * Component API, manual mode. Each call blocks for its bus time.
+ ******************************************************************************/
+static void I2C_BusWait(uint32 bytes)
+{
+    uint64 until = SIM_ClockNs() + ((uint64)bytes * i2c_byte_ns);
+    i2c_stats.busy_ns += (uint64)bytes * i2c_byte_ns;
+    while (SIM_ClockNs() < until)
+    {
+        SIM_PollStep();
+    }
+}
+
+uint32 SCBM_I2CMasterSendStart(uint32 slaveAddress, uint32 bitRnW)
+{
+    I2C_Init();
+    if (i2c_xfer || (i2c_active != NULL))
+    {
+        return (SCBM_I2C_MSTR_BUS_BUSY);
+    }
+    return (SCBM_I2CMasterSendRestart(slaveAddress, bitRnW));
+}
+
+uint32 SCBM_I2CMasterSendRestart(uint32 slaveAddress, uint32 bitRnW)
+{
+    SIM_Lock();
+    i2c_active = I2C_Address(slaveAddress, bitRnW == SCBM_I2C_READ_XFER_MODE);
+    SIM_Unlock();
+    I2C_BusWait(1u);
+    return ((i2c_active != NULL) ? SCBM_I2C_MSTR_NO_ERROR : SCBM_I2C_MSTR_ERR_LB_NAK);
+}
+
+uint32 SCBM_I2CMasterSendStop(void)
+{
+    SIM_Lock();
+    I2C_Stop();
+    SIM_Unlock();
+    return (SCBM_I2C_MSTR_NO_ERROR);
+}
+
+uint32 SCBM_I2CMasterWriteByte(uint32 theByte)
+{
+    bool ack;
+
+    if (i2c_active == NULL)
+    {
+        return (SCBM_I2C_MSTR_NOT_READY);
+    }
+    SIM_Lock();
+    ack = i2c_active->write(i2c_active->context, (uint8)theByte);
+    i2c_stats.bytes++;
+    SIM_Unlock();
+    I2C_BusWait(1u);
+    return (ack ? SCBM_I2C_MSTR_NO_ERROR : SCBM_I2C_MSTR_ERR_LB_NAK);
+}
+
+uint32 SCBM_I2CMasterReadByte(uint32 ackNack)
+{
+    uint8 data;
+
+    if (i2c_active == NULL)
+    {
+        return (0u);
+    }
+    SIM_Lock();
+    data = i2c_active->read(i2c_active->context);
+    i2c_stats.bytes++;
+    SIM_Unlock();
+    I2C_BusWait(1u);
+    (void)ackNack;
+    return (data);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,395 @@
+/*******************************************************************************
+* FILE: sim_uart.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Host simulation model of the SIOU SCB in UART mode.  The TX shifter
+* drains the 8 byte hardware FIFO one frame (start + 8 data + stop bits)
+* at a time, so a blocking SIOU_UartPutString() takes as long as it does on
+* the board.  Interrupt sources are level sensitive like the SCB's.
+*
+* Environment:
+*     SIM_UART_BAUD    line rate                          (default 115200)
+*     SIM_UART_TX      file receiving transmitted bytes   (default stdout)
+*     SIM_UART_RX      file feeding received bytes, "none" disables stdin
+*******************************************************************************/
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim_hal.h"
+
+#define UART_HOST_RX_SIZE   (4096u)
+
+static bool   uart_started;
+static int    uart_tx_fd = STDOUT_FILENO;
+static int    uart_rx_fd = -1;
+static uint64 uart_byte_ns;
+
+static uint8  tx_fifo[SIOU_FIFO_SIZE];
+static uint32 tx_head;
+static uint32 tx_count;
+static bool   tx_shifting;
+static uint64 tx_done_ns;
+static uint32 tx_total;
+static uint32 tx_intr_mask;
+static uint32 tx_intr_latched;
+
+static uint8  rx_fifo[SIOU_FIFO_SIZE];
+static uint32 rx_head;
+static uint32 rx_count;
+static uint64 rx_next_ns;
+static uint32 rx_intr_mask;
+static uint32 rx_intr_latched;
+
+static uint8  host_rx[UART_HOST_RX_SIZE];
+static uint32 host_rx_head;
+static uint32 host_rx_count;
+
+static bool   uart_echo;
+static void (*uart_custom_isr)(void);
+
+/*******************************************************************************
+ * Model
+ ******************************************************************************/
+static void SIOU_Init(void)
+{
+    const char* env;
+
+    if (uart_byte_ns != 0u)
+    {
+        return;
+    }
+    env = getenv("SIM_UART_BAUD");
+    uart_byte_ns = (10u * 1000000000ull) / ((env != NULL) ? strtoull(env, NULL, 0) : 115200u);
+
+    env = getenv("SIM_UART_TX");
+    if (env != NULL)
+    {
+        uart_tx_fd = open(env, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    env = getenv("SIM_UART_RX");
+    if (env == NULL)
+    {
+        uart_rx_fd = STDIN_FILENO;
+    }
+    else if (strcmp(env, "none") != 0)
+    {
+        uart_rx_fd = open(env, O_RDONLY);
+    }
+    if (uart_rx_fd >= 0)
+    {
+        (void)fcntl(uart_rx_fd, F_SETFL, fcntl(uart_rx_fd, F_GETFL) | O_NONBLOCK);
+    }
+}
+
+static void SIM_UartHostRx(void)
+{
+    uint8 buf[64];
+    ssize_t n;
+    ssize_t i;
+
+    if ((uart_rx_fd < 0) || SIM_IsManualClock())
+    {
+        return;
+    }
+    n = read(uart_rx_fd, buf, sizeof(buf));
+    for (i = 0; i < n; i++)
+    {
+        SIM_UartInject(&buf[i], 1u);
+    }
+}
+
+static uint32 SIOU_TxSource(void)
+{
+    uint32 source = tx_intr_latched;
+    if (tx_count < SIOU_FIFO_SIZE)
+    {
+        source |= SIOU_INTR_TX_NOT_FULL;
+    }
+    if (tx_count == 0u)
+    {
+        source |= SIOU_INTR_TX_EMPTY;
+    }
+    return (source);
+}
+
+static uint32 SIOU_RxSource(void)
+{
+    uint32 source = rx_intr_latched;
+    if (rx_count != 0u)
+    {
+        source |= SIOU_INTR_RX_NOT_EMPTY;
+    }
+    if (rx_count == SIOU_FIFO_SIZE)
+    {
+        source |= SIOU_INTR_RX_FULL;
+    }
+    return (source);
+}
+
+uint64 SIM_UartService(uint64 now)
+{
+    uint64 next = SIM_NS_NEVER;
+
+    if (!uart_started)
+    {
+        return (next);
+    }
+
+    /* Transmit shifter */
+    while (tx_shifting && (now >= tx_done_ns))
+    {
+        uint8 c = tx_fifo[tx_head];
+        (void)write(uart_tx_fd, &c, 1u);
+        tx_head = (tx_head + 1u) % SIOU_FIFO_SIZE;
+        tx_count--;
+        tx_total++;
+        if (tx_count != 0u)
+        {
+            tx_done_ns += uart_byte_ns;
+        }
+        else
+        {
+            tx_shifting = false;
+            tx_intr_latched |= SIOU_INTR_TX_UART_DONE;
+        }
+    }
+    if (tx_shifting)
+    {
+        next = tx_done_ns;
+    }
+
+    /* Receive line, one frame time per byte */
+    SIM_UartHostRx();
+    while ((host_rx_count != 0u) && (now >= rx_next_ns))
+    {
+        if (rx_count < SIOU_FIFO_SIZE)
+        {
+            rx_fifo[(rx_head + rx_count) % SIOU_FIFO_SIZE] = host_rx[host_rx_head];
+            rx_count++;
+        }
+        else
+        {
+            rx_intr_latched |= SIOU_INTR_RX_OVERFLOW;
+        }
+        host_rx_head = (host_rx_head + 1u) % UART_HOST_RX_SIZE;
+        host_rx_count--;
+        rx_next_ns = ((rx_next_ns == 0u) ? now : rx_next_ns) + uart_byte_ns;
+    }
+    if (host_rx_count != 0u)
+    {
+        next = (rx_next_ns < next) ? rx_next_ns : next;
+    }
+    else
+    {
+        rx_next_ns = 0u;
+    }
+
+    if (((SIOU_TxSource() & tx_intr_mask) != 0u) || ((SIOU_RxSource() & rx_intr_mask) != 0u))
+    {
+        SIM_IrqRaise(SIOU_ISR_NUMBER);
+    }
+    return (next);
+}
+
+void SIM_UartInject(const uint8* data, size_t length)
+{
+    while (length-- != 0u)
+    {
+        if (host_rx_count < UART_HOST_RX_SIZE)
+        {
+            host_rx[(host_rx_head + host_rx_count) % UART_HOST_RX_SIZE] = *data;
+            host_rx_count++;
+        }
+        data++;
+    }
+}
+
+uint32 SIM_UartTxCount(void)
+{
+    return (tx_total);
+}
+
+void SIM_UartSetEcho(bool echo)
+{
+    uart_echo = echo;
+}
+
+static CY_ISR(SIOU_SPI_UART_ISR)
+{
+    if (uart_custom_isr != NULL)
+    {
+        uart_custom_isr();
+    }
+}
+
+/*******************************************************************************
+ * Component API
+ ******************************************************************************/
+void SIOU_Start(void)
+{
+    SIOU_Init();
+    (void)CyIntSetVector(SIOU_ISR_NUMBER, SIOU_SPI_UART_ISR);
+    CyIntEnable(SIOU_ISR_NUMBER);
+    uart_started = true;
+}
+
+void SIOU_Stop(void)
+{
+    uart_started = false;
+}
+
+void SIOU_SpiUartWriteTxData(uint32 txData)
+{
+    /* The SCB blocks the caller while the FIFO is full */
+    while (uart_started && (tx_count == SIOU_FIFO_SIZE))
+    {
+        SIM_PollStep();
+    }
+    if (!uart_started)
+    {
+        return;
+    }
+    SIM_Lock();
+    tx_fifo[(tx_head + tx_count) % SIOU_FIFO_SIZE] = (uint8)txData;
+    tx_count++;
+    if (!tx_shifting)
+    {
+        tx_shifting = true;
+        tx_done_ns = SIM_ClockNs() + uart_byte_ns;
+    }
+    if (uart_echo && (uart_tx_fd != STDERR_FILENO))
+    {
+        uint8 c = (uint8)txData;
+        (void)write(STDERR_FILENO, &c, 1u);
+    }
+    SIM_Unlock();
+}
+
+void SIOU_SpiUartPutArray(const uint8 wrBuf[], uint32 count)
+{
+    uint32 i;
+    for (i = 0u; i < count; i++)
+    {
+        SIOU_SpiUartWriteTxData(wrBuf[i]);
+    }
+}
+
+uint32 SIOU_SpiUartGetTxBufferSize(void)
+{
+    SIM_PollStep();
+    return (tx_count);
+}
+
+void SIOU_SpiUartClearTxBuffer(void)
+{
+    SIM_Lock();
+    tx_count = 0u;
+    tx_shifting = false;
+    SIM_Unlock();
+}
+
+uint32 SIOU_SpiUartReadRxData(void)
+{
+    uint32 data = 0u;
+    SIM_Lock();
+    if (rx_count != 0u)
+    {
+        data = rx_fifo[rx_head];
+        rx_head = (rx_head + 1u) % SIOU_FIFO_SIZE;
+        rx_count--;
+    }
+    SIM_Unlock();
+    return (data);
+}
+
+uint32 SIOU_SpiUartGetRxBufferSize(void)
+{
+    SIM_PollStep();
+    return (rx_count);
+}
+
+void SIOU_SpiUartClearRxBuffer(void)
+{
+    SIM_Lock();
+    rx_count = 0u;
+    SIM_Unlock();
+}
+
+void SIOU_UartPutString(const char8 string[])
+{
+    while (*string != '\0')
+    {
+        SIOU_SpiUartWriteTxData((uint8)*string++);
+    }
+}
+
+void SIOU_UartPutCRLF(uint32 txDataByte)
+{
+    SIOU_SpiUartWriteTxData(txDataByte);
+    SIOU_SpiUartWriteTxData('\r');
+    SIOU_SpiUartWriteTxData('\n');
+}
+
+uint32 SIOU_UartGetChar(void)
+{
+    return ((SIOU_SpiUartGetRxBufferSize() != 0u) ? SIOU_SpiUartReadRxData() : 0u);
+}
+
+void SIOU_SetTxInterruptMode(uint32 interruptMask)
+{
+    tx_intr_mask = interruptMask;
+    SIM_Service();
+}
+
+uint32 SIOU_GetTxInterruptMode(void)
+{
+    return (tx_intr_mask);
+}
+
+uint32 SIOU_GetTxInterruptSource(void)
+{
+    return (SIOU_TxSource());
+}
+
+void SIOU_ClearTxInterruptSource(uint32 interruptMask)
+{
+    tx_intr_latched &= ~interruptMask;
+}
+
+void SIOU_SetRxInterruptMode(uint32 interruptMask)
+{
+    rx_intr_mask = interruptMask;
+    SIM_Service();
+}
+
+uint32 SIOU_GetRxInterruptMode(void)
+{
+    return (rx_intr_mask);
+}
+
+uint32 SIOU_GetRxInterruptSource(void)
+{
+    return (SIOU_RxSource());
+}
+
+void SIOU_ClearRxInterruptSource(uint32 interruptMask)
+{
+    rx_intr_latched &= ~interruptMask;
+}
+
+void SIOU_SetCustomInterruptHandler(void (*func)(void))
+{
+    uart_custom_isr = func;
+}
+
+/* [] END OF FILE */
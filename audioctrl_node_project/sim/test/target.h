@@ -0,0 +1,22 @@
+#ifndef _TEST_TARGET_H_
+#define _TEST_TARGET_H_
+/*******************************************************************************
+* FILE: target.h
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Stand-in for the fw_common target header, for the host tests that
+* build an application module without fw_common.
+*******************************************************************************/
+#include <project.h>
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,103 @@
+/*******************************************************************************
+* FILE: test_fmt.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Checks FMT_Snprintf() against the host C library for every format of
+* the table, each with a set of values.  Prints the mismatches and exits
+* non-zero if there are any.
+*******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "fmt.h"
+
+static const char* const test_int_formats[] =
+{
+    "%d", "%i", "%5d", "%-5d|", "%05d", "%+d", "% d", "%.3d", "%8.3d", "%-8.3d|", "%.0d",
+    "%u", "%x", "%X", "%o", "%#x", "%#X", "%#o", "%#.0o", "%#.0x", "%#.3o", "%#5o", "%#-5o|",
+    "%#08x", "%#08o", "%.0u", "%5.0o", "%hhu", "%hhd", "%hd", "%hx", "%#hho"
+};
+
+static const int test_int_values[] =
+{
+    0, 1, -1, 7, 8, 9, 10, 255, 256, 4095, -4096, 65535, 0x7FFFFFFF, (int)0x80000000
+};
+
+static const char* const test_ll_formats[] =
+{
+    "%llu", "%lld", "%llx", "%#llo", "%#.0llo", "%20llu"
+};
+
+static const long long test_ll_values[] =
+{
+    0LL, 1LL, -1LL, 0x100000000LL, 1234567890123456789LL
+};
+
+static int test_failures;
+
+static void TEST_Check(const char* format, const char* got, const char* want)
+{
+    if (strcmp(got, want) != 0)
+    {
+        printf("FAIL \"%s\": got \"%s\", want \"%s\"\n", format, got, want);
+        test_failures++;
+    }
+}
+
+int main(void)
+{
+    char got[64];
+    char want[64];
+    int n;
+    unsigned int f;
+    unsigned int v;
+
+    for (f = 0u; f < sizeof(test_int_formats) / sizeof(test_int_formats[0]); f++)
+    {
+        for (v = 0u; v < sizeof(test_int_values) / sizeof(test_int_values[0]); v++)
+        {
+            n = FMT_Snprintf(got, sizeof(got), test_int_formats[f], test_int_values[v]);
+            snprintf(want, sizeof(want), test_int_formats[f], test_int_values[v]);
+            TEST_Check(test_int_formats[f], got, want);
+            if (n != (int)strlen(want))
+            {
+                printf("FAIL \"%s\": returned %d, want %u\n", test_int_formats[f], n, (unsigned int)strlen(want));
+                test_failures++;
+            }
+        }
+    }
+    for (f = 0u; f < sizeof(test_ll_formats) / sizeof(test_ll_formats[0]); f++)
+    {
+        for (v = 0u; v < sizeof(test_ll_values) / sizeof(test_ll_values[0]); v++)
+        {
+            FMT_Snprintf(got, sizeof(got), test_ll_formats[f], test_ll_values[v]);
+            snprintf(want, sizeof(want), test_ll_formats[f], test_ll_values[v]);
+            TEST_Check(test_ll_formats[f], got, want);
+        }
+    }
+
+    FMT_Snprintf(got, sizeof(got), "%s|%-6s|%6.2s|%c|%%", "abc", "de", "fgh", 'z');
+    TEST_Check("strings", got, "abc|de    |    fg|z|%");
+    FMT_Snprintf(got, sizeof(got), "%*d|%-*d|%.*d", 4, 7, 4, 7, 3, 7);
+    TEST_Check("'*'", got, "   7|7   |007");
+    n = FMT_Snprintf(got, 4u, "%d", 123456);
+    TEST_Check("truncation", got, "123");
+    if (n != 6)
+    {
+        printf("FAIL truncation: returned %d, want 6\n", n);
+        test_failures++;
+    }
+
+    printf("fmt: %s\n", (test_failures == 0) ? "OK" : "FAILED");
+    return ((test_failures == 0) ? 0 : 1);
+}
+
+/* [] END OF FILE */
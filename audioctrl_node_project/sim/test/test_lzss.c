@@ -0,0 +1,166 @@
+/*******************************************************************************
+* FILE: test_lzss.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Decodes the streams of test_lzss.py, packed by tools/lz_pack.py, with
+* bootloader.cydsn/lzss.c and compares them with the data they were packed
+* from.  The stream goes in as 7 byte download segments, decoded once after
+* each segment and, a second time, with the input kept full and only a few
+* bytes decoded per segment, so items are split at every point and the input
+* wraps.  Prints the mismatches and exits non-zero if there are any.
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lzss.h"
+
+#define TEST_SEG_SIZE       (7u)
+#define TEST_LINE_SIZE      (65536u)
+
+static int test_failures;
+
+static size_t TEST_Hex(const char* hex, uint8* out)
+{
+    size_t n = 0u;
+
+    while ((hex[0] != '\0') && (hex[1] != '\0'))
+    {
+        unsigned int b;
+
+        (void)sscanf(hex, "%2x", &b);
+        out[n++] = (uint8)b;
+        hex += 2;
+    }
+    return (n);
+}
+
+/*******************************************************************************
+ * Feeds "packed" in segments and decodes at most "burst" bytes after each one
+ * (0 for all there are); returns the number of bytes decoded into "out", or
+ * -1 if the decoder refused the stream
+ ******************************************************************************/
+static long TEST_Decode(const uint8* packed, size_t size, uint8* out, size_t out_size, uint32 burst)
+{
+    size_t pos = 0u;
+    size_t n = 0u;
+    int16 b = LZSS_EMPTY;
+
+    LZSS_Reset();
+    for (;;)
+    {
+        uint32 got = 0u;
+
+        while (pos < size)
+        {
+            uint8 len = (uint8)(((size - pos) < TEST_SEG_SIZE) ? (size - pos) : TEST_SEG_SIZE);
+
+            if (LZSS_Put(&packed[pos], len) == 0u)
+            {
+                break;
+            }
+            pos += len;
+            if (burst == 0u)
+            {
+                break;
+            }
+        }
+        while ((burst == 0u) || (got < burst))
+        {
+            b = LZSS_Get();
+            if (b < 0)
+            {
+                break;
+            }
+            if (n == out_size)
+            {
+                return ((long)n + 1);
+            }
+            out[n++] = (uint8)b;
+            got++;
+        }
+        if (b == LZSS_ERROR)
+        {
+            return (-1);
+        }
+        if ((pos == size) && (b == LZSS_EMPTY))
+        {
+            return ((long)n);
+        }
+    }
+}
+
+static void TEST_Case(const char* name, const char* bits, const char* plain_hex, const char* packed_hex)
+{
+    static uint8 plain[TEST_LINE_SIZE];
+    static uint8 packed[TEST_LINE_SIZE];
+    static uint8 out[TEST_LINE_SIZE];
+    static const uint32 bursts[] = { 0u, 1u, 5u };
+    size_t packed_size = TEST_Hex(packed_hex, packed);
+    long plain_size = (strcmp(plain_hex, "-") == 0) ? -1 : (long)TEST_Hex(plain_hex, plain);
+    uint32 i;
+
+    for (i = 0u; i < (sizeof(bursts) / sizeof(bursts[0])); i++)
+    {
+        long n = TEST_Decode(packed, packed_size, out, sizeof(out), bursts[i]);
+        long at;
+
+        if (n != plain_size)
+        {
+            printf("FAIL %s/%s burst %lu: %ld bytes, want %ld\n", name, bits, (unsigned long)bursts[i], n, plain_size);
+            test_failures++;
+            continue;
+        }
+        for (at = 0; at < n; at++)
+        {
+            if (out[at] != plain[at])
+            {
+                printf("FAIL %s/%s burst %lu: byte %ld is 0x%02x, want 0x%02x\n", name, bits,
+                       (unsigned long)bursts[i], at, out[at], plain[at]);
+                test_failures++;
+                break;
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    static char line[4u * TEST_LINE_SIZE];
+    int cases = 0;
+
+    while (fgets(line, sizeof(line), stdin) != NULL)
+    {
+        char* name = strtok(line, " \n");
+        char* bits = strtok(NULL, " \n");
+        char* plain = strtok(NULL, " \n");
+        char* packed = strtok(NULL, " \n");
+
+        if (packed == NULL)
+        {
+            printf("FAIL malformed vector %s\n", (name != NULL) ? name : "");
+            test_failures++;
+            continue;
+        }
+        TEST_Case(name, bits, plain, packed);
+        cases++;
+    }
+    if (cases == 0)
+    {
+        printf("FAIL no vectors\n");
+        test_failures++;
+    }
+
+    printf("lzss: %s\n", (test_failures == 0) ? "OK" : "FAILED");
+    return ((test_failures == 0) ? 0 : 1);
+}
+
+/* [] END OF FILE */
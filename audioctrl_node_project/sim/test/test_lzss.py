@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+################################################################################
+# FILE: test_lzss.py
+#
+# Version: 1.0
+#
+# Copyright 2016, Bossa Nova Robotics. All rights reserved.
+# This software is owned by Bossa Nova Robotics and is protected by and subject
+# to worldwide patent and copyright laws and treaties.
+#
+################################################################################
+#
+# DESCRIPTION:
+#     Test vectors for test_lzss.c: streams packed by tools/lz_pack.py
+# compress(), one per line as
+#
+#     name window-bits plain-hex packed-hex
+#
+# with plain-hex "-" for a stream the bootloader must refuse.  make test
+# pipes them into test_lzss, which decodes them with
+# bootloader.cydsn/lzss.c.
+################################################################################
+import os
+import random
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'tools'))
+import lz_pack  # noqa: E402
+
+
+def matches(stream):
+    """Distances of the matches in a stream."""
+    len_bits = 16 - stream[1]
+    dists = []
+    pos = 2
+    while pos < len(stream):
+        flags = stream[pos]
+        pos += 1
+        for i in range(8):
+            if pos >= len(stream):
+                break
+            if flags & (1 << i):
+                dists.append((stream[pos] | ((stream[pos + 1] >> len_bits) << 8)) + 1)
+                pos += 2
+            else:
+                pos += 1
+    return dists
+
+
+def image(rng, rows):
+    """Program Row packets of an image with code-like repetition."""
+    words = [bytes(rng.randrange(256) for _ in range(4)) for _ in range(40)]
+    out = b''
+    for row in range(rows):
+        data = b''.join(rng.choice(words) for _ in range(32))
+        out += lz_pack.program_row(0, row, data)
+    return out
+
+
+def main():
+    rng = random.Random(0x4C5A)
+    noise = bytes(rng.randrange(256) for _ in range(3000))
+    cases = [
+        ('short', b'ab'),
+        ('noise', noise),
+        ('run', b'\x00' * 2000 + b'\xff' * 700),
+        ('image', image(rng, 24)),
+    ]
+    out = []
+    for bits in (8, 9):
+        window = 1 << bits
+        for name, plain in cases:
+            out.append((name, bits, plain, lz_pack.compress(plain, bits)))
+        # The only earlier copy of the tail is exactly one window back
+        block = noise[:window]
+        plain = block + block[:60] + noise[window:window + 200]
+        packed = lz_pack.compress(plain, bits)
+        if window not in matches(packed):
+            sys.exit('window case has no match at distance %d' % window)
+        out.append(('window', bits, plain, packed))
+    # A window the decoder is not built for
+    out.append(('wide', 10, None, lz_pack.compress(noise[:100] * 3, 10)))
+
+    for name, bits, plain, packed in out:
+        print('%s %d %s %s' % (name, bits, plain.hex() if plain is not None else '-', packed.hex()))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
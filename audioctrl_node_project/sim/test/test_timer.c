@@ -0,0 +1,307 @@
+/*******************************************************************************
+* FILE: test_timer.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Software timer wheel and cycle conversion of src/timer.c.  Built
+* without the project header, so SysTick runs a 1 ms period and each call of
+* SysTick_Callback() is one tick; the few CyLib calls are stubbed here.
+* Checks that timers of every wheel level run on their tick whether the main
+* loop refreshes every tick or falls behind, the catch-up and coalesce modes,
+* timers armed and cancelled from callbacks, and SysTick_CyclesToMs()
+* against division over its whole input range.  Prints the mismatches and
+* exits non-zero if there are any.
+*******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "timer.h"
+
+#if (SYSTICK_USE_TICKLESS)
+    #error "test_timer.c must be built without the project header"
+#endif
+
+#define TEST_MS_CYCLES      (24000u)
+
+typedef struct
+{
+    SysTick_Timer timer;
+    uint32 runs;
+    uint32 at;                  /* tick of the last expiry run */
+    SysTick_Timer* cancel;      /* cancelled by the callback */
+    uint32 rearm;               /* re-armed by the callback this many times */
+} TEST_Timer;
+
+static int test_failures;
+static uint32 test_icsr;
+static cySysTickCallback test_systick_callbacks[CY_SYS_SYST_NUM_OF_CALLBACKS];
+
+/*******************************************************************************
+ * CyLib stubs: the counter always reads the start of a millisecond and no
+ * wrap is ever pending
+ ******************************************************************************/
+uint8 CyEnterCriticalSection(void)
+{
+    return (0u);
+}
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+    (void)savedIntrStatus;
+}
+
+uint32 SIM_SysTickReadCvr(void)
+{
+    return (TEST_MS_CYCLES - 1u);
+}
+
+uintptr_t SIM_Cm0IcsrAddr(void)
+{
+    return ((uintptr_t)&test_icsr);
+}
+
+void CySysTickStart(void)
+{
+}
+
+void CySysTickSetReload(uint32 value)
+{
+    (void)value;
+}
+
+void CySysTickClear(void)
+{
+}
+
+cySysTickCallback CySysTickSetCallback(uint32 number, cySysTickCallback function)
+{
+    cySysTickCallback old = test_systick_callbacks[number];
+    test_systick_callbacks[number] = function;
+    return (old);
+}
+
+cySysTickCallback CySysTickGetCallback(uint32 number)
+{
+    return (test_systick_callbacks[number]);
+}
+
+/******************************************************************************/
+
+static void TEST_Fail(const char* what, uint32 got, uint32 want)
+{
+    printf("FAIL %s: got %lu, want %lu\n", what, (unsigned long)got, (unsigned long)want);
+    test_failures++;
+}
+
+static void TEST_Check(const char* what, uint32 got, uint32 want)
+{
+    if (got != want)
+    {
+        TEST_Fail(what, got, want);
+    }
+}
+
+static void TEST_Callback(void* context)
+{
+    TEST_Timer* t = (TEST_Timer*)context;
+
+    t->at = SysTick_GetTicks() - t->timer.late_last;
+    t->runs++;
+    if (t->cancel != NULL)
+    {
+        SysTick_TimerCancel(t->cancel);
+    }
+    if (t->rearm != 0u)
+    {
+        t->rearm--;
+        SysTick_TimerArm(&t->timer, 0u, 0u);
+    }
+}
+
+static void TEST_Init(TEST_Timer* t)
+{
+    memset(t, 0, sizeof(*t));
+    SysTick_TimerInit(&t->timer, TEST_Callback, t);
+}
+
+/* "ms" SysTick interrupts without a main loop pass */
+static void TEST_Advance(uint32 ms)
+{
+    while (ms-- != 0u)
+    {
+        SysTick_Callback();
+    }
+}
+
+/* One-shot timers on both sides of each level boundary, and beyond the
+ * 2^20 tick range of the wheel, armed on a tick whose low 20 bits are
+ * "phase"; the main loop runs every "step" ticks */
+static const uint32 test_delays[] =
+{
+    1u, 2u, 31u, 32u, 33u, 63u, 64u, 1023u, 1024u, 1025u, 2047u, 32767u, 32768u,
+    32769u, 1048575u, 1048576u, 1048577u, 1048576u + 40000u
+};
+
+#define TEST_DELAYS     (sizeof(test_delays) / sizeof(test_delays[0]))
+#define TEST_WHEEL_MASK (0xFFFFFu)
+
+static void TEST_Levels(uint32 phase, uint32 step)
+{
+    static TEST_Timer t[TEST_DELAYS];
+    uint32 last = test_delays[TEST_DELAYS - 1u];
+    uint32 start;
+    uint32 i;
+    char what[80];
+
+    TEST_Advance((phase - SysTick_GetTicks()) & TEST_WHEEL_MASK);
+    SysTick_Refresh();
+    start = SysTick_GetTicks();
+    for (i = 0u; i < TEST_DELAYS; i++)
+    {
+        TEST_Init(&t[i]);
+        SysTick_TimerArm(&t[i].timer, test_delays[i], 0u);
+    }
+    while ((SysTick_GetTicks() - start) < last)
+    {
+        TEST_Advance(step);
+        SysTick_Refresh();
+    }
+    for (i = 0u; i < TEST_DELAYS; i++)
+    {
+        snprintf(what, sizeof(what), "phase 0x%05lx step %lu delay %lu", (unsigned long)phase,
+                 (unsigned long)step, (unsigned long)test_delays[i]);
+        if ((t[i].runs != 1u) || (t[i].at != (start + test_delays[i])) || SysTick_TimerPending(&t[i].timer))
+        {
+            printf("FAIL %s: runs %lu at +%lu\n", what, (unsigned long)t[i].runs, (unsigned long)(t[i].at - start));
+            test_failures++;
+        }
+    }
+}
+
+/* A periodic timer whose main loop is held up for 5.5 periods */
+static void TEST_Modes(void)
+{
+    TEST_Timer t;
+    uint32 start = SysTick_GetTicks();
+    uint32 n;
+
+    TEST_Init(&t);
+    SysTick_TimerArm(&t.timer, 10u, 10u);
+    TEST_Advance(55u);
+    SysTick_Refresh();
+    TEST_Check("catchup runs", t.runs, 5u);
+    TEST_Check("catchup last tick", t.at, start + 50u);
+    TEST_Check("catchup late", t.timer.late_last, 5u);
+    TEST_Check("catchup overruns", t.timer.overruns, 0u);
+    for (n = 0u; SysTick_TimerExpired(&t.timer) != 0u; n++)
+    {
+    }
+    TEST_Check("catchup expired", n, 5u);
+    SysTick_TimerCancel(&t.timer);
+    if (SysTick_GetBacklogMax() < 56u)
+    {
+        TEST_Fail("backlog", SysTick_GetBacklogMax(), 56u);
+    }
+
+    start = SysTick_GetTicks();
+    TEST_Init(&t);
+    SysTick_TimerSetMode(&t.timer, SYSTICK_TIMER_COALESCE);
+    SysTick_TimerArm(&t.timer, 10u, 10u);
+    TEST_Advance(55u);
+    SysTick_Refresh();
+    TEST_Check("coalesce runs", t.runs, 1u);
+    TEST_Check("coalesce tick", t.at, start + 10u);
+    TEST_Check("coalesce overruns", t.timer.overruns, 4u);
+    TEST_Advance(5u);
+    SysTick_Refresh();
+    TEST_Check("coalesce next runs", t.runs, 2u);
+    TEST_Check("coalesce next tick", t.at, start + 60u);
+    TEST_Check("coalesce expired", SysTick_TimerExpired(&t.timer), 1u);
+    TEST_Check("coalesce expired overruns", t.timer.overruns, 5u);
+    TEST_Check("coalesce expired again", SysTick_TimerExpired(&t.timer), 0u);
+    SysTick_TimerCancel(&t.timer);
+}
+
+/* Callbacks that cancel a timer due on the same tick and re-arm themselves */
+static void TEST_Callbacks(void)
+{
+    TEST_Timer a;
+    TEST_Timer b;
+    TEST_Timer c;
+    uint32 start = SysTick_GetTicks();
+
+    TEST_Init(&a);
+    TEST_Init(&b);
+    TEST_Init(&c);
+    /* a and b cancel each other, so whichever runs first is the only one */
+    SysTick_TimerArm(&a.timer, 40u, 0u);
+    SysTick_TimerArm(&b.timer, 40u, 0u);
+    SysTick_TimerArm(&c.timer, 40u, 0u);
+    a.cancel = &b.timer;
+    b.cancel = &a.timer;
+    c.rearm = 2u;
+    TEST_Advance(40u);
+    SysTick_Refresh();
+    TEST_Check("cancel runs", a.runs + b.runs, 1u);
+    TEST_Check("cancelled pending", SysTick_TimerPending(&a.timer) + SysTick_TimerPending(&b.timer), 0u);
+    /* Re-armed for "now" from a callback: run on the next tick, not again
+     * within the same one */
+    TEST_Check("rearm runs", c.runs, 1u);
+    TEST_Advance(1u);
+    SysTick_Refresh();
+    TEST_Advance(5u);
+    SysTick_Refresh();
+    TEST_Check("rearm runs", c.runs, 3u);
+    TEST_Check("rearm tick", c.at, start + 42u);
+    TEST_Check("rearm pending", SysTick_TimerPending(&c.timer), 0u);
+}
+
+/* Checked over the whole range it is specified for */
+static void TEST_CyclesToMs(void)
+{
+    uint32 cycles;
+    uint32 ms;
+    uint32 rest;
+
+    for (cycles = 0u; cycles < (1uL << 25); cycles++)
+    {
+        ms = SysTick_CyclesToMs(cycles, &rest);
+        if ((ms != (cycles / TEST_MS_CYCLES)) || (rest != (cycles % TEST_MS_CYCLES)))
+        {
+            printf("FAIL SysTick_CyclesToMs(%lu): got %lu rest %lu\n",
+                   (unsigned long)cycles, (unsigned long)ms, (unsigned long)rest);
+            if (++test_failures > 20)
+            {
+                return;
+            }
+        }
+    }
+    TEST_Check("cycles to ms without rest", SysTick_CyclesToMs(47999u, NULL), 1u);
+}
+
+int main(void)
+{
+    SysTick_Start();
+
+    TEST_Levels(0u, 1u);
+    TEST_Levels(1000u, 1u);
+    TEST_Levels(0x07FE1u, 1u);
+    TEST_Levels(TEST_WHEEL_MASK, 1u);
+    TEST_Levels(0x7FFE1u, 97u);
+    TEST_Levels(33u, 1025u);
+    TEST_Modes();
+    TEST_Callbacks();
+    TEST_CyclesToMs();
+
+    printf("timer: %s\n", (test_failures == 0) ? "OK" : "FAILED");
+    return ((test_failures == 0) ? 0 : 1);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,51 @@
+/*******************************************************************************
+* FILE: test_tlog.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Release build path of the tokenized log.  Built with NDEBUG, so proj.h
+* sets TLOG_DEFERRED and PRINTF_ARGn must come out of tlog.h; the frames of
+* TLOG_Write() go to stdout, mixed with plain text, and make test pipes them
+* through tools/tlog_decode.py with this binary as the string table.
+*******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "tlog.h"
+#include "sio_tx.h"
+
+#if !(TLOG_DEFERRED)
+    #error "test_tlog.c must be built with NDEBUG"
+#endif
+
+uint16 SIO_Write(const uint8* data, uint16 length)
+{
+    return ((uint16)fwrite(data, 1u, length, stdout));
+}
+
+static void TEST_Text(const char* text)
+{
+    (void)SIO_Write((const uint8*)text, (uint16)strlen(text));
+}
+
+int main(void)
+{
+    TEST_Text("plain text\n");
+    PRINTF_ARG0("no arguments\r\n");
+    PRINTF_ARG1("node %u\r\n", 17u);
+    PRINTF_ARG2("%d %x\r\n", -5, 0xBEEFu);
+    PRINTF_ARG3("%c%c [%5u]\r\n", 'o', 'k', 42u);
+    PRINTF_ARG4("%08X %o %u %i\r\n", 0xF0u, 8u, 0xFFFFFFFFu, 0x80000000u);
+    TEST_Text("more text\n");
+    TLOG1("%u%% without newline", 99u);
+    return (0);
+}
+
+/* [] END OF FILE */
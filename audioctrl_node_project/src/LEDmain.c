@@ -35,6 +35,7 @@
 #include "COP.h"
 #include "USR.h"
 #include "LED.h"
+#include "prof.h"
 
 #if ((LED_ERROR_AND_RUN_LEDS) || (LED_STATUS_LED))
 
@@ -202,10 +203,12 @@ void LED_Handler(void)
 
   BOOLEAN o_grn_on = LED_o_GrnOn; /* store previous state */
   BOOLEAN o_red_on = LED_o_RedOn; /* store previous state */
+  PROF_ENTER(PROF_SITE_LED_HANDLER);
 
   /* if the LEDs are not initialized return */
   if(LED_o_Initialized==FALSE)
   {
+    PROF_EXIT(PROF_SITE_LED_HANDLER);
     return;
   }
 
@@ -391,6 +394,7 @@ void LED_Handler(void)
   {
     COP_ENABLE_TIMER_INT;
   }
+  PROF_EXIT(PROF_SITE_LED_HANDLER);
 }
 
 
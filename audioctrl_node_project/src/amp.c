@@ -0,0 +1,375 @@
+/*******************************************************************************
+* FILE: amp.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Amplifier register shadow, see amp.h.  Two bitmaps track the map:
+* valid, the shadow holds what the device has, and dirty, the shadow still
+* has to be written.  The i2cq context of a burst carries its first register
+* and length.  A failed burst holds the flushes back for a SysTick timer.
+*******************************************************************************/
+#include <stdint.h>
+#include <string.h>
+#include "amp.h"
+#include "i2cq.h"
+#include "modlog.h"
+#include "timer.h"
+
+#define AMP_BIT(reg)            ((uint8)(1u << ((reg) & 7u)))
+#define AMP_IS_DIRTY(reg)       ((amp_dirty[(reg) >> 3] & AMP_BIT(reg)) != 0u)
+#define AMP_IS_VALID(reg)       ((amp_valid[(reg) >> 3] & AMP_BIT(reg)) != 0u)
+
+#define AMP_CONTEXT(first, len) ((void*)(uintptr_t)(((uint32)(first) << 8) | (len)))
+#define AMP_CTX_FIRST(c)        ((uint8)((uintptr_t)(c) >> 8))
+#define AMP_CTX_LEN(c)          ((uint8)(uintptr_t)(c))
+
+static uint8 amp_shadow[AMP_REG_COUNT];
+static uint8 amp_valid[AMP_REG_COUNT / 8u];
+static uint8 amp_dirty[AMP_REG_COUNT / 8u];
+static uint16 amp_dirty_count;
+static uint8 amp_inflight;              /* i2cq transactions not done yet */
+static uint8 amp_verify;
+static uint8 amp_failures;              /* failed bursts since the last good one */
+static SysTick_Timer amp_backoff;       /* no flush while it runs */
+static AMP_Stats amp_stats;
+
+static void AMP_SetDirty(uint8 reg)
+{
+    if (!AMP_IS_DIRTY(reg))
+    {
+        amp_dirty[reg >> 3] |= AMP_BIT(reg);
+        amp_dirty_count++;
+    }
+}
+
+static void AMP_ClearDirty(uint8 reg)
+{
+    if (AMP_IS_DIRTY(reg))
+    {
+        amp_dirty[reg >> 3] &= (uint8)~AMP_BIT(reg);
+        amp_dirty_count--;
+    }
+}
+
+/*******************************************************************************
+ * Ends one of our transactions; the next flush goes out as soon as the last
+ * one is done, nothing else would wake the main loop for it.
+ *******************************************************************************/
+static void AMP_Done(void)
+{
+    amp_inflight--;
+    if (amp_inflight == 0u)
+    {
+        AMP_Flush();
+    }
+}
+
+static void AMP_WriteDone(void* context, uint8 result, const uint8* data, uint16 length)
+{
+    uint8 first = AMP_CTX_FIRST(context);
+    uint8 i;
+
+    (void)data;
+    (void)length;
+    if (result != I2CQ_OK)
+    {
+        amp_stats.write_errors++;
+        for (i = 0u; i < AMP_CTX_LEN(context); i++)
+        {
+            AMP_SetDirty((uint8)(first + i));
+        }
+        if (amp_failures < AMP_RETRIES)
+        {
+            amp_failures++;
+            MLOG3(MLOG_MOD_USR, MLOG_LVL_WARN, "amp 0x%02x+%u write failed %u\r\n", first, AMP_CTX_LEN(context), result);
+            if (amp_failures == AMP_RETRIES)
+            {
+                amp_stats.offline = 1u;
+                MLOG0(MLOG_MOD_USR, MLOG_LVL_WARN, "amp offline\r\n");
+            }
+        }
+        SysTick_TimerArm(&amp_backoff, amp_stats.offline ? AMP_OFFLINE_MS : AMP_RETRY_MS, 0u);
+    }
+    else if (amp_failures != 0u)
+    {
+        if (amp_stats.offline)
+        {
+            MLOG0(MLOG_MOD_USR, MLOG_LVL_INFO, "amp online\r\n");
+        }
+        amp_failures = 0u;
+        amp_stats.offline = 0u;
+    }
+    AMP_Done();
+}
+
+static void AMP_VerifyDone(void* context, uint8 result, const uint8* data, uint16 length)
+{
+    uint8 first = AMP_CTX_FIRST(context);
+    uint8 reg;
+    uint16 i;
+
+    if (result == I2CQ_OK)
+    {
+        for (i = 0u; i < length; i++)
+        {
+            reg = (uint8)(first + i);
+            /* A register written again since is checked with its new burst */
+            if (!AMP_IS_DIRTY(reg) && (data[i] != amp_shadow[reg]))
+            {
+                amp_stats.verify_errors++;
+                AMP_SetDirty(reg);
+            }
+        }
+    }
+    AMP_Done();
+}
+
+static void AMP_RefreshDone(void* context, uint8 result, const uint8* data, uint16 length)
+{
+    uint8 first = AMP_CTX_FIRST(context);
+    uint8 reg;
+    uint16 i;
+
+    if (result == I2CQ_OK)
+    {
+        for (i = 0u; i < length; i++)
+        {
+            reg = (uint8)(first + i);
+            if (!AMP_IS_DIRTY(reg))
+            {
+                amp_shadow[reg] = data[i];
+                amp_valid[reg >> 3] |= AMP_BIT(reg);
+            }
+        }
+    }
+    AMP_Done();
+}
+
+/*******************************************************************************
+* Function Name: AMP_Start
+********************************************************************************
+*
+* Summary:
+*  Forgets the register map, so the first write of every register is sent.
+*  Call it after I2CQ_Start().
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void AMP_Start(void)
+{
+    memset(amp_valid, 0, sizeof(amp_valid));
+    memset(amp_dirty, 0, sizeof(amp_dirty));
+    memset(&amp_stats, 0, sizeof(amp_stats));
+    amp_dirty_count = 0u;
+    amp_inflight = 0u;
+    amp_verify = AMP_VERIFY;
+    amp_failures = 0u;
+    SysTick_TimerInit(&amp_backoff, NULL, NULL);
+}
+
+/*******************************************************************************
+* Function Name: AMP_Write
+********************************************************************************
+*
+* Summary:
+*  Sets a register in the shadow.  It is sent by the next AMP_Flush() unless
+*  the device is known to hold the value already.
+*
+* Parameters:
+*  reg: register
+*  value: new value
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void AMP_Write(uint8 reg, uint8 value)
+{
+    amp_stats.writes++;
+    if (AMP_IS_VALID(reg) && (amp_shadow[reg] == value))
+    {
+        if (!AMP_IS_DIRTY(reg))
+        {
+            amp_stats.unchanged++;
+        }
+        return;
+    }
+    amp_shadow[reg] = value;
+    amp_valid[reg >> 3] |= AMP_BIT(reg);
+    AMP_SetDirty(reg);
+}
+
+/*******************************************************************************
+ * Value of a register in the shadow.
+ *******************************************************************************/
+uint8 AMP_Read(uint8 reg)
+{
+    return (amp_shadow[reg]);
+}
+
+/*******************************************************************************
+ * Marks a register unknown, e.g. after a command that changes it in the
+ * device, and drops a write of it that has not been queued.  Its next
+ * AMP_Write() is sent even with the same value.
+ *******************************************************************************/
+void AMP_Invalidate(uint8 reg)
+{
+    AMP_ClearDirty(reg);
+    amp_valid[reg >> 3] &= (uint8)~AMP_BIT(reg);
+}
+
+/*******************************************************************************
+ * Returns 1 while registers wait to be flushed.
+ *******************************************************************************/
+uint8 AMP_Dirty(void)
+{
+    return ((amp_dirty_count != 0u) ? 1u : 0u);
+}
+
+/*******************************************************************************
+* Function Name: AMP_Flush
+********************************************************************************
+*
+* Summary:
+*  Queues the dirty registers, one burst per run of up to I2CQ_DATA_MAX
+*  registers.  Clean but valid registers of up to AMP_GAP_MAX between two
+*  dirty ones are resent to keep the run together.  Does nothing while
+*  bursts of the previous flush are queued; registers that do not fit into
+*  the i2cq ring stay dirty for the next flush.  After a failed burst the
+*  flushes wait AMP_RETRY_MS, and AMP_OFFLINE_MS once AMP_RETRIES bursts in
+*  a row have failed.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void AMP_Flush(void)
+{
+    uint16 reg = 0u;
+    uint16 next;
+    uint16 last;
+    uint8 len;
+
+    if ((amp_dirty_count == 0u) || (amp_inflight != 0u) || SysTick_TimerPending(&amp_backoff))
+    {
+        return;
+    }
+    while ((reg < AMP_REG_COUNT) && (amp_dirty_count != 0u))
+    {
+        if (amp_dirty[reg >> 3] == 0u)
+        {
+            reg = (reg | 7u) + 1u;
+            continue;
+        }
+        if (!AMP_IS_DIRTY(reg))
+        {
+            reg++;
+            continue;
+        }
+
+        last = reg;
+        for (next = reg + 1u; (next < AMP_REG_COUNT) && ((next - reg) < I2CQ_DATA_MAX); next++)
+        {
+            if (AMP_IS_DIRTY(next))
+            {
+                last = next;
+            }
+            else if (!AMP_IS_VALID(next) || ((next - last) > AMP_GAP_MAX))
+            {
+                break;
+            }
+        }
+        len = (uint8)(last - reg + 1u);
+
+        if (I2CQ_Write(AMP_I2C_ADDR, reg, 1u, &amp_shadow[reg], len, AMP_WriteDone,
+                       AMP_CONTEXT(reg, len)) != I2CQ_OK)
+        {
+            break;
+        }
+        amp_inflight++;
+        amp_stats.bursts++;
+        amp_stats.bytes += len;
+        for (next = reg; next <= last; next++)
+        {
+            AMP_ClearDirty((uint8)next);
+        }
+        if ((amp_verify != 0u) &&
+            (I2CQ_Read(AMP_I2C_ADDR, reg, 1u, len, AMP_VerifyDone, AMP_CONTEXT(reg, len)) == I2CQ_OK))
+        {
+            amp_inflight++;
+        }
+        reg = last + 1u;
+    }
+}
+
+/*******************************************************************************
+* Function Name: AMP_Refresh
+********************************************************************************
+*
+* Summary:
+*  Queues reads of a register range into the shadow.  Registers that are
+*  dirty when the data arrives keep their pending value.
+*
+* Parameters:
+*  first: first register
+*  count: number of registers, up to the end of the map
+*
+* Return:
+*  I2CQ_OK, or the i2cq error of the first read that was not queued
+*
+*******************************************************************************/
+uint8 AMP_Refresh(uint8 first, uint16 count)
+{
+    uint16 reg = first;
+    uint16 end = (uint16)first + count;
+    uint8 len;
+    uint8 result;
+
+    if (end > AMP_REG_COUNT)
+    {
+        end = AMP_REG_COUNT;
+    }
+    while (reg < end)
+    {
+        len = ((end - reg) > I2CQ_DATA_MAX) ? I2CQ_DATA_MAX : (uint8)(end - reg);
+        result = I2CQ_Read(AMP_I2C_ADDR, reg, 1u, len, AMP_RefreshDone, AMP_CONTEXT(reg, len));
+        if (result != I2CQ_OK)
+        {
+            return (result);
+        }
+        amp_inflight++;
+        reg += len;
+    }
+    return (I2CQ_OK);
+}
+
+/*******************************************************************************
+ * Reads every burst back after writing it.  Only for register ranges that
+ * read back what was written; status registers would be rewritten forever.
+ *******************************************************************************/
+void AMP_SetVerify(uint8 enable)
+{
+    amp_verify = enable;
+}
+
+void AMP_GetStats(AMP_Stats* stats)
+{
+    *stats = amp_stats;
+}
+
+/* [] END OF FILE */
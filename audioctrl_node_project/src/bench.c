@@ -0,0 +1,357 @@
+/*******************************************************************************
+* FILE: bench.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     On-target micro benchmarks, see bench.h.
+*
+*     BENCH FMT   formats the same values with the digit loop of the old
+*                 iprintf() (% 10, / 10 per digit) and with FMT_Snprintf(),
+*                 both into RAM, and reports cycles and bytes for each.
+*     BENCH TICK  runs the SysTick handler arithmetic as it was (% 1000 per
+*                 tick, / and % for cycle conversions) and as it is now
+*                 (cascaded counters, multiply and shift) on private copies
+*                 of the counters, and reports cycles per call for each.
+*     BENCH EE    reads the whole EEPROM in BENCH_EE_CHUNK byte sequential
+*                 reads, then writes every chunk back with the data it
+*                 holds, so the contents survive, and reports bytes/s of
+*                 each pass.  The write pass costs one write cycle of every
+*                 page.
+*******************************************************************************/
+#include "target.h"
+#include "bench.h"
+#include "ee24.h"
+#include "fmt.h"
+#include "sio_tx.h"
+#include "timer.h"
+
+#if (BENCH_ENABLE)
+
+#define BENCH_FMT_ROUNDS    (50u)
+#define BENCH_TICK_ROUNDS   (1000u)
+#define BENCH_EE_CHUNK      (256u)
+
+static const uint32 bench_values[] =
+{
+    0u, 7u, 42u, 1000u, 65535u, 123456u, 9999999u, 2147483647u, 4000000000u, 0xDEADBEEFu
+};
+
+#define BENCH_VALUES    (sizeof(bench_values) / sizeof(bench_values[0]))
+
+/* Digit loop of the previous iprintf() %d and %x, writing to a buffer */
+static uint16 BENCH_LegacyNumber(char* out, uint32 value, uint32 base)
+{
+    uint32 buffer[12];
+    uint32 i = 0;
+    uint16 n = 0;
+
+    do
+    {
+        buffer[i++] = value % base;
+        value /= base;
+    } while (value);
+    if (base == 16)
+    {
+        if (i % 2 != 0)
+            buffer[i++] = 0;
+        if (i < 2)
+            buffer[i++] = 0;
+    }
+    while (i > 0)
+    {
+        i--;
+        out[n++] = "0123456789abcdef"[buffer[i]];
+    }
+    return (n);
+}
+
+static uint16 BENCH_Legacy(char* out, uint32 value)
+{
+    uint16 n = 0;
+
+    out[n++] = 'v';
+    out[n++] = '=';
+    n += BENCH_LegacyNumber(&out[n], value, 10);
+    out[n++] = ' ';
+    out[n++] = 'x';
+    out[n++] = '=';
+    n += BENCH_LegacyNumber(&out[n], value, 16);
+    out[n] = 0;
+    return (n);
+}
+
+static void BENCH_Report(const char* name, uint32 cycles, uint32 bytes)
+{
+    char line[80];
+
+    /* bytes per 1000 cycles, the division is outside the measurement */
+    FMT_Snprintf(line, sizeof(line), "OK %s cycles %lu bytes %lu bytes/kcycle %lu\r\n", name,
+                 (unsigned long)cycles, (unsigned long)bytes,
+                 (unsigned long)((cycles != 0u) ? ((bytes * 1000u) / cycles) : 0u));
+    SIO_PutString(line);
+    /* Reports outrun the TX ring with the drop policy */
+    SIO_Flush();
+}
+
+static void BENCH_ReportCalls(const char* name, uint32 cycles, uint32 calls)
+{
+    char line[80];
+
+    FMT_Snprintf(line, sizeof(line), "OK %s cycles %lu calls %lu cycles/call %lu\r\n", name,
+                 (unsigned long)cycles, (unsigned long)calls, (unsigned long)(cycles / calls));
+    SIO_PutString(line);
+    SIO_Flush();
+}
+
+static void BENCH_ReportRate(const char* name, uint32 bytes, uint32 us, uint8 result)
+{
+    char line[80];
+
+    if (result != EE24_OK)
+    {
+        FMT_Snprintf(line, sizeof(line), "ERR %s %u\r\n", name, result);
+    }
+    else
+    {
+        FMT_Snprintf(line, sizeof(line), "OK %s bytes %lu us %lu bytes/s %lu\r\n", name,
+                     (unsigned long)bytes, (unsigned long)us,
+                     (unsigned long)((us != 0u) ? (uint32)(((uint64)bytes * 1000000u) / us) : 0u));
+    }
+    SIO_PutString(line);
+    SIO_Flush();
+}
+
+/* Private copies of the tick counters, so the real timebase is not touched */
+static volatile uint32 bench_ms;
+static volatile uint32 bench_ms_hi;
+static volatile uint32 bench_seconds;
+static volatile uint32 bench_ms_in_sec;
+static volatile uint32 bench_sec_in_min;
+static volatile uint32 bench_minutes;
+static volatile uint32 bench_sink;
+
+/* Periodic handler before: seconds from a modulo of the tick count */
+static void BENCH_TickDiv(void)
+{
+    uint32 t = bench_ms + 1u;
+
+    if (t < bench_ms)
+    {
+        ++bench_ms_hi;
+    }
+    bench_ms = t;
+    if ((bench_ms % 1000u) == 0u)
+    {
+        ++bench_seconds;
+    }
+}
+
+/* Periodic handler now: cascaded sub-counters */
+static void BENCH_TickCascade(void)
+{
+    uint32 t = bench_ms + 1u;
+
+    if (t < bench_ms)
+    {
+        ++bench_ms_hi;
+    }
+    bench_ms = t;
+    bench_ms_in_sec += 1u;
+    if (bench_ms_in_sec >= 1000u)
+    {
+        bench_ms_in_sec -= 1000u;
+        ++bench_seconds;
+        if (++bench_sec_in_min >= 60u)
+        {
+            bench_sec_in_min = 0u;
+            ++bench_minutes;
+        }
+    }
+}
+
+/* Cycles to ms and us within the ms, before and now */
+static void BENCH_ConvertDiv(uint32 cycles)
+{
+    bench_sink = (cycles / 24000u) + ((cycles % 24000u) / 24u);
+}
+
+static void BENCH_ConvertShift(uint32 cycles)
+{
+    uint32 rest;
+    uint32 ms = SysTick_CyclesToMs(cycles, &rest);
+
+    bench_sink = ms + ((rest * 21846u) >> 19);
+}
+
+static uint32 BENCH_Run(void (*tick)(void), void (*convert)(uint32))
+{
+    uint64 t0;
+    uint32 overhead;
+    uint32 cycles;
+    uint32 i;
+    uint8 intr;
+
+    intr = CyEnterCriticalSection();
+    t0 = SysTick_GetCycles64();
+    overhead = (uint32)(SysTick_GetCycles64() - t0);
+    t0 = SysTick_GetCycles64();
+    for (i = 0u; i < BENCH_TICK_ROUNDS; i++)
+    {
+        if (tick != NULL)
+        {
+            tick();
+        }
+        else
+        {
+            convert((i * 16411u) & 0xFFFFFFu);
+        }
+    }
+    cycles = (uint32)(SysTick_GetCycles64() - t0) - overhead;
+    CyExitCriticalSection(intr);
+    return (cycles);
+}
+
+static void BENCH_Tick(void)
+{
+    /* Start just short of a second so both carry paths are taken */
+    bench_ms = 999u;
+    bench_ms_in_sec = 999u;
+    BENCH_ReportCalls("tick-div", BENCH_Run(BENCH_TickDiv, NULL), BENCH_TICK_ROUNDS);
+    bench_ms = 999u;
+    bench_ms_in_sec = 999u;
+    BENCH_ReportCalls("tick-cascade", BENCH_Run(BENCH_TickCascade, NULL), BENCH_TICK_ROUNDS);
+    BENCH_ReportCalls("convert-div", BENCH_Run(NULL, BENCH_ConvertDiv), BENCH_TICK_ROUNDS);
+    BENCH_ReportCalls("convert-shift", BENCH_Run(NULL, BENCH_ConvertShift), BENCH_TICK_ROUNDS);
+}
+
+static void BENCH_Fmt(void)
+{
+    char out[48];
+    uint64 t0;
+    uint32 overhead;
+    uint32 cycles;
+    uint32 bytes;
+    uint8 round;
+    uint8 i;
+    uint8 intr;
+
+    intr = CyEnterCriticalSection();
+    t0 = SysTick_GetCycles64();
+    overhead = (uint32)(SysTick_GetCycles64() - t0);
+
+    bytes = 0u;
+    t0 = SysTick_GetCycles64();
+    for (round = 0u; round < BENCH_FMT_ROUNDS; round++)
+    {
+        for (i = 0u; i < BENCH_VALUES; i++)
+        {
+            bytes += BENCH_Legacy(out, bench_values[i]);
+        }
+    }
+    cycles = (uint32)(SysTick_GetCycles64() - t0) - overhead;
+    CyExitCriticalSection(intr);
+    BENCH_Report("legacy", cycles, bytes);
+
+    intr = CyEnterCriticalSection();
+    bytes = 0u;
+    t0 = SysTick_GetCycles64();
+    for (round = 0u; round < BENCH_FMT_ROUNDS; round++)
+    {
+        for (i = 0u; i < BENCH_VALUES; i++)
+        {
+            bytes += (uint32)FMT_Snprintf(out, sizeof(out), "v=%u x=%x", bench_values[i], bench_values[i]);
+        }
+    }
+    cycles = (uint32)(SysTick_GetCycles64() - t0) - overhead;
+    CyExitCriticalSection(intr);
+    BENCH_Report("fmt", cycles, bytes);
+}
+
+/* Interrupts stay on, the I2C queue needs them */
+static void BENCH_Eeprom(void)
+{
+    static uint8 chunk[BENCH_EE_CHUNK];
+    uint64 t0;
+    uint32 read_us = 0u;
+    uint32 write_us = 0u;
+    uint32 address;
+    uint8 result = EE24_OK;
+
+    for (address = 0u; (address < EE24_SIZE) && (result == EE24_OK); address += BENCH_EE_CHUNK)
+    {
+        t0 = SysTick_GetMicroseconds64();
+        result = EE24_Read((uint16)address, chunk, BENCH_EE_CHUNK, NULL, NULL);
+        if (result == EE24_OK)
+        {
+            result = EE24_Wait();
+        }
+        read_us += (uint32)(SysTick_GetMicroseconds64() - t0);
+    }
+    BENCH_ReportRate("ee-read", EE24_SIZE, read_us, result);
+
+    for (address = 0u; (address < EE24_SIZE) && (result == EE24_OK); address += BENCH_EE_CHUNK)
+    {
+        result = EE24_Read((uint16)address, chunk, BENCH_EE_CHUNK, NULL, NULL);
+        if (result == EE24_OK)
+        {
+            result = EE24_Wait();
+        }
+        t0 = SysTick_GetMicroseconds64();
+        if (result == EE24_OK)
+        {
+            result = EE24_Write((uint16)address, chunk, BENCH_EE_CHUNK, NULL, NULL);
+        }
+        if (result == EE24_OK)
+        {
+            result = EE24_Wait();
+        }
+        write_us += (uint32)(SysTick_GetMicroseconds64() - t0);
+    }
+    BENCH_ReportRate("ee-write", EE24_SIZE, write_us, result);
+}
+
+/*******************************************************************************
+* Function Name: BENCH_Command
+********************************************************************************
+*
+* Summary:
+*  Handler of the BENCH serial command.
+*
+* Parameters:
+*  argc, argv: command words, argv[1] selects the benchmark
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void BENCH_Command(uint8 argc, char* argv[])
+{
+    if (strcmp(argv[1], "FMT") == 0)
+    {
+        BENCH_Fmt();
+    }
+    else if (strcmp(argv[1], "TICK") == 0)
+    {
+        BENCH_Tick();
+    }
+    else if (strcmp(argv[1], "EE") == 0)
+    {
+        BENCH_Eeprom();
+    }
+    else
+    {
+        SIO_PutString("ERR ARGS\r\n");
+    }
+    (void)argc;
+}
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,242 @@
+/*******************************************************************************
+* FILE: ee24.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     24AA256 EEPROM driver, see ee24.h.  A write runs as a chain of i2cq
+* callbacks: page write, probes until the device acknowledges, next page.
+*******************************************************************************/
+#include <string.h>
+#include "ee24.h"
+#include "i2cq.h"
+#include "timer.h"
+
+#define EE24_OP_IDLE            (0u)
+#define EE24_OP_READ            (1u)
+#define EE24_OP_WRITE           (2u)
+
+static struct
+{
+    const uint8* src;
+    uint16 address;             /* of the next page */
+    uint16 remaining;
+    uint16 chunk;               /* bytes in the page being written */
+    uint32 poll_start;
+    EE24_DoneFn done;
+    void* context;
+    uint8 op;
+    uint8 result;               /* of the last operation */
+} ee24;
+
+/* Address and data of one page write */
+static uint8 ee24_page[2u + EE24_PAGE_SIZE];
+
+static void EE24_WritePage(void);
+
+static void EE24_End(uint8 result)
+{
+    ee24.op = EE24_OP_IDLE;
+    ee24.result = result;
+    if (ee24.done != NULL)
+    {
+        ee24.done(ee24.context, result);
+    }
+}
+
+static void EE24_ReadDone(void* context, uint8 result, const uint8* data, uint16 length)
+{
+    (void)context;
+    (void)data;
+    (void)length;
+    EE24_End((result == I2CQ_OK) ? EE24_OK : EE24_ERR_I2C);
+}
+
+static void EE24_PollDone(void* context, uint8 result, const uint8* data, uint16 length)
+{
+    (void)context;
+    (void)data;
+    (void)length;
+    if (result == I2CQ_OK)
+    {
+        if (ee24.remaining != 0u)
+        {
+            EE24_WritePage();
+        }
+        else
+        {
+            EE24_End(EE24_OK);
+        }
+    }
+    else if (result != I2CQ_ERR_NAK)
+    {
+        EE24_End(EE24_ERR_I2C);
+    }
+    else if ((SysTick_GetTicks() - ee24.poll_start) > EE24_POLL_MS)
+    {
+        EE24_End(EE24_ERR_TIMEOUT);
+    }
+    else if (I2CQ_Probe(EE24_I2C_ADDR, EE24_PollDone, NULL) != I2CQ_OK)
+    {
+        EE24_End(EE24_ERR_I2C);
+    }
+}
+
+static void EE24_PageDone(void* context, uint8 result, const uint8* data, uint16 length)
+{
+    (void)context;
+    (void)data;
+    (void)length;
+    if (result != I2CQ_OK)
+    {
+        EE24_End(EE24_ERR_I2C);
+        return;
+    }
+    ee24.src += ee24.chunk;
+    ee24.address += ee24.chunk;
+    ee24.remaining -= ee24.chunk;
+    /* The device does not acknowledge until its write cycle is over */
+    ee24.poll_start = SysTick_GetTicks();
+    if (I2CQ_Probe(EE24_I2C_ADDR, EE24_PollDone, NULL) != I2CQ_OK)
+    {
+        EE24_End(EE24_ERR_I2C);
+    }
+}
+
+/*******************************************************************************
+ * Queues the write of the next page, up to its end.
+ *******************************************************************************/
+static void EE24_WritePage(void)
+{
+    uint16 room = EE24_PAGE_SIZE - (ee24.address & (EE24_PAGE_SIZE - 1u));
+
+    ee24.chunk = (ee24.remaining < room) ? ee24.remaining : room;
+    ee24_page[0] = (uint8)(ee24.address >> 8);
+    ee24_page[1] = (uint8)ee24.address;
+    memcpy(&ee24_page[2], ee24.src, ee24.chunk);
+    if (I2CQ_WriteBuf(EE24_I2C_ADDR, ee24_page, 2u + ee24.chunk, EE24_PageDone, NULL) != I2CQ_OK)
+    {
+        EE24_End(EE24_ERR_I2C);
+    }
+}
+
+/*******************************************************************************
+* Function Name: EE24_Read
+********************************************************************************
+*
+* Summary:
+*  Starts a sequential read.
+*
+* Parameters:
+*  address: first byte
+*  buffer: receives the data
+*  size: number of bytes, at least 1
+*  done: completion callback or NULL
+*  context: argument passed to done
+*
+* Return:
+*  EE24_OK if started, otherwise EE24_ERR_xxx and done is not called
+*
+*******************************************************************************/
+uint8 EE24_Read(uint16 address, uint8* buffer, uint16 size, EE24_DoneFn done, void* context)
+{
+    if (ee24.op != EE24_OP_IDLE)
+    {
+        return (EE24_ERR_BUSY);
+    }
+    if ((size == 0u) || (((uint32)address + size) > EE24_SIZE))
+    {
+        return (EE24_ERR_RANGE);
+    }
+    ee24.done = done;
+    ee24.context = context;
+    if (I2CQ_ReadBuf(EE24_I2C_ADDR, address, 2u, buffer, size, EE24_ReadDone, NULL) != I2CQ_OK)
+    {
+        return (EE24_ERR_I2C);
+    }
+    ee24.op = EE24_OP_READ;
+    return (EE24_OK);
+}
+
+/*******************************************************************************
+* Function Name: EE24_Write
+********************************************************************************
+*
+* Summary:
+*  Starts a write, one page at a time.
+*
+* Parameters:
+*  address: first byte
+*  buffer: data, read page by page while the write runs
+*  size: number of bytes, at least 1
+*  done: completion callback or NULL
+*  context: argument passed to done
+*
+* Return:
+*  EE24_OK if started, otherwise EE24_ERR_xxx and done is not called
+*
+*******************************************************************************/
+uint8 EE24_Write(uint16 address, const uint8* buffer, uint16 size, EE24_DoneFn done, void* context)
+{
+    if (ee24.op != EE24_OP_IDLE)
+    {
+        return (EE24_ERR_BUSY);
+    }
+    if ((size == 0u) || (((uint32)address + size) > EE24_SIZE))
+    {
+        return (EE24_ERR_RANGE);
+    }
+    ee24.src = buffer;
+    ee24.address = address;
+    ee24.remaining = size;
+    ee24.done = NULL;
+    ee24.op = EE24_OP_WRITE;
+    EE24_WritePage();
+    if (ee24.op == EE24_OP_IDLE)
+    {
+        return (EE24_ERR_I2C);
+    }
+    ee24.done = done;
+    ee24.context = context;
+    return (EE24_OK);
+}
+
+uint8 EE24_Busy(void)
+{
+    return ((ee24.op != EE24_OP_IDLE) ? 1u : 0u);
+}
+
+/*******************************************************************************
+* Function Name: EE24_Wait
+********************************************************************************
+*
+* Summary:
+*  Runs the I2C queue until the current operation is done.  It also runs
+*  SysTick_Refresh(), so timer wheel callbacks run from inside it, and one of
+*  them may start the next operation.  Not for use from i2cq, EE24 or timer
+*  callbacks.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Result of the last operation
+*
+*******************************************************************************/
+uint8 EE24_Wait(void)
+{
+    while (ee24.op != EE24_OP_IDLE)
+    {
+        SysTick_Refresh();
+        I2CQ_Service();
+    }
+    return (ee24.result);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,580 @@
+/*******************************************************************************
+* FILE: fmt.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Division free printf engine, see fmt.h.  All state lives on the caller's
+* stack, so the functions may be used from interrupts.
+*******************************************************************************/
+#include "fmt.h"
+
+#define FMT_CHUNK           (32u)   /* bytes collected before calling the sink */
+#define FMT_DIGITS_MAX      (22u)   /* 64 bit octal */
+
+#define FMT_LEFT            (0x01u)
+#define FMT_ZERO            (0x02u)
+#define FMT_PLUS            (0x04u)
+#define FMT_SPACE           (0x08u)
+#define FMT_ALT             (0x10u)
+
+typedef struct
+{
+    FMT_SinkFn sink;
+    void* context;
+    uint16 used;
+    int total;
+    char chunk[FMT_CHUNK];
+} FMT_Out;
+
+typedef struct
+{
+    char* buffer;
+    uint16 size;
+    uint16 used;
+} FMT_Buffer;
+
+static const char fmt_lower[] = "0123456789abcdef";
+static const char fmt_upper[] = "0123456789ABCDEF";
+
+/*******************************************************************************
+* Function Name: FMT_DivU10
+********************************************************************************
+*
+* Summary:
+*  n / 10 from shifts and adds (Hacker's Delight 10-10).  About 20 cycles on
+*  the M0 against roughly 100 for the library divide.
+*
+* Parameters:
+*  n: dividend
+*
+* Return:
+*  Quotient
+*
+*******************************************************************************/
+uint32 FMT_DivU10(uint32 n)
+{
+    uint32 q;
+    uint32 r;
+
+    q = (n >> 1) + (n >> 2);
+    q += q >> 4;
+    q += q >> 8;
+    q += q >> 16;
+    q >>= 3;
+    r = n - ((q << 3) + (q << 1));
+    return (q + ((r + 6u) >> 4));
+}
+
+/*******************************************************************************
+* Function Name: FMT_U32ToDec
+********************************************************************************
+*
+* Summary:
+*  Writes the decimal digits of value, most significant first, without a
+*  terminating NUL.
+*
+* Parameters:
+*  value: number to convert
+*  out:   at least 10 characters
+*
+* Return:
+*  Number of digits written
+*
+*******************************************************************************/
+uint8 FMT_U32ToDec(uint32 value, char* out)
+{
+    char digits[10];
+    uint8 n = 0u;
+    uint8 i;
+    uint32 q;
+
+    do
+    {
+        q = FMT_DivU10(value);
+        digits[n++] = (char)('0' + (value - ((q << 3) + (q << 1))));
+        value = q;
+    }
+    while (value != 0u);
+
+    for (i = 0u; i < n; i++)
+    {
+        out[i] = digits[n - 1u - i];
+    }
+    return (n);
+}
+
+/* 64 bit variant of FMT_DivU10(), only used for %ll conversions */
+static uint64 FMT_DivU10_64(uint64 n)
+{
+    uint64 q;
+    uint64 r;
+
+    q = (n >> 1) + (n >> 2);
+    q += q >> 4;
+    q += q >> 8;
+    q += q >> 16;
+    q += q >> 32;
+    q >>= 3;
+    r = n - ((q << 3) + (q << 1));
+    return (q + ((r + 6u) >> 4));
+}
+
+static void FMT_Flush(FMT_Out* out)
+{
+    if (out->used != 0u)
+    {
+        out->sink(out->context, out->chunk, out->used);
+        out->used = 0u;
+    }
+}
+
+static void FMT_Put(FMT_Out* out, char c)
+{
+    out->chunk[out->used++] = c;
+    out->total++;
+    if (out->used == FMT_CHUNK)
+    {
+        FMT_Flush(out);
+    }
+}
+
+static void FMT_Pad(FMT_Out* out, char c, int count)
+{
+    while (count-- > 0)
+    {
+        FMT_Put(out, c);
+    }
+}
+
+/*******************************************************************************
+ * Digits of a 64 bit value, least significant first.  Only %llu and friends
+ * take the slow path; 32 bit values never touch the upper word.
+ *******************************************************************************/
+static uint8 FMT_Digits(uint64 value, uint8 base, const char* set, char* digits)
+{
+    uint8 n = 0u;
+    uint32 lo;
+    uint32 q;
+
+    if (base == 16u)
+    {
+        do
+        {
+            digits[n++] = set[(uint32)value & 0xFu];
+            value >>= 4;
+        }
+        while (value != 0u);
+    }
+    else if (base == 8u)
+    {
+        do
+        {
+            digits[n++] = set[(uint32)value & 0x7u];
+            value >>= 3;
+        }
+        while (value != 0u);
+    }
+    else
+    {
+        while ((value >> 32) != 0u)
+        {
+            uint64 q64 = FMT_DivU10_64(value);
+            digits[n++] = set[(uint32)(value - ((q64 << 3) + (q64 << 1)))];
+            value = q64;
+        }
+        lo = (uint32)value;
+        do
+        {
+            q = FMT_DivU10(lo);
+            digits[n++] = set[lo - ((q << 3) + (q << 1))];
+            lo = q;
+        }
+        while (lo != 0u);
+    }
+    return (n);
+}
+
+static void FMT_Number(FMT_Out* out, uint64 value, uint8 negative, uint8 base,
+                       const char* set, uint8 flags, int width, int precision)
+{
+    char digits[FMT_DIGITS_MAX];
+    char sign = 0;
+    char prefix[2];
+    uint8 nprefix = 0u;
+    uint8 p;
+    uint8 n;
+    int zeros;
+    int length;
+
+    if ((precision == 0) && (value == 0u))
+    {
+        n = 0u;
+    }
+    else
+    {
+        n = FMT_Digits(value, base, set, digits);
+    }
+
+    if (negative)
+    {
+        sign = '-';
+    }
+    else if (flags & FMT_PLUS)
+    {
+        sign = '+';
+    }
+    else if (flags & FMT_SPACE)
+    {
+        sign = ' ';
+    }
+    if ((flags & FMT_ALT) && (base == 16u) && (value != 0u))
+    {
+        prefix[nprefix++] = '0';
+        prefix[nprefix++] = (set == fmt_upper) ? 'X' : 'x';
+    }
+
+    zeros = (precision > (int)n) ? (precision - (int)n) : 0;
+    /* '#' makes the first octal digit a 0, also when there are no digits */
+    if ((flags & FMT_ALT) && (base == 8u) && (zeros == 0) && ((n == 0u) || (digits[n - 1u] != '0')))
+    {
+        zeros = 1;
+    }
+    length = (int)n + zeros + nprefix + ((sign != 0) ? 1 : 0);
+    if ((flags & FMT_ZERO) && !(flags & FMT_LEFT) && (precision < 0) && (width > length))
+    {
+        zeros += width - length;
+        length = width;
+    }
+
+    if (!(flags & FMT_LEFT))
+    {
+        FMT_Pad(out, ' ', width - length);
+    }
+    if (sign != 0)
+    {
+        FMT_Put(out, sign);
+    }
+    for (p = 0u; p < nprefix; p++)
+    {
+        FMT_Put(out, prefix[p]);
+    }
+    FMT_Pad(out, '0', zeros);
+    while (n > 0u)
+    {
+        FMT_Put(out, digits[--n]);
+    }
+    if (flags & FMT_LEFT)
+    {
+        FMT_Pad(out, ' ', width - length);
+    }
+}
+
+/*******************************************************************************
+* Function Name: FMT_VFormat
+********************************************************************************
+*
+* Summary:
+*  Formats into chunks of up to FMT_CHUNK bytes handed to sink.
+*
+* Parameters:
+*  sink:    output function
+*  context: passed to sink
+*  format:  printf format
+*  args:    arguments
+*
+* Return:
+*  Number of characters produced
+*
+*******************************************************************************/
+int FMT_VFormat(FMT_SinkFn sink, void* context, const char* format, va_list args)
+{
+    FMT_Out out;
+    uint8 flags;
+    int width;
+    int precision;
+    uint8 length;
+    uint8 half;
+    uint64 value;
+    uint8 negative;
+    const char* s;
+    int n;
+    int i;
+    char c;
+
+    out.sink = sink;
+    out.context = context;
+    out.used = 0u;
+    out.total = 0;
+
+    while ((c = *format++) != '\0')
+    {
+        if (c != '%')
+        {
+            FMT_Put(&out, c);
+            continue;
+        }
+
+        /* Flags */
+        flags = 0u;
+        for (;;)
+        {
+            c = *format;
+            if (c == '-')       { flags |= FMT_LEFT; }
+            else if (c == '0')  { flags |= FMT_ZERO; }
+            else if (c == '+')  { flags |= FMT_PLUS; }
+            else if (c == ' ')  { flags |= FMT_SPACE; }
+            else if (c == '#')  { flags |= FMT_ALT; }
+            else                { break; }
+            format++;
+        }
+
+        /* Width */
+        width = 0;
+        if (*format == '*')
+        {
+            width = va_arg(args, int);
+            if (width < 0)
+            {
+                flags |= FMT_LEFT;
+                width = -width;
+            }
+            format++;
+        }
+        else
+        {
+            while ((*format >= '0') && (*format <= '9'))
+            {
+                width = (width * 10) + (*format++ - '0');
+            }
+        }
+
+        /* Precision */
+        precision = -1;
+        if (*format == '.')
+        {
+            format++;
+            precision = 0;
+            if (*format == '*')
+            {
+                precision = va_arg(args, int);
+                format++;
+            }
+            else
+            {
+                while ((*format >= '0') && (*format <= '9'))
+                {
+                    precision = (precision * 10) + (*format++ - '0');
+                }
+            }
+        }
+
+        /* Length, 0 int, 1 long, 2 long long; half 1 short, 2 char */
+        length = 0u;
+        half = 0u;
+        while ((*format == 'h') || (*format == 'l'))
+        {
+            if (*format == 'l')
+            {
+                length++;
+            }
+            else
+            {
+                half++;
+            }
+            format++;
+        }
+
+        c = *format++;
+        switch (c)
+        {
+            case 'd':
+            case 'i':
+                if (length >= 2u)
+                {
+                    int64 v = va_arg(args, long long);
+                    negative = (v < 0);
+                    value = negative ? (uint64)(-(v + 1)) + 1u : (uint64)v;
+                }
+                else
+                {
+                    int32 v = (length == 1u) ? (int32)va_arg(args, long) : (int32)va_arg(args, int);
+                    if (half != 0u)
+                    {
+                        v = (half == 1u) ? (int32)(int16)v : (int32)(int8)v;
+                    }
+                    negative = (v < 0);
+                    value = negative ? (uint32)(-(v + 1)) + 1u : (uint32)v;
+                }
+                FMT_Number(&out, value, negative, 10u, fmt_lower, flags, width, precision);
+                break;
+
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                if (length >= 2u)
+                {
+                    value = va_arg(args, unsigned long long);
+                }
+                else
+                {
+                    value = (length == 1u) ? (uint32)va_arg(args, unsigned long) : (uint32)va_arg(args, unsigned int);
+                    if (half != 0u)
+                    {
+                        value = (half == 1u) ? (uint16)value : (uint8)value;
+                    }
+                }
+                FMT_Number(&out, value, 0u, (c == 'u') ? 10u : ((c == 'o') ? 8u : 16u),
+                           (c == 'X') ? fmt_upper : fmt_lower, flags, width, precision);
+                break;
+
+            case 'p':
+                value = (uintptr_t)va_arg(args, void*);
+                FMT_Number(&out, value, 0u, 16u, fmt_lower, flags | FMT_ALT, width, precision);
+                break;
+
+            case 'c':
+                if (!(flags & FMT_LEFT))
+                {
+                    FMT_Pad(&out, ' ', width - 1);
+                }
+                FMT_Put(&out, (char)va_arg(args, int));
+                if (flags & FMT_LEFT)
+                {
+                    FMT_Pad(&out, ' ', width - 1);
+                }
+                break;
+
+            case 's':
+                s = va_arg(args, const char*);
+                if (s == NULL)
+                {
+                    s = "(null)";
+                }
+                for (n = 0; (s[n] != '\0') && ((precision < 0) || (n < precision)); n++)
+                {
+                }
+                if (!(flags & FMT_LEFT))
+                {
+                    FMT_Pad(&out, ' ', width - n);
+                }
+                for (i = 0; i < n; i++)
+                {
+                    FMT_Put(&out, s[i]);
+                }
+                if (flags & FMT_LEFT)
+                {
+                    FMT_Pad(&out, ' ', width - n);
+                }
+                break;
+
+            case '%':
+                FMT_Put(&out, '%');
+                break;
+
+            case '\0':
+                format--;
+                break;
+
+            default:
+                /* Unknown conversion, show it as written */
+                FMT_Put(&out, '%');
+                FMT_Put(&out, c);
+                break;
+        }
+    }
+
+    FMT_Flush(&out);
+    return (out.total);
+}
+
+/*******************************************************************************
+* Function Name: FMT_Format
+********************************************************************************
+*
+* Summary:
+*  Variadic form of FMT_VFormat().
+*
+*******************************************************************************/
+int FMT_Format(FMT_SinkFn sink, void* context, const char* format, ...)
+{
+    va_list args;
+    int ret;
+
+    va_start(args, format);
+    ret = FMT_VFormat(sink, context, format, args);
+    va_end(args);
+    return (ret);
+}
+
+static void FMT_BufferSink(void* context, const char* data, uint16 length)
+{
+    FMT_Buffer* b = (FMT_Buffer*)context;
+
+    while ((length-- != 0u) && ((b->used + 1u) < b->size))
+    {
+        b->buffer[b->used++] = *data++;
+    }
+}
+
+/*******************************************************************************
+* Function Name: FMT_VSnprintf
+********************************************************************************
+*
+* Summary:
+*  Formats into buffer, truncating to size - 1 characters and always NUL
+*  terminating when size is not 0.
+*
+* Parameters:
+*  buffer: destination
+*  size:   size of buffer
+*  format: printf format
+*  args:   arguments
+*
+* Return:
+*  Length the complete output would have had
+*
+*******************************************************************************/
+int FMT_VSnprintf(char* buffer, uint16 size, const char* format, va_list args)
+{
+    FMT_Buffer b;
+    int ret;
+
+    b.buffer = buffer;
+    b.size = size;
+    b.used = 0u;
+    ret = FMT_VFormat(FMT_BufferSink, &b, format, args);
+    if (size != 0u)
+    {
+        buffer[b.used] = '\0';
+    }
+    return (ret);
+}
+
+/*******************************************************************************
+* Function Name: FMT_Snprintf
+********************************************************************************
+*
+* Summary:
+*  Variadic form of FMT_VSnprintf().
+*
+*******************************************************************************/
+int FMT_Snprintf(char* buffer, uint16 size, const char* format, ...)
+{
+    va_list args;
+    int ret;
+
+    va_start(args, format);
+    ret = FMT_VSnprintf(buffer, size, format, args);
+    va_end(args);
+    return (ret);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,516 @@
+/*******************************************************************************
+* FILE: i2cq.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Queued I2C master transactions, see i2cq.h.  Only the transaction at
+* the head of the ring is on the bus; producers add at the tail inside a
+* critical section, so requests may also be queued from interrupts.  The
+* head is advanced in main loop context only.  Short transfers are copied
+* into the ring entry; the Buf variants move data straight from or to the
+* caller's buffer.
+*******************************************************************************/
+#include <string.h>
+#include "i2cq.h"
+#include "timer.h"
+
+#if ((I2CQ_DEPTH & (I2CQ_DEPTH - 1u)) != 0u)
+    #error "I2CQ_DEPTH must be a power of two"
+#endif
+
+#define I2CQ_REG_MAX        (2u)
+
+/* Bus side of the head transaction */
+#define I2CQ_STATE_IDLE     (0u)
+#define I2CQ_STATE_ADDR     (1u)    /* read: register address sent, no stop */
+#define I2CQ_STATE_DATA     (2u)    /* write, or the data phase of a read */
+#define I2CQ_STATE_BACKOFF  (3u)    /* waiting to retry */
+
+typedef struct
+{
+    I2CQ_DoneFn done;
+    void*  context;
+    uint8* ext;                                 /* caller's data, or NULL */
+    uint16 length;                              /* of the data */
+    uint8  address;
+    uint8  read;
+    uint8  reg_size;
+    uint8  retries;                             /* 0 for a probe */
+    uint8  buf[I2CQ_REG_MAX + I2CQ_DATA_MAX];   /* register address, data */
+} I2CQ_Request;
+
+static I2CQ_Request i2cq_ring[I2CQ_DEPTH];
+static uint8 i2cq_head;
+static uint8 i2cq_tail;
+static volatile uint8 i2cq_count;
+static uint8 i2cq_state;
+static uint8 i2cq_attempt;
+static SysTick_Timer i2cq_timer;    /* timeout while on the bus, else backoff */
+static I2CQ_Stats i2cq_stats;
+
+/*******************************************************************************
+ * Adds a request to the tail of the ring.  data is copied into the entry;
+ * ext is used in place.  A request without register address and data is a
+ * probe.
+ *******************************************************************************/
+static uint8 I2CQ_Submit(uint8 address, uint8 read, uint16 reg, uint8 reg_size, const uint8* data,
+                         uint8* ext, uint16 length, I2CQ_DoneFn done, void* context)
+{
+    I2CQ_Request* req;
+    uint8 intr;
+
+    if ((reg_size > I2CQ_REG_MAX) || ((ext == NULL) && (length > I2CQ_DATA_MAX)) ||
+        ((read != 0u) && (length == 0u)))
+    {
+        return (I2CQ_ERR_PARAM);
+    }
+
+    intr = CyEnterCriticalSection();
+    if (i2cq_count == I2CQ_DEPTH)
+    {
+        i2cq_stats.full++;
+        CyExitCriticalSection(intr);
+        return (I2CQ_ERR_FULL);
+    }
+    req = &i2cq_ring[i2cq_tail];
+    req->done = done;
+    req->context = context;
+    req->ext = ext;
+    req->length = length;
+    req->address = address;
+    req->read = read;
+    req->reg_size = reg_size;
+    req->retries = ((reg_size + length) != 0u) ? I2CQ_RETRIES : 0u;
+    if (reg_size == 2u)
+    {
+        req->buf[0] = (uint8)(reg >> 8);
+        req->buf[1] = (uint8)reg;
+    }
+    else if (reg_size == 1u)
+    {
+        req->buf[0] = (uint8)reg;
+    }
+    if (data != NULL)
+    {
+        memcpy(&req->buf[reg_size], data, length);
+    }
+    i2cq_tail = (i2cq_tail + 1u) & (I2CQ_DEPTH - 1u);
+    i2cq_count++;
+    if (i2cq_count > i2cq_stats.depth_max)
+    {
+        i2cq_stats.depth_max = i2cq_count;
+    }
+    i2cq_stats.submitted++;
+    CyExitCriticalSection(intr);
+    return (I2CQ_OK);
+}
+
+/*******************************************************************************
+ * Where the data of a request is.
+ *******************************************************************************/
+static uint8* I2CQ_Data(I2CQ_Request* req)
+{
+    return ((req->ext != NULL) ? req->ext : &req->buf[req->reg_size]);
+}
+
+/*******************************************************************************
+ * Puts the head transaction on the bus.  Returns the SCBM_I2C_MSTR_xxx code.
+ *******************************************************************************/
+static uint32 I2CQ_Begin(void)
+{
+    I2CQ_Request* req = &i2cq_ring[i2cq_head];
+    uint32 rc;
+
+    (void)SCBM_I2CMasterClearStatus();
+    /* Long transfers get their bus time on top of the timeout */
+    SysTick_TimerArm(&i2cq_timer, I2CQ_TIMEOUT_MS + 1u + ((uint32)req->length >> I2CQ_BYTES_PER_MS_SHIFT), 0u);
+    if (req->read != 0u)
+    {
+        if (req->reg_size != 0u)
+        {
+            i2cq_state = I2CQ_STATE_ADDR;
+            rc = SCBM_I2CMasterWriteBuf(req->address, req->buf, req->reg_size, SCBM_I2C_MODE_NO_STOP);
+        }
+        else
+        {
+            i2cq_state = I2CQ_STATE_DATA;
+            rc = SCBM_I2CMasterReadBuf(req->address, I2CQ_Data(req), req->length, SCBM_I2C_MODE_COMPLETE_XFER);
+        }
+    }
+    else
+    {
+        i2cq_state = I2CQ_STATE_DATA;
+        if (req->ext != NULL)
+        {
+            /* The caller's buffer starts with the register address */
+            rc = SCBM_I2CMasterWriteBuf(req->address, req->ext, req->length, SCBM_I2C_MODE_COMPLETE_XFER);
+        }
+        else
+        {
+            rc = SCBM_I2CMasterWriteBuf(req->address, req->buf, (uint32)req->reg_size + req->length,
+                                        SCBM_I2C_MODE_COMPLETE_XFER);
+        }
+    }
+    return (rc);
+}
+
+/*******************************************************************************
+ * Removes the head transaction and reports its result.  The request is
+ * copied first so the callback may queue new work into the freed slot.
+ *******************************************************************************/
+static void I2CQ_Finish(uint8 result)
+{
+    I2CQ_Request req = i2cq_ring[i2cq_head];
+    uint8 intr;
+
+    SysTick_TimerCancel(&i2cq_timer);
+    i2cq_state = I2CQ_STATE_IDLE;
+    if (req.retries == 0u)
+    {
+        i2cq_stats.probes++;
+    }
+    else if (result == I2CQ_OK)
+    {
+        i2cq_stats.completed++;
+    }
+    else
+    {
+        i2cq_stats.failed++;
+    }
+    intr = CyEnterCriticalSection();
+    i2cq_head = (i2cq_head + 1u) & (I2CQ_DEPTH - 1u);
+    i2cq_count--;
+    CyExitCriticalSection(intr);
+
+    if (req.done != NULL)
+    {
+        req.done(req.context, result, (req.read != 0u) ? I2CQ_Data(&req) : NULL, req.length);
+    }
+}
+
+/*******************************************************************************
+ * Retries the head transaction after I2CQ_RETRY_MS or gives up on it.
+ *******************************************************************************/
+static void I2CQ_Fail(uint8 result)
+{
+    if (i2cq_attempt < i2cq_ring[i2cq_head].retries)
+    {
+        i2cq_attempt++;
+        i2cq_stats.retries++;
+        i2cq_state = I2CQ_STATE_BACKOFF;
+        SysTick_TimerArm(&i2cq_timer, I2CQ_RETRY_MS, 0u);
+    }
+    else
+    {
+        I2CQ_Finish(result);
+    }
+}
+
+/*** SCBM custom interrupt handler: a completion is for I2CQ_Service() ***/
+static void I2CQ_Interrupt(void)
+{
+    SysTick_Wake();
+}
+
+/*******************************************************************************
+* Function Name: I2CQ_Start
+********************************************************************************
+*
+* Summary:
+*  Empties the queue and clears the counters.  Call it after I2C_Start(),
+*  which starts the SCBM block.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void I2CQ_Start(void)
+{
+    SysTick_TimerInit(&i2cq_timer, NULL, NULL);
+    i2cq_head = 0u;
+    i2cq_tail = 0u;
+    i2cq_count = 0u;
+    i2cq_state = I2CQ_STATE_IDLE;
+    I2CQ_ClearStats();
+    SCBM_SetCustomInterruptHandler(I2CQ_Interrupt);
+}
+
+/*******************************************************************************
+* Function Name: I2CQ_Service
+********************************************************************************
+*
+* Summary:
+*  Advances the head transaction: checks the SCBM status, starts the read
+*  phase, retries, times out and runs the done callback.  Call it once per
+*  main loop pass; it never waits for the bus.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void I2CQ_Service(void)
+{
+    I2CQ_Request* req = &i2cq_ring[i2cq_head];
+    uint32 status;
+
+    switch (i2cq_state)
+    {
+    case I2CQ_STATE_IDLE:
+        break;
+
+    case I2CQ_STATE_BACKOFF:
+        if (SysTick_TimerExpired(&i2cq_timer) && (I2CQ_Begin() != SCBM_I2C_MSTR_NO_ERROR))
+        {
+            i2cq_stats.bus_errors++;
+            I2CQ_Fail(I2CQ_ERR_BUS);
+        }
+        break;
+
+    default:
+        status = SCBM_I2CMasterStatus();
+        if ((status & SCBM_I2C_MSTAT_ERR_MASK) != 0u)
+        {
+            if ((status & (SCBM_I2C_MSTAT_ERR_ADDR_NAK | SCBM_I2C_MSTAT_ERR_SHORT_XFER)) != 0u)
+            {
+                /* A probe NAK only says the slave is busy */
+                if (req->retries != 0u)
+                {
+                    i2cq_stats.naks++;
+                }
+                I2CQ_Fail(I2CQ_ERR_NAK);
+            }
+            else
+            {
+                i2cq_stats.bus_errors++;
+                I2CQ_Fail(I2CQ_ERR_BUS);
+            }
+        }
+        else if ((status & (SCBM_I2C_MSTAT_RD_CMPLT | SCBM_I2C_MSTAT_WR_CMPLT)) != 0u)
+        {
+            if (i2cq_state == I2CQ_STATE_DATA)
+            {
+                I2CQ_Finish(I2CQ_OK);
+            }
+            else
+            {
+                (void)SCBM_I2CMasterClearStatus();
+                i2cq_state = I2CQ_STATE_DATA;
+                if (SCBM_I2CMasterReadBuf(req->address, I2CQ_Data(req), req->length,
+                                          SCBM_I2C_MODE_REPEAT_START) != SCBM_I2C_MSTR_NO_ERROR)
+                {
+                    i2cq_stats.bus_errors++;
+                    I2CQ_Fail(I2CQ_ERR_BUS);
+                }
+            }
+        }
+        else if (SysTick_TimerExpired(&i2cq_timer))
+        {
+            /* The block is stuck, a restart releases the bus */
+            SCBM_Stop();
+            SCBM_Start();
+            i2cq_stats.timeouts++;
+            I2CQ_Fail(I2CQ_ERR_TIMEOUT);
+        }
+        break;
+    }
+
+    /* Start the next transaction straight away, nothing else would wake
+     * the main loop for it */
+    if ((i2cq_state == I2CQ_STATE_IDLE) && (i2cq_count != 0u))
+    {
+        i2cq_attempt = 0u;
+        if (I2CQ_Begin() != SCBM_I2C_MSTR_NO_ERROR)
+        {
+            i2cq_stats.bus_errors++;
+            I2CQ_Fail(I2CQ_ERR_BUS);
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: I2CQ_Write
+********************************************************************************
+*
+* Summary:
+*  Queues a register write.  The data is copied, the caller's buffer is free
+*  on return.
+*
+* Parameters:
+*  address: 7 bit slave address
+*  reg: register address, sent first if reg_size is not 0
+*  reg_size: bytes of register address, 0..2
+*  data: bytes to write
+*  length: number of bytes, up to I2CQ_DATA_MAX
+*  done: completion callback or NULL
+*  context: argument passed to done
+*
+* Return:
+*  I2CQ_OK if queued, otherwise I2CQ_ERR_FULL or I2CQ_ERR_PARAM
+*
+*******************************************************************************/
+uint8 I2CQ_Write(uint8 address, uint16 reg, uint8 reg_size, const uint8* data, uint8 length,
+                 I2CQ_DoneFn done, void* context)
+{
+    if ((reg_size + length) == 0u)
+    {
+        return (I2CQ_ERR_PARAM);
+    }
+    return (I2CQ_Submit(address, 0u, reg, reg_size, data, NULL, length, done, context));
+}
+
+/*******************************************************************************
+* Function Name: I2CQ_Read
+********************************************************************************
+*
+* Summary:
+*  Queues a register read.  The bytes are passed to the done callback.
+*
+* Parameters:
+*  address: 7 bit slave address
+*  reg: register address, sent first if reg_size is not 0
+*  reg_size: bytes of register address, 0..2
+*  length: number of bytes, 1..I2CQ_DATA_MAX
+*  done: completion callback or NULL
+*  context: argument passed to done
+*
+* Return:
+*  I2CQ_OK if queued, otherwise I2CQ_ERR_FULL or I2CQ_ERR_PARAM
+*
+*******************************************************************************/
+uint8 I2CQ_Read(uint8 address, uint16 reg, uint8 reg_size, uint8 length,
+                I2CQ_DoneFn done, void* context)
+{
+    return (I2CQ_Submit(address, 1u, reg, reg_size, NULL, NULL, length, done, context));
+}
+
+/*******************************************************************************
+* Function Name: I2CQ_WriteBuf
+********************************************************************************
+*
+* Summary:
+*  Queues a write of a caller buffer, sent as it is: it starts with the
+*  register address, if the slave has one.  The buffer must stay unchanged
+*  until the done callback.
+*
+* Parameters:
+*  address: 7 bit slave address
+*  buffer: register address and data
+*  length: number of bytes, at least 1
+*  done: completion callback or NULL
+*  context: argument passed to done
+*
+* Return:
+*  I2CQ_OK if queued, otherwise I2CQ_ERR_FULL or I2CQ_ERR_PARAM
+*
+*******************************************************************************/
+uint8 I2CQ_WriteBuf(uint8 address, const uint8* buffer, uint16 length, I2CQ_DoneFn done, void* context)
+{
+    if ((buffer == NULL) || (length == 0u))
+    {
+        return (I2CQ_ERR_PARAM);
+    }
+    return (I2CQ_Submit(address, 0u, 0u, 0u, NULL, (uint8*)buffer, length, done, context));
+}
+
+/*******************************************************************************
+* Function Name: I2CQ_ReadBuf
+********************************************************************************
+*
+* Summary:
+*  Queues a register read into a caller buffer, as one transaction of any
+*  length.  The buffer must stay valid until the done callback.
+*
+* Parameters:
+*  address: 7 bit slave address
+*  reg: register address, sent first if reg_size is not 0
+*  reg_size: bytes of register address, 0..2
+*  buffer: receives the data
+*  length: number of bytes, at least 1
+*  done: completion callback or NULL
+*  context: argument passed to done
+*
+* Return:
+*  I2CQ_OK if queued, otherwise I2CQ_ERR_FULL or I2CQ_ERR_PARAM
+*
+*******************************************************************************/
+uint8 I2CQ_ReadBuf(uint8 address, uint16 reg, uint8 reg_size, uint8* buffer, uint16 length,
+                   I2CQ_DoneFn done, void* context)
+{
+    if (buffer == NULL)
+    {
+        return (I2CQ_ERR_PARAM);
+    }
+    return (I2CQ_Submit(address, 1u, reg, reg_size, NULL, buffer, length, done, context));
+}
+
+/*******************************************************************************
+ * Queues an address only write, which is not retried: the result is I2CQ_OK
+ * if the slave acknowledged.  Used to poll a busy EEPROM.
+ *******************************************************************************/
+uint8 I2CQ_Probe(uint8 address, I2CQ_DoneFn done, void* context)
+{
+    return (I2CQ_Submit(address, 0u, 0u, 0u, NULL, NULL, 0u, done, context));
+}
+
+/*******************************************************************************
+ * Number of transactions queued or on the bus.
+ *******************************************************************************/
+uint8 I2CQ_Pending(void)
+{
+    return (i2cq_count);
+}
+
+/*******************************************************************************
+* Function Name: I2CQ_Flush
+********************************************************************************
+*
+* Summary:
+*  Runs the queue until it is empty.  Blocks for up to
+*  I2CQ_DEPTH * (I2CQ_RETRIES + 1) * I2CQ_TIMEOUT_MS; used before the reset
+*  into the bootloader, and meant for blocking i2c_psoc calls.  The timer
+*  callbacks run inside, so do not call it from one.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void I2CQ_Flush(void)
+{
+    while (i2cq_count != 0u)
+    {
+        SysTick_Refresh();
+        I2CQ_Service();
+    }
+}
+
+void I2CQ_GetStats(I2CQ_Stats* stats)
+{
+    uint8 intr = CyEnterCriticalSection();
+    *stats = i2cq_stats;
+    CyExitCriticalSection(intr);
+}
+
+void I2CQ_ClearStats(void)
+{
+    uint8 intr = CyEnterCriticalSection();
+    memset(&i2cq_stats, 0, sizeof(i2cq_stats));
+    CyExitCriticalSection(intr);
+}
+
+/* [] END OF FILE */
@@ -1,95 +1,26 @@
 /******************************************************************************
 *This file is for iprintf()
-*The iprintf() is a simple printf() and only can print string with %s,%d,%c,%x.
+*The iprintf() is a simple printf() on top of the division free FMT engine,
+*see fmt.h for the supported conversions.  Output is queued on the SIO port
+*in chunks rather than one character at a time.
 *******************************************************************************/
 #include "iprintf.h"
+#include "fmt.h"
 #include "sio.h"
+#include "sio_tx.h"
 
-static void iputc(char8 ch)
+static void iputs(void* context, const char* data, uint16 length)
 {
-	/*This function has to be replaced by user*/
-    UART_PUT_CHAR(ch);
-}
-
-static uint8* change(uint32 Index)
-{
-    return (uint8*)("0123456789abcdef"+Index);
+    /* FMT sink of iprintf(), queues each chunk on the SIO port */
+    (void)context;
+    (void)SIO_Write((const uint8*)data, length);
 }
 
 void iprintf(char8 *pszFmt,...)
 {
-    uint8 *pszVal;
-    uint32 iVal, xVal, i = 0, buffer[12], index = 1;
-    uint8 cVal;
-    uint32 *pArg;
-    pArg =(uint32 *)&pszFmt;
-
-    while(*pszFmt)
-    {
-        if('%' != *pszFmt)
-        {
-            iputc(*pszFmt);
-            pszFmt++;
-            continue;
-        }
-        pszFmt++;
+    va_list args;
 
-        if(*pszFmt == 's')
-        {
-            pszVal = (uint8*)pArg[index++];
-            for(; *pszVal != '\0'; pszVal++)
-                iputc(*pszVal);
-            pszFmt++;
-            continue;
-        }
-        if(*pszFmt == 'd')
-        {
-            iVal = pArg[index++];
-            i = 0;
-            do{
-                buffer[i++] = iVal % 10;
-                iVal /= 10;
-            }while(iVal);
-            while(i > 0)
-            {
-                i--;
-                iputc(*change(buffer[i]));
-            }
-            pszFmt++;
-            continue;
-        }
-        if(*pszFmt == 'c')
-        {
-            cVal = (uint8)pArg[index++];
-            iputc(cVal);
-            pszFmt++;
-            continue;
-        }
-        if(*pszFmt == 'x')
-        {
-            xVal = pArg[index++];
-            i = 0;
-            do{
-                buffer[i++] = xVal % 16;
-                xVal /= 16;
-            }while(xVal);
-            if(i%2!=0)
-                buffer[i++]=0;
-            if(i<2)
-                buffer[i++]=0;
-
-            while(i > 0)
-            {
-                i--;
-                iputc(*change(buffer[i]));
-            }
-            pszFmt++;
-            continue;
-        }
-        if(pszFmt == '\0')
-        {
-            break;
-        }
-
-    }
-}
\ No newline at end of file
+    va_start(args, pszFmt);
+    (void)FMT_VFormat(iputs, NULL, pszFmt, args);
+    va_end(args);
+}
@@ -0,0 +1,120 @@
+/*******************************************************************************
+* FILE: modlog.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Runtime thresholds for the per module log levels, see modlog.h.
+*******************************************************************************/
+#include "modlog.h"
+
+uint8 mlog_level[MLOG_MOD_LAST] =
+{
+    MLOG_LEVEL_DEFAULT,     /* MLOG_MOD_TIMER */
+    MLOG_LEVEL_DEFAULT,     /* MLOG_MOD_SIO */
+    MLOG_LEVEL_DEFAULT,     /* MLOG_MOD_SDO */
+    MLOG_LEVEL_DEFAULT,     /* MLOG_MOD_USR */
+    MLOG_LEVEL_DEFAULT      /* MLOG_MOD_BOOT */
+};
+
+/*******************************************************************************
+* Function Name: MLOG_SetLevel
+********************************************************************************
+*
+* Summary:
+*  Sets the runtime threshold of one module.  Levels above MLOG_LVL_TRACE are
+*  clamped.
+*
+* Parameters:
+*  module: MLOG_MOD_xxx
+*  level:  MLOG_LVL_xxx
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void MLOG_SetLevel(uint8 module, uint8 level)
+{
+    if (module < MLOG_MOD_LAST)
+    {
+        mlog_level[module] = (level > MLOG_LVL_TRACE) ? MLOG_LVL_TRACE : level;
+    }
+}
+
+/*******************************************************************************
+* Function Name: MLOG_GetLevel
+********************************************************************************
+*
+* Summary:
+*  Returns the runtime threshold of one module.
+*
+* Parameters:
+*  module: MLOG_MOD_xxx
+*
+* Return:
+*  MLOG_LVL_xxx, MLOG_LVL_NONE for an unknown module
+*
+*******************************************************************************/
+uint8 MLOG_GetLevel(uint8 module)
+{
+    return ((module < MLOG_MOD_LAST) ? mlog_level[module] : MLOG_LVL_NONE);
+}
+
+/*******************************************************************************
+* Function Name: MLOG_SetLevels
+********************************************************************************
+*
+* Summary:
+*  Sets every module from the packed object 0x2610 value, one nibble per
+*  module with MLOG_MOD_TIMER in bits 0..3.
+*
+* Parameters:
+*  packed: thresholds
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void MLOG_SetLevels(uint32 packed)
+{
+    uint8 module;
+
+    for (module = 0u; module < MLOG_MOD_LAST; module++)
+    {
+        MLOG_SetLevel(module, (uint8)((packed >> (4u * module)) & 0x0Fu));
+    }
+}
+
+/*******************************************************************************
+* Function Name: MLOG_GetLevels
+********************************************************************************
+*
+* Summary:
+*  Returns the thresholds packed like MLOG_SetLevels() takes them.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Packed thresholds
+*
+*******************************************************************************/
+uint32 MLOG_GetLevels(void)
+{
+    uint32 packed = 0u;
+    uint8 module;
+
+    for (module = 0u; module < MLOG_MOD_LAST; module++)
+    {
+        packed |= (uint32)mlog_level[module] << (4u * module);
+    }
+    return (packed);
+}
+
+/* [] END OF FILE */
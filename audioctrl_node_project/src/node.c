@@ -13,6 +13,7 @@
 *     Implements the API used by the specific CAN node slave application.
 *******************************************************************************/
 #include "global.h"
+#include "ee24.h"
 #include "i2c_psoc.h"
 #include "node.h"
 #include "sio.h"
@@ -54,15 +55,42 @@ void NODE_Start(void)
 }
 
 
-void NODE_ReadEE(uint16 addr, uint8* buffer, size_t size)
+/*******************************************************************************
+ * Blocking EEPROM access through ee24.c; the I2C queue keeps running while
+ * these wait.  An operation already running, a pstore write or the boot log
+ * read, is waited out first.  EE24_Wait() runs SysTick_Refresh(), so timer
+ * wheel callbacks run from inside these calls: do not call them from a
+ * timer callback, nor hold state across them that a callback changes.  Use
+ * EE24_Read() / EE24_Write() to not block.
+ ******************************************************************************/
+uint8 NODE_ReadEE(uint16 addr, uint8* buffer, size_t size)
 {
-    I2C_Write (I2C_ADDR_EEPROM, addr, buffer, size);    
+    uint8 result = EE24_ERR_RANGE;
+
+    if (size <= EE24_SIZE)
+    {
+        do
+        {
+            (void)EE24_Wait();
+            result = EE24_Read(addr, buffer, (uint16)size, NULL, NULL);
+        } while (result == EE24_ERR_BUSY);
+    }
+    return ((result == EE24_OK) ? EE24_Wait() : result);
 }
 
-void NODE_WriteEE(uint16 addr, const uint8* buffer, size_t size)
+uint8 NODE_WriteEE(uint16 addr, const uint8* buffer, size_t size)
 {
-	I2C_Clear();    
-    I2C_Write (I2C_ADDR_EEPROM, addr, (uint8*)buffer, size);    
+    uint8 result = EE24_ERR_RANGE;
+
+    if (size <= EE24_SIZE)
+    {
+        do
+        {
+            (void)EE24_Wait();
+            result = EE24_Write(addr, buffer, (uint16)size, NULL, NULL);
+        } while (result == EE24_ERR_BUSY);
+    }
+    return ((result == EE24_OK) ? EE24_Wait() : result);
 }
 
 /* [] END OF FILE */
@@ -0,0 +1,267 @@
+/*******************************************************************************
+* FILE: od.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Lookup, handler dispatch and range checks of the generated object
+*     dictionary table, see od.h.
+*******************************************************************************/
+#include "od_table.h"
+
+/* A value that fits the object's size came from its bytes (SDO buffer) and
+ * is sign extended; anything larger already is */
+static int32 OD_SignExtend(uint32 value, uint8 size)
+{
+    if ((size == 1u) && (value <= 0xFFu))
+    {
+        return ((int32)(int8)value);
+    }
+    if ((size == 2u) && (value <= 0xFFFFu))
+    {
+        return ((int32)(int16)value);
+    }
+    return ((int32)value);
+}
+
+/*******************************************************************************
+* Function Name: OD_Find
+********************************************************************************
+*
+* Summary:
+*  Looks up an object: od_slot[], or od_comm_slot[] below OD_INDEX_FIRST,
+*  gives the table position of its subindex 0 and the subindices of a
+*  record follow it in order.
+*
+* Parameters:
+*  index, subindex: object
+*
+* Return:
+*  Table entry, NULL if the object is not in the table
+*
+*******************************************************************************/
+const OD_Entry* OD_Find(uint16 index, uint8 subindex)
+{
+    const OD_Entry* e;
+    uint16 slot = OD_NO_SLOT;
+
+    if (index > OD_INDEX_LAST)
+    {
+        return (NULL);
+    }
+    if (index >= OD_INDEX_FIRST)
+    {
+        slot = od_slot[index - OD_INDEX_FIRST];
+    }
+#if (OD_COMM_COUNT > 0u)
+    else
+    {
+        uint8 i;
+
+        for (i = 0u; i < OD_COMM_COUNT; i++)
+        {
+            if (od_comm_slot[i].index == index)
+            {
+                slot = od_comm_slot[i].slot;
+                break;
+            }
+        }
+    }
+#endif
+    if ((slot == OD_NO_SLOT) || ((slot + subindex) >= OD_TABLE_SIZE))
+    {
+        return (NULL);
+    }
+    e = &od_table[slot + subindex];
+    return ((e->index == index) ? e : NULL);
+}
+
+/*******************************************************************************
+* Function Name: OD_Register
+********************************************************************************
+*
+* Summary:
+*  Replaces the handlers of an object.  The handler set must stay valid
+*  while it is registered.
+*
+* Parameters:
+*  index: object
+*  handlers: new handlers, NULL for none
+*
+* Return:
+*  OD_OK or OD_NO_OBJECT
+*
+*******************************************************************************/
+uint8 OD_Register(uint16 index, const OD_Handlers* handlers)
+{
+    const OD_Entry* e = OD_Find(index, 0u);
+
+    if (e == NULL)
+    {
+        return (OD_NO_OBJECT);
+    }
+    od_handlers[e->object] = handlers;
+    return (OD_OK);
+}
+
+/*******************************************************************************
+* Function Name: OD_Read
+********************************************************************************
+*
+* Summary:
+*  Returns the current value of an object, zero extended.
+*
+* Parameters:
+*  index, subindex: object
+*  value: receives the value
+*
+* Return:
+*  OD_OK, OD_NO_OBJECT or the result of the refresh handler
+*
+*******************************************************************************/
+uint8 OD_Read(uint16 index, uint8 subindex, uint32* value)
+{
+    const OD_Entry* e = OD_Find(index, subindex);
+    const OD_Handlers* h;
+
+    if (e == NULL)
+    {
+        return (OD_NO_OBJECT);
+    }
+    h = od_handlers[e->object];
+    if ((h != NULL) && (h->refresh != NULL) && ((e->access & OD_ACCESS_CONST) == 0u))
+    {
+        return (h->refresh(subindex, value));
+    }
+    if (e->data != NULL)
+    {
+        *value = 0u;
+        memcpy(value, e->data, e->size);
+    }
+    else
+    {
+        *value = e->value;
+    }
+    return (OD_OK);
+}
+
+/*******************************************************************************
+* Function Name: OD_Validate
+********************************************************************************
+*
+* Summary:
+*  Checks a value about to be written against the range of the object and
+*  its validate handler.  Access is not checked; the CANopen stack has done
+*  that before it asks.
+*
+* Parameters:
+*  index, subindex: object
+*  value: new value; signed objects also accept it sign extended
+*
+* Return:
+*  OD_OK, OD_NO_OBJECT, OD_RANGE or the result of the validate handler
+*
+*******************************************************************************/
+uint8 OD_Validate(uint16 index, uint8 subindex, uint32 value)
+{
+    const OD_Entry* e = OD_Find(index, subindex);
+    const OD_Handlers* h;
+
+    if (e == NULL)
+    {
+        return (OD_NO_OBJECT);
+    }
+    if ((e->type == OD_TYPE_INT8) || (e->type == OD_TYPE_INT16) || (e->type == OD_TYPE_INT32))
+    {
+        int32 v = OD_SignExtend(value, e->size);
+        if ((v < (int32)e->low) || (v > (int32)e->high))
+        {
+            return (OD_RANGE);
+        }
+    }
+    else if ((value < e->low) || (value > e->high))
+    {
+        return (OD_RANGE);
+    }
+
+    h = od_handlers[e->object];
+    if ((h != NULL) && (h->validate != NULL))
+    {
+        return (h->validate(subindex, value));
+    }
+    return (OD_OK);
+}
+
+/*******************************************************************************
+* Function Name: OD_Apply
+********************************************************************************
+*
+* Summary:
+*  Takes a validated value: stores the RAM copy, if any, and runs the apply
+*  handler.
+*
+* Parameters:
+*  index, subindex: object
+*  value: new value
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void OD_Apply(uint16 index, uint8 subindex, uint32 value)
+{
+    const OD_Entry* e = OD_Find(index, subindex);
+    const OD_Handlers* h;
+
+    if (e == NULL)
+    {
+        return;
+    }
+    if (e->data != NULL)
+    {
+        memcpy(e->data, &value, e->size);
+    }
+    h = od_handlers[e->object];
+    if ((h != NULL) && (h->apply != NULL))
+    {
+        h->apply(subindex, value);
+    }
+}
+
+/* Validate and apply for writes that do not come through the stack, so the
+ * access is checked too */
+uint8 OD_Write(uint16 index, uint8 subindex, uint32 value)
+{
+    const OD_Entry* e = OD_Find(index, subindex);
+    uint8 result;
+
+    if (e == NULL)
+    {
+        return (OD_NO_OBJECT);
+    }
+    if ((e->access & OD_ACCESS_WO) == 0u)
+    {
+        return (OD_READ_ONLY);
+    }
+    result = OD_Validate(index, subindex, value);
+    if (result == OD_OK)
+    {
+        OD_Apply(index, subindex, value);
+    }
+    return (result);
+}
+
+/* Size of an object's value in bytes, 0 if it is not in the table */
+uint8 OD_Size(uint16 index, uint8 subindex)
+{
+    const OD_Entry* e = OD_Find(index, subindex);
+    return ((e != NULL) ? e->size : 0u);
+}
+
+/* [] END OF FILE */
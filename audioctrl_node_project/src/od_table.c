@@ -0,0 +1,197 @@
+/*******************************************************************************
+* FILE: od_table.c
+*
+* Generated by tools/od_gen.py from config/slave_node.yaml, do not edit.
+********************************************************************************
+*
+* DESCRIPTION:
+*     Object dictionary of Audio Control Node: entries in index and subindex
+* order, the slot of each index in the table, and the RAM copy of the
+* values that have no refresh handler.
+*******************************************************************************/
+#include "od_table.h"
+
+/* Values stored here, initialised from the YAML defaults */
+static struct
+{
+    uint8 speaker_volume;
+    uint8 prof_reset;
+} od_values =
+{
+    0x64u,
+    0x0u
+};
+
+static const OD_Handlers od_handlers_store_parameters = { OD_Validate_store_parameters, OD_Apply_store_parameters, OD_Refresh_store_parameters };
+
+static const OD_Handlers od_handlers_restore_default_parameters = { OD_Validate_restore_default_parameters, OD_Apply_restore_default_parameters, OD_Refresh_restore_default_parameters };
+
+static void od_apply_speaker_enable(uint8 subindex, uint32 value)
+{
+    (void)subindex;
+    OD_Apply_speaker_enable((uint8)value);
+}
+
+static uint8 od_refresh_speaker_enable(uint8 subindex, uint32* value)
+{
+    uint8 v;
+    uint8 result = OD_Refresh_speaker_enable(&v);
+
+    (void)subindex;
+    *value = (uint32)v;
+    return (result);
+}
+
+static const OD_Handlers od_handlers_speaker_enable = { NULL, od_apply_speaker_enable, od_refresh_speaker_enable };
+
+static void od_apply_speaker_volume(uint8 subindex, uint32 value)
+{
+    (void)subindex;
+    OD_Apply_speaker_volume((uint8)value);
+}
+
+static const OD_Handlers od_handlers_speaker_volume = { NULL, od_apply_speaker_volume, NULL };
+
+static void od_apply_log_levels(uint8 subindex, uint32 value)
+{
+    (void)subindex;
+    OD_Apply_log_levels((uint32)value);
+}
+
+static uint8 od_refresh_log_levels(uint8 subindex, uint32* value)
+{
+    uint32 v;
+    uint8 result = OD_Refresh_log_levels(&v);
+
+    (void)subindex;
+    *value = (uint32)v;
+    return (result);
+}
+
+static const OD_Handlers od_handlers_log_levels = { NULL, od_apply_log_levels, od_refresh_log_levels };
+
+static void od_apply_prof_reset(uint8 subindex, uint32 value)
+{
+    (void)subindex;
+    OD_Apply_prof_reset((uint8)value);
+}
+
+static const OD_Handlers od_handlers_prof_reset = { NULL, od_apply_prof_reset, NULL };
+
+static const OD_Handlers od_handlers_prof_usr_main = { NULL, NULL, OD_Refresh_prof_usr_main };
+
+static const OD_Handlers od_handlers_prof_led_handler = { NULL, NULL, OD_Refresh_prof_led_handler };
+
+static const OD_Handlers od_handlers_prof_objcb = { NULL, NULL, OD_Refresh_prof_objcb };
+
+static const OD_Handlers od_handlers_prof_can_isr = { NULL, NULL, OD_Refresh_prof_can_isr };
+
+/* Handlers of each object, OD_Register() replaces them */
+const OD_Handlers* od_handlers[OD_OBJECT_COUNT] =
+{
+    &od_handlers_store_parameters,
+    &od_handlers_restore_default_parameters,
+    &od_handlers_speaker_enable,
+    &od_handlers_speaker_volume,
+    &od_handlers_log_levels,
+    &od_handlers_prof_reset,
+    &od_handlers_prof_usr_main,
+    &od_handlers_prof_led_handler,
+    &od_handlers_prof_objcb,
+    &od_handlers_prof_can_isr
+};
+
+const OD_Entry od_table[OD_TABLE_SIZE] =
+{
+    { 0x1010u,  0u, OD_TYPE_UINT8, OD_ACCESS_RO | OD_ACCESS_CONST, 1u, 0u, 0x0u, 0xFFu, 0x1u, NULL },
+    { 0x1010u,  1u, OD_TYPE_UINT32, OD_ACCESS_RW, 4u, 0u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x1011u,  0u, OD_TYPE_UINT8, OD_ACCESS_RO | OD_ACCESS_CONST, 1u, 1u, 0x0u, 0xFFu, 0x1u, NULL },
+    { 0x1011u,  1u, OD_TYPE_UINT32, OD_ACCESS_RW, 4u, 1u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2600u,  0u, OD_TYPE_UINT8, OD_ACCESS_RW, 1u, 2u, 0x0u, 0x1u, 0u, NULL },
+    { 0x2601u,  0u, OD_TYPE_UINT8, OD_ACCESS_RW, 1u, 3u, 0x0u, 0x64u, 0u, &od_values.speaker_volume },
+    { 0x2610u,  0u, OD_TYPE_UINT32, OD_ACCESS_RW, 4u, 4u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2620u,  0u, OD_TYPE_UINT8, OD_ACCESS_RW, 1u, 5u, 0x0u, 0xFFu, 0u, &od_values.prof_reset },
+    { 0x2621u,  0u, OD_TYPE_UINT8, OD_ACCESS_RO | OD_ACCESS_CONST, 1u, 6u, 0x0u, 0xFFu, 0xDu, NULL },
+    { 0x2621u,  1u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2621u,  2u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2621u,  3u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2621u,  4u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2621u,  5u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2621u,  6u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2621u,  7u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2621u,  8u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2621u,  9u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2621u, 10u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2621u, 11u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2621u, 12u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2621u, 13u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 6u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u,  0u, OD_TYPE_UINT8, OD_ACCESS_RO | OD_ACCESS_CONST, 1u, 7u, 0x0u, 0xFFu, 0xDu, NULL },
+    { 0x2622u,  1u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u,  2u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u,  3u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u,  4u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u,  5u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u,  6u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u,  7u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u,  8u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u,  9u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u, 10u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u, 11u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u, 12u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2622u, 13u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 7u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u,  0u, OD_TYPE_UINT8, OD_ACCESS_RO | OD_ACCESS_CONST, 1u, 8u, 0x0u, 0xFFu, 0xDu, NULL },
+    { 0x2623u,  1u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u,  2u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u,  3u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u,  4u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u,  5u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u,  6u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u,  7u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u,  8u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u,  9u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u, 10u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u, 11u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u, 12u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2623u, 13u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 8u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u,  0u, OD_TYPE_UINT8, OD_ACCESS_RO | OD_ACCESS_CONST, 1u, 9u, 0x0u, 0xFFu, 0xDu, NULL },
+    { 0x2624u,  1u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u,  2u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u,  3u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u,  4u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u,  5u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u,  6u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u,  7u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u,  8u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u,  9u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u, 10u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u, 11u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u, 12u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL },
+    { 0x2624u, 13u, OD_TYPE_UINT32, OD_ACCESS_RO, 4u, 9u, 0x0u, 0xFFFFFFFFu, 0u, NULL }
+};
+
+/* Table slot of the communication profile objects */
+const OD_CommSlot od_comm_slot[OD_COMM_COUNT] =
+{
+    { 0x1010u, 0x00u },
+    { 0x1011u, 0x02u }
+};
+
+/* Objects kept by the parameter store, in record order */
+const OD_Persist od_persist[OD_PERSIST_COUNT] =
+{
+    { 0x2600u, 1u },
+    { 0x2601u, 1u },
+    { 0x2610u, 4u }
+};
+
+/* Table slot of subindex 0 of each index from OD_INDEX_FIRST */
+const uint8 od_slot[OD_INDEX_LAST - OD_INDEX_FIRST + 1u] =
+{
+    0x04u, 0x05u, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu,
+    0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu,
+    0x06u, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu,
+    0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu, 0xFFu,
+    0x07u, 0x08u, 0x16u, 0x24u, 0x32u
+};
+
+/* [] END OF FILE */
@@ -0,0 +1,174 @@
+/*******************************************************************************
+* FILE: pfail.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Power-fail snapshot writer, see pfail.h.  The LVD interrupt runs at the
+* highest priority, so the SCBM interrupt and the main loop are held off
+* while it owns the block.
+*******************************************************************************/
+#include "ee24.h"
+#include "modlog.h"
+#include "pfail.h"
+#include "pstore.h"
+#include "timer.h"
+
+/* Start, device address, EEPROM address, the snapshot and stop */
+#define PFAIL_BUS_US            ((((PSTORE_SNAP_SIZE + 4u) * 9u * 1000000u) / PFAIL_I2C_HZ) + 1u)
+#define PFAIL_WORST_US          (PFAIL_ENTRY_US + PFAIL_BUS_US + EE24_WRITE_CYCLE_US)
+
+#if (PFAIL_WORST_US > PFAIL_HOLDUP_US)
+    #error "the power-fail snapshot does not fit into the supply hold-up"
+#endif
+
+/* SysTick does not count while this interrupt holds the CPU, so the time
+   is kept by counting: an ACK poll is a start, the device address and a
+   stop, then a CyDelayUs() pause; the slack of the hold-up buys that many */
+#define PFAIL_POLL_US           (50u)
+#define PFAIL_POLL_STEP_US      (PFAIL_POLL_US + ((11u * 1000000u) / PFAIL_I2C_HZ) + 1u)
+#define PFAIL_POLLS             ((PFAIL_HOLDUP_US - PFAIL_WORST_US) / PFAIL_POLL_STEP_US)
+
+static uint8 pfail_page[2u + PSTORE_SNAP_SIZE];
+static SysTick_Timer pfail_rearm;
+static volatile uint8 pfail_tripped;    /* re-arm timer still to start */
+static PFAIL_Stats pfail_stats;
+
+/*** Sends the page, ACK polling a busy device at most PFAIL_POLLS times ***/
+static uint8 PFAIL_WritePage(uint8 size, uint16* polls)
+{
+    uint32 rc;
+    uint8 i;
+
+    *polls = 0u;
+    while ((rc = SCBM_I2CMasterSendStart(EE24_I2C_ADDR, SCBM_I2C_WRITE_XFER_MODE)) != SCBM_I2C_MSTR_NO_ERROR)
+    {
+        (void)SCBM_I2CMasterSendStop();
+        if (*polls >= PFAIL_POLLS)
+        {
+            pfail_stats.late++;
+            return (0u);
+        }
+        (*polls)++;
+        CyDelayUs(PFAIL_POLL_US);
+    }
+    for (i = 0u; i < size; i++)
+    {
+        rc = SCBM_I2CMasterWriteByte(pfail_page[i]);
+        if (rc != SCBM_I2C_MSTR_NO_ERROR)
+        {
+            break;
+        }
+    }
+    (void)SCBM_I2CMasterSendStop();
+    if (rc != SCBM_I2C_MSTR_NO_ERROR)
+    {
+        pfail_stats.errors++;
+        return (0u);
+    }
+    return (1u);
+}
+
+/*******************************************************************************
+ * LVD interrupt.  One shot: the detector stays off until PFAIL_REARM_MS
+ * after it, so a slowly falling supply does not retrigger it.
+ *******************************************************************************/
+static CY_ISR(PFAIL_Isr)
+{
+    uint32 us;
+    uint16 polls;
+    uint8 size;
+
+    CySysLvdClearInterrupt();
+    CySysLvdDisable();
+    pfail_stats.events++;
+    pfail_tripped = 1u;
+
+    size = PSTORE_Snapshot(&pfail_page[2]);
+    if (size == 0u)
+    {
+        pfail_stats.unchanged++;
+        return;
+    }
+    pfail_page[0] = (uint8)(PSTORE_SNAP_BASE >> 8);
+    pfail_page[1] = (uint8)PSTORE_SNAP_BASE;
+
+    /* Whatever i2cq had on the bus is abandoned */
+    CyIntDisable(SCBM_ISR_NUMBER);
+    SCBM_Stop();
+    SCBM_Start();
+    CyIntDisable(SCBM_ISR_NUMBER);
+    if (PFAIL_WritePage((uint8)(size + 2u), &polls))
+    {
+        pfail_stats.written++;
+        /* Estimated the same way: entry, the polls, then the page with its
+           device address and start/stop */
+        us = PFAIL_ENTRY_US + (uint32)polls * PFAIL_POLL_STEP_US +
+             (((uint32)size + 4u) * 9u * 1000000u) / PFAIL_I2C_HZ;
+        pfail_stats.last_us = (uint16)((us > 0xFFFFu) ? 0xFFFFu : us);
+        if (pfail_stats.last_us > pfail_stats.max_us)
+        {
+            pfail_stats.max_us = pfail_stats.last_us;
+        }
+    }
+    CyIntEnable(SCBM_ISR_NUMBER);
+}
+
+static void PFAIL_Rearm(void* context)
+{
+    (void)context;
+    MLOG1(MLOG_MOD_USR, MLOG_LVL_WARN, "pfail: supply recovered, %u us\r\n", pfail_stats.last_us);
+    CySysLvdClearInterrupt();
+    CySysLvdEnable(PFAIL_LVD_THRESHOLD);
+}
+
+/*******************************************************************************
+* Function Name: PFAIL_Start
+********************************************************************************
+*
+* Summary:
+*  Installs the LVD interrupt at the highest priority and enables the
+*  detector.  Call it after PSTORE_Start(); until the log is loaded a trip
+*  writes nothing.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void PFAIL_Start(void)
+{
+    SysTick_TimerInit(&pfail_rearm, PFAIL_Rearm, NULL);
+    (void)CyIntSetVector(PFAIL_IRQ_NUMBER, PFAIL_Isr);
+    CyIntSetPriority(PFAIL_IRQ_NUMBER, 0u);
+    CySysLvdClearInterrupt();
+    CySysLvdEnable(PFAIL_LVD_THRESHOLD);
+    CyIntEnable(PFAIL_IRQ_NUMBER);
+}
+
+/*******************************************************************************
+ * Starts the re-arm delay after a trip; timers are armed from the main loop.
+ *******************************************************************************/
+void PFAIL_Service(void)
+{
+    if (pfail_tripped)
+    {
+        pfail_tripped = 0u;
+        SysTick_TimerArm(&pfail_rearm, PFAIL_REARM_MS, 0u);
+    }
+}
+
+void PFAIL_GetStats(PFAIL_Stats* stats)
+{
+    *stats = pfail_stats;
+}
+
+/* [] END OF FILE */
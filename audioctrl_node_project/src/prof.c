@@ -0,0 +1,192 @@
+/*******************************************************************************
+* FILE: prof.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Cycle profiler, see prof.h.  The CAN interrupt belongs to the CANopen
+* driver, so it is measured by moving its vector behind a wrapper once the
+* stack has installed it.
+*******************************************************************************/
+#include "target.h"
+#include "prof.h"
+
+#if (PROF_ENABLE)
+
+typedef struct
+{
+    uint32 calls;
+    uint64 total;
+    uint32 min;
+    uint32 max;
+    uint32 hist[PROF_HIST_BINS];
+} PROF_Site;
+
+static PROF_Site prof_site[PROF_SITE_LAST];
+static uint32 prof_overhead;                /* cycles of an empty ENTER/EXIT */
+static cyisraddress prof_can_vector;
+
+static CY_ISR(PROF_CanIsr)
+{
+    PROF_ENTER(PROF_SITE_CAN_ISR);
+    prof_can_vector();
+    PROF_EXIT(PROF_SITE_CAN_ISR);
+}
+
+/*******************************************************************************
+* Function Name: PROF_Start
+********************************************************************************
+*
+* Summary:
+*  Measures the cost of the markers, clears the statistics and hooks the CAN
+*  interrupt.  Call it after the CANopen stack has started.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void PROF_Start(void)
+{
+    uint32 t0;
+    uint8 intr;
+
+    intr = CyEnterCriticalSection();
+    t0 = SysTick_GetCycles();
+    prof_overhead = SysTick_GetCycles() - t0;
+    CyExitCriticalSection(intr);
+    PROF_Reset();
+
+    if (CyIntGetVector(CAN_ISR_NUMBER) != PROF_CanIsr)
+    {
+        prof_can_vector = CyIntSetVector(CAN_ISR_NUMBER, PROF_CanIsr);
+    }
+}
+
+/*******************************************************************************
+* Function Name: PROF_Record
+********************************************************************************
+*
+* Summary:
+*  Adds one measurement to a site.  Reached through PROF_EXIT(); safe from
+*  interrupts.
+*
+* Parameters:
+*  site: PROF_SITE_xxx
+*  cycles: raw cycles between the markers
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void PROF_Record(uint8 site, uint32 cycles)
+{
+    PROF_Site* p = &prof_site[site];
+    uint32 limit = 64u;
+    uint8 bin = 0u;
+    uint8 intr;
+
+    cycles = (cycles > prof_overhead) ? (cycles - prof_overhead) : 0u;
+    while ((cycles >= limit) && (bin < (PROF_HIST_BINS - 1u)))
+    {
+        limit <<= 2;
+        ++bin;
+    }
+
+    intr = CyEnterCriticalSection();
+    ++p->calls;
+    p->total += cycles;
+    if (cycles < p->min)
+    {
+        p->min = cycles;
+    }
+    if (cycles > p->max)
+    {
+        p->max = cycles;
+    }
+    ++p->hist[bin];
+    CyExitCriticalSection(intr);
+}
+
+/* Clears the statistics of every site */
+void PROF_Reset(void)
+{
+    uint8 intr = CyEnterCriticalSection();
+    uint8 i;
+
+    memset(prof_site, 0, sizeof(prof_site));
+    for (i = 0u; i < PROF_SITE_LAST; i++)
+    {
+        prof_site[i].min = 0xFFFFFFFFu;
+    }
+    CyExitCriticalSection(intr);
+}
+
+/*******************************************************************************
+* Function Name: PROF_Read
+********************************************************************************
+*
+* Summary:
+*  Returns one entry of a site's record.  Subindex 0 is the number of
+*  entries, as for any OD record; min reads 0 until the site has run.
+*
+* Parameters:
+*  site: PROF_SITE_xxx
+*  subindex: 0..PROF_SUB_LAST
+*  value: receives the entry
+*
+* Return:
+*  1 if site and subindex exist, otherwise 0
+*
+*******************************************************************************/
+uint8 PROF_Read(uint8 site, uint8 subindex, uint32* value)
+{
+    const PROF_Site* p;
+    uint8 intr;
+
+    if ((site >= PROF_SITE_LAST) || (subindex > PROF_SUB_LAST))
+    {
+        return (0u);
+    }
+
+    p = &prof_site[site];
+    intr = CyEnterCriticalSection();
+    switch (subindex)
+    {
+        case 0u:
+            *value = PROF_SUB_LAST;
+            break;
+        case PROF_SUB_CALLS:
+            *value = p->calls;
+            break;
+        case PROF_SUB_TOTAL_LO:
+            *value = (uint32)p->total;
+            break;
+        case PROF_SUB_TOTAL_HI:
+            *value = (uint32)(p->total >> 32);
+            break;
+        case PROF_SUB_MIN:
+            *value = (p->calls != 0u) ? p->min : 0u;
+            break;
+        case PROF_SUB_MAX:
+            *value = p->max;
+            break;
+        default:
+            *value = p->hist[subindex - PROF_SUB_HIST];
+            break;
+    }
+    CyExitCriticalSection(intr);
+    return (1u);
+}
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,497 @@
+/*******************************************************************************
+* FILE: pstore.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Persistent parameter log, see pstore.h.  A record is
+*
+*       0       PSTORE_MAGIC
+*       1       OD_PERSIST_LAYOUT of the values, 0 for a restore record
+*       2..5    sequence number, little endian
+*       6..13   od_persist[] values in table order, little endian, 0xFF pad
+*       14..15  CRC-16/CCITT of bytes 0..13, little endian
+*
+*     A record written by a firmware with another persistent set has another
+*     layout and is taken as no record, so the defaults apply.  A snapshot is
+*
+*       0       PSTORE_SNAP_MAGIC
+*       1       OD_PERSIST_LAYOUT
+*       2..5    sequence number of the record it is based on
+*       6       mask of the od_persist[] values that follow
+*       7..     those values, little endian
+*       then    CRC-16/CCITT of all bytes before it
+*
+*     The page is 0xFF when there is no snapshot.
+*******************************************************************************/
+#include <string.h>
+#include "ee24.h"
+#include "modlog.h"
+#include "od.h"
+#include "od_table.h"
+#include "pstore.h"
+
+#if (OD_PERSIST_SIZE > PSTORE_PAYLOAD_MAX) || (OD_PERSIST_COUNT > 8u)
+    #error "persistent objects do not fit into a pstore record"
+#endif
+
+#define PSTORE_MAGIC            (0xA5u)
+#define PSTORE_SNAP_MAGIC       (0x5Au)
+#define PSTORE_SNAP_HEADER      (7u)
+#define PSTORE_SLOTS            (PSTORE_LOG_SIZE / PSTORE_RECORD_SIZE)
+#define PSTORE_CRC_OFFSET       (PSTORE_RECORD_SIZE - 2u)
+#define PSTORE_PAYLOAD_OFFSET   (6u)
+
+#define PSTORE_REQ_NONE         (0u)
+#define PSTORE_REQ_SAVE         (1u)
+#define PSTORE_REQ_RESTORE      (2u)
+
+#define PSTORE_WR_NONE          (0u)
+#define PSTORE_WR_RECORD        (1u)
+#define PSTORE_WR_CLEAR         (2u)
+
+static uint8 pstore_status = PSTORE_FAILED;
+static uint8 pstore_request;
+static uint8 pstore_writing;            /* PSTORE_WR_xxx in flight */
+static uint8 pstore_defaults;           /* restore requested, no snapshot */
+static uint8 pstore_snap_clear;         /* snapshot page to blank */
+static uint8 pstore_slot;               /* slot of the next record */
+static uint8 pstore_cached;             /* pstore_cache holds the stored values */
+static uint8 pstore_cache[PSTORE_PAYLOAD_MAX];
+static uint8 pstore_record[PSTORE_RECORD_SIZE];
+static uint8 pstore_log[PSTORE_LOG_SIZE + PSTORE_SNAP_SIZE];   /* boot read */
+static PSTORE_Stats pstore_stats;
+
+/*** CRC-16/CCITT, polynomial 0x1021, initial value 0xFFFF ***/
+static uint16 PSTORE_Crc(const uint8* data, uint8 size)
+{
+    uint16 crc = 0xFFFFu;
+    uint8 bit;
+
+    while (size-- != 0u)
+    {
+        crc ^= (uint16)((uint16)*data++ << 8);
+        for (bit = 0u; bit < 8u; bit++)
+        {
+            crc = ((crc & 0x8000u) != 0u) ? (uint16)((crc << 1) ^ 0x1021u) : (uint16)(crc << 1);
+        }
+    }
+    return (crc);
+}
+
+static void PSTORE_PutCrc(uint8* data, uint8 size)
+{
+    uint16 crc = PSTORE_Crc(data, size);
+
+    data[size] = (uint8)crc;
+    data[size + 1u] = (uint8)(crc >> 8);
+}
+
+static uint8 PSTORE_CrcOk(const uint8* data, uint8 size)
+{
+    uint16 crc = (uint16)data[size] | (uint16)((uint16)data[size + 1u] << 8);
+
+    return ((PSTORE_Crc(data, size) == crc) ? 1u : 0u);
+}
+
+static uint32 PSTORE_Seq(const uint8* record)
+{
+    return ((uint32)record[2] | ((uint32)record[3] << 8) |
+            ((uint32)record[4] << 16) | ((uint32)record[5] << 24));
+}
+
+static uint8 PSTORE_IsValid(const uint8* record)
+{
+    return ((record[0] == PSTORE_MAGIC) && PSTORE_CrcOk(record, PSTORE_CRC_OFFSET)) ? 1u : 0u;
+}
+
+/*** Length of a valid snapshot without its CRC, 0 if there is none ***/
+static uint8 PSTORE_SnapLength(const uint8* snap)
+{
+    uint8 size = PSTORE_SNAP_HEADER;
+    uint8 i;
+
+    if ((snap[0] != PSTORE_SNAP_MAGIC) || (snap[1] != OD_PERSIST_LAYOUT) ||
+        (snap[6] == 0u) || ((snap[6] >> OD_PERSIST_COUNT) != 0u))
+    {
+        return (0u);
+    }
+    for (i = 0u; i < OD_PERSIST_COUNT; i++)
+    {
+        if ((snap[6] & (1u << i)) != 0u)
+        {
+            size += od_persist[i].size;
+        }
+    }
+    return (PSTORE_CrcOk(snap, size) ? size : 0u);
+}
+
+/*** Values of a snapshot over a payload ***/
+static void PSTORE_Merge(uint8* payload, const uint8* snap)
+{
+    const uint8* value = &snap[PSTORE_SNAP_HEADER];
+    uint8 i;
+
+    for (i = 0u; i < OD_PERSIST_COUNT; i++)
+    {
+        if ((snap[6] & (1u << i)) != 0u)
+        {
+            memcpy(payload, value, od_persist[i].size);
+            value += od_persist[i].size;
+        }
+        payload += od_persist[i].size;
+    }
+}
+
+/*** Current values of the persistent objects, in record order ***/
+static void PSTORE_Collect(uint8* payload)
+{
+    uint32 value;
+    uint8 i;
+    uint8 b;
+
+    memset(payload, 0xFF, PSTORE_PAYLOAD_MAX);
+    for (i = 0u; i < OD_PERSIST_COUNT; i++)
+    {
+        value = 0u;
+        (void)OD_Read(od_persist[i].index, 0u, &value);
+        for (b = 0u; b < od_persist[i].size; b++)
+        {
+            *payload++ = (uint8)(value >> (8u * b));
+        }
+    }
+}
+
+/*** Writes stored values to the objects; a value out of range keeps the default ***/
+static void PSTORE_Apply(const uint8* payload)
+{
+    uint32 value;
+    uint8 i;
+    uint8 b;
+
+    for (i = 0u; i < OD_PERSIST_COUNT; i++)
+    {
+        value = 0u;
+        for (b = 0u; b < od_persist[i].size; b++)
+        {
+            value |= (uint32)*payload++ << (8u * b);
+        }
+        if (OD_Write(od_persist[i].index, 0u, value) != OD_OK)
+        {
+            MLOG2(MLOG_MOD_USR, MLOG_LVL_WARN, "pstore 0x%04x: %lu rejected\r\n", od_persist[i].index, (unsigned long)value);
+        }
+    }
+}
+
+/*******************************************************************************
+ * Boot read done: picks the newest valid record, merges a power-fail
+ * snapshot into it and restores the result.
+ *******************************************************************************/
+static void PSTORE_LoadDone(void* context, uint8 result)
+{
+    const uint8* newest = NULL;
+    const uint8* record;
+    const uint8* snap = &pstore_log[PSTORE_LOG_SIZE];
+    uint8 payload[PSTORE_PAYLOAD_MAX];
+    uint8 slot;
+
+    (void)context;
+    if (result != EE24_OK)
+    {
+        pstore_status = PSTORE_FAILED;
+        MLOG1(MLOG_MOD_USR, MLOG_LVL_ERROR, "pstore: log read failed %u\r\n", result);
+        return;
+    }
+    pstore_slot = 0u;
+    for (slot = 0u; slot < PSTORE_SLOTS; slot++)
+    {
+        record = &pstore_log[slot * PSTORE_RECORD_SIZE];
+        if (PSTORE_IsValid(record))
+        {
+            pstore_stats.valid++;
+            if ((newest == NULL) || ((int32)(PSTORE_Seq(record) - PSTORE_Seq(newest)) > 0))
+            {
+                newest = record;
+                pstore_slot = (uint8)((slot + 1u) % PSTORE_SLOTS);
+            }
+        }
+    }
+
+    pstore_status = PSTORE_EMPTY;
+    if (newest != NULL)
+    {
+        pstore_stats.seq = PSTORE_Seq(newest);
+        if (newest[1] == OD_PERSIST_LAYOUT)
+        {
+            memcpy(pstore_cache, &newest[PSTORE_PAYLOAD_OFFSET], PSTORE_PAYLOAD_MAX);
+            pstore_cached = 1u;
+            pstore_status = PSTORE_RESTORED;
+        }
+    }
+
+    /* A snapshot older than the newest record was taken before a store
+     * that was already in the log; one based on a torn record is newer */
+    if ((PSTORE_SnapLength(snap) != 0u) && ((int32)(PSTORE_Seq(snap) - pstore_stats.seq) >= 0))
+    {
+        if (pstore_cached)
+        {
+            memcpy(payload, pstore_cache, PSTORE_PAYLOAD_MAX);
+        }
+        else
+        {
+            PSTORE_Collect(payload);
+        }
+        PSTORE_Merge(payload, snap);
+        PSTORE_Apply(payload);
+        pstore_status = PSTORE_RESTORED;
+        pstore_stats.merged = 1u;
+        pstore_request = PSTORE_REQ_SAVE;
+    }
+    else if (pstore_cached)
+    {
+        PSTORE_Apply(pstore_cache);
+    }
+    pstore_snap_clear = (snap[0] != 0xFFu) ? 1u : 0u;
+    MLOG4(MLOG_MOD_USR, MLOG_LVL_INFO, "pstore: %u valid, seq %lu, status %u, snapshot %u\r\n",
+          pstore_stats.valid, (unsigned long)pstore_stats.seq, pstore_status, pstore_stats.merged);
+}
+
+static void PSTORE_ClearDone(void* context, uint8 result)
+{
+    (void)context;
+    pstore_writing = PSTORE_WR_NONE;
+    pstore_snap_clear = 0u;
+    if (result != EE24_OK)
+    {
+        pstore_stats.errors++;
+    }
+}
+
+static void PSTORE_WriteDone(void* context, uint8 result)
+{
+    (void)context;
+    pstore_writing = PSTORE_WR_NONE;
+    /* The slot is used up either way, a torn record fails its CRC */
+    pstore_slot = (uint8)((pstore_slot + 1u) % PSTORE_SLOTS);
+    pstore_stats.seq = PSTORE_Seq(pstore_record);
+    if (result != EE24_OK)
+    {
+        pstore_stats.errors++;
+        pstore_cached = 0u;
+        MLOG1(MLOG_MOD_USR, MLOG_LVL_ERROR, "pstore: write failed %u\r\n", result);
+        return;
+    }
+    pstore_stats.stores++;
+    if (pstore_record[1] != 0u)
+    {
+        memcpy(pstore_cache, &pstore_record[PSTORE_PAYLOAD_OFFSET], PSTORE_PAYLOAD_MAX);
+        pstore_cached = 1u;
+    }
+    else
+    {
+        pstore_cached = 0u;
+    }
+}
+
+/*******************************************************************************
+* Function Name: PSTORE_Start
+********************************************************************************
+*
+* Summary:
+*  Queues the read of the whole log.  The stored values are applied from
+*  the main loop once it is done, PSTORE_Status() leaves PSTORE_LOADING
+*  then.  Call it after I2CQ_Start() and the modules that apply the
+*  persistent objects.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void PSTORE_Start(void)
+{
+    memset(&pstore_stats, 0, sizeof(pstore_stats));
+    pstore_request = PSTORE_REQ_NONE;
+    pstore_writing = PSTORE_WR_NONE;
+    pstore_defaults = 0u;
+    pstore_snap_clear = 0u;
+    pstore_cached = 0u;
+    pstore_status = PSTORE_LOADING;
+    if (EE24_Read(PSTORE_BASE, pstore_log, sizeof(pstore_log), PSTORE_LoadDone, NULL) != EE24_OK)
+    {
+        pstore_status = PSTORE_FAILED;
+    }
+}
+
+/*******************************************************************************
+* Function Name: PSTORE_Service
+********************************************************************************
+*
+* Summary:
+*  Writes the pending save or restore record when the log is loaded and the
+*  EEPROM is idle.  A save of the values already stored is dropped.  Once
+*  the records are written, blanks a snapshot merged at boot.  Call it from
+*  the main loop.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void PSTORE_Service(void)
+{
+    uint8 layout;
+    uint32 seq;
+
+    if ((pstore_writing != PSTORE_WR_NONE) || (pstore_status == PSTORE_LOADING) ||
+        (pstore_status == PSTORE_FAILED) || EE24_Busy())
+    {
+        return;
+    }
+    if (pstore_request == PSTORE_REQ_NONE)
+    {
+        if (pstore_snap_clear)
+        {
+            memset(pstore_log, 0xFF, PSTORE_SNAP_SIZE);
+            if (EE24_Write(PSTORE_SNAP_BASE, pstore_log, PSTORE_SNAP_SIZE, PSTORE_ClearDone, NULL) == EE24_OK)
+            {
+                pstore_writing = PSTORE_WR_CLEAR;
+            }
+        }
+        return;
+    }
+
+    if (pstore_request == PSTORE_REQ_SAVE)
+    {
+        layout = OD_PERSIST_LAYOUT;
+        PSTORE_Collect(&pstore_record[PSTORE_PAYLOAD_OFFSET]);
+        if (pstore_cached && (memcmp(pstore_cache, &pstore_record[PSTORE_PAYLOAD_OFFSET], PSTORE_PAYLOAD_MAX) == 0))
+        {
+            pstore_request = PSTORE_REQ_NONE;
+            pstore_stats.unchanged++;
+            return;
+        }
+    }
+    else
+    {
+        layout = 0u;
+        memset(&pstore_record[PSTORE_PAYLOAD_OFFSET], 0xFF, PSTORE_PAYLOAD_MAX);
+    }
+
+    seq = pstore_stats.seq + 1u;
+    pstore_record[0] = PSTORE_MAGIC;
+    pstore_record[1] = layout;
+    pstore_record[2] = (uint8)seq;
+    pstore_record[3] = (uint8)(seq >> 8);
+    pstore_record[4] = (uint8)(seq >> 16);
+    pstore_record[5] = (uint8)(seq >> 24);
+    PSTORE_PutCrc(pstore_record, PSTORE_CRC_OFFSET);
+
+    if (EE24_Write((uint16)(PSTORE_BASE + pstore_slot * PSTORE_RECORD_SIZE), pstore_record,
+                   PSTORE_RECORD_SIZE, PSTORE_WriteDone, NULL) == EE24_OK)
+    {
+        pstore_request = PSTORE_REQ_NONE;
+        pstore_writing = PSTORE_WR_RECORD;
+    }
+}
+
+/*******************************************************************************
+ * Requests a store of the current values (0x1010).  The values are taken
+ * when the record is written, so later changes until then are included.
+ *******************************************************************************/
+void PSTORE_Save(void)
+{
+    pstore_request = PSTORE_REQ_SAVE;
+    pstore_defaults = 0u;
+}
+
+/*******************************************************************************
+ * Requests the defaults from the next reset on (0x1011).  The objects keep
+ * their values until then.
+ *******************************************************************************/
+void PSTORE_Restore(void)
+{
+    pstore_request = PSTORE_REQ_RESTORE;
+    pstore_defaults = 1u;
+}
+
+uint8 PSTORE_Status(void)
+{
+    return (pstore_status);
+}
+
+/*******************************************************************************
+* Function Name: PSTORE_Snapshot
+********************************************************************************
+*
+* Summary:
+*  Serializes the persistent values that differ from the stored record.
+*  While a record is being written, or none is cached, every value is taken
+*  and the snapshot is based on the record in flight, which may be torn.
+*  Nothing is taken before the log is loaded or after a restore request.
+*  Only reads state, so it is safe from the power-fail interrupt.
+*
+* Parameters:
+*  snapshot: PSTORE_SNAP_SIZE bytes
+*
+* Return:
+*  Bytes to write at PSTORE_SNAP_BASE, 0 if there is nothing to keep
+*
+*******************************************************************************/
+uint8 PSTORE_Snapshot(uint8* snapshot)
+{
+    uint8 current[PSTORE_PAYLOAD_MAX];
+    uint8 in_flight = (pstore_writing == PSTORE_WR_RECORD) ? 1u : 0u;
+    uint8 full = (in_flight || !pstore_cached) ? 1u : 0u;
+    uint8 size = PSTORE_SNAP_HEADER;
+    uint8 offset = 0u;
+    uint8 mask = 0u;
+    uint32 seq = pstore_stats.seq + in_flight;
+    uint8 i;
+
+    if (((pstore_status != PSTORE_EMPTY) && (pstore_status != PSTORE_RESTORED)) || pstore_defaults)
+    {
+        return (0u);
+    }
+    PSTORE_Collect(current);
+    for (i = 0u; i < OD_PERSIST_COUNT; i++)
+    {
+        if (full || (memcmp(&current[offset], &pstore_cache[offset], od_persist[i].size) != 0))
+        {
+            mask |= (uint8)(1u << i);
+            memcpy(&snapshot[size], &current[offset], od_persist[i].size);
+            size += od_persist[i].size;
+        }
+        offset += od_persist[i].size;
+    }
+    if (mask == 0u)
+    {
+        return (0u);
+    }
+    snapshot[0] = PSTORE_SNAP_MAGIC;
+    snapshot[1] = OD_PERSIST_LAYOUT;
+    snapshot[2] = (uint8)seq;
+    snapshot[3] = (uint8)(seq >> 8);
+    snapshot[4] = (uint8)(seq >> 16);
+    snapshot[5] = (uint8)(seq >> 24);
+    snapshot[6] = mask;
+    PSTORE_PutCrc(snapshot, size);
+    return (size + 2u);
+}
+
+void PSTORE_GetStats(PSTORE_Stats* stats)
+{
+    *stats = pstore_stats;
+}
+
+/* [] END OF FILE */
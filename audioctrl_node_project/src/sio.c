@@ -13,9 +13,21 @@
 *     This is the public interface to routines known collectively as the serial
 * input output subsystem.  These routines are essentially wrappers for UART
 * communications that utilize the serial debug port.
+*
+*     Transmission never waits on the UART.  Output is queued in sio_tx_buffer
+* and moved into the SCB FIFO by the SIOU TX interrupt, see sio_tx.h.
+*
+*     Received bytes are assembled into a command line by the same interrupt
+* as they arrive: letters are upper cased, runs of blanks become one space,
+* BS/DEL edit the line and CR, LF, ETX, EOT or '#' end it.  The finished line
+* is handed to SIO_Service() in the main loop, see sio_cmd.h.
 *******************************************************************************/
 #include "target.h"
+#include "fmt.h"
 #include "sio.h"
+#include "sio_cmd.h"
+#include "sio_tx.h"
+#include "timer.h"
 
 // Size of the circular receive buffer, must be power of 2
 #ifndef SIO_RX_BUFFER_SIZE
@@ -23,151 +35,283 @@
 #endif
 
 //#define SIO_DEBUG_LED
-// Size of the circular transmit buffer, must be power of 2
+// Size of the circular transmit buffer, must be power of 2 and at most 256
 #ifndef SIO_TX_BUFFER_SIZE
-	#define SIO_TX_BUFFER_SIZE 128
+	#define SIO_TX_BUFFER_SIZE 256
 #endif
 
 #define SIO_RX_BUFFER_MASK (SIO_RX_BUFFER_SIZE - 1)
 #define SIO_TX_BUFFER_MASK (SIO_TX_BUFFER_SIZE - 1)
 
-uint8 sio_rx_buffer[SIO_RX_BUFFER_SIZE];
-uint8 sio_rx_head = 0;	// Index of oldest element
-uint8 sio_rx_tail = 0;	// Index at which to write new element
-uint8 sio_rx_error = 0;	// 
+uint8 sio_rx_buffer[SIO_RX_BUFFER_SIZE];	// Last complete line, NUL terminated
+uint8 sio_rx_head = 0;	// Unused, kept for the old polled interface
+uint8 sio_rx_tail = 0;	// Length of the line in sio_rx_buffer
+uint8 sio_rx_error = 0;	// Lines lost since the last SIO_Clear()
+
+static char sio_line[SIO_RX_BUFFER_SIZE];	// Line being assembled
+static uint8 sio_line_len;
+static uint8 sio_line_overflow;
+static volatile uint8 sio_rx_ready;
+static SIO_RxStats sio_rx_stats;
 
 char sio_tx_buffer[SIO_TX_BUFFER_SIZE];
-uint8 sio_tx_head;	// Index of oldest element
-uint8 sio_tx_tail;	// Index at which to write new element
-uint8 sio_tx_error;	// 
+volatile uint8 sio_tx_head;	// Index of oldest element, advanced by the TX interrupt
+volatile uint8 sio_tx_tail;	// Index at which to write new element
+uint8 sio_tx_error;	// Set when a message has been dropped since the last SIO_Clear()
+
+static uint8 sio_tx_policy = SIO_TX_POLICY;
+static SIO_TxStats sio_tx_stats;
+
+#define SIO_TX_USED()   ((uint16)((sio_tx_tail - sio_tx_head) & SIO_TX_BUFFER_MASK))
+#define SIO_TX_FREE()   ((uint16)(SIO_TX_BUFFER_MASK - SIO_TX_USED()))
 
 /*******************************************************************************
- * Helper function to transmit bad command string.
+ * Moves queued bytes into the SCB FIFO until either runs out.  Called from the
+ * TX interrupt, or with interrupts disabled from the writers.  The interrupt
+ * is left enabled only while there is something queued.
  *******************************************************************************/
-void SIO_BadCommand(void)
+static void SIO_TxPump(void)
 {
-    UART_PUT_STRING("BAD COMMAND\r\n");
-    SIO_Clear();  
+    while ( (sio_tx_head != sio_tx_tail) && (SIOU_SpiUartGetTxBufferSize() < SIOU_FIFO_SIZE) )
+    {
+        SIOU_SpiUartWriteTxData((uint8)sio_tx_buffer[sio_tx_head]);
+        sio_tx_head = (sio_tx_head + 1u) & SIO_TX_BUFFER_MASK;
+        sio_tx_stats.bytes++;
+    }
+
+#ifdef SIOU_ISR_NUMBER
+    SIOU_ClearTxInterruptSource(SIOU_INTR_TX_EMPTY);
+    SIOU_SetTxInterruptMode((sio_tx_head != sio_tx_tail) ? SIOU_INTR_TX_EMPTY : 0u);
+#endif
 }
 
 /*******************************************************************************
- * Transfers contents of UART to RX buffer.
+ * Publishes the assembled line.  A line that arrives before the previous one
+ * has been consumed, or that overflowed the buffer, is counted and dropped.
  *******************************************************************************/
-uint8 SIO_CheckHost (void)
+static void SIO_RxEndLine(void)
+{
+    if ( (sio_line_len > 0) && (sio_line[sio_line_len - 1] == ' ') )
+    {
+        sio_line_len--;
+    }
+
+    if ( sio_line_overflow != 0 )
+    {
+        sio_rx_stats.too_long++;
+        sio_rx_error++;
+    }
+    else if ( sio_line_len == 0 )
+    {
+        /* Empty line, or the LF of a CR LF pair */
+    }
+    else if ( sio_rx_ready != 0 )
+    {
+        sio_rx_stats.overruns++;
+        sio_rx_error++;
+    }
+    else
+    {
+        memcpy(sio_rx_buffer, sio_line, sio_line_len);
+        sio_rx_buffer[sio_line_len] = 0;
+        sio_rx_tail = sio_line_len;
+        sio_rx_stats.lines++;
+        sio_rx_ready = 1;
+        SysTick_Wake();
+    }
+
+    sio_line_len = 0;
+    sio_line_overflow = 0;
+}
+
+/*******************************************************************************
+ * Line assembler, takes one received byte.  Constant time per byte.
+ *******************************************************************************/
+static void SIO_RxByte(char c)
 {
-    uint8 count = SIO_GetRxBufferSize();
-    uint8 i;    
-    
-    if (count > 0)
-    {        
-        for (i=0; i < count; i++)
+    char out = 0;
+
+    if ( (c == '#') || (c == ETX) || (c == EOT) || (c == LF) || (c == CR) )
+    {
+        SIO_RxEndLine();
+    }
+    else if ( (c == BS) || (c == DEL) )
+    {
+        if ( sio_line_len > 0 )
         {
-            sio_rx_buffer[sio_rx_tail++] = SIO_ReadRxData();
+            sio_line_len--;
         }
-        
-        SIO_ClearRxBuffer();
+    }
+    else if ( (c == SPACE) || (c == '\t') || (c == ',') )
+    {
+        if ( (sio_line_len > 0) && (sio_line[sio_line_len - 1] != ' ') )
+        {
+            out = ' ';
+        }
+    }
+    else if ( (c > SPACE) && (c < DEL) )
+    {
+        out = ((c >= 'a') && (c <= 'z')) ? (char)(c & 0xDF) : c;
     }
 
-	return(sio_rx_tail);
+    if ( out != 0 )
+    {
+        if ( sio_line_len < (SIO_RX_BUFFER_SIZE - 1) )
+        {
+            sio_line[sio_line_len++] = out;
+        }
+        else
+        {
+            sio_line_overflow = 1;
+        }
+    }
 }
 
 /*******************************************************************************
- * Checks contents of RX buffer for end-of-command character.
+ * Empties the SCB RX FIFO into the line assembler.
  *******************************************************************************/
-uint8 SIO_CheckReady(void)
-{    
-    if ( strchr((char*)sio_rx_buffer, CR) != NULL )
+static void SIO_RxPump(void)
+{
+    while ( SIO_GetRxBufferSize() != 0 )
     {
-        return (1u);
+        SIO_RxByte((char)SIO_ReadRxData());
     }
-    
-    if ( strchr((char*)sio_rx_buffer, LF) != NULL )
+}
+
+#ifdef SIOU_ISR_NUMBER
+/*******************************************************************************
+ * SIOU custom interrupt handler.  RX: runs while the FIFO holds data.  TX:
+ * runs each time the hardware FIFO empties; the shifter still holds the last
+ * byte, so refilling within one character time (87 us at 115200) keeps the
+ * line busy.
+ *******************************************************************************/
+static void SIO_Interrupt(void)
+{
+    if ( (SIOU_GetRxInterruptSource() & SIOU_INTR_RX_NOT_EMPTY) != 0u )
     {
-        return (1u);
+        SIO_RxPump();
+        SIOU_ClearRxInterruptSource(SIOU_INTR_RX_NOT_EMPTY);
     }
-    
-    if ( strchr((char*)sio_rx_buffer, ETX) != NULL )
+    if ( (SIOU_GetTxInterruptSource() & SIOU_GetTxInterruptMode()) != 0u )
     {
-        return (1u);
+        SIO_TxPump();
     }
-    
-    return (0u);
 }
+#endif
 
 /*******************************************************************************
- * Remove all characters not considered valid for command language interpreter
- * particularly when manually entered using terminal emulator.
-*******************************************************************************/
-void SIO_CleanBuffer(void)
+ * Helper function to transmit bad command string.
+ *******************************************************************************/
+void SIO_BadCommand(void)
 {
-	size_t i;
-	size_t j = 0;
-	size_t k;
-	size_t length = sio_rx_tail;
-	char* buffer = (char*)sio_rx_buffer;
-	char c;
-
-#ifdef SIO_DEBUG    
-	SIO_HexDump(buffer, length);
+    SIO_PutString("BAD COMMAND\r\n");
+    SIO_Clear();  
+}
+
+/*******************************************************************************
+ * Returns the length of the completed line in sio_rx_buffer, 0 while none is
+ * waiting.  Without the SIOU interrupt this also feeds the line assembler.
+ *******************************************************************************/
+uint8 SIO_CheckHost (void)
+{
+#ifndef SIOU_ISR_NUMBER
+    SIO_RxPump();
 #endif
+	return(sio_rx_ready ? sio_rx_tail : 0);
+}
 
-	for ( i = 0; i < length; i++ )
-	{
-		if ( i == 0 )
-		{
-			j = 0;
-		}
+/*******************************************************************************
+ * Checks whether a complete line is waiting.
+ *******************************************************************************/
+uint8 SIO_CheckReady(void)
+{    
+    return (sio_rx_ready);
+}
 
-		c = buffer[i];
+/*******************************************************************************
+ * Lines are cleaned as they are assembled, nothing is left to do here.  Kept
+ * for callers of the polled interface.
+*******************************************************************************/
+void SIO_CleanBuffer(void)
+{
+#ifdef SIO_DEBUG     
+	SIO_HexDump(sio_rx_buffer, sio_rx_tail);
+#endif
+}
 
-		if ( (c == '#') || (c == ETX) || (c == EOT) || (c == LF) || (c == CR) )
-		{
-			c = 0;
-			buffer[j] = c;
-			break;
-		}
+/*******************************************************************************
+ * Hands the completed line to the command table, see sio_cmd.h.  Called from
+ * the main loop.  Without the SIOU interrupt it also moves queued output.
+ *******************************************************************************/
+void SIO_Service(void)
+{
+    char* argv[SIO_CMD_MAX_ARGS];
+    uint8 argc = 0;
+    char* p;
+    uint8 i;
 
-		if ( (c == BS) || (c == DEL) )
-		{
-			for ( k = i; k < length; k++ )
-			{
-				c = buffer[k+1];
-				buffer[k-1] = c;
-			}
-
-			buffer[k-1] = 0;
-			c = 0;
-			i = -1;
-		}
+#ifndef SIOU_ISR_NUMBER
+    SIO_TxService();
+#endif
+    if ( SIO_CheckHost() == 0 )
+    {
+        return;
+    }
 
-		if ( (c > SPACE) && (c < DEL) )
-		{
-			if ( (c >= 'a') && (c <= 'z') )
-			{
-				c &= 0xDF;
-			}
+    /* The assembler leaves single spaces between words */
+    p = (char*)sio_rx_buffer;
+    while ( (*p != 0) && (argc < SIO_CMD_MAX_ARGS) )
+    {
+        argv[argc++] = p;
+        p = strchr(p, ' ');
+        if ( p == NULL )
+        {
+            break;
+        }
+        *p++ = 0;
+    }
 
-			buffer[j++] = c;
-		}
-	}
+    for ( i = 0; i < sio_cmd_count; i++ )
+    {
+        if ( strcmp(argv[0], sio_cmd_table[i].name) == 0 )
+        {
+            if ( (argc - 1) < sio_cmd_table[i].min_args )
+            {
+                SIO_PutString("ERR ARGS\r\n");
+            }
+            else
+            {
+                sio_cmd_table[i].handler(argc, argv);
+            }
+            SIO_Clear();
+            return;
+        }
+    }
+    SIO_BadCommand();
+}
 
-    sio_rx_tail = j;
-#ifdef SIO_DEBUG     
-	SIO_HexDump(buffer, length);
-#endif
+/*******************************************************************************
+ * Copies the receive counters.
+ *******************************************************************************/
+void SIO_GetRxStats(SIO_RxStats* stats)
+{
+    uint8 intr = CyEnterCriticalSection();
+    *stats = sio_rx_stats;
+    CyExitCriticalSection(intr);
 }
 
 /*******************************************************************************
- * Resets contents and pointers to SIO buffers
+ * Releases the completed line so the next one can be taken.  Output that is
+ * already queued is left to drain.
  *******************************************************************************/
 void SIO_Clear(void)
 {
     sio_rx_tail = 0;
     sio_rx_head = 0;
-    sio_tx_head = 0;
-    sio_tx_tail = 0;   
-    memset(sio_rx_buffer, 0, sizeof(sio_rx_buffer));
-    memset(sio_tx_buffer, 0, sizeof(sio_tx_buffer));
+    sio_rx_error = 0;
+    sio_tx_error = 0;
+    sio_rx_buffer[0] = 0;
+    sio_rx_ready = 0;
 }
 
 /*******************************************************************************
@@ -201,6 +345,7 @@ uint8 SIO_GetRxBufferSize(void)
 void SIO_HexDump(uint8* buffer, size_t length)
 {
 	size_t i;
+	char hex[8];
 
 	if ( (buffer != NULL) && (length > 0) )
 	{
@@ -208,9 +353,8 @@ void SIO_HexDump(uint8* buffer, size_t length)
 
 		for ( i=0; i < length; i++ )
 		{
-			memset(sio_tx_buffer, 0, sizeof(sio_tx_buffer));       
-			sprintf(sio_tx_buffer, "%02x, ", buffer[i]);
-            UART_PUT_STRING(sio_tx_buffer);                    
+			FMT_Snprintf(hex, sizeof(hex), "%02x, ", buffer[i]);
+            SIO_PutString(hex);
 		}
 
 		SIO_SendReturn(); 
@@ -218,30 +362,185 @@ void SIO_HexDump(uint8* buffer, size_t length)
 }
 
 /*******************************************************************************
- * 
+ * Formats a "> " prompted line and queues it for transmission.  The line is
+ * built on the stack so the call is safe from interrupt context; output beyond
+ * SIO_LINE_SIZE is truncated.
  *******************************************************************************/
 int SIO_Printf(const char* format, ...)
 {
 	int ret;
 	int offset;
+	char line[SIO_LINE_SIZE];
 	va_list args;
 
 	va_start(args, format);
-	memset(sio_tx_buffer, 0, sizeof(sio_tx_buffer));
-	sio_tx_buffer[0] = '>';
-    sio_tx_buffer[1] = ' ';
-	ret = vsprintf((char*)&sio_tx_buffer[2], format, args);
+	line[0] = '>';
+    line[1] = ' ';
+	ret = FMT_VSnprintf(&line[2], sizeof(line) - 4, format, args);
 	va_end(args);
-	offset = strlen(sio_tx_buffer);
-	sio_tx_buffer[offset++] = LF;
-	sio_tx_buffer[offset++] = CR;
-	//sio_tx_buffer[offset++] = '$';
-	//while ( USB2UART_CDCIsReady() == 0u );
-    UART_PUT_STRING(sio_tx_buffer); 
-    CyDelay(100);
+	offset = (ret < 0) ? 0 : ret;
+	if ( offset > (int)(sizeof(line) - 5) )
+	{
+		offset = sizeof(line) - 5;
+	}
+	offset += 2;
+	line[offset++] = LF;
+	line[offset++] = CR;
+    (void)SIO_Write((const uint8*)line, (uint16)offset);
 	return(ret);
 }
 
+/*******************************************************************************
+ * Queues a block of output.  A block that does not fit is either discarded
+ * whole, so the log never shows half lines, or waits for room, depending on
+ * the TX policy.  Returns the number of bytes queued.
+ *******************************************************************************/
+uint16 SIO_Write(const uint8* data, uint16 length)
+{
+    uint8 intr;
+    uint8 waited = 0;
+    uint16 done = 0;
+    uint16 chunk;
+    uint16 used;
+
+    if ( (data == NULL) || (length == 0) )
+    {
+        return (0);
+    }
+
+    intr = CyEnterCriticalSection();
+    if ( (sio_tx_policy == SIO_TX_POLICY_DROP) && (length > SIO_TX_FREE()) )
+    {
+        sio_tx_stats.dropped_msgs++;
+        sio_tx_stats.dropped_bytes += length;
+        sio_tx_error = 1;
+        CyExitCriticalSection(intr);
+        return (0);
+    }
+
+    while ( done < length )
+    {
+        if ( SIO_TX_FREE() == 0 )
+        {
+            /* Blocking: feed the FIFO directly so this also works with
+             * interrupts disabled, and let pending interrupts in between */
+            if ( waited == 0 )
+            {
+                sio_tx_stats.blocked++;
+                waited = 1;
+            }
+            do
+            {
+                SIO_TxPump();
+                CyExitCriticalSection(intr);
+                intr = CyEnterCriticalSection();
+            }
+            while ( SIO_TX_FREE() == 0 );
+        }
+
+        chunk = length - done;
+        if ( chunk > SIO_TX_FREE() )
+        {
+            chunk = SIO_TX_FREE();
+        }
+        while ( chunk-- != 0 )
+        {
+            sio_tx_buffer[sio_tx_tail] = (char)data[done++];
+            sio_tx_tail = (sio_tx_tail + 1u) & SIO_TX_BUFFER_MASK;
+        }
+
+        used = SIO_TX_USED();
+        if ( used > sio_tx_stats.high_water )
+        {
+            sio_tx_stats.high_water = used;
+        }
+        SIO_TxPump();
+    }
+    CyExitCriticalSection(intr);
+
+    return (done);
+}
+
+/*******************************************************************************
+ * Queues a single character.
+ *******************************************************************************/
+void SIO_PutChar(char8 ch)
+{
+    (void)SIO_Write((const uint8*)&ch, 1);
+}
+
+/*******************************************************************************
+ * Queues a NUL terminated string.
+ *******************************************************************************/
+void SIO_PutString(const char8* string)
+{
+    (void)SIO_Write((const uint8*)string, (uint16)strlen(string));
+}
+
+/*******************************************************************************
+ * Waits until everything queued has been handed to the UART and the last
+ * character has left the shifter, e.g. before a reset or bootloader entry.
+ *******************************************************************************/
+void SIO_Flush(void)
+{
+    uint8 intr;
+
+    while ( (sio_tx_head != sio_tx_tail) || (SIOU_SpiUartGetTxBufferSize() != 0u) )
+    {
+        intr = CyEnterCriticalSection();
+        SIO_TxPump();
+        CyExitCriticalSection(intr);
+    }
+}
+
+/*******************************************************************************
+ * Moves queued output into the FIFO from the main loop.  Only needed when the
+ * SIOU component is built without its internal interrupt; SIO_Service()
+ * calls it then.
+ *******************************************************************************/
+void SIO_TxService(void)
+{
+    uint8 intr = CyEnterCriticalSection();
+    SIO_TxPump();
+    CyExitCriticalSection(intr);
+}
+
+/*******************************************************************************
+ * Returns the number of bytes waiting in the transmit buffer.
+ *******************************************************************************/
+uint16 SIO_TxPending(void)
+{
+    return (SIO_TX_USED());
+}
+
+/*******************************************************************************
+ * Selects what SIO_Write() does when the transmit buffer is full.
+ *******************************************************************************/
+void SIO_SetTxPolicy(uint8 policy)
+{
+    sio_tx_policy = policy;
+}
+
+/*******************************************************************************
+ * Copies the transmit counters.
+ *******************************************************************************/
+void SIO_GetTxStats(SIO_TxStats* stats)
+{
+    uint8 intr = CyEnterCriticalSection();
+    *stats = sio_tx_stats;
+    CyExitCriticalSection(intr);
+}
+
+/*******************************************************************************
+ * Resets the transmit counters.
+ *******************************************************************************/
+void SIO_ClearTxStats(void)
+{
+    uint8 intr = CyEnterCriticalSection();
+    memset(&sio_tx_stats, 0, sizeof(sio_tx_stats));
+    CyExitCriticalSection(intr);
+}
+
 /*******************************************************************************
  * Wrapper for ReadRxData function.
  *******************************************************************************/
@@ -259,10 +558,7 @@ uint8 SIO_ReadRxData(void)
  *******************************************************************************/
 void SIO_SendReturn(void)
 {
-	memset(sio_tx_buffer, 0, sizeof(sio_tx_buffer));
-	sio_tx_buffer[0] = CR;
-    sio_tx_buffer[1] = LF;
-    UART_PUT_STRING(sio_tx_buffer);  
+    SIO_PutString("\r\n");
 }
 
 /*******************************************************************************
@@ -271,9 +567,18 @@ void SIO_SendReturn(void)
 void SIO_Start(void)
 {
     SIO_Clear();
+    sio_tx_head = 0;
+    sio_tx_tail = 0;
+    sio_line_len = 0;
+    sio_line_overflow = 0;
     SIOU_Start();
+#ifdef SIOU_ISR_NUMBER
+    SIOU_SetTxInterruptMode(0u);
+    SIOU_SetCustomInterruptHandler(SIO_Interrupt);
+    SIOU_SetRxInterruptMode(SIOU_INTR_RX_NOT_EMPTY);
+#endif
     CyDelay(10u);
-    UART_PUT_STRING("SIO Started\r\n");
+    SIO_PutString("SIO Started\r\n");
     CyDelay(500u);
 }
 
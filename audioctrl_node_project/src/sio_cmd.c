@@ -0,0 +1,207 @@
+/*******************************************************************************
+* FILE: sio_cmd.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Commands of the serial debug port, see sio_cmd.h.
+*******************************************************************************/
+#include <stdlib.h>
+#include "target.h"
+#include "amp.h"
+#include "bench.h"
+#include "fmt.h"
+#include "i2cq.h"
+#include "pfail.h"
+#include "pstore.h"
+#include "sio.h"
+#include "sio_cmd.h"
+#include "sio_tx.h"
+#include "modlog.h"
+#include "timer.h"
+#include "usr_impl.h"
+
+static void CMD_Help(uint8 argc, char* argv[]);
+static void CMD_ObjRead(uint8 argc, char* argv[]);
+static void CMD_ObjWrite(uint8 argc, char* argv[]);
+static void CMD_Log(uint8 argc, char* argv[]);
+static void CMD_Stat(uint8 argc, char* argv[]);
+
+const SIO_Command sio_cmd_table[] =
+{
+    { "HELP", 0u, CMD_Help,     "list commands" },
+    { "ODR",  2u, CMD_ObjRead,  "<index> <sub> read object" },
+    { "ODW",  3u, CMD_ObjWrite, "<index> <sub> <value> write object" },
+    { "LOG",  0u, CMD_Log,      "[levels] show or set packed log levels" },
+    { "STAT", 0u, CMD_Stat,     "serial, timer, I2C, amp, pstore and pfail counters" },
+#if (BENCH_ENABLE)
+    { "BENCH", 1u, BENCH_Command, "FMT|TICK|EE run a micro benchmark" },
+#endif
+};
+
+const uint8 sio_cmd_count = sizeof(sio_cmd_table) / sizeof(sio_cmd_table[0]);
+
+/*******************************************************************************
+ * Parses a whole word as a number, base 0 accepts 0x.. and decimal.
+ *******************************************************************************/
+static uint8 CMD_Number(const char* word, uint8 base, uint32* value)
+{
+    char* end;
+
+    *value = strtoul(word, &end, base);
+    return ( (end != word) && (*end == 0) );
+}
+
+/*******************************************************************************
+ * Sends the reply for a USR_OBJ_xxx result.
+ *******************************************************************************/
+static void CMD_ObjReply(uint8 result, uint32 value)
+{
+    char reply[24];
+
+    switch ( result )
+    {
+        case USR_OBJ_OK:
+            FMT_Snprintf(reply, sizeof(reply), "OK 0x%08lx\r\n", (unsigned long)value);
+            SIO_PutString(reply);
+            break;
+        case USR_OBJ_NO_OBJECT:
+            SIO_PutString("ERR NOOBJ\r\n");
+            break;
+        case USR_OBJ_READ_ONLY:
+            SIO_PutString("ERR READONLY\r\n");
+            break;
+        default:
+            SIO_PutString("ERR RANGE\r\n");
+            break;
+    }
+}
+
+static void CMD_Help(uint8 argc, char* argv[])
+{
+    uint8 i;
+
+    (void)argc;
+    (void)argv;
+    for ( i = 0; i < sio_cmd_count; i++ )
+    {
+        SIO_PutString(sio_cmd_table[i].name);
+        SIO_PutChar(' ');
+        SIO_PutString(sio_cmd_table[i].help);
+        SIO_SendReturn();
+    }
+    SIO_PutString("OK\r\n");
+}
+
+static void CMD_ObjRead(uint8 argc, char* argv[])
+{
+    uint32 index;
+    uint32 sub;
+    uint32 value = 0;
+    uint8 result;
+
+    (void)argc;
+    if ( !CMD_Number(argv[1], 16, &index) || !CMD_Number(argv[2], 16, &sub) )
+    {
+        SIO_PutString("ERR ARGS\r\n");
+        return;
+    }
+    result = USR_ObjRead((uint16)index, (uint8)sub, &value);
+    CMD_ObjReply(result, value);
+}
+
+static void CMD_ObjWrite(uint8 argc, char* argv[])
+{
+    uint32 index;
+    uint32 sub;
+    uint32 value;
+
+    (void)argc;
+    if ( !CMD_Number(argv[1], 16, &index) || !CMD_Number(argv[2], 16, &sub) ||
+         !CMD_Number(argv[3], 0, &value) )
+    {
+        SIO_PutString("ERR ARGS\r\n");
+        return;
+    }
+    CMD_ObjReply(USR_ObjWrite((uint16)index, (uint8)sub, value), value);
+}
+
+static void CMD_Log(uint8 argc, char* argv[])
+{
+    uint32 levels;
+
+    if ( argc > 1 )
+    {
+        if ( !CMD_Number(argv[1], 0, &levels) )
+        {
+            SIO_PutString("ERR ARGS\r\n");
+            return;
+        }
+        MLOG_SetLevels(levels);
+    }
+    CMD_ObjReply(USR_OBJ_OK, MLOG_GetLevels());
+}
+
+/* STAT is longer than the TX ring, whose drop policy would lose the tail */
+static void CMD_StatLine(const char* line)
+{
+    SIO_PutString(line);
+    SIO_Flush();
+}
+
+static void CMD_Stat(uint8 argc, char* argv[])
+{
+    SIO_TxStats tx;
+    SIO_RxStats rx;
+    I2CQ_Stats i2c;
+    AMP_Stats amp;
+    PSTORE_Stats ps;
+    PFAIL_Stats pf;
+    char line[112];
+
+    (void)argc;
+    (void)argv;
+    SIO_GetTxStats(&tx);
+    SIO_GetRxStats(&rx);
+    FMT_Snprintf(line, sizeof(line), "TX %lu DROP %lu/%lu BLOCK %lu HW %u\r\n", (unsigned long)tx.bytes,
+            (unsigned long)tx.dropped_msgs, (unsigned long)tx.dropped_bytes,
+            (unsigned long)tx.blocked, tx.high_water);
+    CMD_StatLine(line);
+    FMT_Snprintf(line, sizeof(line), "RX %lu OVR %lu LONG %lu\r\n", (unsigned long)rx.lines,
+            (unsigned long)rx.overruns, (unsigned long)rx.too_long);
+    CMD_StatLine(line);
+    FMT_Snprintf(line, sizeof(line), "TICK %lu BACKLOG %lu\r\n", (unsigned long)SysTick_GetTicks(),
+            (unsigned long)SysTick_GetBacklogMax());
+    CMD_StatLine(line);
+    I2CQ_GetStats(&i2c);
+    FMT_Snprintf(line, sizeof(line), "I2C %lu OK %lu FAIL %lu RETRY %lu NAK %lu BUS %lu TMO %lu FULL %lu HW %u\r\n",
+            (unsigned long)i2c.submitted, (unsigned long)i2c.completed, (unsigned long)i2c.failed,
+            (unsigned long)i2c.retries, (unsigned long)i2c.naks, (unsigned long)i2c.bus_errors,
+            (unsigned long)i2c.timeouts, (unsigned long)i2c.full, i2c.depth_max);
+    CMD_StatLine(line);
+    AMP_GetStats(&amp);
+    FMT_Snprintf(line, sizeof(line), "AMP %lu SAME %lu BURST %lu BYTES %lu WERR %lu VERR %lu OFF %u\r\n",
+            (unsigned long)amp.writes, (unsigned long)amp.unchanged, (unsigned long)amp.bursts,
+            (unsigned long)amp.bytes, (unsigned long)amp.write_errors, (unsigned long)amp.verify_errors,
+            amp.offline);
+    CMD_StatLine(line);
+    PSTORE_GetStats(&ps);
+    FMT_Snprintf(line, sizeof(line), "PSTORE %u SEQ %lu STORE %lu SAME %lu ERR %lu VALID %u\r\n",
+            PSTORE_Status(), (unsigned long)ps.seq, (unsigned long)ps.stores, (unsigned long)ps.unchanged,
+            (unsigned long)ps.errors, ps.valid);
+    CMD_StatLine(line);
+    PFAIL_GetStats(&pf);
+    FMT_Snprintf(line, sizeof(line), "PFAIL %lu SNAP %lu SAME %lu LATE %lu ERR %lu US %u/%u MERGED %u\r\n",
+            (unsigned long)pf.events, (unsigned long)pf.written, (unsigned long)pf.unchanged,
+            (unsigned long)pf.late, (unsigned long)pf.errors, pf.last_us, pf.max_us, ps.merged);
+    CMD_StatLine(line);
+    CMD_StatLine("OK\r\n");
+}
+
+/* [] END OF FILE */
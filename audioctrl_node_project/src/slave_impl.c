@@ -18,10 +18,18 @@
 #include "cytypes.h"
 #include "string.h"
 
+#include "amp.h"
 #include "i2c_psoc.h"
+#include "i2cq.h"
 #include "node.h"
 #include "slave_framework.h"
+#include "modlog.h"
+#include "od_table.h"
+#include "pfail.h"
+#include "prof.h"
+#include "pstore.h"
 #include "usr_impl.h"
+#include "vol.h"
 
 
 
@@ -31,7 +39,6 @@
 #define IDAC_ID_3 3
 #define IDAC_ID_4 4
 
-#define ACN_BASE_INDEX              (0x2600)
 #define ACN_NODE_ID                 (0x17)
 
 #if (TAR_k_ENABLE_LED == 1)
@@ -115,17 +122,239 @@ void USR_IntSyncIndication(UINT8* pb_data, UINT8* pb_len)
 *************************************************************************/
 void USR_SyncIndication(void)
 {
-	PRINTF_ARG0("sync received\r\n");
+	MLOG0(MLOG_MOD_USR, MLOG_LVL_TRACE, "sync received\r\n");
 }
 
 uint32_t uid[2] = { 0 };
 
+/*************************************************************************
+**
+** Function    : USR_ObjRead
+**
+** Description : Reads the current value of an application object.  Used
+**               by the SDO read path and the serial ODR command.
+**
+** Parameters  : index       (IN)  - object index
+**               subindex    (IN)  - object subindex
+**               value       (OUT) - current value
+**
+** Returnvalue : USR_OBJ_OK, USR_OBJ_NO_OBJECT
+**
+*************************************************************************/
+uint8 USR_ObjRead(uint16 index, uint8 subindex, uint32* value)
+{
+    return (OD_Read(index, subindex, value));
+}
+
+/*************************************************************************
+**
+** Function    : USR_ObjWrite
+**
+** Description : Applies a new value to an application object.  Used by
+**               the SDO write path and the serial ODW command.
+**
+** Parameters  : index       (IN) - object index
+**               subindex    (IN) - object subindex
+**               value       (IN) - new value
+**
+** Returnvalue : USR_OBJ_OK, USR_OBJ_NO_OBJECT, USR_OBJ_RANGE,
+**               USR_OBJ_READ_ONLY
+**
+*************************************************************************/
+uint8 USR_ObjWrite(uint16 index, uint8 subindex, uint32 value)
+{
+    return (OD_Write(index, subindex, value));
+}
+
+/*************************************************************************
+**    object dictionary handlers, see config/slave_node.yaml
+*************************************************************************/
+
+/* CiA 301 store and restore: sub 1 takes the signature, reads 1 for
+ * "on command"; the EEPROM is written later from the main loop */
+uint8 OD_Validate_store_parameters(uint8 subindex, uint32 value)
+{
+    (void)subindex;
+    if ((value != PSTORE_SIGNATURE_SAVE) || (PSTORE_Status() == PSTORE_FAILED))
+        return (OD_RANGE);
+    return (OD_OK);
+}
+
+void OD_Apply_store_parameters(uint8 subindex, uint32 value)
+{
+    (void)subindex;
+    (void)value;
+    PSTORE_Save();
+}
+
+uint8 OD_Refresh_store_parameters(uint8 subindex, uint32* value)
+{
+    (void)subindex;
+    *value = 1;
+    return (OD_OK);
+}
+
+uint8 OD_Validate_restore_default_parameters(uint8 subindex, uint32 value)
+{
+    (void)subindex;
+    if ((value != PSTORE_SIGNATURE_LOAD) || (PSTORE_Status() == PSTORE_FAILED))
+        return (OD_RANGE);
+    return (OD_OK);
+}
+
+void OD_Apply_restore_default_parameters(uint8 subindex, uint32 value)
+{
+    (void)subindex;
+    (void)value;
+    PSTORE_Restore();
+}
+
+uint8 OD_Refresh_restore_default_parameters(uint8 subindex, uint32* value)
+{
+    (void)subindex;
+    *value = 1;
+    return (OD_OK);
+}
+
+uint8 OD_Refresh_speaker_enable(uint8* value)
+{
+    *value = USR_SPKR_IsEnabled();
+    return (OD_OK);
+}
+
+void OD_Apply_speaker_enable(uint8 value)
+{
+    if (value == 1)
+        USR_SPKR_Enable();
+    else
+        USR_SPKR_Disable();
+}
+
+void OD_Apply_speaker_volume(uint8 value)
+{
+    VOL_Set(value);
+}
+
+uint8 OD_Refresh_log_levels(uint32* value)
+{
+    *value = MLOG_GetLevels();
+    return (OD_OK);
+}
+
+void OD_Apply_log_levels(uint32 value)
+{
+    MLOG_SetLevels(value);
+}
+
+#if (PROF_ENABLE)
+void OD_Apply_prof_reset(uint8 value)
+{
+    (void)value;
+    PROF_Reset();
+}
+
+/* One profiler record per site */
+#define ACN_PROF_RECORD(name, site) \
+    uint8 OD_Refresh_##name(uint8 subindex, uint32* value) \
+    { \
+        return (PROF_Read((site), subindex, value) ? OD_OK : OD_NO_OBJECT); \
+    }
+
+ACN_PROF_RECORD(prof_usr_main, PROF_SITE_USR_MAIN)
+ACN_PROF_RECORD(prof_led_handler, PROF_SITE_LED_HANDLER)
+ACN_PROF_RECORD(prof_objcb, PROF_SITE_OBJCB)
+ACN_PROF_RECORD(prof_can_isr, PROF_SITE_CAN_ISR)
+#endif
+
+/*************************************************************************
+**    PDO writes
+*************************************************************************/
+
+/* The PDO mappable objects with an apply handler and their storage in the
+ * stack's object dictionary (OBD_app.h).  A PDO write reaches
+ * ACN_ObjCallback only as a memory index, so the storage is compared with
+ * the value last seen there and the objects that changed are applied. */
+typedef struct
+{
+    uint16 index;
+    void*  stack;
+} ACN_PdoObject;
+
+#define ACN_PDO_COUNT   (3u)
+
+#if (ACN_PDO_COUNT != OD_PDO_APPLY_COUNT)
+    #error "acn_pdo_objects[] does not match the PDO mappable objects of od_table.h"
+#endif
+
+static const ACN_PdoObject acn_pdo_objects[ACN_PDO_COUNT] =
+{
+    { OD_IDX_SPEAKER_ENABLE, &speaker_enable },
+    { OD_IDX_SPEAKER_VOLUME, &speaker_volume },
+    { OD_IDX_LOG_LEVELS, &log_levels }
+};
+
+static uint32 acn_pdo_seen[ACN_PDO_COUNT];
+
+/*******************************************************************************
+* Function Name: ACN_PdoScan
+********************************************************************************
+*
+* Summary:
+*  Compares the stack storage of the objects in acn_pdo_objects[] with the
+*  values last seen there and validates and applies those that changed.  A
+*  value that is rejected is put back, as an SDO write would leave it.
+*
+* Parameters:
+*  apply: 0 to only take the current values, at start and after an SDO
+*         access has stored one
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void ACN_PdoScan(uint8 apply)
+{
+    uint8 i;
+
+    for (i = 0u; i < ACN_PDO_COUNT; i++)
+    {
+        uint16 index = acn_pdo_objects[i].index;
+        uint8 size = OD_Size(index, 0u);
+        uint32 value = 0u;
+        uint8 result;
+
+        memcpy(&value, acn_pdo_objects[i].stack, size);
+        if (value == acn_pdo_seen[i])
+        {
+            continue;
+        }
+        if (apply != 0u)
+        {
+            result = OD_Validate(index, 0u, value);
+            if (result != OD_OK)
+            {
+                MLOG3(MLOG_MOD_SDO, MLOG_LVL_INFO, "PDO write %xh = %lu rejected (%u)\r\n", index, (unsigned long)value, result);
+                memcpy(acn_pdo_objects[i].stack, &acn_pdo_seen[i], size);
+                continue;
+            }
+            OD_Apply(index, 0u, value);
+        }
+        acn_pdo_seen[i] = value;
+    }
+}
+
 /*******************************************************************************
  * 
  ******************************************************************************/
 void USR_Start(void)
 {
     I2C_Start();
+    I2CQ_Start();
+    AMP_Start();
+    VOL_Start();
+    PSTORE_Start();
+    PFAIL_Start();
+    ACN_PdoScan(0u);
 
     // WS_LED_cisr_StartEx
     // to set new interrupt controllable by us
@@ -133,9 +362,13 @@ void USR_Start(void)
 
 /*************************************************************************
 **
-** Function    : slave_framework_objcb
+** Function    : ACN_ObjCallback
 **
-** Description : Callback function for SDO access and dynamic PDO mapping
+** Description : Callback function for SDO access and dynamic PDO mapping.
+**               Each service maps onto the object's entry in od_table[]:
+**               lengths come from the table, a write is validated before
+**               and applied after the stack stores it, and a read is
+**               refreshed first.
 **
 ** Parameters  : Idx         (IN) - Memory index of object
 **               srvc        (IN) - Indicator which service is performed
@@ -156,84 +389,99 @@ void USR_Start(void)
 **                                  if srvc COP_k_SDO_READ_MAX_OBJLEN
 **
 *************************************************************************/
-COP_t_OBJ_LEN slave_framework_objcb(PDO_t_Idx Idx, UINT8 srvc)
-{    
-	Idx = Idx; /* avoid compiler warning */
-    
-    PRINTF_ARG0("Received Object\r\n");
-
-	if ( srvc == COP_k_SDO_READ_OBJLEN )
-	{
-		PRINTF_ARG2("COP_k_SDO_READ_OBJLEN : Index %xh Subindex %xh\r\n", OBD_s_ObjectInfo.index, OBD_s_ObjectInfo.subindex);
-		/* length of the object (not used in demo, here always 0x10) */
-		return (0x10);
-	}
-	else if ( srvc == COP_k_SDO_READ_MAX_OBJLEN )
-	{
-		PRINTF_ARG2("COP_k_SDO_READ_MAX_OBJLEN : Index %xh Subindex %xh\r\n", OBD_s_ObjectInfo.index, OBD_s_ObjectInfo.subindex);
-		/* max. length of the object (not used in demo, here always 0x10) */
-		return (0x10);
-	}
-	else if ( srvc == COP_k_SDO_BEFORE_WRITE )
-	{
-		PRINTF_ARG2("COP_k_SDO_BEFORE_WRITE : Index %xh Subindex %xh\r\n", OBD_s_ObjectInfo.index, OBD_s_ObjectInfo.subindex);
-
-		/* OBD_s_ObjectInfo.p_sdobuf is pointer to "new value"          */
-		/* if value is not allowed, an return value != COP_k_OK         */
-		/* aborts the transfer and the actual value is not overwritten  */
-		/* Remark: The pointer is of type *UINT8, so be aware on 16-Bit */
-		/*         microcontrollers concerning the alignment            */
-
-		return (COP_k_OK);
-	}
+static COP_t_OBJ_LEN ACN_ObjCallback(PDO_t_Idx Idx, UINT8 srvc)
+{
+    uint16 index = OBD_s_ObjectInfo.index;
+    uint8 subindex = OBD_s_ObjectInfo.subindex;
+    const OD_Entry* e;
+    uint32 value = 0;
+    uint8 result;
+
+    (void)Idx; /* only used for logging */
+    if ( srvc == COP_k_PDO_WRITE )
+    {
+        /* Only the memory index is known here, see ACN_PdoScan */
+        MLOG1(MLOG_MOD_SDO, MLOG_LVL_TRACE, "COP_k_PDO_WRITE : memindex %xh\r\n", Idx);
+        ACN_PdoScan(1u);
+        return (COP_k_OK);
+    }
 #if (SDO_FLASH_SUPPORT == 1)
-	else if ( srvc == COP_k_SDO_WRITE_SEGMENT )
-	{
-		/* example of writing a testobject defined with attributes ATTR_FLASH|NO_SDO_BUF */
-		/* OBD_s_ObjectInfo.datalength => offset in destination  */
-		/* Idx => datalength in actual segment                   */
-		/* OBD_s_ObjectInfo.p_sdobuf => pointer to source buffer */
-		PRINTF_ARG4("COP_k_SDO_WRITE_SEGMENT: index %xh Subindex %xh SegNo %d NumBytes %d\r\n",
-					OBD_s_ObjectInfo.index,
-					OBD_s_ObjectInfo.subindex,
-					OBD_s_ObjectInfo.datalength / 7, /* max 7 bytes per segment */
-					Idx
-				   );
-	}
+    if ( srvc == COP_k_SDO_WRITE_SEGMENT )
+    {
+        /* OBD_s_ObjectInfo.datalength => offset in destination  */
+        /* Idx => datalength in actual segment                   */
+        MLOG4(MLOG_MOD_SDO, MLOG_LVL_DEBUG, "COP_k_SDO_WRITE_SEGMENT: index %xh Subindex %xh SegNo %d NumBytes %d\r\n",
+              index, subindex, OBD_s_ObjectInfo.datalength / 7, Idx);
+        return (COP_k_OK);
+    }
 #endif
-	else if ( srvc == COP_k_SDO_AFTER_WRITE )
-	{
-        uint16_t index = OBD_s_ObjectInfo.index;
-		PRINTF_ARG2("COP_k_SDO_AFTER_WRITE : Index %xh Subindex %xh\r\n", OBD_s_ObjectInfo.index, OBD_s_ObjectInfo.subindex);
-		
-        if (index == ACN_BASE_INDEX )
+
+    e = OD_Find(index, subindex);
+    if (e == NULL)
+    {
+        /* Not an application object, the stack's own length stands */
+        if ((srvc == COP_k_SDO_READ_OBJLEN) || (srvc == COP_k_SDO_READ_MAX_OBJLEN))
         {
-            uint8_t* dataPtr = OBD_s_ObjectInfo.p_object;
-            if ((*dataPtr) == 1)
-                USR_SPKR_Enable();
-            else
-                USR_SPKR_Disable();
+            return (OBD_s_ObjectInfo.datalength);
         }
-        
         return (COP_k_OK);
-	}
-	else if ( srvc == COP_k_SDO_READ )
-	{
-		PRINTF_ARG2("COP_k_SDO_READ : Index %xh Subindex %xh\r\n", OBD_s_ObjectInfo.index, OBD_s_ObjectInfo.subindex);
-    
+    }
+
+    switch ( srvc )
+    {
+        case COP_k_SDO_READ_OBJLEN:
+        case COP_k_SDO_READ_MAX_OBJLEN:
+            return (e->size);
+
+        case COP_k_SDO_BEFORE_WRITE:
+            /* OBD_s_ObjectInfo.p_sdobuf is the new value; rejecting it
+             * aborts the transfer and leaves the object unchanged */
+            memcpy(&value, OBD_s_ObjectInfo.p_sdobuf, e->size);
+            result = OD_Validate(index, subindex, value);
+            if (result != OD_OK)
+            {
+                MLOG3(MLOG_MOD_SDO, MLOG_LVL_INFO, "SDO write %xh.%xh rejected (%u)\r\n", index, subindex, result);
+                return (COP_k_NO);
+            }
+            return (COP_k_OK);
+
+        case COP_k_SDO_AFTER_WRITE:
+            memcpy(&value, OBD_s_ObjectInfo.p_object, e->size);
+            OD_Apply(index, subindex, value);
+            ACN_PdoScan(0u);
+            return (COP_k_OK);
 
-        
-		return (COP_k_OK);
-	}
-	else if ( srvc == COP_k_PDO_WRITE )
-	{
-		PRINTF_ARG1("COP_k_PDO_WRITE : memindex %xh\r\n", Idx);
-		return (COP_k_OK);
-	}
+        case COP_k_SDO_READ:
+            /* Report what is in effect, the object may also have been
+             * changed over the serial port or by the application */
+            if (OD_Read(index, subindex, &value) == OD_OK)
+            {
+                memcpy(OBD_s_ObjectInfo.p_object, &value, e->size);
+                ACN_PdoScan(0u);
+            }
+            return (COP_k_OK);
 
-	return (COP_k_OK);
+        default:
+            return (COP_k_OK);
+    }
 }
 
+/*************************************************************************
+**
+** Function    : slave_framework_objcb
+**
+** Description : Callback function for SDO access and dynamic PDO mapping,
+**               see ACN_ObjCallback.  Profiled as PROF_SITE_OBJCB.
+**
+*************************************************************************/
+COP_t_OBJ_LEN slave_framework_objcb(PDO_t_Idx Idx, UINT8 srvc)
+{
+    COP_t_OBJ_LEN result;
+    PROF_ENTER(PROF_SITE_OBJCB);
 
+    result = ACN_ObjCallback(Idx, srvc);
+    PROF_EXIT(PROF_SITE_OBJCB);
+    return (result);
+}
 
 /* [] END OF FILE */
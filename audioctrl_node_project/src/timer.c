@@ -32,25 +32,204 @@
 
 /* SysClk = 24 MHz, therefore each clock cycle is 41.667 nanoseconds */
 #define SYS_TICK_MSEC (24000u) /* Number of cycles per millisecond */
-#define SYS_TICK_USEC (2400u)  /* Number of cycles per microsecond */
+#define SYS_TICK_USEC (24u)    /* Number of cycles per microsecond */
+
+/* The M0 has no divide instruction, so cycle counts are converted with
+ * multiply and shift.  Cycles to ms: SYS_TICK_MSEC = 64 * 375, and
+ * (x >> 6) * 5592 >> 21 is x / 24000 or one less for x < 2^25.  Cycles to us
+ * within one millisecond: r * 21846 >> 19 is r / 24 for r < 32768. */
+#define SYS_TICK_MSEC_SHIFT     (6u)
+#define SYS_TICK_MSEC_MUL       (5592u)
+#define SYS_TICK_MSEC_MUL_SHIFT (21u)
+#define SYS_TICK_USEC_MUL       (21846u)
+#define SYS_TICK_USEC_MUL_SHIFT (19u)
+#define SYS_TICK_CYCLES_TO_US(r) (((r) * SYS_TICK_USEC_MUL) >> SYS_TICK_USEC_MUL_SHIFT)
+
+/* Cycles lost between reading and clearing the counter when the tickless
+ * period is reprogrammed */
+#ifndef SYS_TICK_RELOAD_ADJUST
+    #define SYS_TICK_RELOAD_ADJUST  (8u)
+#endif
+#define SYS_TICK_RELOAD_MAX_MS  ((CY_SYS_SYST_RVR_CNT_MASK + 1u) / SYS_TICK_MSEC)
+/* Counts this close to a wrap are not reprogrammed from the main loop */
+#define SYS_TICK_RELOAD_MARGIN  (64u)
+/* Shortest period programmed, long enough for the handler to return before
+ * the next wrap */
+#define SYS_TICK_RELOAD_MIN     (SYS_TICK_MSEC / 4u)
+
+/* SCB interrupt control and state register, PENDSTSET flags a SysTick wrap
+ * whose handler has not run yet */
+#define SYS_TICK_ICSR_PENDSTSET ((uint32)0x04000000u)
+#define SYS_TICK_WRAP_PENDING() ((CY_GET_REG32(CYREG_CM0_ICSR) & SYS_TICK_ICSR_PENDSTSET) != 0u)
+
+/* Hierarchical timer wheel: TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SIZE
+ * slots, level n holding timers due within 2^(TIMER_WHEEL_BITS * (n + 1))
+ * ticks.  Level 0 slots are run one per tick; a higher level slot is cascaded
+ * down each time the level below wraps. */
+#define TIMER_WHEEL_BITS    (5u)
+#define TIMER_WHEEL_SIZE    (1u << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK    (TIMER_WHEEL_SIZE - 1u)
+#define TIMER_WHEEL_LEVELS  (4u)
+#define TIMER_WHEEL_RANGE   (1uL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
 
 /* Global Variables */
 volatile uint32 tick_seconds; 
 volatile uint32 tick_milliseconds;
 volatile uint32 tick_status;
-uint32 timer_interval[TIMER_ID_LAST];
-uint8 timer_check[TIMER_ID_LAST];
+
+/* The tick count is advanced by tick_period_ms each time the counter wraps
+ * after tick_period_cycles cycles.  A reprogrammed period starts
+ * tick_period_offset cycles into a millisecond; auto-reloaded periods start on
+ * a millisecond boundary.  tick_epoch changes with every update so readers can
+ * detect that they were interrupted. */
+static volatile uint32 tick_ms_hi;          /* upper half of the 64-bit count */
+static volatile uint32 tick_period_ms;
+static volatile uint32 tick_period_cycles;
+static volatile uint32 tick_period_offset;  /* cycles of the first ms spent before the period started */
+static volatile uint32 tick_epoch;
+/* Cascaded sub-counters, so seconds and minutes need no division */
+static uint32 tick_ms_in_sec;
+static uint32 tick_sec_in_min;
+static volatile uint32 tick_minutes;
+#if (SYSTICK_USE_TICKLESS)
+static volatile uint32 tick_deadline;       /* tick of the next timer work */
+static volatile uint8 tick_wake;            /* an interrupt left work for the main loop */
+#endif
+
+static SysTick_Timer* timer_wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE];
+static uint32 timer_base;                   /* next tick to be run */
+static uint32 timer_backlog_max;            /* most ticks run by one refresh */
+static SysTick_Timer timer_legacy[TIMER_ID_LAST];
+
+static const uint16 timer_legacy_period[TIMER_ID_LAST] =
+{
+    500u,   /* TIMER_ID_500 */
+    250u,   /* TIMER_ID_250 */
+    100u,   /* TIMER_ID_100 */
+    50u,    /* TIMER_ID_050 */
+    250u,   /* TIMER_ID_SENSOR */
+    1000u,  /* TIMER_ID_SECONDS */
+};
 
 /* Function prototypes */
 void SysTick_Callback(void);
 
+/*******************************************************************************
+ * Advances the 64-bit tick count and the seconds and minutes cascaded from
+ * it.  "ms" is at most one period (< 1 s), so each level carries at most
+ * once.  Callers hold interrupts off.
+ *******************************************************************************/
+static void SysTick_AddMilliseconds(uint32 ms)
+{
+    uint32 t = tick_milliseconds + ms;
+    if (t < tick_milliseconds)
+    {
+        ++tick_ms_hi;
+    }
+    tick_milliseconds = t;
+    ++tick_epoch;
+
+    tick_ms_in_sec += ms;
+    if (tick_ms_in_sec >= TIME_MS_IN_SEC)
+    {
+        tick_ms_in_sec -= TIME_MS_IN_SEC;
+        ++tick_seconds;
+        if (++tick_sec_in_min >= TIME_SECS_IN_MIN)
+        {
+            tick_sec_in_min = 0u;
+            ++tick_minutes;
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: SysTick_CyclesToMs
+********************************************************************************
+*
+* Summary:
+*  Splits a SysClk cycle count into whole milliseconds and the cycles left
+*  over, without a division.  Valid for counts below 2^25 (1.4 s), which
+*  covers anything measured within one SysTick period.
+*
+* Parameters:
+*  cycles: cycle count
+*  rest: receives the remaining cycles, 0..SYS_TICK_MSEC-1 (may be NULL)
+*
+* Return:
+*  Whole milliseconds
+*
+*******************************************************************************/
+uint32 SysTick_CyclesToMs(uint32 cycles, uint32* rest)
+{
+    uint32 ms = ((cycles >> SYS_TICK_MSEC_SHIFT) * SYS_TICK_MSEC_MUL) >> SYS_TICK_MSEC_MUL_SHIFT;
+    uint32 r = cycles - (ms * SYS_TICK_MSEC);
+
+    /* The estimate is low by at most one */
+    if (r >= SYS_TICK_MSEC)
+    {
+        r -= SYS_TICK_MSEC;
+        ++ms;
+    }
+    if (rest != NULL)
+    {
+        *rest = r;
+    }
+    return (ms);
+}
+
+#if (SYSTICK_USE_TICKLESS)
+/*******************************************************************************
+ * Restarts the SysTick counter so that it next wraps when tick_milliseconds
+ * reaches tick_deadline, bounded to 1..SYSTICK_TICKLESS_MAX_MS.  "elapsed" is
+ * the number of cycles already spent since tick_milliseconds was last
+ * correct; whole milliseconds of it are folded into the tick count and the
+ * remainder is taken off the new period so no time is lost.  Must be called
+ * with interrupts disabled and no wrap pending.
+ *******************************************************************************/
+static void SysTick_TicklessReload(uint32 elapsed)
+{
+    uint32 ms;
+    uint32 cycles;
+
+    if (elapsed >= SYS_TICK_MSEC)
+    {
+        SysTick_AddMilliseconds(SysTick_CyclesToMs(elapsed, &elapsed));
+    }
+
+    ms = tick_deadline - tick_milliseconds;
+    if (((int32)ms <= 0) || (ms > SYSTICK_TICKLESS_MAX_MS))
+    {
+        ms = SYSTICK_TICKLESS_MAX_MS;
+    }
+    if (ms > SYS_TICK_RELOAD_MAX_MS)
+    {
+        ms = SYS_TICK_RELOAD_MAX_MS;
+    }
+
+    /* The remainder is below one ms, so only a 1 ms period can come out too
+     * short, or negative; it then runs to the end of the next ms instead */
+    if ((ms * SYS_TICK_MSEC) < (elapsed + SYS_TICK_RELOAD_ADJUST + SYS_TICK_RELOAD_MIN))
+    {
+        ++ms;
+    }
+    cycles = (ms * SYS_TICK_MSEC) - elapsed - SYS_TICK_RELOAD_ADJUST;
+    CySysTickSetReload(cycles - 1u);
+    CySysTickClear();
+    tick_period_ms = ms;
+    tick_period_cycles = cycles;
+    tick_period_offset = elapsed;
+    ++tick_epoch;
+}
+#endif
+
 /*******************************************************************************
 * Function Name: SysTick_Callback
 ********************************************************************************
 *
 * Summary:
 *  This API is called from SysTick timer interrupt handler to update the
-*  millisecond counter.
+*  millisecond counter.  In tickless mode it also runs the other CySysTick
+*  callbacks once for each further millisecond of the period that ended.
 *
 * Parameters:
 *  None
@@ -61,22 +240,195 @@ void SysTick_Callback(void);
 *******************************************************************************/
 void SysTick_Callback(void)
 {
-	tick_status = 1u;
-    ++tick_milliseconds;
-    
-   	/* Also count the number of milliseconds in one second */
-    if ((tick_milliseconds % TIME_MS_IN_SEC) == 0u)
+    uint8 state = CyEnterCriticalSection();
+#if (SYSTICK_USE_TICKLESS)
+    uint32 ms = tick_period_ms;
+    cySysTickCallback callback;
+    uint32 i;
+#endif
+
+	++tick_status;
+    SysTick_AddMilliseconds(tick_period_ms);
+#if (SYSTICK_USE_TICKLESS)
+    /* The counter has already reloaded; program the next deadline from here */
+    SysTick_TicklessReload(tick_period_cycles - 1u - (CY_SYS_SYST_CVR_REG & CY_SYS_SYST_CVR_CNT_MASK));
+#endif
+    CyExitCriticalSection(state);
+
+#if (SYSTICK_USE_TICKLESS)
+    /* The other CySysTick callbacks, the stack timebase among them, count
+     * interrupts as milliseconds.  The handler runs them once per wrap, so
+     * they get the rest of the period here. */
+    while (--ms != 0u)
     {
-        ++tick_seconds;
+        for (i = 0u; i < CY_SYS_SYST_NUM_OF_CALLBACKS; ++i)
+        {
+            callback = CySysTickGetCallback(i);
+            if ((callback != NULL) && (callback != SysTick_Callback))
+            {
+                callback();
+            }
+        }
+    }
+#endif
+}
+
+/*******************************************************************************
+ * Links a timer into the wheel slot matching its expiry, relative to the next
+ * tick to be run.  Overdue timers go to the next tick and timers beyond the
+ * wheel range are parked in the top level and cascaded again later.
+ *******************************************************************************/
+static void SysTick_WheelInsert(SysTick_Timer* timer)
+{
+    uint32 delta = timer->expires - timer_base;
+    uint32 level = 0u;
+    SysTick_Timer** head;
+
+    if ((int32)delta < 0)
+    {
+        delta = 0u;
+    }
+    else if (delta >= TIMER_WHEEL_RANGE)
+    {
+        delta = TIMER_WHEEL_RANGE - 1u;
+    }
+    while (delta >= (1uL << (TIMER_WHEEL_BITS * (level + 1u))))
+    {
+        ++level;
+    }
+
+    head = &timer_wheel[level][((timer_base + delta) >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK];
+    timer->next = *head;
+    if (timer->next != NULL)
+    {
+        timer->next->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+static void SysTick_WheelRemove(SysTick_Timer* timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next != NULL)
+    {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+/*******************************************************************************
+ * Redistributes one slot of a higher level into the levels below and returns
+ * the slot index, which is zero when the next level up must cascade too.
+ *******************************************************************************/
+static uint32 SysTick_WheelCascade(uint32 level)
+{
+    uint32 slot = (timer_base >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    SysTick_Timer* list = timer_wheel[level][slot];
+
+    timer_wheel[level][slot] = NULL;
+    while (list != NULL)
+    {
+        SysTick_Timer* next = list->next;
+        SysTick_WheelInsert(list);
+        list = next;
+    }
+    return (slot);
+}
+
+/*******************************************************************************
+ * Accounts for one expiry: lateness against the tick being run, and either a
+ * pending count for flag consumers or an overrun when that count saturates.
+ *******************************************************************************/
+static void SysTick_TimerAccount(SysTick_Timer* timer, uint32 late)
+{
+    timer->late_last = (late > 0xFFFFu) ? 0xFFFFu : (uint16)late;
+    if (timer->late_last > timer->late_max)
+    {
+        timer->late_max = timer->late_last;
+    }
+    if (timer->pending != 0xFFu)
+    {
+        ++timer->pending;
+    }
+    else if (timer->overruns != 0xFFFFu)
+    {
+        ++timer->overruns;
     }
 }
 
 /*******************************************************************************
-* Function Name: SysTickRefresh
+ * Runs every timer due on tick timer_base and advances it.  The due list is
+ * detached first so callbacks may arm or cancel any timer, themselves
+ * included.  A periodic timer that is still behind "now" after its reload is
+ * run again on its next tick by the caller's loop (catch-up), or skipped
+ * forward past "now" with the missed expiries counted (coalesce).
+ *******************************************************************************/
+static void SysTick_WheelRun(uint32 now)
+{
+    SysTick_Timer* work;
+    uint32 slot = timer_base & TIMER_WHEEL_MASK;
+    uint32 late = now - timer_base;
+    uint32 level;
+
+    if (slot == 0u)
+    {
+        for (level = 1u; level < TIMER_WHEEL_LEVELS; ++level)
+        {
+            if (SysTick_WheelCascade(level) != 0u)
+            {
+                break;
+            }
+        }
+    }
+
+    work = timer_wheel[0][slot];
+    timer_wheel[0][slot] = NULL;
+    if (work != NULL)
+    {
+        work->pprev = &work;
+    }
+    ++timer_base;
+
+    while (work != NULL)
+    {
+        SysTick_Timer* timer = work;
+
+        SysTick_WheelRemove(timer);
+        if (timer->period != 0u)
+        {
+            timer->expires += timer->period;
+            if ((timer->mode == SYSTICK_TIMER_COALESCE) && ((int32)(now - timer->expires) >= 0))
+            {
+                /* Step over the missed expiries; no more steps than the
+                 * backlog this refresh is running anyway */
+                uint32 missed = 0u;
+                do
+                {
+                    timer->expires += timer->period;
+                    ++missed;
+                } while ((int32)(now - timer->expires) >= 0);
+                timer->overruns = ((timer->overruns + missed) > 0xFFFFu) ? 0xFFFFu : (uint16)(timer->overruns + missed);
+            }
+            SysTick_WheelInsert(timer);
+        }
+        SysTick_TimerAccount(timer, late);
+        if (timer->callback != NULL)
+        {
+            timer->callback(timer->context);
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: SysTick_Refresh
 ********************************************************************************
 *
 * Summary:
-*  This API is called from main program to update the millisecond counter.
+*  This API is called from main program to run the software timers.  Every
+*  tick elapsed since the previous call is run in order, so a main loop that
+*  was held up still sees each expiry.
 *
 * Parameters:
 *  None
@@ -87,37 +439,130 @@ void SysTick_Callback(void)
 *******************************************************************************/
 void SysTick_Refresh(void)
 {
-    uint32 tick;
-#ifdef DEBUG_TIMERS    
-	char message[32u];
-#endif    
-	/* Tick status fires only once every millisecond. */
-	if ( tick_status != 0u )
-	{
-		tick_status = 0u;  		/* Reset tick status. */
-        tick = tick_milliseconds;
-                
-        if ((tick % 500u) == 0u)
+    uint32 now = SysTick_GetTicks();
+    uint32 backlog = (now + 1u) - timer_base;
+
+    tick_status = 0u;
+    if (backlog > timer_backlog_max)
+    {
+        timer_backlog_max = backlog;
+    }
+    while ((int32)(now - timer_base) >= 0)
+    {
+        SysTick_WheelRun(now);
+    }
+}
+
+#if (SYSTICK_USE_TICKLESS)
+/*******************************************************************************
+ * Returns the number of ticks from timer_base to the first tick that has a
+ * level 0 slot to run or a non-empty slot to cascade, at most "limit".
+ *******************************************************************************/
+static uint32 SysTick_WheelNextEvent(uint32 limit)
+{
+    uint32 best = limit;
+    uint32 slot = timer_base & TIMER_WHEEL_MASK;
+    uint32 level;
+    uint32 i;
+
+    for (i = 0u; (slot + i < TIMER_WHEEL_SIZE) && (i < best); ++i)
+    {
+        if (timer_wheel[0][slot + i] != NULL)
         {
-            timer_check[TIMER_ID_500] = 1u;
+            best = i;
         }
-        
-        if ((tick % 250u) == 0u)
+    }
+    for (level = 1u; level < TIMER_WHEEL_LEVELS; ++level)
+    {
+        uint32 shift = TIMER_WHEEL_BITS * level;
+        uint32 unit = 1uL << shift;
+        uint32 t = (timer_base + unit - 1u) & ~(unit - 1u);
+
+        for (i = 0u; (i < TIMER_WHEEL_SIZE) && ((t - timer_base) < best); ++i, t += unit)
         {
-            timer_check[TIMER_ID_250] = 1u;
-            timer_check[TIMER_ID_SENSOR] = 1u;
+            if (timer_wheel[level][(t >> shift) & TIMER_WHEEL_MASK] != NULL)
+            {
+                best = t - timer_base;
+            }
         }
-        
-        if ((tick % 100u) == 0u)
+    }
+    return (best);
+}
+#endif
+
+/*******************************************************************************
+* Function Name: SysTick_Idle
+********************************************************************************
+*
+* Summary:
+*  Runs the software timers and, in tickless mode, sleeps until the next timer
+*  deadline or any other interrupt.  Call it once per main loop pass when the
+*  loop has nothing else to do.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void SysTick_Idle(void)
+{
+#if (SYSTICK_USE_TICKLESS)
+    uint8 state;
+    uint32 deadline;
+
+    SysTick_Refresh();
+    deadline = timer_base + SysTick_WheelNextEvent(SYSTICK_TICKLESS_MAX_MS);
+
+    state = CyEnterCriticalSection();
+    if (deadline != tick_deadline)
+    {
+        uint32 count = CY_SYS_SYST_CVR_REG & CY_SYS_SYST_CVR_CNT_MASK;
+
+        tick_deadline = deadline;
+        /* Leave a wrap that is pending or about to happen to its handler,
+         * which programs the new deadline itself */
+        if ((count > SYS_TICK_RELOAD_MARGIN) && !SYS_TICK_WRAP_PENDING())
         {
-            timer_check[TIMER_ID_100] = 1u;
+            SysTick_TicklessReload(tick_period_offset + tick_period_cycles - 1u - count);
         }
+    }
+    /* WFI wakes on a pending interrupt even with PRIMASK set, and the
+     * handler runs once the critical section is left.  An interrupt that
+     * came after the main loop polled has already been handled, so only
+     * its flag tells; the loop then takes one more pass instead. */
+    if (tick_wake == 0u)
+    {
+        CySysPmSleep();
+    }
+    tick_wake = 0u;
+    CyExitCriticalSection(state);
+#else
+    SysTick_Refresh();
+#endif
+}
 
-        if ((tick % 50u) == 0u)
-        {
-            timer_check[TIMER_ID_050] = 1u;
-        }        
-	}
+/*******************************************************************************
+* Function Name: SysTick_Wake
+********************************************************************************
+*
+* Summary:
+*  Keeps the next SysTick_Idle() from sleeping.  Call it from an interrupt
+*  that leaves work for the main loop.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void SysTick_Wake(void)
+{
+#if (SYSTICK_USE_TICKLESS)
+    tick_wake = 1u;
+#endif
 }
 
 /*******************************************************************************
@@ -143,10 +588,30 @@ void SysTick_Start(void)
 	tick_status = 0u;
     tick_seconds = 0u;
     tick_milliseconds = 0u;   
-    memset(timer_interval, 0, sizeof(timer_interval));
-    memset(timer_check, 0, sizeof(timer_check));
-   
+    timer_base = 0u;
+    timer_backlog_max = 0u;
+    memset(timer_wheel, 0, sizeof(timer_wheel));
+    tick_ms_hi = 0u;
+    tick_period_ms = 1u;
+    tick_period_cycles = SYS_TICK_MSEC;
+    tick_period_offset = 0u;
+    ++tick_epoch;
+    tick_ms_in_sec = 0u;
+    tick_sec_in_min = 0u;
+    tick_minutes = 0u;
+#if (SYSTICK_USE_TICKLESS)
+    tick_deadline = 0u;
+#endif
+
+    for (i = 0u; i < TIMER_ID_LAST; ++i)
+    {
+        SysTick_TimerInit(&timer_legacy[i], NULL, NULL);
+        SysTick_TimerSet((uint8)i, timer_legacy_period[i]);
+    }
+
 	CySysTickStart();
+    CySysTickSetReload(SYS_TICK_MSEC - 1u);
+    CySysTickClear();
     
 	/* Find unused callback slot. */
 	for ( i = 0u; i < CY_SYS_SYST_NUM_OF_CALLBACKS; ++i )
@@ -162,7 +627,7 @@ void SysTick_Start(void)
 
 uint32 SysTick_GetMinutes(void)
 {
-    uint32 t = tick_seconds / TIME_SECS_IN_MIN;
+    uint32 t = tick_minutes;
     return (t);
 }
 
@@ -178,27 +643,139 @@ uint32 SysTick_GetStatus(void)
     return (t);
 }
 
+/*******************************************************************************
+ * Takes a consistent snapshot of the 64-bit tick count and the cycles counted
+ * down since it was last advanced.  The read is retried if the SysTick
+ * handler ran in between, and a wrap whose handler is held off (caller in an
+ * interrupt or critical section) is accounted for here.
+ *******************************************************************************/
+static uint32 SysTick_Snapshot(uint32* ms_hi, uint32* elapsed)
+{
+    uint32 epoch;
+    uint32 hi;
+    uint32 ms;
+    uint32 cycles;
+    uint8 pending;
+
+    do
+    {
+        epoch = tick_epoch;
+        pending = SYS_TICK_WRAP_PENDING() ? 1u : 0u;
+        hi = tick_ms_hi;
+        ms = tick_milliseconds;
+        cycles = tick_period_cycles - 1u - (CY_SYS_SYST_CVR_REG & CY_SYS_SYST_CVR_CNT_MASK);
+    } while ((epoch != tick_epoch) || (pending != (SYS_TICK_WRAP_PENDING() ? 1u : 0u)));
+
+    if (pending != 0u)
+    {
+        uint32 t = ms + tick_period_ms;
+        hi += (t < ms) ? 1u : 0u;
+        ms = t;
+    }
+    else
+    {
+        cycles += tick_period_offset;
+    }
+    *ms_hi = hi;
+    *elapsed = cycles;
+    return (ms);
+}
+
 uint32 SysTick_GetTicks(void)
 {
+#if (SYSTICK_USE_TICKLESS)
+    /* tick_milliseconds only advances at the end of each (long) period, so
+     * add the whole milliseconds already counted down in this one */
+    uint32 hi;
+    uint32 elapsed;
+    uint32 t = SysTick_Snapshot(&hi, &elapsed);
+
+    return (t + SysTick_CyclesToMs(elapsed, NULL));
+#else
     uint32 t = tick_milliseconds;
     return (t);
+#endif
 }
 
 /* This takes advantage of the SysTick timer to obtain a resolution greater
- * than one millisecond */
-
+ * than one millisecond: microseconds elapsed in the current millisecond */
 uint16 SysTick_GetMicroseconds(void)
 {
-    uint16 usecs;
-    uint32 reload = (uint32)(SYS_TICK_MSEC - (CY_SYS_SYST_CVR_REG & CY_SYS_SYST_CVR_CNT_MASK));
-    usecs = (uint16)(reload % SYS_TICK_USEC);
-    return (usecs);
+    uint32 hi;
+    uint32 elapsed;
+    uint32 rest;
+
+    (void)SysTick_Snapshot(&hi, &elapsed);
+    (void)SysTick_CyclesToMs(elapsed, &rest);
+    return ((uint16)SYS_TICK_CYCLES_TO_US(rest));
 }
 
+/*******************************************************************************
+* Function Name: SysTick_GetMicroseconds64
+********************************************************************************
+*
+* Summary:
+*  Monotonic microseconds since SysTick_Start(), combining the 64-bit tick
+*  count with the SysTick down counter.  Safe to call from any context.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Microsecond timestamp, does not wrap in practice
+*
+*******************************************************************************/
+uint64 SysTick_GetMicroseconds64(void)
+{
+    uint32 hi;
+    uint32 elapsed;
+    uint32 rest;
+    uint64 ms = SysTick_Snapshot(&hi, &elapsed);
+
+    ms |= (uint64)hi << 32;
+    ms += SysTick_CyclesToMs(elapsed, &rest);
+    return ((ms * TIME_MS_IN_SEC) + SYS_TICK_CYCLES_TO_US(rest));
+}
+
+/*******************************************************************************
+* Function Name: SysTick_GetCycles64
+********************************************************************************
+*
+* Summary:
+*  SysClk cycles since SysTick_Start(), for measuring short code paths.
+*  Reading it costs a few hundred cycles; subtract an empty measurement.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Cycle count
+*
+*******************************************************************************/
+uint64 SysTick_GetCycles64(void)
+{
+    uint32 hi;
+    uint32 elapsed;
+    uint32 ms = SysTick_Snapshot(&hi, &elapsed);
+
+    return (((((uint64)hi << 32) | ms) * SYS_TICK_MSEC) + elapsed);
+}
+
+/* Low 32 bits of SysTick_GetCycles64(), wraps every 179 s.  Cheaper, for
+ * measuring durations by unsigned subtraction. */
+uint32 SysTick_GetCycles(void)
+{
+    uint32 hi;
+    uint32 elapsed;
+    uint32 ms = SysTick_Snapshot(&hi, &elapsed);
+
+    return ((ms * SYS_TICK_MSEC) + elapsed);
+}
+
+/* Millisecond timestamp; use SysTick_GetMicroseconds64() for finer ones */
 uint32 SysTick_GetTimestamp(void)
 {
-    uint32 t = (tick_milliseconds);
-    //t |= SysTick_GetMicroseconds();    
+    uint32 t = SysTick_GetTicks();
     return (t);
 }
 
@@ -208,21 +785,169 @@ uint8 SysTick_TimerCheck(uint8 index)
 
     if (index < TIMER_ID_LAST)
     {
-        if (timer_check[index] != 0u)
-        {
-            status = 1u;
-            timer_check[index] = 0u;
-        }
+        status = SysTick_TimerExpired(&timer_legacy[index]);
     }
     
     return (status);
 }
 
+/*******************************************************************************
+* Function Name: SysTick_TimerSet
+********************************************************************************
+*
+* Summary:
+*  Changes the period of one of the fixed TIMER_ID_xxx flags.  The flag is
+*  realigned to multiples of the new period; zero stops it.  Missed expiries
+*  are caught up, one per SysTick_TimerCheck() call.
+*
+* Parameters:
+*  index: TIMER_ID_xxx
+*  milliseconds: new period
+*
+* Return:
+*  None
+*
+*******************************************************************************/
 void SysTick_TimerSet(uint8 index, uint32 milliseconds)
 {
     if (index < TIMER_ID_LAST)
     {
-        timer_interval[index] = milliseconds;
+        if (milliseconds == 0u)
+        {
+            SysTick_TimerCancel(&timer_legacy[index]);
+        }
+        else
+        {
+            uint32 now = SysTick_GetTicks();
+            SysTick_TimerArm(&timer_legacy[index], milliseconds - (now % milliseconds), milliseconds);
+        }
     }
 }
+
+/*******************************************************************************
+* Function Name: SysTick_TimerInit
+********************************************************************************
+*
+* Summary:
+*  Prepares a software timer for use.  The callback, if any, runs from
+*  SysTick_Refresh() on every expiry; the expiry is also counted for
+*  SysTick_TimerExpired() either way.  New timers use SYSTICK_TIMER_CATCHUP.
+*
+* Parameters:
+*  timer: timer storage
+*  callback: expiry callback or NULL
+*  context: argument passed to the callback
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void SysTick_TimerInit(SysTick_Timer* timer, SysTick_TimerFn callback, void* context)
+{
+    memset(timer, 0, sizeof(*timer));
+    timer->callback = callback;
+    timer->context = context;
+}
+
+/*******************************************************************************
+* Function Name: SysTick_TimerArm
+********************************************************************************
+*
+* Summary:
+*  (Re)starts a software timer.  Arm and cancel are O(1) and must be called
+*  from the main loop, not from an interrupt.
+*
+* Parameters:
+*  timer: initialised timer
+*  delay: ticks until the first expiry
+*  period: ticks between further expiries, 0 for a one-shot timer
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void SysTick_TimerArm(SysTick_Timer* timer, uint32 delay, uint32 period)
+{
+    SysTick_TimerCancel(timer);
+    timer->pending = 0u;
+    timer->period = period;
+    timer->expires = SysTick_GetTicks() + delay;
+    SysTick_WheelInsert(timer);
+}
+
+void SysTick_TimerCancel(SysTick_Timer* timer)
+{
+    if (timer->pprev != NULL)
+    {
+        SysTick_WheelRemove(timer);
+    }
+}
+
+uint8 SysTick_TimerPending(const SysTick_Timer* timer)
+{
+    return ((timer->pprev != NULL) ? 1u : 0u);
+}
+
+/*******************************************************************************
+* Function Name: SysTick_TimerExpired
+********************************************************************************
+*
+* Summary:
+*  Consumes expiries of a flag delivered timer.  In catch-up mode one expiry
+*  is consumed per call, so a caller polling once per main loop pass still
+*  handles every one that was missed; in coalesce mode all are consumed and
+*  the surplus is added to the overrun count.
+*
+* Parameters:
+*  timer: timer to check
+*
+* Return:
+*  1 if an expiry was consumed, otherwise 0
+*
+*******************************************************************************/
+uint8 SysTick_TimerExpired(SysTick_Timer* timer)
+{
+    uint8 status = 0u;
+    uint8 pending = timer->pending;
+
+    if (pending != 0u)
+    {
+        status = 1u;
+        if (timer->mode == SYSTICK_TIMER_COALESCE)
+        {
+            timer->pending = 0u;
+            timer->overruns = ((timer->overruns + pending - 1u) > 0xFFFFu) ? 0xFFFFu : (uint16)(timer->overruns + pending - 1u);
+        }
+        else
+        {
+            timer->pending = pending - 1u;
+        }
+    }
+    return (status);
+}
+
+void SysTick_TimerSetMode(SysTick_Timer* timer, uint8 mode)
+{
+    timer->mode = mode;
+}
+
+void SysTick_TimerClearStats(SysTick_Timer* timer)
+{
+    timer->overruns = 0u;
+    timer->late_last = 0u;
+    timer->late_max = 0u;
+}
+
+/* Gives access to the statistics of the TIMER_ID_xxx flags */
+SysTick_Timer* SysTick_TimerGetLegacy(uint8 index)
+{
+    return ((index < TIMER_ID_LAST) ? &timer_legacy[index] : NULL);
+}
+
+/* Largest number of ticks a single SysTick_Refresh() call had to run; 1 means
+ * the main loop has always kept up. */
+uint32 SysTick_GetBacklogMax(void)
+{
+    return (timer_backlog_max);
+}
 /* [] END OF FILE */
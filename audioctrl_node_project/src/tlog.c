@@ -0,0 +1,64 @@
+/*******************************************************************************
+* FILE: tlog.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Target side of tokenized logging, see tlog.h.  A record is packed into
+* one frame and queued with a single SIO_Write(), so records from the main
+* loop and from interrupts never interleave on the wire.
+*******************************************************************************/
+#include "tlog.h"
+#include "sio_tx.h"
+
+/*******************************************************************************
+* Function Name: TLOG_Write
+********************************************************************************
+*
+* Summary:
+*  Queues one tokenized log record.  Normally reached through the TLOGn()
+*  macros rather than called directly.
+*
+* Parameters:
+*  id:    offset of the format string in .tlog_fmt
+*  nargs: number of argument words, at most TLOG_MAX_ARGS
+*  args:  argument words
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void TLOG_Write(uint16 id, uint8 nargs, const uint32* args)
+{
+    uint8 frame[3u + (4u * TLOG_MAX_ARGS)];
+    uint8* p = frame;
+    uint32 word;
+    uint8 i;
+
+    if (nargs > TLOG_MAX_ARGS)
+    {
+        nargs = TLOG_MAX_ARGS;
+    }
+
+    *p++ = TLOG_FRAME_MARK | nargs;
+    *p++ = (uint8)id;
+    *p++ = (uint8)(id >> 8);
+    for (i = 0u; i < nargs; i++)
+    {
+        word = args[i];
+        *p++ = (uint8)word;
+        *p++ = (uint8)(word >> 8);
+        *p++ = (uint8)(word >> 16);
+        *p++ = (uint8)(word >> 24);
+    }
+
+    (void)SIO_Write(frame, (uint16)(p - frame));
+}
+
+/* [] END OF FILE */
@@ -18,9 +18,17 @@
 #include "cytypes.h"
 #include "string.h"
 
-#include "i2c_psoc.h"
+#include "amp.h"
+#include "i2cq.h"
 #include "node.h"
 #include "slave_framework.h"
+#include "modlog.h"
+#include "pfail.h"
+#include "prof.h"
+#include "pstore.h"
+#include "sio_cmd.h"
+#include "sio_tx.h"
+#include "timer.h"
 #include "usr_impl.h"
 #include <project.h>
 
@@ -29,24 +37,42 @@
 static bool reset = false;
 
 // **** timers ****
-static uint16_t timer = 0;
+static SysTick_Timer sys_led_timer;
+static SysTick_Timer mod_timer;
 
 static uint32_t mod_index = 0;
-static uint32_t mod_timer = 0;
-static uint32_t update_timer = 0;
 
 static volatile uint8_t b_DisplayIsBusy = 0;
 static volatile uint8_t b_mod_timer_update = 0;
 
 static uint8_t b_ACN_Init = 1;
-uint32 I2CA = 0x20;
-uint8 I2CData[1];
+static cyisraddress usr_can_vector;
+static uint8 spkr_enabled = 0;
+static uint8 spkr_default = 1;         /* default of object 0x2600 not applied yet */
+
+#define USR_AMP_REG_OFF     (0x00u)
+#define USR_AMP_REG_ON      (0xFFu)
+
+static void USR_SysLedTimer(void* context);
+static void USR_ModTimer(void* context);
+
+/* A received frame is for the stack's main loop processing */
+static CY_ISR(USR_CanIsr)
+{
+    usr_can_vector();
+    SysTick_Wake();
+}
 
 /*************************************************************************
 **
-** Function    : USR_Main
+** Function    : USR_SPKR_Enable / USR_SPKR_Disable
 **
-** Description : Main loop usr function
+** Description : Switch the amplifier.  The register goes to the shadow in
+**               amp.c and is sent by the next flush, so these are safe
+**               from the SDO and PDO handlers and repeating a state costs
+**               no bus traffic.  Each switch write is a command to the
+**               amplifier, so the other one is forgotten: a change back is
+**               sent again and one still waiting for the flush is dropped.
 **
 ** Parameters  : -
 **
@@ -55,82 +81,146 @@ uint8 I2CData[1];
 *************************************************************************/
 void USR_SPKR_Enable(void)
 {
-    I2CData[0] = 0xFF;
-    //I2CData[1] = 0xFF;
-   // I2CData_on[2] = 0xFF;
-    I2C_Write(I2CA,0xFF,I2CData,1);
+    spkr_enabled = 1;
+    AMP_Write(USR_AMP_REG_ON, 0xFFu);
+    AMP_Invalidate(USR_AMP_REG_OFF);
 }
 void USR_SPKR_Disable(void)
 {
-    I2CData[0] = 0x00;
-  //  I2CData[1] = 0x00;
-  //  I2CData_on[2] = 0x00;
-    I2C_Write(I2CA,0,I2CData,1);
+    spkr_enabled = 0;
+    AMP_Write(USR_AMP_REG_OFF, 0x00u);
+    AMP_Invalidate(USR_AMP_REG_ON);
 }
+uint8 USR_SPKR_IsEnabled(void)
+{
+    return spkr_enabled;
+}
+
+/*************************************************************************
+**
+** Function    : USR_Main
+**
+** Description : Main loop usr function
+**
+** Parameters  : -
+**
+** Returnvalue : -
+**
+*************************************************************************/
 void USR_Main(void)
 {
     bool tx_pend;
+    PROF_ENTER(PROF_SITE_USR_MAIN);
     COP_CheckTransmissionInProgress(&tx_pend);
     if (reset && !tx_pend)
     {
+        /* Let queued I2C writes, a parameter store among them, finish */
+        I2CQ_Flush();
+        SIO_Flush();
         Bootloadable_Load();
     }
     if (b_ACN_Init)
     {
-        USR_SPKR_Enable();
         Str_Mon_Write(1);
         Amp_Shtdn_Write(1);
+        SysTick_TimerInit(&sys_led_timer, USR_SysLedTimer, NULL);
+        SysTick_TimerArm(&sys_led_timer, 500, 500);
+        SysTick_TimerInit(&mod_timer, USR_ModTimer, NULL);
+        SysTick_TimerArm(&mod_timer, MOD_FREQ, MOD_FREQ);
+#if (PROF_ENABLE)
+        PROF_Start();
+#endif
+        if (CyIntGetVector(CAN_ISR_NUMBER) != USR_CanIsr)
+        {
+            usr_can_vector = CyIntSetVector(CAN_ISR_NUMBER, USR_CanIsr);
+        }
         b_ACN_Init = 0;
     }
+    /* The speaker is on after reset, the YAML default of object 0x2600,
+     * unless a stored setting was restored */
+    if (spkr_default && (PSTORE_Status() != PSTORE_LOADING))
+    {
+        if (PSTORE_Status() != PSTORE_RESTORED)
+            USR_SPKR_Enable();
+        spkr_default = 0;
+    }
+    PFAIL_Service();
+    PSTORE_Service();
+    AMP_Flush();
+    I2CQ_Service();
+    SIO_Service();
+    /* Sleep time in SysTick_Idle() is not counted */
+    PROF_EXIT(PROF_SITE_USR_MAIN);
+    SysTick_Idle();
 }
 
 /*************************************************************************
 **
-** Function    : USR_Tick
+** Function    : USR_SysLedTimer
 **
-** Description : User level system callback for millisecond timer
+** Description : Blinks the system LED, runs every 500 ms
 **
-** Parameters  : None
+** Parameters  : context - unused
 **
 ** Returnvalue : -
 **
 *************************************************************************/
+static void USR_SysLedTimer(void* context)
+{
+  (void)context;
+  LED_SYS_Write(~LED_SYS_Read());
+}
 
-void USR_Tick(void)
-{ 
-  timer++;
-  if (timer == 500)
+/*************************************************************************
+**
+** Function    : USR_ModTimer
+**
+** Description : Advances the LED modulation index, runs every MOD_FREQ ms
+**
+** Parameters  : context - unused
+**
+** Returnvalue : -
+**
+*************************************************************************/
+static void USR_ModTimer(void* context)
+{
+  (void)context;
+  if( mod_timer.late_last != 0 )
   {
-    LED_SYS_Write(~LED_SYS_Read());
-    timer = 0;
+      MLOG1(MLOG_MOD_TIMER, MLOG_LVL_DEBUG, "mod timer late %u ms\r\n", mod_timer.late_last);
   }
-
-  mod_timer++;
-  if( mod_timer >= MOD_FREQ )
+  if( !b_DisplayIsBusy )
   {
-    if( !b_DisplayIsBusy )
-    {
-        b_mod_timer_update = 1;
-    }
-    mod_timer = 0;
-    mod_index++;
-    if( mod_index == MOD_PERIOD )
-    {
-        mod_index = 0;
-    }
+      b_mod_timer_update = 1;
   }
-   
-  update_timer++;
-  if( update_timer >= 80 )
+  mod_index++;
+  if( mod_index == MOD_PERIOD )
   {
-    update_timer = 0;
-    //USR_UpdateDisplay();
+      mod_index = 0;
   }
-   
+}
+
+/*************************************************************************
+**
+** Function    : USR_Tick
+**
+** Description : User level system callback for millisecond timer.  The
+**               periodic work lives in SysTick timers so it keeps running
+**               when the tick is stretched by tickless mode.
+**
+** Parameters  : None
+**
+** Returnvalue : -
+**
+*************************************************************************/
+
+void USR_Tick(void)
+{ 
 }
 
 bool USR_StartBootloader(void)
 {
+    MLOG0(MLOG_MOD_BOOT, MLOG_LVL_INFO, "bootloader requested\r\n");
     reset = true;
     
     return true;
@@ -0,0 +1,155 @@
+/*******************************************************************************
+* FILE: vol.c
+*
+* Version: 1.0
+*
+* Copyright 2016, Bossa Nova Robotics. All rights reserved.
+* This software is owned by Bossa Nova Robotics and is protected by and subject
+* to worldwide patent and copyright laws and treaties.
+*
+********************************************************************************
+*
+* DESCRIPTION:
+*     Speaker volume ramp, see vol.h.  The ramp runs in attenuation, so each
+* step is the same 0.5 dB whatever the level.
+*******************************************************************************/
+#include "amp.h"
+#include "timer.h"
+#include "vol.h"
+
+/* Gain of each attenuation in half dB, round(32768 * 10^(-k / 40)) */
+static const uint16 vol_gain_q15[VOL_ATTEN_MUTE] =
+{
+    32768u, 30935u, 29205u, 27571u, 26029u, 24573u, 23198u, 21900u,
+    20675u, 19519u, 18427u, 17396u, 16423u, 15504u, 14637u, 13818u,
+    13045u, 12315u, 11627u, 10976u, 10362u,  9783u,  9235u,  8719u,
+     8231u,  7771u,  7336u,  6925u,  6538u,  6172u,  5827u,  5501u,
+     5193u,  4903u,  4629u,  4370u,  4125u,  3894u,  3677u,  3471u,
+     3277u,  3093u,  2920u,  2757u,  2603u,  2457u,  2320u,  2190u,
+     2068u,  1952u,  1843u,  1740u,  1642u,  1550u,  1464u,  1382u,
+     1305u,  1232u,  1163u,  1098u,  1036u,   978u,   924u,   872u,
+      823u,   777u,   734u,   693u,   654u,   617u,   583u,   550u,
+      519u,   490u,   463u,   437u,   413u,   389u,   368u,   347u,
+      328u,   309u,   292u,   276u,   260u,   246u,   232u,   219u,
+      207u,   195u,   184u,   174u,   164u,   155u,   146u,   138u,
+      130u
+};
+
+static SysTick_Timer vol_timer;
+static uint8 vol_atten;             /* where the ramp is */
+static uint8 vol_target;
+
+/*******************************************************************************
+ * Volume 1..100 to attenuation 95..0, (100 - volume) * 0.96 rounded
+ * without a division; 0 mutes.
+ *******************************************************************************/
+static uint8 VOL_ToAtten(uint8 volume)
+{
+    if (volume == 0u)
+    {
+        return (VOL_ATTEN_MUTE);
+    }
+    if (volume > VOL_MAX)
+    {
+        volume = VOL_MAX;
+    }
+    return ((uint8)((((uint32)(VOL_MAX - volume) * 983u) + 512u) >> 10));
+}
+
+/*******************************************************************************
+ * Writes the gain of the current attenuation to the register shadow.
+ *******************************************************************************/
+static void VOL_Output(void)
+{
+    uint8 code = 0u;
+
+    if (vol_atten < VOL_ATTEN_MUTE)
+    {
+        code = (uint8)(((uint32)vol_gain_q15[vol_atten] * VOL_GAIN_MAX + 16384u) >> 15);
+    }
+    AMP_Write(VOL_AMP_REG, code);
+}
+
+/*******************************************************************************
+ * One ramp step, runs every VOL_RAMP_MS while the ramp is on.  Expiries
+ * missed by a late main loop are caught up, so the ramp keeps its speed.
+ *******************************************************************************/
+static void VOL_RampTimer(void* context)
+{
+    (void)context;
+    if (vol_atten < vol_target)
+    {
+        vol_atten = ((vol_target - vol_atten) > VOL_RAMP_STEP) ? (uint8)(vol_atten + VOL_RAMP_STEP) : vol_target;
+    }
+    else if (vol_atten > vol_target)
+    {
+        vol_atten = ((vol_atten - vol_target) > VOL_RAMP_STEP) ? (uint8)(vol_atten - VOL_RAMP_STEP) : vol_target;
+    }
+    VOL_Output();
+    if (vol_atten == vol_target)
+    {
+        SysTick_TimerCancel(&vol_timer);
+    }
+}
+
+/*******************************************************************************
+* Function Name: VOL_Start
+********************************************************************************
+*
+* Summary:
+*  Sets the amplifier to VOL_DEFAULT, the volume of object 0x2601 until a
+*  stored or commanded one arrives.  Call it after AMP_Start().
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void VOL_Start(void)
+{
+    SysTick_TimerInit(&vol_timer, VOL_RampTimer, NULL);
+    vol_atten = VOL_ToAtten(VOL_DEFAULT);
+    vol_target = vol_atten;
+    VOL_Output();
+}
+
+/*******************************************************************************
+* Function Name: VOL_Set
+********************************************************************************
+*
+* Summary:
+*  Sets the volume to ramp to.  A ramp that is running turns towards the new
+*  target from its current position.
+*
+* Parameters:
+*  volume: 0 (mute) .. VOL_MAX
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void VOL_Set(uint8 volume)
+{
+    vol_target = VOL_ToAtten(volume);
+    if ((vol_target != vol_atten) && !SysTick_TimerPending(&vol_timer))
+    {
+        SysTick_TimerArm(&vol_timer, VOL_RAMP_MS, VOL_RAMP_MS);
+    }
+}
+
+/*******************************************************************************
+ * Current attenuation in half dB, VOL_ATTEN_MUTE when muted.
+ *******************************************************************************/
+uint8 VOL_GetAtten(void)
+{
+    return (vol_atten);
+}
+
+uint8 VOL_Ramping(void)
+{
+    return (SysTick_TimerPending(&vol_timer));
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+################################################################################
+# FILE: cyacd_diff.py
+#
+# Version: 1.0
+#
+# Copyright 2016, Bossa Nova Robotics. All rights reserved.
+# This software is owned by Bossa Nova Robotics and is protected by and subject
+# to worldwide patent and copyright laws and treaties.
+#
+################################################################################
+#
+# DESCRIPTION:
+#     Delta update plan for the bootloader.  A row of the new image is
+# programmed only if the flash of the node holds something else: the plan
+# comes from the image installed on the node, or from the Row CRC command
+# (0x50) of bootloader.cydsn/bldr_impl.c, which returns the CRC-32 of each
+# row as the node has it.  The rows left are written as Program Row
+# packets, plain or packed by lz_pack.py, for one block download.
+#
+#     cyacd_diff.py old.cyacd new.cyacd                  plan from two images
+#     cyacd_diff.py old.cyacd new.cyacd -o rows.bin --lz
+#     cyacd_diff.py new.cyacd --requests req.bin         Row CRC commands
+#     cyacd_diff.py new.cyacd --crcs resp.bin -o rows.bin
+#
+# The Row CRC commands in req.bin go to the node one at a time; resp.bin is
+# the responses in the same order.
+################################################################################
+import argparse
+import struct
+import sys
+import zlib
+
+from lz_pack import CHECKSUM_SUM, SOP, EOP, checksum, compress, packet, program_row, read_cyacd
+
+CMD_ROW_CRC = 0x50
+CMD_BUFFER = 300                    # Bootloader_SIZEOF_COMMAND_BUFFER
+ROW_CRC_MAX = (CMD_BUFFER - 7) // 4
+
+
+def row_crc(data):
+    return zlib.crc32(data) & 0xFFFFFFFF
+
+
+def runs(rows):
+    """(array, first row, count) of consecutive rows, at most ROW_CRC_MAX
+    each."""
+    out = []
+    for array, row, _ in rows:
+        last = out[-1] if out else None
+        if last and last[0] == array and last[1] + last[2] == row and last[2] < ROW_CRC_MAX:
+            out[-1] = (array, last[1], last[2] + 1)
+        else:
+            out.append((array, row, 1))
+    return out
+
+
+def row_crc_requests(rows, kind=CHECKSUM_SUM):
+    return [packet(CMD_ROW_CRC, struct.pack('<BHB', array, first, count), kind)
+            for array, first, count in runs(rows)]
+
+
+def parse_row_crcs(rows, responses, kind=CHECKSUM_SUM):
+    """{(array, row): CRC} from the responses to row_crc_requests(rows)."""
+    crcs = {}
+    pos = 0
+    for array, first, count in runs(rows):
+        if pos + 7 > len(responses) or responses[pos] != SOP:
+            raise ValueError('responses end before the request for row %d' % first)
+        status, size = responses[pos + 1], struct.unpack_from('<H', responses, pos + 2)[0]
+        body = responses[pos:pos + 4 + size]
+        if struct.unpack_from('<H', responses, pos + 4 + size)[0] != checksum(body, kind) or \
+           responses[pos + 6 + size] != EOP:
+            raise ValueError('bad response packet for row %d' % first)
+        if status != 0 or size != 4 * count:
+            raise ValueError('row %d: status 0x%02X, %d bytes' % (first, status, size))
+        for i, crc in enumerate(struct.unpack_from('<%dI' % count, responses, pos + 4)):
+            crcs[(array, first + i)] = crc
+        pos += size + 7
+    return crcs
+
+
+def plan(rows, installed):
+    """Rows of the new image whose CRC differs from the installed one."""
+    return [r for r in rows if installed.get((r[0], r[1])) != row_crc(r[2])]
+
+
+def ranges(rows):
+    return ', '.join('%d:%d' % (a, f) if n == 1 else '%d:%d-%d' % (a, f, f + n - 1)
+                     for a, f, n in runs(rows))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Delta update plan for the bootloader')
+    parser.add_argument('images', nargs='+', metavar='image', help='[old.cyacd] new.cyacd')
+    parser.add_argument('--crcs', metavar='FILE', help='Row CRC responses of the node instead of the old image')
+    parser.add_argument('--requests', metavar='FILE', help='write the Row CRC commands for the new image')
+    parser.add_argument('-o', '--output', help='write the Program Row packets of the changed rows')
+    parser.add_argument('--lz', action='store_true', help='pack the output with lz_pack.py')
+    args = parser.parse_args()
+
+    old = args.images[0] if len(args.images) == 2 else None
+    if len(args.images) > 2 or (old and args.crcs) or not (old or args.crcs or args.requests):
+        sys.exit('give the old and the new image, or the new image and --crcs or --requests')
+    kind, rows = read_cyacd(args.images[-1])
+    if args.requests:
+        with open(args.requests, 'wb') as f:
+            f.write(b''.join(row_crc_requests(rows, kind)))
+        if not (old or args.crcs):
+            return 0
+
+    if args.crcs:
+        with open(args.crcs, 'rb') as f:
+            try:
+                installed = parse_row_crcs(rows, f.read(), kind)
+            except ValueError as e:
+                sys.exit(str(e))
+    else:
+        installed = {(a, r): row_crc(d) for a, r, d in read_cyacd(old)[1]}
+
+    changed = plan(rows, installed)
+    data = b''.join(program_row(a, r, d, kind) for a, r, d in changed)
+    print('%d of %d rows differ, %d bytes of packets' % (len(changed), len(rows), len(data)))
+    if changed:
+        print('rows ' + ranges(changed))
+    if args.output:
+        if args.lz and data:
+            packed = compress(data)
+            data = packed if len(packed) < len(data) else data
+        with open(args.output, 'wb') as f:
+            f.write(data)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,204 @@
+#!/usr/bin/env python3
+################################################################################
+# FILE: lz_pack.py
+#
+# Version: 1.0
+#
+# Copyright 2016, Bossa Nova Robotics. All rights reserved.
+# This software is owned by Bossa Nova Robotics and is protected by and subject
+# to worldwide patent and copyright laws and treaties.
+#
+################################################################################
+#
+# DESCRIPTION:
+#     Packer for compressed bootloader downloads.  The rows of a .cyacd image
+# become Program Row packets, with the packet checksum the image header
+# asks for, and the packets one LZSS stream in the format of
+# bootloader.cydsn/lzss.h.  The output is written to object 0x1F50 sub 1 in
+# one SDO block download; the bootloader decodes it into its command slots.
+# Every stream is decoded again before it is written, as the node would.
+# An image the packer cannot shrink, flag bytes included, is written plain;
+# the bootloader takes either.
+#
+#     lz_pack.py app.cyacd -o app.lzb            compressed stream
+#     lz_pack.py app.cyacd -o app.bin --plain    the same packets, plain
+#     lz_pack.py app.cyacd --window-bits 10      ratio only; the node must
+#                                                be built with that window
+################################################################################
+import argparse
+import sys
+
+MAGIC = 0x4C
+MIN_MATCH = 3
+WINDOW_BITS = 9                     # LZSS_WINDOW_BITS of the bootloader
+SEG_SIZE = 7
+
+SOP, EOP = 0x01, 0x17
+CMD_PROGRAM_ROW = 0x39
+CHECKSUM_SUM, CHECKSUM_CRC = 0, 1
+MAX_CHAIN = 64                      # match candidates tried per position
+
+
+def read_cyacd(path):
+    """Checksum type and rows (array, row, data) of a .cyacd image.  The
+    header is silicon ID, revision and checksum type; a row line is
+    :AARRRRLLLL<data>CC, big endian."""
+    with open(path) as f:
+        header = bytes.fromhex(f.readline().strip())
+        rows = []
+        for line in f:
+            line = line.strip()
+            if line.startswith(':'):
+                raw = bytes.fromhex(line[1:])
+                size = (raw[3] << 8) | raw[4]
+                rows.append((raw[0], (raw[1] << 8) | raw[2], raw[5:5 + size]))
+    return header[5], rows
+
+
+def checksum(packet, kind):
+    """Packet checksum of the Cypress bootloader."""
+    if kind == CHECKSUM_SUM:
+        return (1 + ~sum(packet)) & 0xFFFF
+    crc = 0xFFFF
+    for b in packet:
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x8408 if (crc ^ b) & 1 else crc >> 1
+            b >>= 1
+    crc = ~crc & 0xFFFF
+    return ((crc << 8) | (crc >> 8)) & 0xFFFF
+
+
+def packet(cmd, data, kind=CHECKSUM_SUM):
+    head = bytes([SOP, cmd, len(data) & 0xFF, len(data) >> 8]) + data
+    crc = checksum(head, kind)
+    return head + bytes([crc & 0xFF, crc >> 8, EOP])
+
+
+def program_row(array, row, data, kind=CHECKSUM_SUM):
+    return packet(CMD_PROGRAM_ROW, bytes([array, row & 0xFF, row >> 8]) + data, kind)
+
+
+def compress(data, bits=WINDOW_BITS):
+    """LZSS stream of data: greedy matching over hash chains, with one step
+    of lazy evaluation."""
+    window = 1 << bits
+    max_len = MIN_MATCH + (1 << (16 - bits)) - 1
+    chains = {}
+    items = []
+
+    def longest(pos):
+        best_len, best_dist = 0, 0
+        for cand in reversed(chains.get(data[pos:pos + MIN_MATCH], [])[-MAX_CHAIN:]):
+            dist = pos - cand
+            if dist > window:
+                break
+            n = 0
+            while n < max_len and pos + n < len(data) and data[cand + n] == data[pos + n]:
+                n += 1
+            if n > best_len:
+                best_len, best_dist = n, dist
+                if n == max_len:
+                    break
+        return (best_len, best_dist) if best_len >= MIN_MATCH else (0, 0)
+
+    def insert(pos):
+        if pos + MIN_MATCH <= len(data):
+            chains.setdefault(data[pos:pos + MIN_MATCH], []).append(pos)
+
+    pos = 0
+    while pos < len(data):
+        n, dist = longest(pos)
+        if n and pos + 1 < len(data):
+            insert(pos)
+            if longest(pos + 1)[0] > n:
+                items.append(data[pos])
+                pos += 1
+                continue
+            for p in range(pos + 1, pos + n):
+                insert(p)
+        elif n:
+            insert(pos)
+        if n:
+            items.append((dist, n))
+            pos += n
+        else:
+            insert(pos)
+            items.append(data[pos])
+            pos += 1
+
+    out = bytearray([MAGIC, bits])
+    for at in range(0, len(items), 8):
+        group = items[at:at + 8]
+        flags = sum(1 << i for i, item in enumerate(group) if isinstance(item, tuple))
+        out.append(flags)
+        for item in group:
+            if isinstance(item, tuple):
+                dist, n = item
+                out.append((dist - 1) & 0xFF)
+                out.append((((dist - 1) >> 8) << (16 - bits)) | (n - MIN_MATCH))
+            else:
+                out.append(item)
+    return bytes(out)
+
+
+def decompress(stream, window_bits=WINDOW_BITS):
+    """Decodes a stream as lzss.c does, with a window of 2^window_bits."""
+    if len(stream) < 2 or stream[0] != MAGIC or not 8 <= stream[1] <= window_bits:
+        raise ValueError('not a stream for a %d bit window' % window_bits)
+    len_bits = 16 - stream[1]
+    out = bytearray()
+    pos = 2
+    while pos < len(stream):
+        flags = stream[pos]
+        pos += 1
+        for i in range(8):
+            if pos >= len(stream):
+                break
+            if flags & (1 << i):
+                lo, hi = stream[pos], stream[pos + 1]
+                pos += 2
+                dist = (lo | ((hi >> len_bits) << 8)) + 1
+                for _ in range((hi & ((1 << len_bits) - 1)) + MIN_MATCH):
+                    out.append(out[-dist])
+            else:
+                out.append(stream[pos])
+                pos += 1
+    return bytes(out)
+
+
+def segments(size):
+    return (size + SEG_SIZE - 1) // SEG_SIZE
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Pack a .cyacd image for a compressed block download')
+    parser.add_argument('image', help='.cyacd image')
+    parser.add_argument('-o', '--output', help='stream to write')
+    parser.add_argument('--window-bits', type=int, default=WINDOW_BITS, help='8..12, LZSS_WINDOW_BITS')
+    parser.add_argument('--plain', action='store_true', help='write the packets uncompressed')
+    args = parser.parse_args()
+
+    if not 8 <= args.window_bits <= 12:
+        sys.exit('window bits must be in 8..12')
+    kind, rows = read_cyacd(args.image)
+    if kind not in (CHECKSUM_SUM, CHECKSUM_CRC):
+        sys.exit('unknown packet checksum type %d' % kind)
+    plain = b''.join(program_row(array, row, data, kind) for array, row, data in rows)
+    packed = compress(plain, args.window_bits)
+    if decompress(packed, args.window_bits) != plain:
+        sys.exit('internal error: the stream does not decode to the packets')
+    if len(packed) >= len(plain) and not args.plain:
+        print('no gain, the packets are written plain')
+        args.plain = True
+
+    print('%d rows, %d bytes of packets, %d bytes packed, ratio %.2f:1, %d segments instead of %d'
+          % (len(rows), len(plain), len(packed), len(plain) / float(len(packed)),
+             segments(len(packed)), segments(len(plain))))
+    if args.output:
+        with open(args.output, 'wb') as f:
+            f.write(plain if args.plain else packed)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
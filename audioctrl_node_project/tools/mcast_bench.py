@@ -0,0 +1,285 @@
+#!/usr/bin/env python3
+################################################################################
+# FILE: mcast_bench.py
+#
+# Version: 1.0
+#
+# Copyright 2016, Bossa Nova Robotics. All rights reserved.
+# This software is owned by Bossa Nova Robotics and is protected by and subject
+# to worldwide patent and copyright laws and treaties.
+#
+################################################################################
+#
+# DESCRIPTION:
+#     Simulated-bus benchmark of a fleet update with the multicast download
+# of bootloader.cydsn/mcast.h, on the bus model of sdo_bench.py.  Every
+# Program Row packet of the image is one unit, sent once to all nodes on
+# MCAST_COB_RX.  A node takes the frames of a row write into its receive
+# mailboxes; the frames beyond them are lost and the unit with them.  There
+# is no flow control, so the host paces the units to the row write of the
+# slowest node, letting the next unit fill half of the mailboxes meanwhile.
+#
+#     Then the host polls the acknowledge bitmaps, 32 units per answer, and
+# sends each node the rows it lacks alone, in one block download as the
+# stream mode of sdo_bench.py does.  The fleet time is compared with the
+# same stream sent to one node after the other, and with the bus bound of
+# streams to all nodes at once.
+#
+#     mcast_bench.py                          full image, 1 to 32 nodes
+#     mcast_bench.py app.cyacd --nodes 8 --loss 0.001
+#     mcast_bench.py --jitter 0.2 --mailboxes 8
+################################################################################
+import argparse
+import copy
+import random
+import sys
+
+from lz_pack import SEG_SIZE, program_row, read_cyacd
+from sdo_bench import COB_TX, FLASH_ROWS, ROW_SIZE, Bus, Link, frame, frame_bits, simulate, stream
+
+COB_MCAST = 0x680                   # MCAST_COB_RX
+SLOTS = 2
+STATUS_UNITS = 32
+MAX_UNITS = 1024                    # MCAST_MAX_UNITS
+NO_UNIT = 0xFFFF
+SESSION = 1
+
+START, UNIT, POLL, STATUS = 0x81, 0x82, 0x83, 0xE4
+
+
+class Node:
+    """mcast.c and the bldr_impl.c command slots of one node."""
+
+    def __init__(self, bus, node_id, args, rng):
+        self.bus = bus
+        self.node_id = node_id
+        self.args = args
+        self.rng = rng
+        self.stall = 0.0                # CPU held by a row write until
+        self.fifo = []
+        self.units = 0
+        self.session = None
+        self.acked = set()
+        self.queued = []                # units in the slots, not read yet
+        self.unit = None                # unit being received
+        self.seq = 0
+        self.nseg = 0
+        self.lost = 0                   # frames the mailboxes could not take
+        self.dropped = 0
+        self.replies = None             # STATUS answers go here
+
+    def rx(self, t, msg):
+        if self.rng.random() < self.args.loss:
+            self.lost += 1
+            return
+        if t < self.stall:
+            if len(self.fifo) < self.args.mailboxes:
+                self.fifo.append(msg)
+            else:
+                self.lost += 1
+            return
+        self.process(t, msg)
+        self.try_read(t)
+
+    def drop(self):
+        if self.unit is not None:
+            self.unit = None
+            self.dropped += 1
+
+    def process(self, t, msg):
+        if msg[0] == START:
+            self.drop()
+            self.units, self.session = msg[1], msg[2]
+            self.acked = set()
+            if self.units > self.args.max_units:
+                # Too many units to track: the node stays out of the session
+                self.session = None
+        elif msg[0] == UNIT:
+            self.drop()
+            if self.session is not None and msg[1] < self.units and msg[1] not in self.acked:
+                self.unit, self.nseg, self.seq = msg[1], msg[2], 0
+        elif msg[0] == POLL:
+            self.status(t, msg[1], msg[2])
+        elif self.unit is not None:
+            # The first byte of a unit takes the fill slot, if it is free
+            if msg[1] != self.seq + 1 or (self.seq == 0 and len(self.queued) >= SLOTS):
+                self.drop()
+                return
+            self.seq += 1
+            if self.seq == self.nseg:
+                self.queued.append(self.unit)
+                self.unit = None
+
+    def status(self, t, first, session):
+        unit, bits = first, 0
+        if session == self.session:
+            while unit < self.units and unit in self.acked:
+                unit += 1
+            if unit < self.units:
+                for i in range(min(STATUS_UNITS, self.units - unit)):
+                    bits |= (unit + i in self.acked) << i
+            else:
+                unit = NO_UNIT
+        data = frame(STATUS, unit & 0xFF, unit >> 8, bits & 0xFF, (bits >> 8) & 0xFF,
+                     (bits >> 16) & 0xFF, bits >> 24, len(self.queued))
+        reply = (self.node_id, unit, bits, len(self.queued))
+        self.bus.send(t + self.args.node_us * 1e-6, COB_TX + self.node_id, data,
+                      lambda t: self.replies.append(reply))
+
+    def try_read(self, t):
+        if t < self.stall or not self.queued:
+            return
+        unit = self.queued.pop(0)
+        self.stall = t + self.args.flash_ms * 1e-3 * (1.0 + self.rng.uniform(0.0, self.args.jitter))
+        self.bus.at(self.stall, lambda t: self.resume(t, unit))
+
+    def resume(self, t, unit):
+        self.acked.add(unit)
+        fifo, self.fifo = self.fifo, []
+        for msg in fifo:
+            self.process(t, msg)
+        self.try_read(t)
+
+    def idle(self):
+        return not self.queued and self.bus.t >= self.stall
+
+
+def host_send(bus, nodes, msg, data):
+    bus.send(bus.t, COB_MCAST, data, lambda t: [node.rx(t, msg) for node in nodes])
+
+
+def send_unit(bus, nodes, unit, packet):
+    count = (len(packet) + SEG_SIZE - 1) // SEG_SIZE
+    host_send(bus, nodes, (UNIT, unit, count), frame(UNIT, unit & 0xFF, unit >> 8, len(packet) & 0xFF,
+                                                     len(packet) >> 8, 0x12, 0x34))
+    for i in range(count):
+        chunk = packet[i * SEG_SIZE:(i + 1) * SEG_SIZE]
+        host_send(bus, nodes, ('seg', i + 1), bytes([i + 1]) + chunk + bytes(SEG_SIZE - len(chunk)))
+
+
+def pace(packets, args):
+    """Gap between the units: a row write of the slowest node and the frames
+    of a unit, less the frames half of the mailboxes keep meanwhile.  The
+    frames of a unit may come back to back, at the full bit rate."""
+    frames = (len(max(packets, key=len)) + SEG_SIZE - 1) // SEG_SIZE + 1
+    frame_s = frame_bits(COB_MCAST, bytes(range(8))) / float(args.bitrate)
+    return (args.flash_ms * 1e-3 * (1.0 + args.jitter) + frames * frame_s / (1.0 - args.load) -
+            args.mailboxes // 2 * frame_s)
+
+
+def poll(bus, nodes, units, args):
+    """Missing units of each node, from as many POLL rounds as the bitmaps
+    need.  A node that has not answered by --poll-ms is polled again."""
+    missing = {node.node_id: set() for node in nodes}
+    first, polls = 0, 0
+    while first != NO_UNIT:
+        replies = []
+        for node in nodes:
+            node.replies = replies
+        bus.t += args.host_us * 1e-6
+        deadline = bus.t + args.poll_ms * 1e-3
+        host_send(bus, nodes, (POLL, first, SESSION), frame(POLL, first & 0xFF, first >> 8, SESSION))
+        bus.run(lambda: len(set(r[0] for r in replies)) == len(nodes) or bus.t >= deadline)
+        polls += 1
+        answers = dict((r[0], r) for r in replies)
+        if len(answers) < len(nodes) or any(r[3] for r in answers.values()):
+            # A node has not written all the units yet: ask again after a write
+            bus.t = max(bus.t, deadline) if len(answers) < len(nodes) else \
+                bus.t + args.flash_ms * 1e-3 * (1.0 + args.jitter)
+            continue
+        nxt = NO_UNIT
+        for node_id, unit, bits, _ in answers.values():
+            if unit == NO_UNIT:
+                continue
+            count = min(STATUS_UNITS, units - unit)
+            missing[node_id].update(unit + i for i in range(count) if not bits & (1 << i))
+            if unit + count < units:
+                nxt = min(nxt, unit + count)
+        first = nxt
+    return missing, polls
+
+
+def fleet(rows, args, count):
+    rng = random.Random(args.seed)
+    bus = Bus(args.bitrate, args.load, rng)
+    nodes = [Node(bus, args.node + i, args, random.Random(args.seed * 1000 + i)) for i in range(count)]
+    packets = [program_row(*row) for row in rows]
+    gap = pace(packets, args)
+
+    bus.t += args.host_us * 1e-6
+    host_send(bus, nodes, (START, len(packets), SESSION),
+              frame(START, len(packets) & 0xFF, len(packets) >> 8, SESSION))
+    start = bus.t
+    for unit, packet in enumerate(packets):
+        bus.at(start + unit * gap, lambda t, u=unit, p=packet: send_unit(bus, nodes, u, p))
+    bus.run(lambda: not bus.timers and not bus.sdo_pending() and all(node.idle() for node in nodes))
+    mcast_t = bus.t
+
+    missing, polls = poll(bus, nodes, len(packets), args)
+    poll_t = bus.t - mcast_t
+    resent = 0
+    for node in nodes:
+        if missing[node.node_id]:
+            node_args = copy.copy(args)
+            node_args.node = node.node_id
+            link = Link(bus, node.node_id, args.host_us, args.node_us, args.loop_us)
+            stream([rows[u] for u in sorted(missing[node.node_id])], node_args, bus, link)
+            resent += len(missing[node.node_id])
+    return {'time': bus.t, 'mcast': mcast_t, 'poll': poll_t, 'polls': polls, 'resent': resent,
+            'lost': sum(node.lost for node in nodes), 'bus': bus}
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Multicast fleet update against unicast streams')
+    parser.add_argument('image', nargs='?', help='.cyacd image (default: a full CY8C4247 image)')
+    parser.add_argument('--rows', type=int, default=FLASH_ROWS, help='rows without an image')
+    parser.add_argument('--nodes', default='1,2,4,8,16,32', help='fleet sizes')
+    parser.add_argument('--bitrate', type=int, default=500000)
+    parser.add_argument('--load', type=float, default=0.3, help='background bus load, 0..1')
+    parser.add_argument('--host-us', type=float, default=1000.0, help='host adapter turnaround')
+    parser.add_argument('--node-us', type=float, default=200.0, help='node turnaround')
+    parser.add_argument('--loop-us', type=float, default=20.0, help='node gap between upload segments')
+    parser.add_argument('--flash-ms', type=float, default=20.0, help='row erase and program')
+    parser.add_argument('--jitter', type=float, default=0.05, help='row write spread between nodes, 0..1')
+    parser.add_argument('--loss', type=float, default=0.0005, help='chance a node misses a frame')
+    parser.add_argument('--poll-ms', type=float, default=50.0, help='host wait for the STATUS answers')
+    parser.add_argument('--blksize', type=int, default=16, help='SDOB_BLKSIZE of the unicast stream')
+    parser.add_argument('--mailboxes', type=int, default=16, help='RX mailboxes of a node')
+    parser.add_argument('--max-units', type=int, default=MAX_UNITS, help='MCAST_MAX_UNITS of a node')
+    parser.add_argument('--node', type=int, default=1, help='node-ID of the first node')
+    parser.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+
+    if not 0.0 <= args.load < 1.0:
+        sys.exit('load must be in 0..1')
+    if not 0.0 <= args.jitter <= 1.0 or not 0.0 <= args.loss < 1.0:
+        sys.exit('jitter and loss must be in 0..1')
+    if args.blksize > args.mailboxes:
+        sys.exit('a block larger than the mailboxes loses frames while a row is written')
+    rng = random.Random(args.seed)
+    if args.image:
+        rows = read_cyacd(args.image)[1]
+    else:
+        rows = [(0, n, bytes(rng.getrandbits(8) for _ in range(ROW_SIZE))) for n in range(args.rows)]
+
+    one = simulate('stream', rows, args)
+    one_t = one.t
+    one_s = one.bits['sdo'] / float(args.bitrate)
+
+    print('%d rows, %d kbit/s, %.0f%% background, row write %.0f ms +%.0f%%, loss %g, %d mailboxes'
+          % (len(rows), args.bitrate // 1000, args.load * 100, args.flash_ms, args.jitter * 100,
+             args.loss, args.mailboxes))
+    print('one node, unicast stream: %.2f s' % one_t)
+    print('%6s %9s %8s %6s %7s %9s %11s %11s %8s' % ('nodes', 'fleet s', 'mcast s', 'polls', 'resent',
+                                                     'lost', 'one by one', 'all at once', 'speedup'))
+    for count in [int(n) for n in args.nodes.split(',')]:
+        r = fleet(rows, args, count)
+        serial = count * one_t
+        parallel = max(one_t, count * one_s / (1.0 - args.load))
+        print('%6d %9.2f %8.2f %6d %7d %9d %11.2f %11.2f %7.2fx'
+              % (count, r['time'], r['mcast'], r['polls'], r['resent'], r['lost'], serial, parallel,
+                 serial / r['time']))
+
+
+if __name__ == '__main__':
+    main()
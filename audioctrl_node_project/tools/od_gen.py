@@ -0,0 +1,392 @@
+#!/usr/bin/env python3
+################################################################################
+# FILE: od_gen.py
+#
+# Version: 1.0
+#
+# Copyright 2016, Bossa Nova Robotics. All rights reserved.
+# This software is owned by Bossa Nova Robotics and is protected by and subject
+# to worldwide patent and copyright laws and treaties.
+#
+################################################################################
+#
+# DESCRIPTION:
+#     Generates the application side of the object dictionary from
+# config/slave_node.yaml: a const table of every index/subindex with a dense
+# index to table slot map for O(1) lookup, the RAM copy of the values that
+# have no refresh handler, the default handler registrations
+# (src/od_table.c) and the typed handler prototypes the application
+# implements (inc/od_table.h).  See inc/od.h for the access rules.
+#
+#     tools/od_gen.py [--config inc/proj.h] [-D NAME=VALUE]
+#                     config/slave_node.yaml inc/od_table.h src/od_table.c
+#
+# Per object keys used here, besides those of the slave framework:
+#     handlers: any of validate, apply, refresh.  validate may reject a value
+#               before it is written, apply acts on it afterwards and
+#               refresh supplies the value for a read.  Objects without
+#               refresh are stored in RAM.
+#     min/max:  range accepted by writes, defaults to the range of the type.
+#     persist:  true to keep the value in the parameter store (src/pstore.c),
+#               plain objects only.
+#     condition: name of a build switch; the object is left out when it is
+#               0 or not defined.  The switches are read from the integer
+#               #defines of the --config header and -D, and od_table.h stops
+#               a build whose switches differ from those it was made with.
+# A PDO write reaches the application only as a memory index; the entries
+# that are PDO mappable and have an apply handler are counted in
+# OD_PDO_APPLY_COUNT for the application's rescan of the stack storage.
+# A RECORD lists its entries under subindexes, numbered from 1 without gaps;
+# its handlers take the subindex.  Objects of the communication profile area
+# (below 0x2000) are found through a short list, the others through the
+# dense slot map.
+################################################################################
+import argparse
+import re
+import sys
+
+try:
+    import yaml
+except ImportError:
+    sys.stderr.write('od_gen.py needs PyYAML (pip install pyyaml)\n')
+    sys.exit(2)
+
+# type: (C type, size, min, max)
+TYPES = {
+    'BOOLEAN': ('uint8', 1, 0, 1),
+    'UINT8': ('uint8', 1, 0, 0xFF),
+    'UINT16': ('uint16', 2, 0, 0xFFFF),
+    'UINT32': ('uint32', 4, 0, 0xFFFFFFFF),
+    'INT8': ('int8', 1, -0x80, 0x7F),
+    'INT16': ('int16', 2, -0x8000, 0x7FFF),
+    'INT32': ('int32', 4, -0x80000000, 0x7FFFFFFF),
+}
+
+ACCESS = {
+    'READ_ONLY': 'OD_ACCESS_RO',
+    'WRITE_ONLY': 'OD_ACCESS_WO',
+    'READ_WRITE': 'OD_ACCESS_RW',
+    'CONST': 'OD_ACCESS_RO | OD_ACCESS_CONST',
+}
+
+HANDLERS = ('validate', 'apply', 'refresh')
+NO_SLOT = 0xFF
+MANUFACTURER_FIRST = 0x2000
+
+
+class Object(object):
+    def __init__(self, number, spec):
+        self.number = number
+        self.name = spec['name']
+        self.index = spec['index']
+        self.record = spec.get('type') == 'RECORD'
+        self.ctype = None if self.record else TYPES[spec.get('type', 'UINT8')][0]
+        self.handlers = spec.get('handlers') or []
+        for h in self.handlers:
+            if h not in HANDLERS:
+                raise ValueError('%s: unknown handler %s' % (self.name, h))
+        self.persist = bool(spec.get('persist', False))
+        if self.persist and self.record:
+            raise ValueError('%s: a RECORD cannot persist' % self.name)
+        self.size = None if self.record else TYPES[spec.get('type', 'UINT8')][1]
+        self.condition = spec.get('condition')
+        if self.condition and self.persist:
+            raise ValueError('%s: a conditional object cannot persist' % self.name)
+
+
+class Entry(object):
+    def __init__(self, obj, subindex, spec, const=False):
+        self.obj = obj
+        self.subindex = subindex
+        self.type = spec.get('type', 'UINT8')
+        if self.type not in TYPES:
+            raise ValueError('0x%04X.%d: unsupported type %s' % (obj.index, subindex, self.type))
+        self.ctype, self.size, lo, hi = TYPES[self.type]
+        self.access = ACCESS[spec.get('access', 'READ_WRITE')]
+        self.low = spec.get('min', lo)
+        self.high = spec.get('max', hi)
+        self.value = spec.get('value', 0)
+        self.const = const or spec.get('access') == 'CONST'
+        self.pdo_apply = spec.get('pdo_mappable', 'NO_PDO') != 'NO_PDO' and 'apply' in obj.handlers
+        self.ram = None
+        if not self.const and 'refresh' not in obj.handlers:
+            self.ram = '%s_%d' % (obj.name, subindex) if obj.record else obj.name
+
+
+def c_int(v):
+    if v < 0:
+        return '(uint32)(%d)' % v
+    return '0x%Xu' % v
+
+
+def read_config(path, defines):
+    """Integer #defines of a header, as a C preprocessor #if would see them."""
+    with open(path) as f:
+        for line in f:
+            m = re.match(r'\s*#\s*define\s+(\w+)\s+\(?\s*(0x[0-9A-Fa-f]+|\d+)u?\s*\)?\s*(/[*/].*)?$', line)
+            if m:
+                defines[m.group(1)] = int(m.group(2), 0)
+
+
+def load(path, defines):
+    with open(path) as f:
+        node = yaml.safe_load(f)['slave_node']
+    objects = []
+    entries = []
+    conditions = {}
+    for spec in node['objects']:
+        if spec.get('condition'):
+            conditions[spec['condition']] = 1 if defines.get(spec['condition'], 0) else 0
+    specs = [o for o in node['objects'] if not o.get('condition') or conditions[o['condition']]]
+    for spec in sorted(specs, key=lambda o: o['index']):
+        obj = Object(len(objects), spec)
+        if objects and objects[-1].index == obj.index:
+            raise ValueError('0x%04X defined twice' % obj.index)
+        objects.append(obj)
+        if obj.record:
+            subs = spec['subindexes']
+            if [s['subindex'] for s in subs] != list(range(1, len(subs) + 1)):
+                raise ValueError('%s: subindexes must be numbered 1..n' % obj.name)
+            entries.append(Entry(obj, 0, {'type': 'UINT8', 'access': 'CONST', 'value': len(subs)}, True))
+            entries.extend(Entry(obj, s['subindex'], s) for s in subs)
+        else:
+            entries.append(Entry(obj, 0, spec))
+    if len(entries) >= NO_SLOT:
+        raise ValueError('more than %d entries, widen od_slot[]' % (NO_SLOT - 1))
+    if not [o for o in objects if o.index >= MANUFACTURER_FIRST]:
+        raise ValueError('no object at 0x%04X or above' % MANUFACTURER_FIRST)
+    return node, objects, entries, conditions
+
+
+def persist_layout(objects):
+    """8 bit signature of the persistent set, never 0."""
+    h = 0
+    for o in objects:
+        if o.persist:
+            for b in (o.index & 0xFF, o.index >> 8, o.size):
+                h = ((h << 1) | (h >> 7)) & 0xFF
+                h ^= b
+    return h or 1
+
+
+def banner(out, name, lines):
+    out.append('/' + '*' * 79)
+    out.append('* FILE: %s' % name)
+    out.append('*')
+    out.append('* Generated by tools/od_gen.py from config/slave_node.yaml, do not edit.')
+    out.append('*' * 80)
+    out.append('*')
+    out.append('* DESCRIPTION:')
+    out.extend(lines)
+    out.append('*' * 79 + '/')
+
+
+def prototypes(obj):
+    if obj.record:
+        args = {'validate': 'uint8 subindex, uint32 value', 'apply': 'uint8 subindex, uint32 value',
+                'refresh': 'uint8 subindex, uint32* value'}
+    else:
+        args = {'validate': '%s value' % obj.ctype, 'apply': '%s value' % obj.ctype,
+                'refresh': '%s* value' % obj.ctype}
+    ret = {'validate': 'uint8', 'apply': 'void', 'refresh': 'uint8'}
+    return [(h, '%s OD_%s_%s(%s)' % (ret[h], h.capitalize(), obj.name, args[h]))
+            for h in HANDLERS if h in obj.handlers]
+
+
+def header(node, objects, entries, conditions):
+    out = ['#ifndef _OD_TABLE_H_', '#define _OD_TABLE_H_']
+    banner(out, 'od_table.h', ['*   Object indices and the typed handlers of %s.' % node.get('printed_name', node['name'])])
+    out.append('#include "od.h"')
+    out.append('')
+    if conditions:
+        out.append('#ifdef USE_PROJECT_HEADER')
+        out.append('    #include "proj.h"')
+        out.append('#endif')
+        out.append('')
+        out.append('/* Build switches of the conditional objects, as generated */')
+        for name in sorted(conditions):
+            out.append('#if (((%s) ? 1 : 0) != %d)' % (name, conditions[name]))
+            out.append('    #error "od_table.h was generated for %s %d, run make od"' % (name, conditions[name]))
+            out.append('#endif')
+        out.append('')
+    out.append('/* Object indices */')
+    for obj in objects:
+        out.append('#define OD_IDX_%-28s (0x%04Xu)' % (obj.name.upper(), obj.index))
+    out.append('')
+    manufacturer = [o for o in objects if o.index >= MANUFACTURER_FIRST]
+    persist = [o for o in objects if o.persist]
+    out.append('#define OD_INDEX_FIRST                     (0x%04Xu)' % manufacturer[0].index)
+    out.append('#define OD_INDEX_LAST                      (0x%04Xu)' % manufacturer[-1].index)
+    out.append('#define OD_OBJECT_COUNT                    (%du)' % len(objects))
+    out.append('#define OD_TABLE_SIZE                      (%du)' % len(entries))
+    out.append('#define OD_COMM_COUNT                      (%du)' % (len(objects) - len(manufacturer)))
+    out.append('#define OD_NO_SLOT                         (0x%02Xu)' % NO_SLOT)
+    out.append('#define OD_PDO_APPLY_COUNT                 (%du)' % len([e for e in entries if e.pdo_apply]))
+    out.append('')
+    out.append('/* Parameter store: objects, bytes of their values, layout signature */')
+    out.append('#define OD_PERSIST_COUNT                   (%du)' % len(persist))
+    out.append('#define OD_PERSIST_SIZE                    (%du)' % sum(o.size for o in persist))
+    out.append('#define OD_PERSIST_LAYOUT                  (0x%02Xu)' % persist_layout(objects))
+    out.append('')
+    out.append('/* Default handlers, implemented by the application.  validate and')
+    out.append(' * refresh return OD_xxx; validate only sees values in the object\'s')
+    out.append(' * range. */')
+    for obj in objects:
+        for h, proto in prototypes(obj):
+            out.append(proto + ';')
+    out.append('')
+    out.append('#endif')
+    out.append('')
+    out.append('/* [] END OF FILE */')
+    return '\n'.join(out) + '\n'
+
+
+def source(node, objects, entries):
+    out = []
+    banner(out, 'od_table.c', [
+        '*     Object dictionary of %s: entries in index and subindex' % node.get('printed_name', node['name']),
+        '* order, the slot of each index in the table, and the RAM copy of the',
+        '* values that have no refresh handler.'])
+    out.append('#include "od_table.h"')
+    out.append('')
+
+    ram = [e for e in entries if e.ram]
+    if ram:
+        out.append('/* Values stored here, initialised from the YAML defaults */')
+        out.append('static struct')
+        out.append('{')
+        for e in ram:
+            out.append('    %s %s;' % (e.ctype, e.ram))
+        out.append('} od_values =')
+        out.append('{')
+        out.append(',\n'.join('    %s' % c_int(e.value) for e in ram))
+        out.append('};')
+        out.append('')
+
+    # Thunks from the generic handler signatures to the typed ones
+    for obj in objects:
+        if not obj.handlers:
+            continue
+        for h in HANDLERS:
+            # record handlers already have the generic signature
+            if obj.record or h not in obj.handlers:
+                continue
+            if h == 'validate':
+                out.append('static uint8 od_validate_%s(uint8 subindex, uint32 value)' % obj.name)
+                out.append('{')
+                out.append('    (void)subindex;')
+                out.append('    return (OD_Validate_%s((%s)value));' % (obj.name, obj.ctype))
+                out.append('}')
+            elif h == 'apply':
+                out.append('static void od_apply_%s(uint8 subindex, uint32 value)' % obj.name)
+                out.append('{')
+                out.append('    (void)subindex;')
+                out.append('    OD_Apply_%s((%s)value);' % (obj.name, obj.ctype))
+                out.append('}')
+            else:
+                out.append('static uint8 od_refresh_%s(uint8 subindex, uint32* value)' % obj.name)
+                out.append('{')
+                out.append('    %s v;' % obj.ctype)
+                out.append('    uint8 result = OD_Refresh_%s(&v);' % obj.name)
+                out.append('')
+                out.append('    (void)subindex;')
+                out.append('    *value = (uint32)v;')
+                out.append('    return (result);')
+                out.append('}')
+            out.append('')
+        fn = {}
+        for h in HANDLERS:
+            if h not in obj.handlers:
+                fn[h] = 'NULL'
+            elif obj.record:
+                fn[h] = 'OD_%s_%s' % (h.capitalize(), obj.name)
+            else:
+                fn[h] = 'od_%s_%s' % (h, obj.name)
+        out.append('static const OD_Handlers od_handlers_%s = { %s, %s, %s };' % (
+            obj.name, fn['validate'], fn['apply'], fn['refresh']))
+        out.append('')
+
+    out.append('/* Handlers of each object, OD_Register() replaces them */')
+    out.append('const OD_Handlers* od_handlers[OD_OBJECT_COUNT] =')
+    out.append('{')
+    out.append(',\n'.join('    %s' % (('&od_handlers_%s' % o.name) if o.handlers else 'NULL') for o in objects))
+    out.append('};')
+    out.append('')
+
+    out.append('const OD_Entry od_table[OD_TABLE_SIZE] =')
+    out.append('{')
+    rows = []
+    for e in entries:
+        data = ('&od_values.%s' % e.ram) if e.ram else 'NULL'
+        rows.append('    { 0x%04Xu, %2du, OD_TYPE_%s, %s, %du, %du, %s, %s, %s, %s }' % (
+            e.obj.index, e.subindex, e.type, e.access, e.size, e.obj.number, c_int(e.low), c_int(e.high),
+            c_int(e.value) if e.const else '0u', data))
+    out.append(',\n'.join(rows))
+    out.append('};')
+    out.append('')
+
+    comm = [(e.obj.index, pos) for pos, e in enumerate(entries)
+            if e.subindex == 0 and e.obj.index < MANUFACTURER_FIRST]
+    if comm:
+        out.append('/* Table slot of the communication profile objects */')
+        out.append('const OD_CommSlot od_comm_slot[OD_COMM_COUNT] =')
+        out.append('{')
+        out.append(',\n'.join('    { 0x%04Xu, 0x%02Xu }' % c for c in comm))
+        out.append('};')
+        out.append('')
+
+    persist = [o for o in objects if o.persist]
+    if persist:
+        out.append('/* Objects kept by the parameter store, in record order */')
+        out.append('const OD_Persist od_persist[OD_PERSIST_COUNT] =')
+        out.append('{')
+        out.append(',\n'.join('    { 0x%04Xu, %du }' % (o.index, o.size) for o in persist))
+        out.append('};')
+        out.append('')
+
+    first = min(o.index for o in objects if o.index >= MANUFACTURER_FIRST)
+    slots = [NO_SLOT] * (objects[-1].index - first + 1)
+    for pos, e in enumerate(entries):
+        if e.subindex == 0 and e.obj.index >= MANUFACTURER_FIRST:
+            slots[e.obj.index - first] = pos
+    out.append('/* Table slot of subindex 0 of each index from OD_INDEX_FIRST */')
+    out.append('const uint8 od_slot[OD_INDEX_LAST - OD_INDEX_FIRST + 1u] =')
+    out.append('{')
+    lines = []
+    for i in range(0, len(slots), 8):
+        lines.append('    ' + ', '.join('0x%02Xu' % v for v in slots[i:i + 8]))
+    out.append(',\n'.join(lines))
+    out.append('};')
+    out.append('')
+    out.append('/* [] END OF FILE */')
+    return '\n'.join(out) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate the object dictionary tables')
+    parser.add_argument('yaml', help='slave node description')
+    parser.add_argument('header', help='output header, e.g. inc/od_table.h')
+    parser.add_argument('source', help='output source, e.g. src/od_table.c')
+    parser.add_argument('--config', action='append', default=[],
+                        help='header whose integer #defines set the conditions, e.g. inc/proj.h')
+    parser.add_argument('-D', dest='define', action='append', default=[], metavar='NAME=VALUE',
+                        help='set a condition, after the --config headers')
+    args = parser.parse_args()
+
+    defines = {}
+    for path in args.config:
+        read_config(path, defines)
+    for d in args.define:
+        name, _, value = d.partition('=')
+        defines[name] = int(value or '1', 0)
+
+    node, objects, entries, conditions = load(args.yaml, defines)
+    with open(args.header, 'w') as f:
+        f.write(header(node, objects, entries, conditions))
+    with open(args.source, 'w') as f:
+        f.write(source(node, objects, entries))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
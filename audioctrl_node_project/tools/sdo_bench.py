@@ -0,0 +1,545 @@
+#!/usr/bin/env python3
+################################################################################
+# FILE: sdo_bench.py
+#
+# Version: 1.0
+#
+# Copyright 2016, Bossa Nova Robotics. All rights reserved.
+# This software is owned by Bossa Nova Robotics and is protected by and subject
+# to worldwide patent and copyright laws and treaties.
+#
+################################################################################
+#
+# DESCRIPTION:
+#     Simulated-bus benchmark of a bootloader image download over SDO.  Every
+# row of the image is one Program Row command written to object 0x1F50 and
+# its response read back, with segmented SDO (the stack) or with block SDO
+# (bootloader.cydsn/sdo_block.c).  The bus model arbitrates by identifier
+# and counts every bit of a frame, stuff bits included, against background
+# traffic of higher priority at the given load.  The host adapter and the
+# node add their turnaround before each reply; the node answers the upload
+# of a Program Row response only once the row is written.
+#
+#     The stream mode sends the whole image as one block download into the
+# two command slots of bldr_impl.c and reads the last response at the end.
+# A row write holds the node CPU; frames arriving meanwhile wait in up to
+# --mailboxes receive mailboxes and are taken when the write is done.  The
+# stream-lz mode sends the packets packed by lz_pack.py through the decoder
+# input of bootloader.cydsn/lzss.c instead, or plain if packing does not
+# shrink them, as lz_pack.py does.  Downloads in every block mode use
+# --blksize, so compare the modes from one run: a block figure taken at
+# another block size is not the same transfer.
+#
+#     With --base, or --changed for the random image, the node already has
+# an image: the host first reads the CRC of every row with the Row CRC
+# command and then writes only the rows cyacd_diff.py finds different.
+#
+#     sdo_bench.py                          full CY8C4247 image, defaults
+#     sdo_bench.py app.cyacd --load 0.4     rows of an image, busier bus
+#     sdo_bench.py --rows 256 --host-us 2000 --bitrate 250000
+#     sdo_bench.py new.cyacd --base old.cyacd   delta update
+################################################################################
+import argparse
+import random
+import sys
+
+from cyacd_diff import CMD_ROW_CRC, plan, row_crc, runs
+from lz_pack import MIN_MATCH, compress, packet, program_row, read_cyacd
+
+ROW_SIZE = 128
+FLASH_ROWS = 1024                   # CY8C4247, 128 KB
+CMD_BUFFER = 300                    # Bootloader_SIZEOF_COMMAND_BUFFER
+LZ_INPUT = 256                      # LZSS_INPUT_SIZE
+ROW_CRC_US = 50                     # node time to CRC one row
+SEG_SIZE = 7
+COB_RX = 0x600                      # host to node
+COB_TX = 0x580                      # node to host
+
+HOST, NODE = 0, 1
+
+
+def crc15(bits):
+    """CAN CRC over a bit list."""
+    crc = 0
+    for b in bits:
+        top = ((crc >> 14) & 1) ^ b
+        crc = (crc << 1) & 0x7FFF
+        if top:
+            crc ^= 0x4599
+    return crc
+
+
+def frame_bits(can_id, data):
+    """Bits of a standard data frame on the wire, intermission included."""
+    bits = [0]
+    bits += [(can_id >> (10 - i)) & 1 for i in range(11)]
+    bits += [0, 0, 0]                                       # RTR, IDE, r0
+    bits += [(len(data) >> (3 - i)) & 1 for i in range(4)]
+    for byte in data:
+        bits += [(byte >> (7 - i)) & 1 for i in range(8)]
+    crc = crc15(bits)
+    bits += [(crc >> (14 - i)) & 1 for i in range(15)]
+    stuffed, run, last = 0, 0, None
+    for b in bits:
+        run = run + 1 if b == last else 1
+        last = b
+        if run == 5:
+            stuffed += 1
+            last = 1 - b                                    # the stuff bit starts a run
+            run = 1
+    return len(bits) + stuffed + 13                         # delimiters, ACK, EOF, IFS
+
+
+class Bus:
+    """One CAN segment; frames wait for the bus and win arbitration by ID."""
+
+    def __init__(self, bitrate, load, rng):
+        self.bit = 1.0 / bitrate
+        self.rng = rng
+        self.t = 0.0
+        self.queue = []
+        self.timers = []
+        self.order = 0
+        self.bits = {'sdo': 0, 'bg': 0}
+        self.frames = {'sdo': 0, 'bg': 0}
+        # Background: Poisson arrivals of 8 byte PDOs, about 125 bits each
+        self.bg_gap = (125.0 * self.bit / load) if load > 0.0 else None
+        self.bg_next = self._gap()
+
+    def _gap(self):
+        return self.rng.expovariate(1.0 / self.bg_gap) if self.bg_gap else float('inf')
+
+    def send(self, ready, can_id, data, done=None, kind='sdo'):
+        self.queue.append((ready, self.order, can_id, bytes(data), done, kind))
+        self.order += 1
+
+    def at(self, when, fn):
+        self.timers.append((when, self.order, fn))
+        self.order += 1
+
+    def _timers(self):
+        while self.timers:
+            timer = min(self.timers)
+            if timer[0] > self.t:
+                break
+            self.timers.remove(timer)
+            timer[2](timer[0])
+
+    def _background(self, until):
+        while self.bg_next <= until:
+            data = bytes(self.rng.getrandbits(8) for _ in range(8))
+            self.send(self.bg_next, self.rng.randrange(0x181, 0x500), data, kind='bg')
+            self.bg_next += self._gap()
+
+    def run(self, finished):
+        while not finished():
+            self._timers()
+            self._background(self.t)
+            ready = [q for q in self.queue if q[0] <= self.t]
+            if not ready:
+                nxt = min([q[0] for q in self.queue] + [t[0] for t in self.timers] + [self.bg_next])
+                self._background(nxt)
+                self.t = max(self.t, nxt)
+                continue
+            frame = min(ready, key=lambda q: (q[2], q[1]))
+            self.queue.remove(frame)
+            _, _, can_id, data, done, kind = frame
+            bits = frame_bits(can_id, data)
+            self.t += bits * self.bit
+            self.bits[kind] += bits
+            self.frames[kind] += 1
+            self._timers()
+            if done:
+                done(self.t)
+
+    def sdo_pending(self):
+        return any(q[5] == 'sdo' for q in self.queue)
+
+
+class Link:
+    """Runs the steps of one SDO transfer in turn.  A step is a list of frames
+    one side sends once it has received the last frame of the step before."""
+
+    def __init__(self, bus, node_id, host_us, node_us, loop_us):
+        self.bus = bus
+        self.node_id = node_id
+        self.delay = {HOST: host_us * 1e-6, NODE: node_us * 1e-6}
+        self.loop = loop_us * 1e-6
+        self.steps = []
+        self.hold = 0.0                 # node response not ready before this
+
+    def run(self, steps):
+        self.steps = list(steps)
+        self._next(self.bus.t)
+        self.bus.run(lambda: not self.steps and not self.bus.sdo_pending())
+
+    def _next(self, t):
+        if not self.steps:
+            return
+        side, frames, wait = self.steps.pop(0)
+        start = t + self.delay[side]
+        if wait:
+            start = max(start, self.hold)
+        can_id = (COB_RX if side == HOST else COB_TX) + self.node_id
+        if side == HOST:
+            # The adapter queues the whole step, the bus sends it back to back
+            for i, data in enumerate(frames):
+                self.bus.send(start, can_id, data, self._next if i == len(frames) - 1 else None)
+        else:
+            # sdo_block.c queues the next segment once the last one is out
+            self._node_frames(start, can_id, list(frames))
+
+    def _node_frames(self, start, can_id, frames):
+        data = frames.pop(0)
+        if frames:
+            done = lambda t: self._node_frames(t + self.loop, can_id, frames)
+        else:
+            done = self._next
+        self.bus.send(start, can_id, data, done)
+
+
+def frame(*data):
+    return bytes(data) + bytes(8 - len(data))
+
+
+def segments(payload, first):
+    """7 byte segments; first(i, last, chunk) builds the command byte."""
+    out = []
+    count = max(1, (len(payload) + SEG_SIZE - 1) // SEG_SIZE)
+    for i in range(count):
+        chunk = payload[i * SEG_SIZE:(i + 1) * SEG_SIZE]
+        out.append(bytes([first(i, i == count - 1, chunk)]) + chunk + bytes(SEG_SIZE - len(chunk)))
+    return out
+
+
+def segmented_download(cmd, blksize):
+    steps = [(HOST, [frame(0x21, 0x50, 0x1F, 1, len(cmd) & 0xFF, len(cmd) >> 8)], False),
+             (NODE, [frame(0x60, 0x50, 0x1F, 1)], False)]
+    for i, seg in enumerate(segments(cmd, lambda i, last, c: ((i & 1) << 4) | ((7 - len(c)) << 1) | last)):
+        steps += [(HOST, [seg], False), (NODE, [frame(0x20 | ((i & 1) << 4))], False)]
+    return steps
+
+
+def segmented_upload(resp):
+    steps = [(HOST, [frame(0x40, 0x50, 0x1F, 1)], False)]
+    if len(resp) <= 4:
+        return steps + [(NODE, [frame(0x43 | ((4 - len(resp)) << 2), 0x50, 0x1F, 1, *resp)], True)]
+    steps.append((NODE, [frame(0x41, 0x50, 0x1F, 1, len(resp) & 0xFF, len(resp) >> 8)], True))
+    for i, seg in enumerate(segments(resp, lambda i, last, c: ((i & 1) << 4) | ((7 - len(c)) << 1) | last)):
+        steps += [(HOST, [frame(0x60 | ((i & 1) << 4))], False), (NODE, [seg], False)]
+    return steps
+
+
+def block_download(cmd, blksize):
+    segs = segments(cmd, lambda i, last, c: (0x80 if last else 0) | ((i % blksize) + 1))
+    steps = [(HOST, [frame(0xC6, 0x50, 0x1F, 1, len(cmd) & 0xFF, len(cmd) >> 8)], False),
+             (NODE, [frame(0xA4, 0x50, 0x1F, 1, blksize)], False)]
+    for at in range(0, len(segs), blksize):
+        block = segs[at:at + blksize]
+        steps += [(HOST, block, False), (NODE, [frame(0xA2, len(block), blksize)], False)]
+    unused = len(segs) * SEG_SIZE - len(cmd)
+    return steps + [(HOST, [frame(0xC1 | (unused << 2), 0x12, 0x34)], False),
+                    (NODE, [frame(0xA1)], False)]
+
+
+def block_upload(resp, blksize=127):
+    segs = segments(resp, lambda i, last, c: (0x80 if last else 0) | ((i % blksize) + 1))
+    unused = len(segs) * SEG_SIZE - len(resp)
+    return [(HOST, [frame(0xA4, 0x50, 0x1F, 1, blksize)], False),
+            (NODE, [frame(0xC6, 0x50, 0x1F, 1, len(resp) & 0xFF, len(resp) >> 8)], True),
+            (HOST, [frame(0xA3)], False),
+            (NODE, segs, False),
+            (HOST, [frame(0xA2, len(segs), blksize)], False),
+            (NODE, [frame(0xC1 | (unused << 2), 0x56, 0x78)], False),
+            (HOST, [frame(0xA1)], False)]
+
+
+class Stream:
+    """One block download of the whole image: the host side of a block
+    transfer and the node side of sdo_block.c and the bldr_impl.c slots."""
+
+    SLOTS = 2
+
+    def __init__(self, bus, data, ends, args):
+        self.bus = bus
+        self.args = args
+        self.host_id = COB_RX + args.node
+        self.node_id = COB_TX + args.node
+        self.data = data
+        self.ends = ends                # bytes of the download that complete each command
+        self.segs = segments(self.data, lambda i, last, c: 0)
+        # host
+        self.pos = 0                    # first segment not acknowledged
+        self.done = False
+        # node
+        self.stall = 0.0                # CPU held by a row write until
+        self.fifo = []
+        self.seq = 0
+        self.blksize = 0
+        self.accepted = 0               # segments taken, the last one held
+        self.last = False
+        self.ended = False              # end frame taken, the last command released
+        self.ack_wait = False
+        self.read = 0                   # commands read by the bootloader
+        self.lost = 0
+        self.stalls = 0
+
+    # ---- host ---------------------------------------------------------
+    def start(self):
+        size = len(self.data)
+        self.bus.send(self.bus.t, self.host_id, frame(0xC6, 0x50, 0x1F, 1, size & 0xFF, (size >> 8) & 0xFF,
+                                                      size >> 16), lambda t: self.node_rx(t, ('init',)))
+
+    def host_rx(self, t, msg):
+        t += self.args.host_us * 1e-6
+        if msg[0] == 'ack':
+            self.pos += msg[1]
+            if self.pos >= len(self.segs):
+                unused = len(self.segs) * SEG_SIZE - len(self.data)
+                self.bus.send(t, self.host_id, frame(0xC1 | (unused << 2), 0x12, 0x34),
+                              lambda t: self.node_rx(t, ('end',)))
+                return
+            for k in range(msg[2]):
+                i = self.pos + k
+                if i >= len(self.segs):
+                    break
+                last = i == len(self.segs) - 1
+                data = bytes([(0x80 if last else 0) | (k + 1)]) + self.segs[i][1:]
+                self.bus.send(t, self.host_id, data, lambda t, m=('seg', k + 1, last): self.node_rx(t, m))
+        elif msg[0] == 'end':
+            self.done = True
+
+    # ---- node ---------------------------------------------------------
+    def forwarded(self):
+        if self.ended:
+            return len(self.data)
+        return max(0, self.accepted - 1) * SEG_SIZE
+
+    def limit(self):
+        """Bytes the two command slots allow: up to the end of the second
+        command not yet read."""
+        return self.ends[min(self.read + self.SLOTS, len(self.ends)) - 1]
+
+    def held(self):
+        return SEG_SIZE if self.accepted else 0
+
+    def next_block(self):
+        """Program_BlockSpace(): the rest of the command being received,
+        and a whole buffer if the other slot is free."""
+        pos = self.forwarded()
+        fill = len([end for end in self.ends if end <= pos])
+        space = self.ends[fill] - pos if fill < len(self.ends) else 0
+        if self.read >= fill:
+            space += CMD_BUFFER
+        space -= self.held()
+        return max(0, min(self.args.blksize, space // SEG_SIZE))
+
+    def reply(self, t, data, msg):
+        self.bus.send(t + self.args.node_us * 1e-6, self.node_id, data, lambda t: self.host_rx(t, msg))
+
+    def ack(self, t):
+        blksize = self.next_block()
+        self.ack_wait = blksize == 0
+        if self.ack_wait:
+            return
+        self.reply(t, frame(0xA2, self.seq, blksize), ('ack', self.seq, blksize))
+        self.seq = 0
+        self.blksize = blksize
+
+    def node_rx(self, t, msg):
+        if t < self.stall:
+            if len(self.fifo) < self.args.mailboxes:
+                self.fifo.append(msg)
+            else:
+                self.lost += 1
+            return
+        self.process(t, msg)
+        self.try_read(t)
+
+    def process(self, t, msg):
+        if msg[0] == 'init':
+            self.blksize = self.next_block()
+            self.reply(t, frame(0xA4, 0x50, 0x1F, 1, self.blksize), ('ack', 0, self.blksize))
+        elif msg[0] == 'seg':
+            _, seqno, last = msg
+            if seqno == self.seq + 1 and not self.last and not self.ack_wait:
+                if self.forwarded() + self.held() <= self.limit():
+                    self.accepted += 1
+                    self.seq = seqno
+                    self.last = last
+                else:
+                    self.stalls += 1
+            if (seqno >= self.blksize or last) and not self.ack_wait:
+                self.ack(t)
+        elif msg[0] == 'end':
+            self.ended = True
+            self.reply(t, frame(0xA1), ('end',))
+
+    def try_read(self, t):
+        if t < self.stall or self.read >= len(self.ends):
+            return
+        released = self.ended or self.forwarded() > self.ends[self.read]
+        if not released:
+            return
+        self.read += 1
+        if self.ack_wait:
+            self.ack(t - self.args.node_us * 1e-6)
+        self.stall = t + self.args.flash_ms * 1e-3
+        self.bus.at(self.stall, self.resume)
+
+    def resume(self, t):
+        fifo, self.fifo = self.fifo, []
+        for msg in fifo:
+            self.process(t, msg)
+        self.try_read(t)
+
+    def finished(self):
+        return self.done and self.read >= len(self.ends) and self.bus.t >= self.stall
+
+
+class LzStream(Stream):
+    """The stream through the decoder input: it is drained into the command
+    slots in the main loop, as far as the two slots reach."""
+
+    def decoded(self):
+        return min(self.forwarded(), self.ends[min(self.read + self.SLOTS, len(self.ends)) - 1])
+
+    def limit(self):
+        return self.decoded() + LZ_INPUT
+
+    def next_block(self):
+        space = self.limit() - self.forwarded() - self.held()
+        return max(0, min(self.args.blksize, space // SEG_SIZE))
+
+
+def lz_ends(packed, ends):
+    """Bytes of a packed stream the decoder needs for each packet."""
+    len_bits = 16 - packed[1]
+    out, pos, k, found = 0, 2, 0, []
+    while pos < len(packed) and k < len(ends):
+        flags = packed[pos]
+        pos += 1
+        for i in range(8):
+            if pos >= len(packed):
+                break
+            if flags & (1 << i):
+                out += (packed[pos + 1] & ((1 << len_bits) - 1)) + MIN_MATCH
+                pos += 2
+            else:
+                out += 1
+                pos += 1
+            while k < len(ends) and out >= ends[k]:
+                found.append(pos)
+                k += 1
+    return found
+
+
+def stream(rows, args, bus, link, lz=False):
+    packets = [program_row(*row) for row in rows]
+    if not packets:
+        return None
+    data = b''.join(packets)
+    ends = []
+    for packet in packets:
+        ends.append((ends[-1] if ends else 0) + len(packet))
+    packed = compress(data) if lz else data
+    if len(packed) < len(data):
+        s = LzStream(bus, packed, lz_ends(packed, ends), args)
+    else:
+        s = Stream(bus, data, ends, args)
+    s.start()
+    bus.run(s.finished)
+    link.hold = s.stall
+    link.run(segmented_upload(bytes([0x01, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x17])))
+    return s
+
+
+MODES = {
+    'segmented': (segmented_download, segmented_upload),
+    'block': (block_download, block_upload),
+    'block-dl': (block_download, segmented_upload),
+    'stream': (None, None),
+    'stream-lz': (None, None),
+}
+
+
+def simulate(mode, rows, args, installed=None):
+    rng = random.Random(args.seed)
+    bus = Bus(args.bitrate, args.load, rng)
+    link = Link(bus, args.node, args.host_us, args.node_us, args.loop_us)
+    download, upload = MODES[mode]
+    if mode.startswith('stream'):
+        download, upload = MODES['block']
+    blksize = min(args.blksize, (CMD_BUFFER + SEG_SIZE - 1) // SEG_SIZE)
+    if installed is not None:
+        for array, first, count in runs(rows):
+            link.run(download(packet(CMD_ROW_CRC, bytes([array, first & 0xFF, first >> 8, count])), blksize))
+            link.hold = bus.t + count * ROW_CRC_US * 1e-6
+            link.run(upload(bytes(4 * count + 7)))
+        rows = plan(rows, installed)
+    if mode.startswith('stream'):
+        stream(rows, args, bus, link, mode == 'stream-lz')
+        return bus
+    response = bytes([0x01, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x17])
+    for row in rows:
+        cmd = program_row(*row)
+        link.run(download(cmd, blksize))
+        link.hold = bus.t + args.flash_ms * 1e-3
+        link.run(upload(response))
+    return bus
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Segmented versus block SDO image download')
+    parser.add_argument('image', nargs='?', help='.cyacd image (default: a full CY8C4247 image)')
+    parser.add_argument('--rows', type=int, default=FLASH_ROWS, help='rows without an image')
+    parser.add_argument('--base', metavar='CYACD', help='image on the node, for a delta update')
+    parser.add_argument('--changed', type=int, help='rows of the random image not on the node yet')
+    parser.add_argument('--bitrate', type=int, default=500000)
+    parser.add_argument('--load', type=float, default=0.3, help='background bus load, 0..1')
+    parser.add_argument('--host-us', type=float, default=1000.0, help='host adapter turnaround')
+    parser.add_argument('--node-us', type=float, default=200.0, help='node turnaround')
+    parser.add_argument('--loop-us', type=float, default=20.0, help='node gap between upload segments')
+    parser.add_argument('--flash-ms', type=float, default=20.0, help='row erase and program')
+    parser.add_argument('--blksize', type=int, default=16, help='SDOB_BLKSIZE')
+    parser.add_argument('--mailboxes', type=int, default=16, help='RX mailboxes open to the server SDO')
+    parser.add_argument('--node', type=int, default=5, help='node-ID')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--modes', default='segmented,block,block-dl,stream,stream-lz')
+    args = parser.parse_args()
+
+    if not 0.0 <= args.load < 1.0:
+        sys.exit('load must be in 0..1')
+    if not 1 <= args.blksize <= 127:
+        sys.exit('blksize must be in 1..127')
+    if 'stream' in args.modes and args.blksize > args.mailboxes:
+        sys.exit('a block larger than the mailboxes loses frames while a row is written')
+    rng = random.Random(args.seed)
+    if args.image:
+        rows = read_cyacd(args.image)[1]
+    else:
+        rows = [(0, n, bytes(rng.getrandbits(8) for _ in range(ROW_SIZE))) for n in range(args.rows)]
+    installed = None
+    if args.base:
+        installed = {(a, r): row_crc(d) for a, r, d in read_cyacd(args.base)[1]}
+    elif args.changed is not None:
+        new = set(rng.sample(range(len(rows)), min(args.changed, len(rows))))
+        installed = {(a, r): row_crc(d) for n, (a, r, d) in enumerate(rows) if n not in new}
+    if installed is not None:
+        print('delta update: %d of %d rows differ' % (len(plan(rows, installed)), len(rows)))
+
+    print('%d rows, %d kbit/s, %.0f%% background, host %.0f us, node %.0f us, row write %.0f ms'
+          % (len(rows), args.bitrate // 1000, args.load * 100, args.host_us, args.node_us, args.flash_ms))
+    print('%-10s %10s %10s %10s %10s %8s' % ('mode', 'time s', 'frames', 'SDO util', 'bus util', 'speedup'))
+    base = None
+    for mode in args.modes.split(','):
+        bus = simulate(mode, rows, args, installed)
+        base = base or bus.t
+        sdo = bus.bits['sdo'] / args.bitrate / bus.t
+        total = (bus.bits['sdo'] + bus.bits['bg']) / args.bitrate / bus.t
+        print('%-10s %10.2f %10d %9.1f%% %9.1f%% %7.2fx'
+              % (mode, bus.t, bus.frames['sdo'], sdo * 100, total * 100, base / bus.t))
+
+
+if __name__ == '__main__':
+    main()
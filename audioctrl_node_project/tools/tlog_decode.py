@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+################################################################################
+# FILE: tlog_decode.py
+#
+# Version: 1.0
+#
+# Copyright 2016, Bossa Nova Robotics. All rights reserved.
+# This software is owned by Bossa Nova Robotics and is protected by and subject
+# to worldwide patent and copyright laws and treaties.
+#
+################################################################################
+#
+# DESCRIPTION:
+#     Host decoder for the tokenized log records written by TLOG_Write()
+# (see inc/tlog.h).  The format strings are read from the .tlog_fmt section
+# of the application .elf, or from a table saved earlier with --extract, and
+# the UART byte stream is turned back into text.  Bytes outside a record are
+# passed through unchanged.
+#
+#     tlog_decode.py app.elf < capture.bin
+#     tlog_decode.py app.elf /dev/ttyUSB0 --baud 115200
+#     tlog_decode.py app.elf --extract app.tlog.json
+#     tlog_decode.py app.tlog.json capture.bin
+################################################################################
+import argparse
+import json
+import os
+import re
+import struct
+import subprocess
+import sys
+
+FRAME_MARK = 0xF0
+MAX_ARGS = 4
+SECTIONS = ('.tlog_fmt', 'tlog_fmt')
+
+SPEC = re.compile(r'%([-+ #0]*)(\d+)?(?:\.(\d+))?(?:hh|h|ll|l|z|t|j)?([diouxXcsp%])')
+
+
+def elf_section(path, names):
+    """Returns the contents of the first section in names, or None."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'\x7fELF':
+        raise ValueError('%s: not an ELF file' % path)
+    is64 = data[4] == 2
+    end = '<' if data[5] == 1 else '>'
+    if is64:
+        shoff, = struct.unpack_from(end + 'Q', data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + 'HHH', data, 0x3A)
+        shdr = end + 'IIQQQQIIQQ'
+    else:
+        shoff, = struct.unpack_from(end + 'I', data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + 'HHH', data, 0x2E)
+        shdr = end + 'IIIIIIIIII'
+    headers = [struct.unpack_from(shdr, data, shoff + i * shentsize) for i in range(shnum)]
+    strtab = headers[shstrndx]
+    for h in headers:
+        name_end = data.index(b'\0', strtab[4] + h[0])
+        name = data[strtab[4] + h[0]:name_end].decode()
+        if name in names:
+            return data[h[4]:h[4] + h[5]]
+    return None
+
+
+def load_table(path):
+    """Maps format string offset to format string."""
+    if path.endswith('.json'):
+        with open(path) as f:
+            return {int(k): v for k, v in json.load(f).items()}
+    blob = elf_section(path, SECTIONS)
+    if blob is None:
+        raise ValueError('%s: no tlog_fmt section' % path)
+    table = {}
+    offset = 0
+    while offset < len(blob):
+        nul = blob.find(b'\0', offset)
+        if nul < 0:
+            nul = len(blob)
+        if nul > offset:
+            table[offset] = blob[offset:nul].decode('latin-1')
+        offset = nul + 1
+    return table
+
+
+def render(fmt, args):
+    """printf() for 32 bit argument words."""
+    words = iter(args)
+
+    def convert(m):
+        flags, width, prec, conv = m.groups()
+        if conv == '%':
+            return '%'
+        value = next(words, 0)
+        if conv in 'di':
+            value = value - (1 << 32) if value & 0x80000000 else value
+        elif conv == 'c':
+            value = chr(value & 0xFF)
+        elif conv == 's':
+            return '<str@0x%08x>' % value
+        elif conv == 'p':
+            conv = 'x'
+            flags = (flags or '') + '#'
+        spec = '%' + (flags or '') + (width or '') + ('.' + prec if prec else '') + conv
+        return spec % value
+
+    return SPEC.sub(convert, fmt)
+
+
+class Decoder(object):
+    def __init__(self, table, out):
+        self.table = table
+        self.out = out
+        self.frame = bytearray()
+        self.need = 0
+
+    def feed(self, data):
+        for b in bytearray(data):
+            if self.need:
+                self.frame.append(b)
+                if len(self.frame) == self.need:
+                    self.record()
+            elif (b & 0xF0) == FRAME_MARK and (b & 0x0F) <= MAX_ARGS:
+                self.frame = bytearray([b])
+                self.need = 3 + 4 * (b & 0x0F)
+            else:
+                self.out.write(chr(b))
+        self.out.flush()
+
+    def record(self):
+        nargs = self.frame[0] & 0x0F
+        fid, = struct.unpack_from('<H', self.frame, 1)
+        args = struct.unpack_from('<%dI' % nargs, self.frame, 3)
+        self.need = 0
+        fmt = self.table.get(fid)
+        if fmt is None:
+            text = '<tlog id 0x%04x%s>\n' % (fid, ''.join(' 0x%x' % a for a in args))
+        else:
+            text = render(fmt, args)
+        # Match the SIO_Printf() prompt so mixed logs line up
+        self.out.write('> ' + text)
+        if not text.endswith('\n'):
+            self.out.write('\n')
+
+
+def open_input(path, baud):
+    if path is None or path == '-':
+        return os.fdopen(sys.stdin.fileno(), 'rb', 0)
+    if baud:
+        subprocess.check_call(['stty', '-F', path, str(baud), 'raw', '-echo'])
+    return open(path, 'rb', 0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode tokenized TLOG output')
+    parser.add_argument('table', help='application .elf or table saved with --extract')
+    parser.add_argument('input', nargs='?', help='capture file or serial device (default stdin)')
+    parser.add_argument('--baud', type=int, help='configure the serial device first')
+    parser.add_argument('--extract', metavar='JSON', help='save the string table and exit')
+    args = parser.parse_args()
+
+    table = load_table(args.table)
+    if args.extract:
+        with open(args.extract, 'w') as f:
+            json.dump({str(k): v for k, v in sorted(table.items())}, f, indent=1)
+        return 0
+
+    decoder = Decoder(table, sys.stdout)
+    source = open_input(args.input, args.baud)
+    while True:
+        data = source.read(256)
+        if not data:
+            break
+        decoder.feed(data)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())